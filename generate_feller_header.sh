@@ -6,6 +6,13 @@ fi
 
 touch Feller.hpp
 cat src/Feller_Feller.hpp    >> Feller.hpp
+
+cat src/Feller_TimeFormatter.hpp >> Feller.hpp
+cat src/Feller_TimeFormatter.cpp >> Feller.hpp
+
+cat src/Feller_Clock.hpp >> Feller.hpp
+cat src/Feller_Clock.cpp >> Feller.hpp
+
 cat src/Feller_Util.hpp >> Feller.hpp
 cat src/Feller_Util.cpp >> Feller.hpp
 
@@ -14,18 +21,75 @@ cat src/Feller_LoggingMode.hpp >> Feller.hpp
 cat src/Feller_AnyType.hpp >> Feller.hpp
 cat src/Feller_AnyType.cpp >> Feller.hpp
 
-cat src/Feller_ContiguousLogStorage.hpp >> Feller.hpp
-cat src/Feller_ContiguousLogStorage.cpp >> Feller.hpp
-
 cat src/Feller_Data.hpp >> Feller.hpp
 cat src/Feller_Data.cpp >> Feller.hpp
 
+cat src/Feller_DataArena.hpp >> Feller.hpp
+cat src/Feller_DataArena.cpp >> Feller.hpp
+
+cat src/Feller_AuxData.hpp >> Feller.hpp
+cat src/Feller_AuxData.cpp >> Feller.hpp
+
+cat src/Feller_StringTable.hpp >> Feller.hpp
+cat src/Feller_StringTable.cpp >> Feller.hpp
+
+cat src/Feller_ParameterValue.hpp >> Feller.hpp
+cat src/Feller_ParameterValue.cpp >> Feller.hpp
+
+cat src/Feller_LogSite.hpp >> Feller.hpp
+cat src/Feller_LogSite.cpp >> Feller.hpp
+
 cat src/Feller_EventLog.hpp >> Feller.hpp
 cat src/Feller_EventLog.cpp >> Feller.hpp
 
+cat src/Feller_ThreadInfo.hpp >> Feller.hpp
+cat src/Feller_ThreadInfo.cpp >> Feller.hpp
+
+cat src/Feller_MetricLog.hpp >> Feller.hpp
+cat src/Feller_MetricLog.cpp >> Feller.hpp
+
+cat src/Feller_DeferredLog.hpp >> Feller.hpp
+cat src/Feller_DeferredLog.cpp >> Feller.hpp
+
+cat src/Feller_BinaryFormat.hpp >> Feller.hpp
+cat src/Feller_BinaryFormat.cpp >> Feller.hpp
+
+cat src/Feller_ContiguousLogStorage.hpp >> Feller.hpp
+cat src/Feller_ContiguousLogStorage.cpp >> Feller.hpp
+
+cat src/Feller_RingBufferLogStorage.hpp >> Feller.hpp
+cat src/Feller_RingBufferLogStorage.cpp >> Feller.hpp
+
+cat src/Feller_ShardedLogStorage.hpp >> Feller.hpp
+cat src/Feller_ShardedLogStorage.cpp >> Feller.hpp
+
+cat src/Feller_SegmentedLogStorage.hpp >> Feller.hpp
+cat src/Feller_SegmentedLogStorage.cpp >> Feller.hpp
+
+cat src/Feller_FlightRecorderLogStorage.hpp >> Feller.hpp
+cat src/Feller_FlightRecorderLogStorage.cpp >> Feller.hpp
+
+cat src/Feller_KeyedLogStorage.hpp >> Feller.hpp
+cat src/Feller_KeyedLogStorage.cpp >> Feller.hpp
+
+cat src/Feller_TimeIndexedLogStorage.hpp >> Feller.hpp
+cat src/Feller_TimeIndexedLogStorage.cpp >> Feller.hpp
+
+cat src/Feller_ColumnarLogStorage.hpp >> Feller.hpp
+cat src/Feller_ColumnarLogStorage.cpp >> Feller.hpp
+
+cat src/Feller_MetricLogStorage.hpp >> Feller.hpp
+cat src/Feller_MetricLogStorage.cpp >> Feller.hpp
+
+cat src/Feller_MappedLogStorage.hpp >> Feller.hpp
+cat src/Feller_MappedLogStorage.cpp >> Feller.hpp
+
 cat src/Feller_Logger.hpp >> Feller.hpp
 cat src/Feller_Logger.cpp >> Feller.hpp
 
+cat src/Feller_AsyncLogger.hpp >> Feller.hpp
+cat src/Feller_AsyncLogger.cpp >> Feller.hpp
+
 cat src/Feller_MutexLock.hpp >> Feller.hpp
 cat src/Feller_MutexLock.cpp >> Feller.hpp
 
@@ -35,18 +99,27 @@ cat src/Feller_NoLock.cpp >> Feller.hpp
 cat src/Feller_TestData.hpp >> Feller.hpp
 cat src/Feller_TestData.cpp >> Feller.hpp
 
-
-
 cat src/Feller_StaticLoggingPolicy.hpp >> Feller.hpp
 cat src/Feller_StaticLoggingPolicy.cpp >> Feller.hpp
+
 cat src/Feller_ConditionalLoggingPolicy.hpp >> Feller.hpp
 cat src/Feller_ConditionalLoggingPolicy.cpp >> Feller.hpp
 
+cat src/Feller_AtomicConditionalLoggingPolicy.hpp >> Feller.hpp
+cat src/Feller_AtomicConditionalLoggingPolicy.cpp >> Feller.hpp
+
 cat src/Feller_LogEverything.hpp >> Feller.hpp
 cat src/Feller_LogEverything.cpp >> Feller.hpp
+
 cat src/Feller_LogNothing.hpp >> Feller.hpp
 cat src/Feller_LogNothing.cpp >> Feller.hpp
 
+cat src/Feller_ScopedSpan.hpp >> Feller.hpp
+cat src/Feller_ScopedSpan.cpp >> Feller.hpp
+
+cat src/Feller_ChromeTrace.hpp >> Feller.hpp
+cat src/Feller_ChromeTrace.cpp >> Feller.hpp
+
 cat src/Feller_Decl.hpp >> Feller.hpp
 cat src/Feller_Decl.cpp >> Feller.hpp
 
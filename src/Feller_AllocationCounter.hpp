@@ -0,0 +1,68 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_ALLOCATION_COUNTER
+#define INCLUDED_FELLER_ALLOCATION_COUNTER
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/**
+ \brief The purpose of this component is to let tests check that an operation does not allocate.
+
+ Including this header replaces the global operator new and operator delete with versions that
+count every allocation in `nr_allocations`. A test records the count before an operation and
+compares it afterwards. Since the replacements are ordinary definitions, this header must be
+included by exactly one file of each test executable, and never by the library itself.
+**/
+
+/**
+   nr_allocations. This is the number of calls to the global operator new so far.
+**/
+static std::size_t nr_allocations = 0;
+
+void *operator new(std::size_t size)
+{
+  ++nr_allocations;
+  if (void *ptr = std::malloc(size))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+// The default memory resource (used by ContiguousLogStorage) allocates via the aligned overloads.
+void *operator new(std::size_t size, std::align_val_t align)
+{
+  ++nr_allocations;
+  const auto alignment = static_cast<std::size_t>(align);
+  if (void *ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+#endif
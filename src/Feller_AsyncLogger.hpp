@@ -0,0 +1,571 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_ASYNC_LOGGER
+#define INCLUDED_FELLER_ASYNC_LOGGER
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Feller_Feller.hpp"
+#include "Feller_LoggingMode.hpp"
+
+namespace Feller
+{
+/**
+   Backpressure. This enum describes what an \ref AsyncLogger does when a producer's queue is
+   full.
+   - BLOCK: the producer waits until the background thread has made room.
+   - DROP_NEWEST: the log being inserted is discarded.
+   - OVERWRITE_OLDEST: the oldest log in the producer's queue is discarded to make room.
+   Any discarded log is counted in \ref AsyncLogger::dropped.
+**/
+enum class Backpressure
+{
+  BLOCK,
+  DROP_NEWEST,
+  OVERWRITE_OLDEST
+};
+
+/**
+   AsyncLogger. This class wraps a \ref Logger so that inserting a log never touches the
+ underlying store. Briefly, each thread that inserts into this object is given its own bounded
+ queue: inserting a log simply moves it into the calling thread's queue. A dedicated background
+ thread drains every queue into the wrapped logger (and, optionally, passes each log to a sink).
+ This means that application threads never pay for storage growth, formatting or I/O, and never
+ contend with each other: each queue is only ever shared between one producer and the background
+ thread.
+
+   The logging policy of the wrapped logger is consulted before a log is queued, so rejected logs
+ cost no more than they would with the wrapped logger. A queued log has been accepted, so it is
+ sinked and stored even if the mode is switched before it is drained. If the mode is switched
+ whilst other threads are logging, then the wrapped logger should use \ref
+ AtomicConditionalLoggingPolicy.
+
+   Logs from a single thread reach the wrapped logger in the order in which they were inserted.
+ No ordering is guaranteed between threads.
+
+   The wrapped logger should only be read after a call to flush() (with no concurrent insertions)
+ or after shutdown(). The destructor calls shutdown(), which drains every queue before stopping the
+ background thread: any log inserted before shutdown() is called is therefore never lost, unless
+ it is discarded by the backpressure policy.
+
+   \tparam LoggerType: the type of the wrapped logger. This must be an instantiation of \ref Logger,
+ as logs are drained straight into its storage policy.
+**/
+template <typename LoggerType> class AsyncLogger
+{
+public:
+  /**
+     log_type. This type exposes the type of log stored in the wrapped logger.
+  **/
+  using log_type = typename LoggerType::log_type;
+
+  /**
+     logger_type. This type exposes the type of the wrapped logger.
+  **/
+  using logger_type = LoggerType;
+
+  /**
+     size_type. This type is used to represent sizes in this object.
+  **/
+  using size_type = std::size_t;
+
+  /**
+     sink_type. This type describes the optional sink. The sink is called from the background
+  thread with each log, just before that log is inserted into the wrapped logger.
+  **/
+  using sink_type = std::function<void(const log_type &)>;
+
+  /**
+     default_queue_depth. This is the number of logs each producer can queue if no depth is given.
+  **/
+  static constexpr size_type default_queue_depth = 1024;
+
+  // CONSTRUCTORS
+
+  /**
+     AsyncLogger. This constructor builds an empty wrapped logger and starts the background
+  thread. This constructor may throw if the thread cannot be started.
+     \param queue_depth: the maximum number of logs each producer can queue.
+     \param backpressure: what to do when a producer's queue is full.
+     \param sink: an optional callable that is passed each log from the background thread.
+  **/
+  explicit AsyncLogger(const size_type queue_depth           = default_queue_depth,
+                       const Feller::Backpressure backpressure = Feller::Backpressure::BLOCK,
+                       sink_type sink                          = sink_type{});
+
+  /// This class owns a thread, and so it cannot be copied.
+  AsyncLogger(const AsyncLogger &)            = delete;
+  AsyncLogger &operator=(const AsyncLogger &) = delete;
+
+  /**
+     ~AsyncLogger. This destructor calls shutdown().
+  **/
+  ~AsyncLogger();
+
+  // MODIFIERS
+
+  /**
+     insert. This method moves `log` into the calling thread's queue, provided that `priority` is
+  accepted by the wrapped logger. This method may block if the backpressure policy is BLOCK.
+  This method may throw due to std::bad_alloc on the first insertion from a thread.
+     \param log: the log to be queued.
+     \param priority: the priority of the log. This determines whether the log will be inserted.
+  **/
+  inline void insert(log_type &&log,
+                     const Feller::LoggingMode priority = Feller::LoggingMode::EVERYTHING);
+
+  /**
+     insert. This method copies `log` into the calling thread's queue, provided that `priority`
+  is accepted by the wrapped logger.
+     \param log: the log to be queued.
+     \param priority: the priority of the log. This determines whether the log will be inserted.
+  **/
+  inline void insert(const log_type &log,
+                     const Feller::LoggingMode priority = Feller::LoggingMode::EVERYTHING);
+
+  /**
+     flush. This method blocks until every log that was inserted before this call has been
+  passed to the sink and inserted into the wrapped logger. If shutdown() has been called then this
+  method returns immediately.
+  **/
+  void flush();
+
+  /**
+     shutdown. This method drains every queue and stops the background thread. Any insertion
+  after this call is discarded. This method is idempotent.
+  **/
+  void shutdown();
+
+  /**
+     switchMode. This method switches the mode of the wrapped logger.
+     \param mode: the new logging mode.
+  **/
+  inline void switchMode(const Feller::LoggingMode mode) noexcept;
+
+  // ACCESSORS
+
+  /**
+     dropped. This method returns the number of logs that have been discarded. This includes logs
+  discarded by the backpressure policy, logs inserted after shutdown, and logs for which the sink
+  or the wrapped logger threw.
+     \return the number of discarded logs.
+  **/
+  inline size_type dropped() const noexcept;
+
+  /**
+     nr_producers. This method returns the number of producer queues, i.e the number of distinct
+  threads that have inserted into this object.
+     \return the number of producer queues.
+  **/
+  inline size_type nr_producers() const;
+
+  /**
+     logger. This method returns the wrapped logger. Reading from the wrapped logger is only safe
+  after flush() (with no concurrent insertions) or after shutdown().
+     \return a reference to the wrapped logger.
+  **/
+  inline LoggerType &logger() noexcept;
+  inline const LoggerType &logger() const noexcept;
+
+private:
+  /**
+     Queue. This struct is the bounded queue for a single producer. The queue is a ring of
+  `m_depth` entries, and it is only ever shared between its producer and the background thread.
+  **/
+  struct alignas(64) Queue
+  {
+    std::thread::id owner{};
+    std::mutex mutex{};
+    std::condition_variable not_full{};
+    std::vector<log_type> slots{};
+    size_type head{0};
+    size_type size{0};
+  };
+
+  /**
+     enqueue. This method implements both insertion methods.
+  **/
+  template <typename T> inline void enqueue(T &&log, const Feller::LoggingMode priority);
+
+  /**
+     local_queue. This method returns the queue of the calling thread, creating it if necessary.
+  The queue is cached in a thread_local variable, so this method only synchronises on the first
+  insertion from each thread (or when the thread switches between loggers, in which case its
+  existing queue is found by thread id).
+  **/
+  inline Queue &local_queue();
+
+  /**
+     drain. This method moves every queued log into the wrapped logger. This is only called from
+  the background thread.
+     \return true if any logs were drained, false otherwise.
+  **/
+  bool drain();
+
+  /**
+     run. This method is the body of the background thread.
+  **/
+  void run();
+
+  /**
+     next_id. This method returns a new, unique identifier for an AsyncLogger.
+  **/
+  static inline std::uint64_t next_id() noexcept;
+
+  /**
+     poll_interval. This is the longest the background thread sleeps before checking the queues.
+  Producers bump `m_pending` and wake the background thread whenever their queue becomes
+  non-empty, so this is only a safety net.
+  **/
+  static constexpr std::chrono::milliseconds poll_interval{1};
+
+  const std::uint64_t m_id;
+  const size_type m_depth;
+  const Feller::Backpressure m_backpressure;
+  sink_type m_sink;
+  LoggerType m_logger{};
+  std::atomic<size_type> m_dropped{0};
+  std::atomic<bool> m_stopped{false};
+
+  /// m_registry guards m_queues. m_snapshot is only used by the background thread.
+  mutable std::mutex m_registry{};
+  std::vector<std::unique_ptr<Queue>> m_queues{};
+  std::vector<Queue *> m_snapshot{};
+
+  /// m_control guards m_stop, the flush counters and m_pending, which producers bump whenever
+  /// their queue becomes non-empty.
+  std::mutex m_control{};
+  std::condition_variable m_wake{};
+  std::condition_variable m_flushed{};
+  bool m_stop{false};
+  std::uint64_t m_flush_requested{0};
+  std::uint64_t m_flush_completed{0};
+  std::uint64_t m_pending{0};
+
+  /// m_worker is declared last so that every other member is ready when it starts.
+  std::thread m_worker{};
+};
+
+/// INLINE FUNCTIONS
+template <typename LoggerType>
+Feller::AsyncLogger<LoggerType>::AsyncLogger(const size_type queue_depth,
+                                             const Feller::Backpressure backpressure,
+                                             sink_type sink)
+    : m_id{next_id()}, m_depth{queue_depth == 0 ? 1 : queue_depth}, m_backpressure{backpressure},
+      m_sink{std::move(sink)}
+{
+  m_worker = std::thread([this]() { run(); });
+}
+
+template <typename LoggerType> Feller::AsyncLogger<LoggerType>::~AsyncLogger() { shutdown(); }
+
+template <typename LoggerType>
+inline std::uint64_t Feller::AsyncLogger<LoggerType>::next_id() noexcept
+{
+  static std::atomic<std::uint64_t> counter{0};
+  return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+template <typename LoggerType>
+inline auto Feller::AsyncLogger<LoggerType>::local_queue() -> Queue &
+{
+  struct Cache
+  {
+    std::uint64_t id{0};
+    Queue *queue{nullptr};
+  };
+  static thread_local Cache cache;
+
+  if (cache.id == m_id)
+  {
+    return *cache.queue;
+  }
+
+  // The cache only remembers one logger, so this thread may already have a queue here.
+  std::lock_guard<std::mutex> guard{m_registry};
+  const auto me = std::this_thread::get_id();
+  Queue *queue  = nullptr;
+  for (auto &q : m_queues)
+  {
+    if (q->owner == me)
+    {
+      queue = q.get();
+      break;
+    }
+  }
+
+  if (queue == nullptr)
+  {
+    m_queues.push_back(std::make_unique<Queue>());
+    queue        = m_queues.back().get();
+    queue->owner = me;
+    queue->slots.resize(m_depth);
+  }
+
+  cache.id    = m_id;
+  cache.queue = queue;
+  return *queue;
+}
+
+template <typename LoggerType>
+template <typename T>
+inline void Feller::AsyncLogger<LoggerType>::enqueue(T &&log, const Feller::LoggingMode priority)
+{
+  if (!m_logger.shouldLog(priority))
+    return;
+
+  if (m_stopped.load(std::memory_order_relaxed))
+  {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  auto &queue = local_queue();
+  bool was_empty;
+  {
+    std::unique_lock<std::mutex> lock{queue.mutex};
+    if (queue.size == m_depth && m_backpressure == Feller::Backpressure::BLOCK)
+    {
+      queue.not_full.wait(lock, [this, &queue]() {
+        return queue.size < m_depth || m_stopped.load(std::memory_order_relaxed);
+      });
+    }
+
+    // This is checked under the lock so that the final drain in shutdown() cannot miss this log.
+    if (m_stopped.load(std::memory_order_relaxed))
+    {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    if (queue.size == m_depth)
+    {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      if (m_backpressure == Feller::Backpressure::DROP_NEWEST)
+      {
+        return;
+      }
+      queue.head = (queue.head + 1) % m_depth;
+      --queue.size;
+    }
+
+    queue.slots[(queue.head + queue.size) % m_depth] = std::forward<T>(log);
+    was_empty = queue.size == 0;
+    ++queue.size;
+  }
+
+  // The generation is bumped under the lock, so the background thread either sees it before it
+  // sleeps or is woken by the notification.
+  if (was_empty)
+  {
+    {
+      std::lock_guard<std::mutex> guard{m_control};
+      ++m_pending;
+    }
+    m_wake.notify_one();
+  }
+}
+
+template <typename LoggerType>
+inline void Feller::AsyncLogger<LoggerType>::insert(log_type &&log,
+                                                    const Feller::LoggingMode priority)
+{
+  enqueue(std::move(log), priority);
+}
+
+template <typename LoggerType>
+inline void Feller::AsyncLogger<LoggerType>::insert(const log_type &log,
+                                                    const Feller::LoggingMode priority)
+{
+  enqueue(log, priority);
+}
+
+template <typename LoggerType> bool Feller::AsyncLogger<LoggerType>::drain()
+{
+  {
+    std::lock_guard<std::mutex> guard{m_registry};
+    m_snapshot.clear();
+    for (const auto &queue : m_queues)
+    {
+      m_snapshot.push_back(queue.get());
+    }
+  }
+
+  bool drained = false;
+  log_type log;
+  for (auto *queue : m_snapshot)
+  {
+    // We drain one entry at a time so that the producer's lock is only held for a move.
+    for (;;)
+    {
+      {
+        std::lock_guard<std::mutex> guard{queue->mutex};
+        if (queue->size == 0)
+        {
+          break;
+        }
+        log         = std::move(queue->slots[queue->head]);
+        queue->head = (queue->head + 1) % m_depth;
+        --queue->size;
+      }
+      queue->not_full.notify_one();
+      drained = true;
+
+      try
+      {
+        if (m_sink)
+        {
+          m_sink(log);
+        }
+
+        // The log was accepted when it was queued, so the logging policy is not consulted again:
+        // otherwise a switchMode could drop a log that the sink has already seen.
+        auto lock = m_logger.getWorkingLock();
+        static_cast<typename LoggerType::storage_policy &>(m_logger).insert(std::move(log));
+      }
+      catch (...)
+      {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  return drained;
+}
+
+template <typename LoggerType> void Feller::AsyncLogger<LoggerType>::run()
+{
+  for (;;)
+  {
+    std::uint64_t requested;
+    std::uint64_t pending;
+    bool stop;
+    {
+      std::lock_guard<std::mutex> guard{m_control};
+      requested = m_flush_requested;
+      pending   = m_pending;
+      stop      = m_stop;
+    }
+
+    const bool drained = drain();
+
+    if (requested != m_flush_completed)
+    {
+      std::lock_guard<std::mutex> guard{m_control};
+      m_flush_completed = requested;
+      m_flushed.notify_all();
+    }
+
+    if (stop)
+    {
+      return;
+    }
+
+    if (!drained)
+    {
+      std::unique_lock<std::mutex> lock{m_control};
+      m_wake.wait_for(lock, poll_interval, [this, requested, pending]() {
+        return m_stop || m_flush_requested != requested || m_pending != pending;
+      });
+    }
+  }
+}
+
+template <typename LoggerType> void Feller::AsyncLogger<LoggerType>::flush()
+{
+  std::unique_lock<std::mutex> lock{m_control};
+  if (m_stop)
+  {
+    return;
+  }
+
+  const auto target = ++m_flush_requested;
+  m_wake.notify_one();
+  m_flushed.wait(lock, [this, target]() { return m_flush_completed >= target; });
+}
+
+template <typename LoggerType> void Feller::AsyncLogger<LoggerType>::shutdown()
+{
+  {
+    std::lock_guard<std::mutex> guard{m_control};
+    if (m_stop)
+    {
+      return;
+    }
+    // Producers check m_stopped under their queue's lock: since the background thread only sees
+    // m_stop after this store, every log is either drained below or counted as dropped.
+    m_stopped.store(true, std::memory_order_relaxed);
+    m_stop = true;
+  }
+
+  m_wake.notify_one();
+  m_worker.join();
+
+  // Any producer still blocked on a full queue must be released: its log is counted as dropped.
+  std::lock_guard<std::mutex> guard{m_registry};
+  for (auto &queue : m_queues)
+  {
+    std::lock_guard<std::mutex> queue_guard{queue->mutex};
+    queue->not_full.notify_all();
+  }
+}
+
+template <typename LoggerType>
+inline void Feller::AsyncLogger<LoggerType>::switchMode(const Feller::LoggingMode mode) noexcept
+{
+  m_logger.switchMode(mode);
+}
+
+template <typename LoggerType>
+inline auto Feller::AsyncLogger<LoggerType>::dropped() const noexcept -> size_type
+{
+  return m_dropped.load(std::memory_order_relaxed);
+}
+
+template <typename LoggerType>
+inline auto Feller::AsyncLogger<LoggerType>::nr_producers() const -> size_type
+{
+  std::lock_guard<std::mutex> guard{m_registry};
+  return m_queues.size();
+}
+
+template <typename LoggerType> inline LoggerType &Feller::AsyncLogger<LoggerType>::logger() noexcept
+{
+  return m_logger;
+}
+
+template <typename LoggerType>
+inline const LoggerType &Feller::AsyncLogger<LoggerType>::logger() const noexcept
+{
+  return m_logger;
+}
+
+}  // namespace Feller
+
+#endif
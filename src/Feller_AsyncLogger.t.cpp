@@ -0,0 +1,307 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_AsyncLogger.hpp"
+#include "Feller_AtomicConditionalLoggingPolicy.hpp"
+#include "Feller_ContiguousLogStorage.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_MutexLock.hpp"
+#include "Feller_TestLogs.hpp"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <future>
+#include <thread>
+
+using LoggerType = Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage,
+                                  Feller::MutexLock, Feller::AtomicConditionalLoggingPolicy>;
+using AsyncType  = Feller::AsyncLogger<LoggerType>;
+
+// This sink blocks the background thread on the first log until it is released. This lets
+// us fill a producer's queue deterministically.
+struct GatedSink
+{
+  std::promise<void> entered{};
+  std::promise<void> release{};
+  std::shared_future<void> released{release.get_future().share()};
+  bool first{true};
+
+  AsyncType::sink_type sink()
+  {
+    return [this](const Feller::EventLog &) {
+      if (first)
+      {
+        first = false;
+        entered.set_value();
+        released.wait();
+      }
+    };
+  }
+};
+
+TEST(AsyncLogger, testInsertAndFlush)
+{
+  AsyncType logger;
+  const auto size = static_cast<unsigned>(rand()) % 4096;
+  for (unsigned i = 0; i < size; i++)
+  {
+    logger.insert(numbered(i));
+  }
+
+  logger.flush();
+  ASSERT_EQ(logger.logger().size(), size);
+  unsigned curr = 0;
+  for (const auto &v : logger.logger())
+  {
+    EXPECT_EQ(v.name(), std::to_string(curr++));
+  }
+  EXPECT_EQ(logger.dropped(), 0);
+}
+
+TEST(AsyncLogger, testManyProducers)
+{
+  constexpr unsigned nr_threads = 4;
+  constexpr unsigned per_thread = 2000;
+  AsyncType logger{16};
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < nr_threads; t++)
+  {
+    threads.emplace_back([&logger, t]() {
+      for (unsigned i = 0; i < per_thread; i++)
+      {
+        Feller::EventLog log{numbered(t)};
+        log.emplace_back("i", std::to_string(i));
+        logger.insert(std::move(log));
+      }
+    });
+  }
+
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  logger.flush();
+  ASSERT_EQ(logger.logger().size(), nr_threads * per_thread);
+  EXPECT_EQ(logger.dropped(), 0);
+
+  // Each producer's logs must arrive in order.
+  std::vector<unsigned> next(nr_threads, 0);
+  for (const auto &v : logger.logger())
+  {
+    const auto t = std::stoul(v.name());
+    EXPECT_EQ(v.cbegin()->second, std::to_string(next[t]++));
+  }
+}
+
+TEST(AsyncLogger, testFiltering)
+{
+  AsyncType logger;
+  logger.switchMode(Feller::LoggingMode::IMPORTANT);
+  logger.insert(Feller::EventLog{"Rejected"}, Feller::LoggingMode::EVERYTHING);
+  logger.insert(Feller::EventLog{"Accepted"}, Feller::LoggingMode::IMPORTANT);
+  logger.flush();
+  EXPECT_EQ(names(logger.logger()), std::vector<std::string>{"Accepted"});
+}
+
+TEST(AsyncLogger, testSwitchModeAfterQueue)
+{
+  std::vector<std::string> seen;
+  GatedSink gate;
+  const auto gated = gate.sink();
+  AsyncType logger{8, Feller::Backpressure::BLOCK, [&](const Feller::EventLog &log) {
+                     gated(log);
+                     seen.push_back(log.name());
+                   }};
+
+  logger.insert(Feller::EventLog{"0"});
+  gate.entered.get_future().wait();
+  logger.insert(numbered(1));
+  logger.insert(numbered(2));
+
+  // Logs that were queued before the switch have already been accepted.
+  logger.switchMode(Feller::LoggingMode::NOTHING);
+  logger.insert(numbered(3));
+  gate.release.set_value();
+  logger.flush();
+
+  const std::vector<std::string> expected{"0", "1", "2"};
+  EXPECT_EQ(seen, expected);
+  EXPECT_EQ(names(logger.logger()), expected);
+  EXPECT_EQ(logger.dropped(), 0);
+}
+
+TEST(AsyncLogger, testDropNewest)
+{
+  GatedSink gate;
+  AsyncType logger{4, Feller::Backpressure::DROP_NEWEST, gate.sink()};
+
+  // The first log is taken by the background thread, which then blocks in the sink.
+  logger.insert(Feller::EventLog{"0"});
+  gate.entered.get_future().wait();
+
+  for (unsigned i = 1; i <= 6; i++)
+  {
+    logger.insert(numbered(i));
+  }
+  EXPECT_EQ(logger.dropped(), 2);
+
+  gate.release.set_value();
+  logger.flush();
+  const std::vector<std::string> expected{"0", "1", "2", "3", "4"};
+  EXPECT_EQ(names(logger.logger()), expected);
+}
+
+TEST(AsyncLogger, testOverwriteOldest)
+{
+  GatedSink gate;
+  AsyncType logger{4, Feller::Backpressure::OVERWRITE_OLDEST, gate.sink()};
+
+  logger.insert(Feller::EventLog{"0"});
+  gate.entered.get_future().wait();
+
+  for (unsigned i = 1; i <= 6; i++)
+  {
+    logger.insert(numbered(i));
+  }
+  EXPECT_EQ(logger.dropped(), 2);
+
+  gate.release.set_value();
+  logger.flush();
+  const std::vector<std::string> expected{"0", "3", "4", "5", "6"};
+  EXPECT_EQ(names(logger.logger()), expected);
+}
+
+TEST(AsyncLogger, testBlock)
+{
+  GatedSink gate;
+  AsyncType logger{4, Feller::Backpressure::BLOCK, gate.sink()};
+
+  logger.insert(Feller::EventLog{"0"});
+  gate.entered.get_future().wait();
+
+  // The producer fills the queue and then blocks until the sink is released.
+  std::atomic<unsigned> inserted{0};
+  std::thread producer([&logger, &inserted]() {
+    for (unsigned i = 1; i <= 6; i++)
+    {
+      logger.insert(numbered(i));
+      inserted.fetch_add(1);
+    }
+  });
+
+  // Once the queue is full the producer cannot make progress, so the short wait below can let a
+  // broken BLOCK policy slip through but can never fail a working one.
+  while (inserted.load() < 4)
+  {
+    std::this_thread::yield();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  EXPECT_EQ(inserted.load(), 4);
+  EXPECT_EQ(logger.dropped(), 0);
+
+  gate.release.set_value();
+  producer.join();
+  logger.flush();
+  EXPECT_EQ(logger.dropped(), 0);
+  EXPECT_EQ(logger.logger().size(), 7);
+}
+
+TEST(AsyncLogger, testWakeLatency)
+{
+  // With a depth-1 blocking queue every insertion waits for the previous log to be drained, so
+  // this relies on each insertion waking the background thread. The cost of a round trip is
+  // measured in the benchmark rather than here, where timing bounds would be flaky.
+  constexpr unsigned nr_logs = 500;
+  AsyncType logger{1, Feller::Backpressure::BLOCK};
+  for (unsigned i = 0; i < nr_logs; i++)
+  {
+    logger.insert(numbered(i));
+  }
+  logger.flush();
+  EXPECT_EQ(logger.logger().size(), nr_logs);
+
+  logger.insert(numbered(nr_logs));
+  logger.flush();
+  EXPECT_EQ(logger.logger().size(), nr_logs + 1);
+  EXPECT_EQ(logger.dropped(), 0);
+}
+
+TEST(AsyncLogger, testAlternatingLoggers)
+{
+  // A thread that switches between loggers keeps using its existing queue in each.
+  AsyncType first;
+  AsyncType second;
+  for (unsigned i = 0; i < 200; i++)
+  {
+    first.insert(numbered(i));
+    second.insert(numbered(i));
+  }
+
+  std::thread other([&first]() { first.insert(numbered(0)); });
+  other.join();
+
+  first.flush();
+  second.flush();
+  EXPECT_EQ(first.nr_producers(), 2);
+  EXPECT_EQ(second.nr_producers(), 1);
+  EXPECT_EQ(first.logger().size(), 201);
+  EXPECT_EQ(second.logger().size(), 200);
+}
+
+TEST(AsyncLogger, testSinkSeesEveryLog)
+{
+  std::vector<std::string> seen;
+  AsyncType logger{8, Feller::Backpressure::BLOCK,
+                   [&seen](const Feller::EventLog &log) { seen.push_back(log.name()); }};
+  for (unsigned i = 0; i < 100; i++)
+  {
+    logger.insert(numbered(i));
+  }
+
+  logger.flush();
+  EXPECT_EQ(seen, names(logger.logger()));
+  EXPECT_EQ(seen.size(), 100);
+}
+
+TEST(AsyncLogger, testShutdownDrains)
+{
+  unsigned seen = 0;
+  {
+    AsyncType logger{8, Feller::Backpressure::BLOCK, [&seen](const Feller::EventLog &) { ++seen; }};
+    for (unsigned i = 0; i < 100; i++)
+    {
+      logger.insert(Feller::EventLog{"Test"});
+    }
+  }
+  EXPECT_EQ(seen, 100);
+}
+
+TEST(AsyncLogger, testInsertAfterShutdown)
+{
+  AsyncType logger;
+  logger.insert(Feller::EventLog{"Before"});
+  logger.shutdown();
+  logger.insert(Feller::EventLog{"After"});
+  logger.flush();
+  logger.shutdown();
+  EXPECT_EQ(names(logger.logger()), std::vector<std::string>{"Before"});
+  EXPECT_EQ(logger.dropped(), 1);
+}
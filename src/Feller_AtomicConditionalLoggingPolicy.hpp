@@ -0,0 +1,97 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#ifndef INCLUDED_FELLER_ATOMIC_CONDITIONAL_LOGGING_POLICY
+#define INCLUDED_FELLER_ATOMIC_CONDITIONAL_LOGGING_POLICY
+
+#include <atomic>
+#include <type_traits>
+
+#include "Feller_Feller.hpp"
+#include "Feller_LoggingMode.hpp"
+
+namespace Feller
+{
+/**
+   AtomicConditionalLoggingPolicy. This policy class provides the ability to decide what logs
+   should be collected at runtime, in the same way as \ref ConditionalLoggingPolicy. The difference
+   is that the mode is held atomically: this means that the mode can be switched by one thread
+   whilst other threads are logging, without any locking. This policy should be used in any
+   logger that is shared between threads.
+
+   Since \ref Logger checks the mode before taking its lock, the check uses a relaxed load: on
+   common platforms this is exactly as cheap as reading a plain variable. Switching the mode uses a
+   release store, so a thread that observes the new mode also observes anything written before
+   the switch.
+**/
+class AtomicConditionalLoggingPolicy
+{
+private:
+  /**
+     mode. This specifies the current logging mode. The way to read this mode is the following:
+     any logging request that is less than or equal to the current mode is selected, with anything
+  above it rejected.
+  **/
+  std::atomic<Feller::LoggingMode> m_mode{Feller::LoggingMode::EVERYTHING};
+
+public:
+  /**
+     shouldLog. This method returns true if `mode =< m_mode` and false otherwise.
+     This allows the caller to know if logging should occur. This method is safe to call
+     concurrently with switchMode.
+     The result is undefined if mode == LoggingMode::SIZE.
+     \param mode: the type of logging request.
+     \return true if logging should occur, false otherwise.
+  **/
+  inline bool shouldLog(const Feller::LoggingMode mode) const noexcept;
+
+  /**
+     switchMode. This method switches the mode of the logger to `mode`. This method
+     can be used to adjust the granularity of the logger whilst other threads are logging.
+   **/
+  inline void switchMode(const Feller::LoggingMode mode) noexcept;
+
+  /**
+     mode. This method returns the logging mode of this logger.
+     \return the logging mode of this logger.
+   **/
+  inline Feller::LoggingMode mode() const noexcept;
+};
+
+/// INLINE METHODS
+inline bool AtomicConditionalLoggingPolicy::shouldLog(const Feller::LoggingMode mode) const noexcept
+{
+  const auto current = m_mode.load(std::memory_order_relaxed);
+  return (current != Feller::LoggingMode::NOTHING) &&
+         static_cast<std::underlying_type<Feller::LoggingMode>::type>(mode) <=
+             static_cast<std::underlying_type<Feller::LoggingMode>::type>(current);
+}
+
+inline void AtomicConditionalLoggingPolicy::switchMode(const Feller::LoggingMode mode) noexcept
+{
+  m_mode.store(mode, std::memory_order_release);
+}
+
+inline Feller::LoggingMode AtomicConditionalLoggingPolicy::mode() const noexcept
+{
+  return m_mode.load(std::memory_order_acquire);
+}
+}  // namespace Feller
+
+#endif
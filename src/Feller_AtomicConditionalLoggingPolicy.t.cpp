@@ -0,0 +1,123 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "Feller_AtomicConditionalLoggingPolicy.hpp"
+#include "Feller_Decl.hpp"
+#include "Feller_ContiguousLogStorage.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_LoggingMode.hpp"
+#include "Feller_MutexLock.hpp"
+#include "Feller_NoLock.hpp"
+#include "Feller_RingBufferLogStorage.hpp"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+
+TEST(AtomicConditionalLoggingPolicy, testInit)
+{
+  Feller::AtomicConditionalLoggingPolicy policy{};
+  EXPECT_EQ(policy.mode(), Feller::LoggingMode::EVERYTHING);
+}
+
+TEST(AtomicConditionalLoggingPolicy, testShouldLog)
+{
+  Feller::AtomicConditionalLoggingPolicy policy{};
+  const auto size = static_cast<unsigned>(Feller::LoggingMode::SIZE);
+
+  for (unsigned i = 0; i < size; i++)
+  {
+    const auto level = static_cast<Feller::LoggingMode>(i);
+    policy.switchMode(level);
+    for (unsigned j = 0; j < size; j++)
+    {
+      EXPECT_EQ(policy.shouldLog(static_cast<Feller::LoggingMode>(j)), (i != 0 & j <= i));
+    }
+  }
+}
+
+TEST(AtomicConditionalLoggingPolicy, testSwitchMode)
+{
+  Feller::AtomicConditionalLoggingPolicy policy{};
+  const auto size = static_cast<unsigned>(Feller::LoggingMode::SIZE);
+  for (unsigned i = 0; i < size; i++)
+  {
+    const auto level = static_cast<Feller::LoggingMode>(i);
+    policy.switchMode(level);
+    EXPECT_EQ(policy.mode(), level);
+  }
+}
+
+// This test is designed to be run under ThreadSanitizer: several threads insert into
+// a logger whilst another thread repeatedly switches the mode. Any data race on the mode
+// will be reported by TSan.
+template <typename LoggerType> void stress_switch_mode(LoggerType &logger)
+{
+  constexpr unsigned nr_threads = 4;
+  constexpr unsigned per_thread = 2000;
+  std::atomic<bool> done{false};
+
+  std::thread switcher([&logger, &done]() {
+    unsigned i = 0;
+    while (!done.load())
+    {
+      logger.switchMode(static_cast<Feller::LoggingMode>(i++ % 3));
+    }
+  });
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < nr_threads; t++)
+  {
+    threads.emplace_back([&logger]() {
+      for (unsigned i = 0; i < per_thread; i++)
+      {
+        logger.insert(Feller::EventLog{"Test"}, Feller::LoggingMode::IMPORTANT);
+      }
+    });
+  }
+
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  done.store(true);
+  switcher.join();
+
+  // Whatever the interleaving, we can never have more logs than were inserted.
+  const auto size = logger.size();
+  EXPECT_EQ(size <= nr_threads * per_thread, true);
+  for (const auto &v : logger)
+  {
+    EXPECT_EQ(v.name(), "Test");
+  }
+}
+
+TEST(AtomicConditionalLoggingPolicy, testSwitchWhilstLoggingMutex)
+{
+  Feller::MultiThreadedEventLogger logger;
+  stress_switch_mode(logger);
+}
+
+TEST(AtomicConditionalLoggingPolicy, testSwitchWhilstLoggingLockFree)
+{
+  Feller::MultiThreadedLockFreeEventLogger logger;
+  stress_switch_mode(logger);
+}
@@ -0,0 +1,53 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_AuxData.hpp"
+
+Feller::AuxData::AuxData(const AuxData &other)
+{
+  if (other.is_inline())
+  {
+    m_ptr = other.m_ops->copy(*other.m_ptr, m_buffer);
+    m_ops = other.m_ops;
+  }
+  else if (other.m_ptr != nullptr)
+  {
+    m_ptr = other.m_ptr->copy().release();
+  }
+}
+
+auto Feller::AuxData::operator=(const AuxData &other) -> AuxData &
+{
+  if (this != &other)
+  {
+    // The copy is made first, so that this holder is unchanged if the copy throws.
+    AuxData copy{other};
+    *this = std::move(copy);
+  }
+  return *this;
+}
+
+auto Feller::AuxData::operator=(AuxData &&other) noexcept -> AuxData &
+{
+  if (this != &other)
+  {
+    reset();
+    take(other);
+  }
+  return *this;
+}
@@ -0,0 +1,293 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_AUX_DATA
+#define INCLUDED_FELLER_AUX_DATA
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Feller_Feller.hpp"
+
+#include "Feller_Data.hpp"
+#include "Feller_DataArena.hpp"
+
+namespace Feller
+{
+/**
+ AuxData. This class holds the auxiliary \ref Data of a log. It behaves like a
+`std::unique_ptr<Data>` (it may be empty, compared with nullptr, dereferenced, and assigned from
+a `std::unique_ptr`), but small data is stored inline, inside this object, rather than on the heap.
+
+ Data built via `emplace` is stored inline if it fits in `inline_size` bytes and can be moved
+without throwing. Copying inline data calls the copy constructor of its type directly, so it
+neither allocates nor calls the virtual \ref Data::copy. Larger types, and data adopted from a
+`std::unique_ptr`, are held on the heap and are copied via \ref Data::copy, exactly as before.
+Data allocated from a \ref DataArena is referenced but not owned: the arena destroys it on release,
+and copying it copies it to the heap.
+
+ Note that moving an object of this class moves inline data into the new object, so (unlike with
+a `std::unique_ptr`) the address of inline data changes when its holder is moved.
+**/
+class AuxData
+{
+public:
+  /**
+     inline_size. This is the largest data type that may be stored inline. Every log holds an
+  object of this class, whether or not it has any auxiliary data, so this is kept to two
+  pointers: enough for the vtable pointer of a \ref Data plus a pointer or a word of payload
+  (e.g a counter or a handle). This keeps an object of this class to four pointers in all.
+  **/
+  static constexpr std::size_t inline_size = 2 * sizeof(void *);
+
+  /**
+     inline_align. This is the strictest alignment of a data type that may be stored inline.
+  **/
+  static constexpr std::size_t inline_align = alignof(void *);
+
+  /**
+     fits_inline. This is true if data of type `T` is stored inline by `emplace`.
+  **/
+  template <typename T>
+  static constexpr bool fits_inline = sizeof(T) <= inline_size && alignof(T) <= inline_align &&
+                                      std::is_nothrow_move_constructible_v<T>;
+
+  /**
+     AuxData. This constructor builds an empty holder.
+  **/
+  AuxData() noexcept {}
+  AuxData(std::nullptr_t) noexcept {}
+
+  /**
+     AuxData. This constructor takes ownership of heap allocated data. This allows a
+  `std::unique_ptr` to be assigned to a holder.
+     \param data: the data to be held.
+  **/
+  template <typename T, std::enable_if_t<std::is_base_of_v<Data, T>, int> = 0>
+  AuxData(std::unique_ptr<T> data) noexcept : m_ptr{data.release()}
+  {
+  }
+
+  /**
+     AuxData. This constructor refers to data allocated from a \ref DataArena. This allows the
+  result of \ref DataArena::make to be assigned to a holder. The data is not destroyed by this
+  holder.
+     \param data: the data to be held.
+  **/
+  template <typename T, std::enable_if_t<std::is_base_of_v<Data, T>, int> = 0>
+  AuxData(arena_ptr<T> data) noexcept : m_ptr{data.release()}, m_ops{&arena_ops}
+  {
+  }
+
+  /**
+     AuxData. This is the copy constructor for this class. Inline data is copy constructed in
+  place. Heap data is copied via \ref Data::copy. This constructor may throw if the copy throws.
+     \param other: the holder to be copied.
+  **/
+  AuxData(const AuxData &other);
+
+  /**
+     AuxData. This is the move constructor for this class. This does not allocate or throw.
+     \param other: the holder to be moved from. This is left empty.
+  **/
+  AuxData(AuxData &&other) noexcept { take(other); }
+
+  /// Assignment operators. These follow the same rules as the constructors above.
+  AuxData &operator=(const AuxData &other);
+  AuxData &operator=(AuxData &&other) noexcept;
+
+  /**
+     ~AuxData. This destroys the held data, if any.
+  **/
+  ~AuxData() { reset(); }
+
+  /**
+     emplace. This method replaces the held data with a `T` built from `args`. The new data is
+  stored inline if `fits_inline<T>` is true, and on the heap otherwise. This method may throw if
+  the constructor of `T` throws, or due to allocation failures: in this case the holder is empty.
+     \tparam T: the type of data to be built. This must derive from \ref Data.
+     \param args: the arguments to be forwarded to the constructor of `T`.
+     \return a reference to the new data.
+  **/
+  template <typename T, typename... Args> inline T &emplace(Args &&...args);
+
+  /**
+     reset. This method destroys the held data, if any, leaving this holder empty.
+  **/
+  inline void reset() noexcept;
+
+  /**
+     is_inline. This method returns true if the held data is stored inside this object.
+     \return true if the held data is inline, false if it is on the heap or there is no data.
+  **/
+  inline bool is_inline() const noexcept { return m_ops != nullptr && m_ops != &arena_ops; }
+
+  /**
+     is_arena. This method returns true if the held data was allocated from a \ref DataArena.
+     \return true if the held data is in an arena, false otherwise.
+  **/
+  inline bool is_arena() const noexcept { return m_ops == &arena_ops; }
+
+  /// Pointer-like access to the held data. These behave as the std::unique_ptr methods.
+  inline Data *get() const noexcept { return m_ptr; }
+  inline Data *operator->() const noexcept { return m_ptr; }
+  inline Data &operator*() const noexcept { return *m_ptr; }
+  inline explicit operator bool() const noexcept { return m_ptr != nullptr; }
+
+  /// Comparisons. As with std::unique_ptr, these compare the address of the held data.
+  inline friend bool operator==(const AuxData &lhs, const AuxData &rhs) noexcept
+  {
+    return lhs.m_ptr == rhs.m_ptr;
+  }
+  inline friend bool operator!=(const AuxData &lhs, const AuxData &rhs) noexcept
+  {
+    return lhs.m_ptr != rhs.m_ptr;
+  }
+  inline friend bool operator==(const AuxData &lhs, std::nullptr_t) noexcept
+  {
+    return lhs.m_ptr == nullptr;
+  }
+  inline friend bool operator==(std::nullptr_t, const AuxData &rhs) noexcept
+  {
+    return rhs.m_ptr == nullptr;
+  }
+  inline friend bool operator!=(const AuxData &lhs, std::nullptr_t) noexcept
+  {
+    return lhs.m_ptr != nullptr;
+  }
+  inline friend bool operator!=(std::nullptr_t, const AuxData &rhs) noexcept
+  {
+    return rhs.m_ptr != nullptr;
+  }
+
+private:
+  /**
+     Ops. This struct holds the operations needed to copy and move inline data of a single type.
+  Each returns the address of the new data, as a Data pointer.
+  **/
+  struct Ops
+  {
+    Data *(*copy)(const Data &from, void *buffer);
+    Data *(*move)(Data &from, void *buffer) noexcept;
+  };
+
+  /**
+     InlineOps. This struct provides the operations for inline data of type `T`.
+  **/
+  template <typename T> struct InlineOps
+  {
+    static Data *copy(const Data &from, void *const buffer)
+    {
+      return ::new (buffer) T(static_cast<const T &>(from));
+    }
+    static Data *move(Data &from, void *const buffer) noexcept
+    {
+      return ::new (buffer) T(std::move(static_cast<T &>(from)));
+    }
+    static constexpr Ops ops{&copy, &move};
+  };
+
+  /**
+     arena_ops. This marks data that is owned by a \ref DataArena. Its address is all that
+  matters: none of its operations are ever called.
+  **/
+  static constexpr Ops arena_ops{nullptr, nullptr};
+
+  /**
+     take. This method moves the data held by `other` into this (empty) holder.
+  **/
+  inline void take(AuxData &other) noexcept;
+
+  /**
+     m_ptr. This points to the held data, which is either in m_buffer or on the heap.
+  **/
+  Data *m_ptr{nullptr};
+
+  /**
+     m_ops. This is the table of operations for inline data, &arena_ops for arena data, and
+  nullptr otherwise.
+  **/
+  const Ops *m_ops{nullptr};
+
+  /**
+     m_buffer. This holds inline data.
+  **/
+  alignas(inline_align) unsigned char m_buffer[inline_size];
+};
+
+/// INLINE FUNCTIONS
+inline void AuxData::reset() noexcept
+{
+  if (m_ops == &arena_ops)
+  {
+    // The arena destroys its own data.
+  }
+  else if (m_ops != nullptr)
+  {
+    m_ptr->~Data();
+  }
+  else
+  {
+    delete m_ptr;
+  }
+
+  m_ptr = nullptr;
+  m_ops = nullptr;
+}
+
+inline void AuxData::take(AuxData &other) noexcept
+{
+  if (other.m_ops != nullptr && other.m_ops != &arena_ops)
+  {
+    m_ptr = other.m_ops->move(*other.m_ptr, m_buffer);
+    m_ops = other.m_ops;
+    other.reset();
+  }
+  else
+  {
+    m_ptr = std::exchange(other.m_ptr, nullptr);
+    m_ops = std::exchange(other.m_ops, nullptr);
+  }
+}
+
+template <typename T, typename... Args> inline T &AuxData::emplace(Args &&...args)
+{
+  static_assert(std::is_base_of_v<Data, T>, "Error: AuxData can only hold types of Data");
+  reset();
+
+  if constexpr (fits_inline<T>)
+  {
+    auto *const data = ::new (static_cast<void *>(m_buffer)) T(std::forward<Args>(args)...);
+    m_ptr            = data;
+    m_ops            = &InlineOps<T>::ops;
+    return *data;
+  }
+  else
+  {
+    auto *const data = new T(std::forward<Args>(args)...);
+    m_ptr            = data;
+    return *data;
+  }
+}
+
+}  // namespace Feller
+
+#endif
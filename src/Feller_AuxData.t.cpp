@@ -0,0 +1,167 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_AllocationCounter.hpp"
+#include "Feller_AuxData.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_TestData.hpp"
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <string>
+
+// This counts live objects, so that we can check that every copy is destroyed.
+static int nr_live = 0;
+
+struct Counted : public Feller::Data
+{
+  explicit Counted(const int v) : value{v} { ++nr_live; }
+  Counted(const Counted &other) noexcept : value{other.value} { ++nr_live; }
+  ~Counted() override { --nr_live; }
+  bool operator==(const Data &other) const noexcept override
+  {
+    const auto *const counted = dynamic_cast<const Counted *>(&other);
+    return counted != nullptr && counted->value == value;
+  }
+  std::string to_string() const override { return std::to_string(value); }
+  std::unique_ptr<Data> copy() const override { return std::make_unique<Counted>(*this); }
+
+  int value;
+};
+
+// This is too large to be held inline.
+struct Large : public Counted
+{
+  using Counted::Counted;
+  std::unique_ptr<Data> copy() const override { return std::make_unique<Large>(*this); }
+  char padding[2 * Feller::AuxData::inline_size]{};
+};
+
+static_assert(Feller::AuxData::fits_inline<Feller::TestData>);
+static_assert(Feller::AuxData::fits_inline<Counted>);
+static_assert(!Feller::AuxData::fits_inline<Large>);
+// Logs without aux data pay for the holder, so it is kept to four pointers.
+static_assert(sizeof(Feller::AuxData) == 4 * sizeof(void *));
+
+TEST(AuxData, testEmpty)
+{
+  const Feller::AuxData aux;
+  EXPECT_EQ(aux, nullptr);
+  EXPECT_FALSE(aux);
+  EXPECT_FALSE(aux.is_inline());
+  EXPECT_EQ(aux.get(), nullptr);
+}
+
+TEST(AuxData, testEmplaceInline)
+{
+  {
+    Feller::AuxData aux;
+    const auto before = nr_allocations;
+    auto &data        = aux.emplace<Counted>(3);
+    EXPECT_EQ(nr_allocations, before);
+    EXPECT_TRUE(aux.is_inline());
+    EXPECT_NE(aux, nullptr);
+    EXPECT_EQ(aux.get(), &data);
+    EXPECT_EQ(aux->to_string(), "3");
+    EXPECT_EQ(nr_live, 1);
+  }
+  EXPECT_EQ(nr_live, 0);
+}
+
+TEST(AuxData, testCopyInlineDoesNotAllocate)
+{
+  Feller::AuxData aux;
+  aux.emplace<Counted>(7);
+
+  const auto before = nr_allocations;
+  Feller::AuxData copy{aux};
+  Feller::AuxData assigned;
+  assigned = copy;
+  EXPECT_EQ(nr_allocations, before);
+
+  EXPECT_TRUE(copy.is_inline());
+  EXPECT_NE(copy.get(), aux.get());
+  EXPECT_TRUE(*copy == *aux);
+  EXPECT_TRUE(*assigned == *aux);
+  EXPECT_EQ(nr_live, 3);
+}
+
+TEST(AuxData, testMoveInline)
+{
+  Feller::AuxData aux;
+  aux.emplace<Counted>(9);
+  Feller::AuxData moved{std::move(aux)};
+  EXPECT_EQ(aux, nullptr);
+  EXPECT_TRUE(moved.is_inline());
+  EXPECT_EQ(moved->to_string(), "9");
+
+  aux = std::move(moved);
+  EXPECT_EQ(moved, nullptr);
+  EXPECT_EQ(aux->to_string(), "9");
+  EXPECT_EQ(nr_live, 1);
+
+  aux.reset();
+  EXPECT_EQ(aux, nullptr);
+  EXPECT_EQ(nr_live, 0);
+}
+
+TEST(AuxData, testHeap)
+{
+  {
+    Feller::AuxData aux;
+    aux.emplace<Large>(1);
+    EXPECT_FALSE(aux.is_inline());
+
+    // Heap data is copied via Data::copy, and moving keeps the same object.
+    const Feller::AuxData copy{aux};
+    EXPECT_FALSE(copy.is_inline());
+    EXPECT_TRUE(*copy == *aux);
+
+    auto *const data = aux.get();
+    const Feller::AuxData moved{std::move(aux)};
+    EXPECT_EQ(moved.get(), data);
+    EXPECT_EQ(nr_live, 2);
+  }
+  EXPECT_EQ(nr_live, 0);
+}
+
+TEST(AuxData, testAdoptUniquePtr)
+{
+  Feller::AuxData aux;
+  auto data        = std::make_unique<Counted>(5);
+  auto *const ptr  = data.get();
+  aux              = std::move(data);
+  EXPECT_EQ(aux.get(), ptr);
+  EXPECT_FALSE(aux.is_inline());
+
+  aux = nullptr;
+  EXPECT_EQ(aux, nullptr);
+  EXPECT_EQ(nr_live, 0);
+}
+
+TEST(AuxData, testEventLogCopyDoesNotAllocate)
+{
+  Feller::EventLog log{"With aux"};
+  log.aux().emplace<Feller::TestData>();
+
+  const auto before = nr_allocations;
+  const Feller::EventLog copy{log};
+  EXPECT_EQ(nr_allocations, before);
+  EXPECT_EQ(copy, log);
+  EXPECT_NE(copy.aux().get(), log.aux().get());
+}
@@ -0,0 +1,187 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_BinaryFormat.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+void Feller::Binary::put_header(std::string &out)
+{
+  out.append("FELR");
+  put_varint(out, binary_format_version);
+  put_varint(out, std::chrono::system_clock::period::num);
+  put_varint(out, std::chrono::system_clock::period::den);
+}
+
+void Feller::Binary::put_record(std::string &out, const EventLog &log, std::int64_t &previous,
+                                const EventLog::parameter_type *const first,
+                                const EventLog::parameter_type *const last)
+{
+  // We compute the difference in unsigned arithmetic so that it wraps rather than overflows.
+  const auto ticks = static_cast<std::uint64_t>(log.time().time_since_epoch().count());
+  const auto delta = static_cast<std::int64_t>(ticks - static_cast<std::uint64_t>(previous));
+  previous         = static_cast<std::int64_t>(ticks);
+
+  out.push_back(static_cast<char>(record_marker));
+  const auto put_string = [&out](const std::string &str) {
+    put_varint(out, str.size());
+    out.append(str);
+  };
+
+  put_string(log.name());
+  put_varint(out, zigzag(delta));
+  put_varint(out, static_cast<std::size_t>(last - first) + log.size());
+  const auto put_parameter = [&out, &put_string](const EventLog::parameter_type &parameter) {
+    put_string(parameter.first);
+    put_value(out, parameter.second);
+  };
+  std::for_each(first, last, put_parameter);
+  std::for_each(log.cbegin(), log.cend(), put_parameter);
+
+  if (log.aux() == nullptr)
+  {
+    out.push_back(0);
+  }
+  else
+  {
+    out.push_back(1);
+    put_string(log.aux()->to_string());
+  }
+}
+
+void Feller::Binary::put_value(std::string &out, const ParameterValue &value)
+{
+  const auto type = value.type();
+  out.push_back(static_cast<char>(type));
+  switch (type)
+  {
+  case ParameterValue::Type::STRING:
+  {
+    const auto &str = *value.get_if<ParameterValue::string_type>();
+    put_varint(out, str.size());
+    out.append(str);
+    break;
+  }
+  case ParameterValue::Type::INTEGER:
+    put_varint(out, zigzag(*value.get_if<std::int64_t>()));
+    break;
+  case ParameterValue::Type::UNSIGNED:
+    put_varint(out, *value.get_if<std::uint64_t>());
+    break;
+  case ParameterValue::Type::DOUBLE:
+  {
+    std::uint64_t bits;
+    std::memcpy(&bits, value.get_if<double>(), sizeof(bits));
+    for (unsigned i = 0; i < 8; i++)
+    {
+      out.push_back(static_cast<char>(bits >> (8 * i)));
+    }
+    break;
+  }
+  case ParameterValue::Type::BOOLEAN:
+    out.push_back(*value.get_if<bool>() ? 1 : 0);
+    break;
+  case ParameterValue::Type::DURATION:
+    put_varint(out, zigzag(value.get_if<ParameterValue::duration>()->count()));
+    break;
+  }
+}
+
+Feller::BinaryWriter::BinaryWriter(std::ostream &os) : m_os{os}
+{
+  m_buffer.reserve(buffer_size + buffer_size / 4);
+  Binary::put_header(m_buffer);
+}
+
+Feller::BinaryWriter::~BinaryWriter() { flush(); }
+
+void Feller::BinaryWriter::write(const EventLog &log)
+{
+  Binary::put_record(m_buffer, log, m_previous);
+  if (m_buffer.size() >= buffer_size)
+  {
+    m_os.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_buffer.clear();
+  }
+}
+
+void Feller::BinaryWriter::write(const ThreadEventLog &log)
+{
+  const auto parameters = log.thread_parameters();
+  Binary::put_record(m_buffer, log, m_previous, parameters.data(),
+                     parameters.data() + parameters.size());
+  if (m_buffer.size() >= buffer_size)
+  {
+    m_os.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_buffer.clear();
+  }
+}
+
+bool Feller::BinaryWriter::flush()
+{
+  m_os.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+  m_buffer.clear();
+  m_os.flush();
+  return m_os.good();
+}
+
+Feller::BinaryReader::BinaryReader(std::istream &is, aux_decoder decoder)
+    : m_source{is, std::vector<char>(buffer_size)}, m_decoder{std::move(decoder)}
+{
+  m_error = !Binary::get_header(m_source);
+}
+
+bool Feller::BinaryReader::StreamSource::fill()
+{
+  is.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  pos = 0;
+  end = static_cast<std::size_t>(is.gcount());
+  return end != 0;
+}
+
+bool Feller::BinaryReader::StreamSource::get_bytes(std::string &out, const std::uint64_t size)
+{
+  out.clear();
+  while (out.size() < size)
+  {
+    if (pos == end && !fill())
+    {
+      return false;
+    }
+
+    const auto chunk = std::min<std::uint64_t>(size - out.size(), end - pos);
+    out.append(buffer.data() + pos, chunk);
+    pos += chunk;
+  }
+  return true;
+}
+
+bool Feller::BinaryReader::read(EventLog &log)
+{
+  // The stream may only end cleanly on a record boundary.
+  unsigned char marker;
+  if (m_error || !m_source.get_byte(marker) || marker == Binary::end_marker)
+  {
+    return false;
+  }
+
+  m_error = marker != Binary::record_marker ||
+            !Binary::get_record(m_source, log, m_previous, m_decoder);
+  return !m_error;
+}
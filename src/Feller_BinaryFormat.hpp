@@ -0,0 +1,664 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_BINARY_FORMAT
+#define INCLUDED_FELLER_BINARY_FORMAT
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Feller_Feller.hpp"
+
+#include "Feller_Data.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_ParameterValue.hpp"
+#include "Feller_ThreadInfo.hpp"
+
+namespace Feller
+{
+
+/**
+ \brief The purpose of this component is to provide a compact binary encoding for \ref EventLog.
+
+ Binary format. Every stream starts with a header, which is followed by zero or more records.
+Every integer in the stream is written as an unsigned LEB128 varint (i.e 7 bits per byte, with the
+high bit set on every byte but the last). Strings are written as a varint length followed by the
+raw bytes.
+
+ The header is made up of the bytes "FELR", the format version and the numerator and denominator
+of the clock period used for timestamps. Each record is laid out as follows:
+
+ - the byte `record_marker`.
+ - the name of the log.
+ - the creation time of the log, as the (zigzag encoded) difference in clock ticks from the
+   previous record in the stream. The first record is relative to the epoch.
+ - the number of parameters, followed by each key and value. Each value is written as a single
+   byte holding its \ref ParameterValue::Type, followed by the value itself: strings as strings,
+   signed integers and durations (in nanoseconds) as zigzag varints, unsigned integers as varints,
+   doubles as their 8-byte IEEE-754 representation (least significant byte first) and booleans as
+   a single byte.
+ - a single byte that is 1 if auxiliary data is present and 0 otherwise. If present, this is
+   followed by the string representation of the data (see \ref Data::to_string).
+
+ Since \ref Data is polymorphic, the reader cannot rebuild the auxiliary data on its own: instead,
+callers may supply a decoder that turns the stored string back into a \ref Data object.
+
+ A stream ends either at the end of the input or at an `end_marker` byte where a record would
+start. Since `end_marker` is zero, a writer that grows its output in advance (such as \ref
+MappedLogStorage) leaves a valid stream behind even if it never trims the zero padding.
+**/
+
+/**
+   binary_format_version. This is the version written by \ref BinaryWriter. \ref BinaryReader
+   rejects streams with any other version.
+**/
+constexpr std::uint64_t binary_format_version = 3;
+
+namespace Binary
+{
+/**
+   record_marker. This byte starts every record.
+**/
+constexpr unsigned char record_marker = 1;
+
+/**
+   end_marker. This byte marks the end of the stream.
+**/
+constexpr unsigned char end_marker = 0;
+
+/**
+   aux_decoder. This type is used to rebuild auxiliary data from its stored string.
+**/
+using aux_decoder = std::function<std::unique_ptr<Data>(const std::string &)>;
+
+/**
+   put_varint. This function appends `value` to `out` as a varint. This function may throw due to
+   allocation failures.
+   \param out: the buffer to append to.
+   \param value: the value to be appended.
+**/
+inline void put_varint(std::string &out, std::uint64_t value);
+
+/**
+   put_header. This function appends the stream header to `out`. This function may throw due to
+   allocation failures.
+   \param out: the buffer to append to.
+**/
+void put_header(std::string &out);
+
+/**
+   put_record. This function appends the encoding of `log` to `out`. This function may throw due
+   to allocation failures, or if the auxiliary data of `log` throws whilst being converted to a
+   string.
+   \param out: the buffer to append to.
+   \param log: the log to be encoded.
+   \param previous: the timestamp of the previous record. This is updated to the time of `log`.
+   \param first: the first of any extra parameters, which are encoded before those of `log`.
+   \param last: one past the last extra parameter.
+**/
+void put_record(std::string &out, const EventLog &log, std::int64_t &previous,
+                const EventLog::parameter_type *first = nullptr,
+                const EventLog::parameter_type *last  = nullptr);
+
+/**
+   put_value. This function appends the encoding of a single parameter value to `out`. This
+   function may throw due to allocation failures.
+   \param out: the buffer to append to.
+   \param value: the value to be encoded.
+**/
+void put_value(std::string &out, const ParameterValue &value);
+
+/**
+ MemorySource. This struct reads bytes from a contiguous range of memory. This, along with the
+ private source inside \ref BinaryReader, is a model of a Source for the get_ functions below:
+ a Source provides `get_byte`, `get_bytes` and `at_end`.
+**/
+struct MemorySource
+{
+  /**
+     pos. This is the next byte to be read.
+  **/
+  const char *pos;
+
+  /**
+     end. This is one past the last byte that may be read.
+  **/
+  const char *end;
+
+  /**
+     get_byte. This method reads a single byte.
+     \param out: the location to store the byte.
+     \return true on success, false if the range is exhausted.
+  **/
+  inline bool get_byte(unsigned char &out) noexcept;
+
+  /**
+     get_bytes. This method reads `size` bytes into `out`, replacing its contents.
+     \param out: the location to store the bytes.
+     \param size: the number of bytes to read.
+     \return true on success, false if the range is too short.
+  **/
+  inline bool get_bytes(std::string &out, std::uint64_t size);
+
+  /**
+     at_end. This method returns true if there are no more bytes to read.
+  **/
+  inline bool at_end() const noexcept;
+};
+
+/**
+   get_varint. This function reads a single varint from `source`.
+   \param source: the source to read from.
+   \param out: the location to store the value.
+   \return true on success, false if the source ended or the varint is too long.
+**/
+template <typename Source> inline bool get_varint(Source &source, std::uint64_t &out);
+
+/**
+   get_string. This function reads a length-prefixed string from `source`.
+   \param source: the source to read from.
+   \param out: the location to store the string.
+   \return true on success, false if the source ended.
+**/
+template <typename Source> inline bool get_string(Source &source, std::string &out);
+
+/**
+   get_value. This function reads a single parameter value from `source`.
+   \param source: the source to read from.
+   \param out: the location to store the value.
+   \return true on success, false if the source ended or the type is unknown.
+**/
+template <typename Source> bool get_value(Source &source, ParameterValue &out);
+
+/**
+   get_header. This function reads a stream header from `source` and checks that it matches the
+   header written by put_header.
+   \param source: the source to read from.
+   \return true if the header is valid, false otherwise.
+**/
+template <typename Source> bool get_header(Source &source);
+
+/**
+   get_record. This function reads a single record from `source` into `log`, replacing its
+   contents. The record marker must already have been read. This function may throw due to
+   allocation failures, or if the decoder throws.
+   \param source: the source to read from.
+   \param log: the log to be overwritten. This is not modified if the record is malformed.
+   \param previous: the timestamp of the previous record. This is updated to the time of `log`.
+   \param decoder: the function used to rebuild auxiliary data. If this is empty then any
+   auxiliary data is skipped.
+   \return true on success, false if the record is malformed.
+**/
+template <typename Source>
+bool get_record(Source &source, EventLog &log, std::int64_t &previous,
+                const aux_decoder &decoder);
+
+/**
+   zigzag. This function maps signed values onto unsigned values so that values close to zero
+   (of either sign) produce short varints.
+**/
+constexpr std::uint64_t zigzag(const std::int64_t value) noexcept
+{
+  return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+/**
+   unzigzag. This function is the inverse of zigzag.
+**/
+constexpr std::int64_t unzigzag(const std::uint64_t value) noexcept
+{
+  return static_cast<std::int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+}  // namespace Binary
+
+/**
+ BinaryWriter. This class writes event logs to an output stream in the binary format described
+above. Records are encoded into an internal buffer which is written to the stream whenever it
+grows past `buffer_size` bytes, on `flush` and on destruction. This class does not own the
+stream.
+**/
+class BinaryWriter
+{
+public:
+  /**
+     buffer_size. This is the number of bytes that are buffered before writing to the stream.
+  **/
+  static constexpr std::size_t buffer_size = 1 << 16;
+
+  /**
+     BinaryWriter. This constructor writes the stream header into the buffer. This constructor
+  may throw due to allocation failures.
+     \param os: the stream to write to. This must outlive this object.
+  **/
+  explicit BinaryWriter(std::ostream &os);
+
+  // This class refers to a stream and to a position in its output, so copying makes no sense.
+  BinaryWriter(const BinaryWriter &)            = delete;
+  BinaryWriter &operator=(const BinaryWriter &) = delete;
+
+  /**
+     ~BinaryWriter. This destructor writes any buffered records to the stream.
+  **/
+  ~BinaryWriter();
+
+  /**
+     write. This method appends `log` to the stream. This method may throw due to allocation
+  failures, or if the auxiliary data of `log` throws whilst being converted to a string.
+     \param log: the log to be written.
+  **/
+  void write(const EventLog &log);
+
+  /**
+     write. This method appends `log` to the stream, with its thread and CPU encoded as the
+  parameters "thread_id" and "cpu" (see \ref ThreadEventLog). This method may throw due to
+  allocation failures, or if the auxiliary data of `log` throws whilst being converted to a string.
+     \param log: the log to be written.
+  **/
+  void write(const ThreadEventLog &log);
+
+  /**
+     flush. This method writes any buffered records to the stream and flushes the stream.
+     \return true if the stream is still good, false otherwise.
+  **/
+  bool flush();
+
+private:
+  /**
+     m_os. This is the stream that is written to.
+  **/
+  std::ostream &m_os;
+
+  /**
+     m_buffer. This holds the bytes that have not yet been written to the stream.
+  **/
+  std::string m_buffer{};
+
+  /**
+     m_previous. This is the timestamp (in clock ticks) of the previous record.
+  **/
+  std::int64_t m_previous{0};
+};
+
+/**
+ BinaryReader. This class reads event logs that were written by \ref BinaryWriter from an input
+stream. The stream is read in large chunks, so this class may read past the last record that is
+returned. This class does not own the stream.
+**/
+class BinaryReader
+{
+public:
+  /**
+     aux_decoder. This type is used to rebuild auxiliary data from its stored string.
+  **/
+  using aux_decoder = Binary::aux_decoder;
+
+  /**
+     buffer_size. This is the number of bytes that are read from the stream at once.
+  **/
+  static constexpr std::size_t buffer_size = 1 << 16;
+
+  /**
+     BinaryReader. This constructor reads and checks the stream header. If the header is not
+  valid then `error` returns true and no records are read. This constructor may throw due to
+  allocation failures.
+     \param is: the stream to read from. This must outlive this object.
+     \param decoder: the function used to rebuild auxiliary data. If this is empty then any
+  auxiliary data in the stream is skipped.
+  **/
+  explicit BinaryReader(std::istream &is, aux_decoder decoder = {});
+
+  /**
+     read. This method reads the next record in the stream into `log`, replacing its contents.
+  This method may throw due to allocation failures, or if the decoder throws.
+     \param log: the log to be overwritten.
+     \return true if a record was read, false at the end of the stream or on a malformed record.
+  **/
+  bool read(EventLog &log);
+
+  /**
+     error. This method returns true if the header or a record was malformed. This function does
+  not throw.
+     \return true if the stream was malformed, false otherwise.
+  **/
+  inline bool error() const noexcept;
+
+private:
+  /**
+     StreamSource. This struct reads bytes from the stream in chunks of `buffer_size` bytes.
+  **/
+  struct StreamSource
+  {
+    std::istream &is;
+    std::vector<char> buffer;
+    std::size_t pos{0};
+    std::size_t end{0};
+
+    /**
+       fill. This method reads the next chunk of the stream into the buffer.
+       \return true if any bytes were read, false otherwise.
+    **/
+    bool fill();
+
+    /// These follow the same contract as the methods in \ref Binary::MemorySource. Strings are
+    /// read in chunks, so a corrupted length cannot cause a huge allocation.
+    inline bool get_byte(unsigned char &out);
+    bool get_bytes(std::string &out, std::uint64_t size);
+    inline bool at_end();
+  };
+
+  /**
+     m_source. This is where bytes are read from.
+  **/
+  StreamSource m_source;
+
+  /**
+     m_decoder. This is used to rebuild auxiliary data, if set.
+  **/
+  aux_decoder m_decoder;
+
+  /**
+     m_previous. This is the timestamp (in clock ticks) of the previous record.
+  **/
+  std::int64_t m_previous{0};
+
+  /**
+     m_error. This is set if the stream was found to be malformed.
+  **/
+  bool m_error{false};
+};
+
+/**
+   write_binary. This function writes every log in `storage` to `os`.
+   \tparam StorageType: the type of storage. This must be iterable and hold \ref EventLog objects.
+   \param os: the stream to write to.
+   \param storage: the logs to be written.
+   \return true if the stream is still good, false otherwise.
+**/
+template <typename StorageType> bool write_binary(std::ostream &os, const StorageType &storage);
+
+/**
+   read_binary. This function reads every log in `is` and inserts them into `storage`.
+   \tparam StorageType: the type of storage. This must provide an `insert` method.
+   \param is: the stream to read from.
+   \param storage: the storage to insert into.
+   \param decoder: the function used to rebuild auxiliary data, if any.
+   \return true if the whole stream was read, false if it was malformed. In the latter case every
+   log before the malformed record is still inserted.
+**/
+template <typename StorageType>
+bool read_binary(std::istream &is, StorageType &storage,
+                 BinaryReader::aux_decoder decoder = BinaryReader::aux_decoder{});
+
+/// INLINE FUNCTIONS
+inline void Binary::put_varint(std::string &out, std::uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+inline bool Binary::MemorySource::get_byte(unsigned char &out) noexcept
+{
+  if (pos == end)
+  {
+    return false;
+  }
+
+  out = static_cast<unsigned char>(*pos++);
+  return true;
+}
+
+inline bool Binary::MemorySource::get_bytes(std::string &out, const std::uint64_t size)
+{
+  if (static_cast<std::uint64_t>(end - pos) < size)
+  {
+    return false;
+  }
+
+  out.assign(pos, static_cast<std::size_t>(size));
+  pos += size;
+  return true;
+}
+
+inline bool Binary::MemorySource::at_end() const noexcept { return pos == end; }
+
+template <typename Source> inline bool Binary::get_varint(Source &source, std::uint64_t &out)
+{
+  out = 0;
+  // A 64-bit value never needs more than 10 bytes.
+  for (unsigned shift = 0; shift < 70; shift += 7)
+  {
+    unsigned char byte;
+    if (!source.get_byte(byte))
+    {
+      return false;
+    }
+
+    out |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template <typename Source> inline bool Binary::get_string(Source &source, std::string &out)
+{
+  std::uint64_t size;
+  return get_varint(source, size) && source.get_bytes(out, size);
+}
+
+template <typename Source> bool Binary::get_value(Source &source, ParameterValue &out)
+{
+  unsigned char type;
+  std::uint64_t bits;
+  if (!source.get_byte(type))
+  {
+    return false;
+  }
+
+  switch (static_cast<ParameterValue::Type>(type))
+  {
+  case ParameterValue::Type::STRING:
+  {
+    std::string str;
+    if (!get_string(source, str))
+    {
+      return false;
+    }
+    out = std::move(str);
+    return true;
+  }
+  case ParameterValue::Type::INTEGER:
+    if (!get_varint(source, bits))
+    {
+      return false;
+    }
+    out = unzigzag(bits);
+    return true;
+  case ParameterValue::Type::UNSIGNED:
+    if (!get_varint(source, bits))
+    {
+      return false;
+    }
+    out = bits;
+    return true;
+  case ParameterValue::Type::DOUBLE:
+  {
+    bits = 0;
+    for (unsigned i = 0; i < 8; i++)
+    {
+      unsigned char byte;
+      if (!source.get_byte(byte))
+      {
+        return false;
+      }
+      bits |= static_cast<std::uint64_t>(byte) << (8 * i);
+    }
+
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    out = value;
+    return true;
+  }
+  case ParameterValue::Type::BOOLEAN:
+  {
+    unsigned char value;
+    if (!source.get_byte(value) || value > 1)
+    {
+      return false;
+    }
+    out = value == 1;
+    return true;
+  }
+  case ParameterValue::Type::DURATION:
+    if (!get_varint(source, bits))
+    {
+      return false;
+    }
+    out = ParameterValue::duration{unzigzag(bits)};
+    return true;
+  }
+
+  return false;
+}
+
+template <typename Source> bool Binary::get_header(Source &source)
+{
+  std::string magic;
+  std::uint64_t version, num, den;
+  return source.get_bytes(magic, 4) && magic == "FELR" && get_varint(source, version) &&
+         get_varint(source, num) && get_varint(source, den) && version == binary_format_version &&
+         num == std::chrono::system_clock::period::num &&
+         den == std::chrono::system_clock::period::den;
+}
+
+template <typename Source>
+bool Binary::get_record(Source &source, EventLog &log, std::int64_t &previous,
+                        const aux_decoder &decoder)
+{
+  std::string name;
+  std::uint64_t delta;
+  if (!get_string(source, name) || !get_varint(source, delta))
+  {
+    return false;
+  }
+
+  // We add in unsigned arithmetic so that a corrupted delta wraps rather than overflows.
+  const auto time = static_cast<std::int64_t>(static_cast<std::uint64_t>(previous) +
+                                              static_cast<std::uint64_t>(unzigzag(delta)));
+  const std::chrono::system_clock::duration since_epoch{time};
+  EventLog out{std::move(name), std::chrono::time_point<std::chrono::system_clock>{since_epoch}};
+
+  std::uint64_t nr_parameters;
+  if (!get_varint(source, nr_parameters))
+  {
+    return false;
+  }
+
+  // The count is capped so that a corrupted stream cannot cause a huge allocation.
+  out.reserve(static_cast<EventLog::size_type>(std::min<std::uint64_t>(nr_parameters, 64)));
+  for (std::uint64_t i = 0; i < nr_parameters; i++)
+  {
+    std::string key;
+    ParameterValue value;
+    if (!get_string(source, key) || !get_value(source, value))
+    {
+      return false;
+    }
+    out.emplace_back(key, std::move(value));
+  }
+
+  unsigned char has_aux;
+  if (!source.get_byte(has_aux) || has_aux > 1)
+  {
+    return false;
+  }
+
+  if (has_aux)
+  {
+    std::string payload;
+    if (!get_string(source, payload))
+    {
+      return false;
+    }
+
+    if (decoder)
+    {
+      out.aux() = decoder(payload);
+    }
+  }
+
+  log      = std::move(out);
+  previous = time;
+  return true;
+}
+
+inline bool BinaryReader::error() const noexcept { return m_error; }
+
+inline bool BinaryReader::StreamSource::get_byte(unsigned char &out)
+{
+  if (pos == end && !fill())
+  {
+    return false;
+  }
+
+  out = static_cast<unsigned char>(buffer[pos++]);
+  return true;
+}
+
+inline bool BinaryReader::StreamSource::at_end() { return pos == end && !fill(); }
+
+template <typename StorageType> bool write_binary(std::ostream &os, const StorageType &storage)
+{
+  BinaryWriter writer{os};
+  for (const auto &v : storage)
+  {
+    writer.write(v);
+  }
+  return writer.flush();
+}
+
+template <typename StorageType>
+bool read_binary(std::istream &is, StorageType &storage, BinaryReader::aux_decoder decoder)
+{
+  BinaryReader reader{is, std::move(decoder)};
+  EventLog log;
+  while (reader.read(log))
+  {
+    storage.insert(std::move(log));
+  }
+  return !reader.error();
+}
+
+}  // namespace Feller
+#endif
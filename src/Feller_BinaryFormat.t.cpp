@@ -0,0 +1,215 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_BinaryFormat.hpp"
+#include "Feller_ContiguousLogStorage.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_TestData.hpp"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+using Storage = Feller::ContiguousLogStorage<Feller::EventLog>;
+using Time    = std::chrono::time_point<std::chrono::system_clock>;
+
+// This builds a storage with varied names, times and parameters. The times deliberately go
+// backwards as well as forwards.
+Storage make_storage(const unsigned size)
+{
+  Storage storage;
+  const auto now = std::chrono::system_clock::now();
+  for (unsigned i = 0; i < size; i++)
+  {
+    const auto offset = std::chrono::microseconds((i % 7) * 1000) - std::chrono::seconds(i % 3);
+    Feller::EventLog log{"Log " + std::to_string(i), now + offset};
+    for (unsigned j = 0; j < i % 4; j++)
+    {
+      log.emplace_back("key" + std::to_string(j), std::string(i % 300, 'v'));
+    }
+    storage.insert(std::move(log));
+  }
+  return storage;
+}
+
+TEST(BinaryFormat, testRoundTrip)
+{
+  // This is large enough to cross several chunks of the reader and writer.
+  const auto storage = make_storage(5000);
+  std::stringstream ss;
+  ASSERT_TRUE(Feller::write_binary(ss, storage));
+
+  Storage out;
+  ASSERT_TRUE(Feller::read_binary(ss, out));
+  EXPECT_EQ(out, storage);
+}
+
+TEST(BinaryFormat, testTypedValues)
+{
+  Feller::EventLog log{"Typed", std::chrono::system_clock::now()};
+  log.emplace_back("string", "text");
+  log.emplace_back("negative", -123456789);
+  log.emplace_back("unsigned", ~std::uint64_t{0});
+  log.emplace_back("double", -0.1);
+  log.emplace_back("true", true);
+  log.emplace_back("false", false);
+  log.emplace_back("duration", std::chrono::milliseconds(-5));
+
+  Storage storage;
+  storage.insert(log);
+  std::stringstream ss;
+  ASSERT_TRUE(Feller::write_binary(ss, storage));
+
+  // Each value keeps its type across the round trip.
+  Storage out;
+  ASSERT_TRUE(Feller::read_binary(ss, out));
+  ASSERT_EQ(out.size(), 1);
+  EXPECT_EQ(*out.cbegin(), log);
+  EXPECT_EQ((out.cbegin()->cbegin() + 3)->second.type(), Feller::ParameterValue::Type::DOUBLE);
+}
+
+TEST(BinaryFormat, testEmpty)
+{
+  std::stringstream ss;
+  ASSERT_TRUE(Feller::write_binary(ss, Storage{}));
+
+  Feller::BinaryReader reader{ss};
+  Feller::EventLog log;
+  EXPECT_FALSE(reader.read(log));
+  EXPECT_FALSE(reader.error());
+}
+
+TEST(BinaryFormat, testSmallerThanText)
+{
+  const auto storage = make_storage(1000);
+  std::stringstream binary, text;
+  Feller::write_binary(binary, storage);
+  text << storage;
+  EXPECT_LT(binary.str().size(), text.str().size());
+}
+
+TEST(BinaryFormat, testAux)
+{
+  Storage storage;
+  storage.insert(Feller::EventLog{"No aux", Time{}});
+  Feller::EventLog log{"Aux", Time{}};
+  log.aux() = std::make_unique<Feller::TestData>();
+  storage.insert(std::move(log));
+
+  std::stringstream ss;
+  Feller::write_binary(ss, storage);
+  const auto bytes = ss.str();
+
+  // Without a decoder the payload is skipped.
+  {
+    std::stringstream in{bytes};
+    Storage out;
+    ASSERT_TRUE(Feller::read_binary(in, out));
+    ASSERT_EQ(out.size(), 2);
+    EXPECT_EQ(out[1].aux(), nullptr);
+    EXPECT_EQ(out[1].name(), "Aux");
+  }
+
+  // With a decoder the payload is rebuilt.
+  {
+    std::stringstream in{bytes};
+    Storage out;
+    std::string payload;
+    ASSERT_TRUE(Feller::read_binary(in, out, [&payload](const std::string &str) {
+      payload = str;
+      return std::make_unique<Feller::TestData>();
+    }));
+    EXPECT_EQ(out, storage);
+    EXPECT_EQ(payload, Feller::TestData{}.to_string());
+  }
+}
+
+TEST(BinaryFormat, testStreaming)
+{
+  const auto storage = make_storage(100);
+  std::stringstream ss;
+  {
+    Feller::BinaryWriter writer{ss};
+    for (const auto &v : storage)
+    {
+      writer.write(v);
+    }
+  }
+
+  Feller::BinaryReader reader{ss};
+  Feller::EventLog log;
+  for (const auto &v : storage)
+  {
+    ASSERT_TRUE(reader.read(log));
+    EXPECT_EQ(log, v);
+  }
+  EXPECT_FALSE(reader.read(log));
+  EXPECT_FALSE(reader.error());
+}
+
+TEST(BinaryFormat, testTruncated)
+{
+  const auto storage = make_storage(10);
+  std::stringstream ss;
+  Feller::write_binary(ss, storage);
+  auto bytes = ss.str();
+  bytes.resize(bytes.size() - 3);
+
+  std::stringstream in{bytes};
+  Storage out;
+  EXPECT_FALSE(Feller::read_binary(in, out));
+  EXPECT_EQ(out.size(), 9);
+  EXPECT_TRUE(std::equal(out.cbegin(), out.cend(), storage.cbegin()));
+}
+
+TEST(BinaryFormat, testZeroPadding)
+{
+  const auto storage = make_storage(10);
+  std::stringstream ss;
+  Feller::write_binary(ss, storage);
+
+  // Zero padding is the end of the stream, not a run of empty records.
+  std::stringstream in{ss.str() + std::string(64, '\0')};
+  Storage out;
+  EXPECT_TRUE(Feller::read_binary(in, out));
+  EXPECT_EQ(out, storage);
+
+  // Any other byte where a record should start is an error.
+  std::stringstream bad{ss.str() + '\x02'};
+  Storage partial;
+  EXPECT_FALSE(Feller::read_binary(bad, partial));
+  EXPECT_EQ(partial, storage);
+}
+
+TEST(BinaryFormat, testBadHeader)
+{
+  std::stringstream text;
+  text << make_storage(10);
+
+  Storage out;
+  EXPECT_FALSE(Feller::read_binary(text, out));
+  EXPECT_EQ(out.size(), 0);
+
+  // A stream with a different version is also rejected.
+  std::stringstream ss;
+  Feller::write_binary(ss, make_storage(10));
+  auto bytes = ss.str();
+  bytes[4]   = static_cast<char>(Feller::binary_format_version + 1);
+  std::stringstream in{bytes};
+  EXPECT_FALSE(Feller::read_binary(in, out));
+  EXPECT_EQ(out.size(), 0);
+}
@@ -0,0 +1,411 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_ChromeTrace.hpp"
+#include "Feller_TimeFormatter.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+/**
+   max_string. This is the most bytes that a string of `size` characters takes once quoted and
+   escaped: each character may become a six-byte \u escape (or a three-byte U+FFFD).
+**/
+constexpr std::size_t max_string(const std::size_t size) { return 6 * size + 2; }
+
+/**
+   max_number. This is the most bytes taken by any number written by this component.
+**/
+constexpr std::size_t max_number = 32;
+
+/**
+   max_event. This is the most bytes taken by an event, leaving out its name and arguments.
+**/
+constexpr std::size_t max_event = 128 + 3 * max_number;
+
+// The functions below write into a buffer that the caller has already made large enough (using
+// the bounds above), and return one past the last byte written. Writing through a raw pointer
+// rather than appending to a string makes exporting several times faster.
+
+template <std::size_t N> inline char *put(char *const pos, const char (&text)[N]) noexcept
+{
+  std::memcpy(pos, text, N - 1);
+  return pos + N - 1;
+}
+
+inline char *put(char *const pos, const std::string_view text) noexcept
+{
+  std::memcpy(pos, text.data(), text.size());
+  return pos + text.size();
+}
+
+/**
+   utf8_sequence. This function returns the length of the well-formed UTF-8 sequence that starts
+   at `text[i]`, which must be a non-ASCII byte. If the sequence is ill-formed then this returns
+   zero and sets `bad` to the length of its longest well-formed prefix (or 1 if there is none):
+   following Unicode, those bytes are replaced by a single U+FFFD.
+**/
+std::size_t utf8_sequence(const std::string_view text, const std::size_t i,
+                          std::size_t &bad) noexcept
+{
+  // The second byte has a narrower range after some lead bytes, which rules out overlong
+  // encodings, surrogates and code points past U+10FFFF.
+  const auto c       = static_cast<unsigned char>(text[i]);
+  unsigned char low  = 0x80;
+  unsigned char high = 0xBF;
+  std::size_t length;
+  if (c >= 0xC2 && c <= 0xDF)
+  {
+    length = 2;
+  }
+  else if (c >= 0xE0 && c <= 0xEF)
+  {
+    length = 3;
+    low    = c == 0xE0 ? 0xA0 : low;
+    high   = c == 0xED ? 0x9F : high;
+  }
+  else if (c >= 0xF0 && c <= 0xF4)
+  {
+    length = 4;
+    low    = c == 0xF0 ? 0x90 : low;
+    high   = c == 0xF4 ? 0x8F : high;
+  }
+  else
+  {
+    bad = 1;
+    return 0;
+  }
+
+  for (std::size_t j = 1; j < length; j++)
+  {
+    const auto next = i + j < text.size() ? static_cast<unsigned char>(text[i + j]) : 0;
+    if (next < low || next > high)
+    {
+      bad = j;
+      return 0;
+    }
+    low  = 0x80;
+    high = 0xBF;
+  }
+  return length;
+}
+
+char *write_string(char *pos, const std::string_view text) noexcept
+{
+  constexpr char hex[] = "0123456789abcdef";
+  *pos++               = '"';
+  // Most names and values need no escaping, so we copy unescaped runs in one go.
+  std::size_t start = 0;
+  for (std::size_t i = 0; i < text.size(); i++)
+  {
+    const auto c = static_cast<unsigned char>(text[i]);
+    if (c >= 0x80)
+    {
+      std::size_t bad;
+      if (const auto length = utf8_sequence(text, i, bad))
+      {
+        i += length - 1;
+        continue;
+      }
+
+      // This is U+FFFD, encoded as UTF-8.
+      pos   = put(pos, text.substr(start, i - start));
+      pos   = put(pos, "\xEF\xBF\xBD");
+      i    += bad - 1;
+      start = i + 1;
+      continue;
+    }
+
+    if (c >= 0x20 && c != '"' && c != '\\')
+    {
+      continue;
+    }
+
+    pos   = put(pos, text.substr(start, i - start));
+    start = i + 1;
+    switch (c)
+    {
+    case '"':
+      pos = put(pos, "\\\"");
+      break;
+    case '\\':
+      pos = put(pos, "\\\\");
+      break;
+    case '\n':
+      pos = put(pos, "\\n");
+      break;
+    case '\t':
+      pos = put(pos, "\\t");
+      break;
+    default:
+      pos    = put(pos, "\\u00");
+      *pos++ = hex[c >> 4];
+      *pos++ = hex[c & 0xF];
+      break;
+    }
+  }
+  pos    = put(pos, text.substr(start));
+  *pos++ = '"';
+  return pos;
+}
+
+std::size_t max_value(const Feller::ParameterValue &value) noexcept
+{
+  const auto *const text = value.get_if<Feller::ParameterValue::string_type>();
+  return text == nullptr ? max_number : max_string(text->size());
+}
+
+char *write_value(char *pos, const Feller::ParameterValue &value) noexcept
+{
+  using Type     = Feller::ParameterValue::Type;
+  char *const end = pos + max_number;
+  switch (value.type())
+  {
+  case Type::STRING:
+    return write_string(pos, *value.get_if<Feller::ParameterValue::string_type>());
+  case Type::INTEGER:
+    return std::to_chars(pos, end, *value.get_if<std::int64_t>()).ptr;
+  case Type::UNSIGNED:
+    return std::to_chars(pos, end, *value.get_if<std::uint64_t>()).ptr;
+  case Type::DOUBLE:
+  {
+    const auto d = *value.get_if<double>();
+    if (std::isfinite(d))
+    {
+      return std::to_chars(pos, end, d).ptr;
+    }
+    // JSON has no infinities or NaNs, so these are written as strings.
+    *pos++ = '"';
+    pos    = std::to_chars(pos, end - 1, d).ptr;
+    *pos++ = '"';
+    return pos;
+  }
+  case Type::BOOLEAN:
+    return *value.get_if<bool>() ? put(pos, "true") : put(pos, "false");
+  case Type::DURATION:
+    return std::to_chars(pos, end, value.get_if<Feller::ParameterValue::duration>()->count()).ptr;
+  }
+  return pos;
+}
+
+char *write_micros(char *pos, const std::int64_t ns) noexcept
+{
+  // The magnitude is taken as unsigned so that the most negative value does not overflow.
+  auto magnitude = static_cast<std::uint64_t>(ns);
+  if (ns < 0)
+  {
+    *pos++    = '-';
+    magnitude = ~magnitude + 1;
+  }
+
+  pos             = std::to_chars(pos, pos + max_number - 5, magnitude / 1000).ptr;
+  const auto frac = static_cast<unsigned>(magnitude % 1000);
+  pos[0]          = '.';
+  pos[1]          = static_cast<char>('0' + frac / 100);
+  pos[2]          = static_cast<char>('0' + frac / 10 % 10);
+  pos[3]          = static_cast<char>('0' + frac % 10);
+  return pos + 4;
+}
+
+/**
+   append. This function appends at most `size` bytes to `out` via `write`, which is called with
+   a pointer to the new space and returns one past the last byte that it wrote.
+**/
+template <typename Write> void append(std::string &out, const std::size_t size, Write &&write)
+{
+  const auto old = out.size();
+  out.resize(old + size);
+  out.resize(static_cast<std::size_t>(write(out.data() + old) - out.data()));
+}
+}  // namespace
+
+void Feller::ChromeTrace::append_string(std::string &out, const std::string_view text)
+{
+  append(out, max_string(text.size()), [text](char *pos) { return write_string(pos, text); });
+}
+
+void Feller::ChromeTrace::append_value(std::string &out, const ParameterValue &value)
+{
+  append(out, max_value(value), [&value](char *pos) { return write_value(pos, value); });
+}
+
+void Feller::ChromeTrace::append_micros(std::string &out, const std::int64_t ns)
+{
+  append(out, max_number, [ns](char *pos) { return write_micros(pos, ns); });
+}
+
+Feller::ChromeTraceWriter::ChromeTraceWriter(std::ostream &os, const time_point base)
+    : m_os{os}, m_base{base}
+{
+  m_buffer.resize(buffer_size + buffer_size / 4);
+  m_size = static_cast<std::size_t>(put(m_buffer.data(), "{\"traceEvents\":[\n") - m_buffer.data());
+}
+
+Feller::ChromeTraceWriter::~ChromeTraceWriter() { finish(); }
+
+void Feller::ChromeTraceWriter::write(const EventLog &log) { write(log, nullptr, nullptr); }
+
+void Feller::ChromeTraceWriter::write(const ThreadEventLog &log)
+{
+  const auto parameters = log.thread_parameters();
+  write(log, parameters.data(), parameters.data() + parameters.size());
+}
+
+void Feller::ChromeTraceWriter::write(const EventLog &log,
+                                      const EventLog::parameter_type *const first,
+                                      const EventLog::parameter_type *const last)
+{
+  const auto duration_key = Span::duration_key();
+  const auto thread_key   = Span::thread_key();
+  const auto &name        = log.name();
+
+  // The extra parameters are visited before those of the log.
+  const auto for_each_parameter = [&log, first, last](auto &&f) {
+    std::for_each(first, last, f);
+    std::for_each(log.cbegin(), log.cend(), f);
+  };
+
+  // The duration and thread are written as part of the event, rather than as arguments.
+  const ParameterValue *duration = nullptr;
+  const ParameterValue *thread   = nullptr;
+  std::size_t nr_args            = 0;
+  std::size_t size               = max_event + max_string(name.size());
+  for_each_parameter([&](const EventLog::parameter_type &parameter) {
+    if (parameter.first == duration_key &&
+        parameter.second.type() == ParameterValue::Type::DURATION)
+    {
+      duration = &parameter.second;
+    }
+    else if (parameter.first == thread_key &&
+             parameter.second.type() != ParameterValue::Type::STRING)
+    {
+      thread = &parameter.second;
+    }
+    else
+    {
+      ++nr_args;
+      size += max_string(parameter.first.str().size()) + max_value(parameter.second) + 2;
+    }
+  });
+
+  char *pos = begin_event(size);
+
+  pos = put(pos, "{\"name\":");
+  pos = write_string(pos, name);
+  pos = duration != nullptr ? put(pos, ",\"ph\":\"X\",\"ts\":")
+                            : put(pos, ",\"ph\":\"i\",\"s\":\"t\",\"ts\":");
+  pos = write_micros(
+      pos, std::chrono::duration_cast<std::chrono::nanoseconds>(log.time() - m_base).count());
+  if (duration != nullptr)
+  {
+    pos = put(pos, ",\"dur\":");
+    pos = write_micros(pos, duration->get_if<ParameterValue::duration>()->count());
+  }
+
+  pos = put(pos, ",\"pid\":1,\"tid\":");
+  pos = thread != nullptr ? write_value(pos, *thread) : put(pos, "0");
+
+  if (nr_args != 0)
+  {
+    pos            = put(pos, ",\"args\":{");
+    bool first_arg = true;
+    for_each_parameter([&](const EventLog::parameter_type &parameter) {
+      if (&parameter.second == duration || &parameter.second == thread)
+      {
+        return;
+      }
+
+      if (!first_arg)
+      {
+        *pos++ = ',';
+      }
+      first_arg = false;
+      pos       = write_string(pos, parameter.first.str());
+      *pos++    = ':';
+      pos       = write_value(pos, parameter.second);
+    });
+    *pos++ = '}';
+  }
+  *pos++ = '}';
+  end_event(pos);
+}
+
+void Feller::ChromeTraceWriter::write(const MetricLog &metric, const time_point time)
+{
+  const auto &name = metric.name();
+  char *pos        = begin_event(max_event + max_string(name.size()));
+
+  pos = put(pos, "{\"name\":");
+  pos = write_string(pos, name);
+  pos = put(pos, ",\"ph\":\"C\",\"ts\":");
+  pos = write_micros(
+      pos, std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_base).count());
+  pos = put(pos, ",\"pid\":1,\"args\":{\"value\":");
+  pos = metric.kind() == MetricLog::Kind::COUNTER
+            ? std::to_chars(pos, pos + max_number, metric.count()).ptr
+            : write_value(pos, ParameterValue{metric.gauge()});
+  pos = put(pos, "}}");
+  end_event(pos);
+}
+
+char *Feller::ChromeTraceWriter::begin_event(const std::size_t size)
+{
+  if (m_size + size > m_buffer.size())
+  {
+    write_buffer();
+    m_buffer.resize(std::max(m_buffer.size(), size));
+  }
+
+  char *const pos = m_buffer.data() + m_size;
+  return m_nr_events++ == 0 ? pos : put(pos, ",\n");
+}
+
+void Feller::ChromeTraceWriter::end_event(const char *const pos)
+{
+  m_size = static_cast<std::size_t>(pos - m_buffer.data());
+  if (m_size >= buffer_size)
+  {
+    write_buffer();
+  }
+}
+
+void Feller::ChromeTraceWriter::write_buffer()
+{
+  m_os.write(m_buffer.data(), static_cast<std::streamsize>(m_size));
+  m_size = 0;
+}
+
+bool Feller::ChromeTraceWriter::finish()
+{
+  if (!m_finished)
+  {
+    m_finished = true;
+    write_buffer();
+
+    std::string tail = "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"base_time\":\"";
+    TimeFormatter{TimeFormatter::Format::ISO8601, TimeFormatter::Precision::NANOSECONDS}.append_to(
+        tail, m_base);
+    tail += "\"}}\n";
+    m_os.write(tail.data(), static_cast<std::streamsize>(tail.size()));
+    m_os.flush();
+  }
+  return m_os.good();
+}
@@ -0,0 +1,251 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_CHROME_TRACE
+#define INCLUDED_FELLER_CHROME_TRACE
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "Feller_Feller.hpp"
+
+#include "Feller_EventLog.hpp"
+#include "Feller_MetricLog.hpp"
+#include "Feller_ParameterValue.hpp"
+#include "Feller_ScopedSpan.hpp"
+#include "Feller_ThreadInfo.hpp"
+
+namespace Feller
+{
+/**
+ \brief The purpose of this component is to export logs in the Chrome Trace Event format, so that
+a run can be opened in `chrome://tracing` or in the Perfetto UI (https://ui.perfetto.dev).
+
+ The output is a single JSON object whose "traceEvents" array holds one event per log:
+
+ - logs with a "duration" parameter (i.e spans, see \ref ScopedSpan) become complete events
+   (`"ph":"X"`), which start at the time of the log and last for the duration.
+ - every other log becomes an instant event (`"ph":"i"`) at the time of the log.
+ - metrics (see \ref MetricLog) that are written explicitly become counter events (`"ph":"C"`).
+
+ The name of the event is the name of the log, and the thread of the event is the "thread_id"
+parameter of the log (or 0 if it has none). Every other parameter is written to the "args" of
+the event, so span and parent ids show up when an event is selected. Times are written in
+microseconds, with nanosecond precision, relative to a base time that is recorded in "otherData".
+**/
+
+namespace ChromeTrace
+{
+/**
+   append_string. This function appends `text` to `out` as a quoted, escaped JSON string. Any
+   bytes that are not valid UTF-8 are replaced with U+FFFD, so that the output is always valid
+   JSON. This function may throw due to allocation failures.
+   \param out: the buffer to append to.
+   \param text: the text to be written.
+**/
+void append_string(std::string &out, std::string_view text);
+
+/**
+   append_value. This function appends `value` to `out` as a JSON value. Numbers are written as
+   numbers (durations in nanoseconds), except for non-finite doubles, which JSON cannot represent:
+   these are written as strings. This function may throw due to allocation failures.
+   \param out: the buffer to append to.
+   \param value: the value to be written.
+**/
+void append_value(std::string &out, const ParameterValue &value);
+
+/**
+   append_micros. This function appends `ns` nanoseconds to `out` as a number of microseconds, with
+   three decimal places. This function may throw due to allocation failures.
+   \param out: the buffer to append to.
+   \param ns: the number of nanoseconds.
+**/
+void append_micros(std::string &out, std::int64_t ns);
+}  // namespace ChromeTrace
+
+/**
+ ChromeTraceWriter. This class writes event logs to an output stream in the Chrome Trace Event
+format described above. As with \ref BinaryWriter, events are formatted straight into an internal
+buffer, which is written to the stream whenever it grows past `buffer_size` bytes: no
+intermediate strings are built per log, and each event is written through a raw pointer once
+room has been made for it. The JSON is completed by `finish`, or on destruction.
+This class does not own the stream.
+**/
+class ChromeTraceWriter
+{
+public:
+  /**
+     time_point. This is the type of time held by each log.
+  **/
+  using time_point = EventLog::time_point;
+
+  /**
+     buffer_size. This is the number of bytes that are buffered before writing to the stream.
+  **/
+  static constexpr std::size_t buffer_size = 1 << 16;
+
+  /**
+     ChromeTraceWriter. This constructor writes the start of the JSON into the buffer. This
+  constructor may throw due to allocation failures.
+     \param os: the stream to write to. This must outlive this object.
+     \param base: the time that is written as zero. Logs before this time are written with a
+  negative timestamp, which some viewers reject: the earliest time of the logs is a good choice.
+  **/
+  ChromeTraceWriter(std::ostream &os, time_point base);
+
+  // This class refers to a stream and to a position in its output, so copying makes no sense.
+  ChromeTraceWriter(const ChromeTraceWriter &)            = delete;
+  ChromeTraceWriter &operator=(const ChromeTraceWriter &) = delete;
+
+  /**
+     ~ChromeTraceWriter. This destructor completes the JSON, if `finish` has not been called.
+  **/
+  ~ChromeTraceWriter();
+
+  /**
+     write. This method appends `log` to the trace as a single event. This method must not be
+  called after `finish`. This method may throw due to allocation failures.
+     \param log: the log to be written.
+  **/
+  void write(const EventLog &log);
+
+  /**
+     write. This method appends `log` to the trace as a single event on the thread that built it
+  (see \ref ThreadEventLog), with its CPU written as the argument "cpu". This method must not be
+  called after `finish`. This method may throw due to allocation failures.
+     \param log: the log to be written.
+  **/
+  void write(const ThreadEventLog &log);
+
+  /**
+     write. This method appends `metric` to the trace as a counter event (`"ph":"C"`) at `time`,
+  so that viewers draw the value of the metric over time. This method must not be called after
+  `finish`. This method may throw due to allocation failures.
+     \param metric: the metric to be written (e.g an aggregate read from \ref MetricLogStorage).
+     \param time: the time at which the metric had this value.
+  **/
+  void write(const MetricLog &metric, time_point time);
+
+  /**
+     finish. This method completes the JSON, writes any buffered events to the stream and flushes
+  the stream. Calling this more than once has no further effect.
+     \return true if the stream is still good, false otherwise.
+  **/
+  bool finish();
+
+private:
+  /**
+     write. This method appends `log` to the trace as a single event, as though the parameters in
+  [first, last) came before those of `log`.
+     \param log: the log to be written.
+     \param first: the first extra parameter.
+     \param last: one past the last extra parameter.
+  **/
+  void write(const EventLog &log, const EventLog::parameter_type *first,
+             const EventLog::parameter_type *last);
+
+  /**
+     begin_event. This method makes room for an event of at most `size` bytes, and writes the
+  separator from the previous event.
+     \param size: the most bytes that the event can take.
+     \return a pointer to where the event should be written.
+  **/
+  char *begin_event(std::size_t size);
+
+  /**
+     end_event. This method records that the event written by the caller ends at `pos`.
+     \param pos: one past the last byte of the event.
+  **/
+  void end_event(const char *pos);
+
+  /**
+     write_buffer. This method writes the buffered bytes to the stream.
+  **/
+  void write_buffer();
+
+  /**
+     m_os. This is the stream that is written to.
+  **/
+  std::ostream &m_os;
+
+  /**
+     m_buffer. This holds the bytes that have not yet been written to the stream. Only the first
+  `m_size` bytes are in use: the rest is room for the next event.
+  **/
+  std::string m_buffer{};
+
+  /**
+     m_size. This is the number of bytes in use in m_buffer.
+  **/
+  std::size_t m_size{0};
+
+  /**
+     m_base. This is the time that is written as zero.
+  **/
+  time_point m_base;
+
+  /**
+     m_nr_events. This is the number of events that have been written.
+  **/
+  std::size_t m_nr_events{0};
+
+  /**
+     m_finished. This is true once the JSON has been completed.
+  **/
+  bool m_finished{false};
+};
+
+/**
+   write_chrome_trace. This function writes every log in `storage` to `os` as a Chrome trace. The
+   storage is iterated twice: once to find the earliest time (which is used as the base time) and
+   once to write each log.
+   \tparam StorageType: the type of storage. This must be iterable and hold \ref EventLog objects.
+   \param os: the stream to write to.
+   \param storage: the logs to be written.
+   \return true if the stream is still good, false otherwise.
+**/
+template <typename StorageType>
+bool write_chrome_trace(std::ostream &os, const StorageType &storage);
+
+/// INLINE FUNCTIONS
+template <typename StorageType>
+bool write_chrome_trace(std::ostream &os, const StorageType &storage)
+{
+  auto base = ChromeTraceWriter::time_point::max();
+  for (const auto &v : storage)
+  {
+    base = std::min(base, v.time());
+  }
+
+  ChromeTraceWriter writer{os, base == ChromeTraceWriter::time_point::max()
+                                   ? ChromeTraceWriter::time_point{}
+                                   : base};
+  for (const auto &v : storage)
+  {
+    writer.write(v);
+  }
+  return writer.finish();
+}
+
+}  // namespace Feller
+#endif
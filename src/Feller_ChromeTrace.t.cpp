@@ -0,0 +1,222 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_ChromeTrace.hpp"
+#include "Feller_ContiguousLogStorage.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_LogEverything.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_MetricLog.hpp"
+#include "Feller_NoLock.hpp"
+#include "Feller_ScopedSpan.hpp"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+
+using Storage = Feller::ContiguousLogStorage<Feller::EventLog>;
+using Time    = Feller::EventLog::time_point;
+
+// 2024-02-29T12:34:56.123456789Z
+static const Time base{std::chrono::duration_cast<Time::duration>(
+    std::chrono::nanoseconds{1709210096123456789})};
+
+static std::string json(const Feller::ParameterValue &value)
+{
+  std::string out;
+  Feller::ChromeTrace::append_value(out, value);
+  return out;
+}
+
+static std::string micros(const std::int64_t ns)
+{
+  std::string out;
+  Feller::ChromeTrace::append_micros(out, ns);
+  return out;
+}
+
+TEST(ChromeTrace, testString)
+{
+  std::string out;
+  Feller::ChromeTrace::append_string(out, "plain");
+  EXPECT_EQ(out, "\"plain\"");
+
+  out.clear();
+  Feller::ChromeTrace::append_string(out, std::string{"a\"b\\c\nd\te\x01"} + '\0');
+  EXPECT_EQ(out, "\"a\\\"b\\\\c\\nd\\te\\u0001\\u0000\"");
+}
+
+TEST(ChromeTrace, testUtf8)
+{
+  const auto quoted = [](const std::string &text) {
+    std::string out;
+    Feller::ChromeTrace::append_string(out, text);
+    return out;
+  };
+
+  // Well-formed sequences of every length are copied as they are.
+  const std::string valid{"a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80"};
+  EXPECT_EQ(quoted(valid), '"' + valid + '"');
+
+  // Each ill-formed sequence becomes a single U+FFFD, as do stray bytes.
+  const std::string r{"\xEF\xBF\xBD"};
+  EXPECT_EQ(quoted("a\x80" "b"), "\"a" + r + "b\"");
+  EXPECT_EQ(quoted("a\xE2\x82"), "\"a" + r + "\"");
+  EXPECT_EQ(quoted("\xE2\x82x\xFF"), '"' + r + "x" + r + '"');
+  // Overlong encodings, surrogates and code points past U+10FFFF are rejected byte by byte.
+  EXPECT_EQ(quoted("\xC0\xAF"), '"' + r + r + '"');
+  EXPECT_EQ(quoted("\xED\xA0\x80"), '"' + r + r + r + '"');
+  EXPECT_EQ(quoted("\xF4\x90\x80\x80"), '"' + r + r + r + r + '"');
+}
+
+TEST(ChromeTrace, testValue)
+{
+  EXPECT_EQ(json("text"), "\"text\"");
+  EXPECT_EQ(json(-5), "-5");
+  EXPECT_EQ(json(std::uint64_t{18446744073709551615u}), "18446744073709551615");
+  EXPECT_EQ(json(0.5), "0.5");
+  EXPECT_EQ(json(std::numeric_limits<double>::infinity()), "\"inf\"");
+  EXPECT_EQ(json(true), "true");
+  EXPECT_EQ(json(std::chrono::microseconds{3}), "3000");
+}
+
+TEST(ChromeTrace, testMicros)
+{
+  EXPECT_EQ(micros(0), "0.000");
+  EXPECT_EQ(micros(1), "0.001");
+  EXPECT_EQ(micros(1234567), "1234.567");
+  EXPECT_EQ(micros(-1500), "-1.500");
+  EXPECT_EQ(micros(std::numeric_limits<std::int64_t>::min()), "-9223372036854775.808");
+}
+
+TEST(ChromeTrace, testEmpty)
+{
+  std::stringstream ss;
+  ASSERT_TRUE(Feller::write_chrome_trace(ss, Storage{}));
+  EXPECT_EQ(ss.str(), "{\"traceEvents\":[\n\n],\"displayTimeUnit\":\"ns\","
+                      "\"otherData\":{\"base_time\":\"1970-01-01T00:00:00.000000000Z\"}}\n");
+}
+
+TEST(ChromeTrace, testEvents)
+{
+  Storage storage;
+  Feller::EventLog span{"span \"1\"", base + std::chrono::nanoseconds{1500}};
+  span.emplace_back(Feller::Span::duration_key(), std::chrono::nanoseconds{2001});
+  span.emplace_back(Feller::Span::id_key(), std::uint64_t{7});
+  span.emplace_back(Feller::Span::thread_key(), std::uint64_t{3});
+  storage.insert(span);
+
+  Feller::EventLog instant{"instant", base};
+  instant.emplace_back("count", 5);
+  instant.emplace_back("flag", false);
+  storage.insert(instant);
+  storage.insert(Feller::EventLog{"bare", base + std::chrono::seconds{1}});
+
+  std::stringstream ss;
+  ASSERT_TRUE(Feller::write_chrome_trace(ss, storage));
+  EXPECT_EQ(ss.str(),
+            "{\"traceEvents\":[\n"
+            "{\"name\":\"span \\\"1\\\"\",\"ph\":\"X\",\"ts\":1.500,\"dur\":2.001,\"pid\":1,"
+            "\"tid\":3,\"args\":{\"span_id\":7}},\n"
+            "{\"name\":\"instant\",\"ph\":\"i\",\"s\":\"t\",\"ts\":0.000,\"pid\":1,\"tid\":0,"
+            "\"args\":{\"count\":5,\"flag\":false}},\n"
+            "{\"name\":\"bare\",\"ph\":\"i\",\"s\":\"t\",\"ts\":1000000.000,\"pid\":1,\"tid\":0}"
+            "\n],\"displayTimeUnit\":\"ns\","
+            "\"otherData\":{\"base_time\":\"2024-02-29T12:34:56.123456789Z\"}}\n");
+}
+
+TEST(ChromeTrace, testWriterBase)
+{
+  // Logs before the base time are written with a negative time.
+  std::stringstream ss;
+  {
+    Feller::ChromeTraceWriter writer{ss, base};
+    writer.write(Feller::EventLog{"early", base - std::chrono::microseconds{2}});
+  }
+  EXPECT_NE(ss.str().find("\"ts\":-2.000"), std::string::npos);
+  EXPECT_EQ(ss.str().back(), '\n');
+}
+
+TEST(ChromeTrace, testMetrics)
+{
+  // Metrics are written as counter events, alongside the event logs.
+  std::stringstream ss;
+  {
+    Feller::ChromeTraceWriter writer{ss, base};
+    writer.write(Feller::EventLog{"event", base});
+    writer.write(Feller::MetricLog::counter("requests", 12), base + std::chrono::microseconds{3});
+    writer.write(Feller::MetricLog::gauge("load", 0.5), base + std::chrono::microseconds{3});
+  }
+  EXPECT_NE(ss.str().find("{\"name\":\"event\",\"ph\":\"i\""), std::string::npos);
+  EXPECT_NE(ss.str().find(",\n{\"name\":\"requests\",\"ph\":\"C\",\"ts\":3.000,\"pid\":1,"
+                          "\"args\":{\"value\":12}},\n"),
+            std::string::npos);
+  EXPECT_NE(ss.str().find("{\"name\":\"load\",\"ph\":\"C\",\"ts\":3.000,\"pid\":1,"
+                          "\"args\":{\"value\":0.5}}\n]"),
+            std::string::npos);
+}
+
+TEST(ChromeTrace, testLargeTrace)
+{
+  // This is large enough to cross several flushes of the buffer.
+  Storage storage;
+  for (unsigned i = 0; i < 5000; i++)
+  {
+    Feller::EventLog log{"Log " + std::to_string(i), base + std::chrono::microseconds{i}};
+    log.emplace_back("value", std::string(i % 100, 'v'));
+    storage.insert(std::move(log));
+  }
+
+  std::stringstream ss;
+  ASSERT_TRUE(Feller::write_chrome_trace(ss, storage));
+  const auto out = ss.str();
+  EXPECT_GT(out.size(), Feller::ChromeTraceWriter::buffer_size);
+
+  std::size_t nr_events = 0;
+  for (auto pos = out.find("{\"name\""); pos != std::string::npos;
+       pos      = out.find("{\"name\"", pos + 1))
+  {
+    ++nr_events;
+  }
+  EXPECT_EQ(nr_events, storage.size());
+  EXPECT_NE(out.find("\"name\":\"Log 4999\",\"ph\":\"i\",\"s\":\"t\",\"ts\":4999.000"),
+            std::string::npos);
+}
+
+TEST(ChromeTrace, testSpans)
+{
+  using LoggerType = Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage,
+                                    Feller::NoLock, Feller::LogEverything>;
+  LoggerType logger;
+  {
+    Feller::ScopedSpan<LoggerType> outer{logger, "outer"};
+    Feller::ScopedSpan<LoggerType> inner{logger, "inner"};
+  }
+
+  std::stringstream ss;
+  ASSERT_TRUE(Feller::write_chrome_trace(ss, logger));
+  const auto out = ss.str();
+  EXPECT_NE(out.find("{\"name\":\"inner\",\"ph\":\"X\""), std::string::npos);
+  EXPECT_NE(out.find("{\"name\":\"outer\",\"ph\":\"X\",\"ts\":0.000"), std::string::npos);
+  const auto tid = "\"tid\":" + std::to_string(Feller::Span::thread_state().thread_id);
+  EXPECT_NE(out.find(tid + ",\"args\":{\"span_id\":"), std::string::npos);
+  EXPECT_NE(out.find("\"parent_id\":0}"), std::string::npos);
+}
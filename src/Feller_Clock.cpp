@@ -0,0 +1,51 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_Clock.hpp"
+
+auto Feller::TscClock::measure() noexcept -> Calibration
+{
+  // We spin rather than sleep, so that the counter is read as soon as the interval has passed.
+  const auto start_time  = std::chrono::steady_clock::now();
+  const auto start_ticks = ticks();
+  auto end_time          = start_time;
+  while (end_time - start_time < calibration_interval)
+  {
+    end_time = std::chrono::steady_clock::now();
+  }
+  const auto end_ticks = ticks();
+
+  const auto elapsed =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+  // A counter that does not move would otherwise divide by zero.
+  const auto nr_ticks = end_ticks > start_ticks ? end_ticks - start_ticks : tick_type{1};
+
+  Calibration out{};
+  out.multiplier = (static_cast<std::uint64_t>(elapsed) << shift) / nr_ticks;
+  out.base_ticks = ticks();
+  out.base_time  = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+  return out;
+}
+
+auto Feller::TscClock::ticks_per_second() noexcept -> double
+{
+  return static_cast<double>(std::uint64_t{1} << shift) * 1e9 /
+         static_cast<double>(calibration().multiplier);
+}
@@ -0,0 +1,296 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_CLOCK
+#define INCLUDED_FELLER_CLOCK
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "Feller_Feller.hpp"
+
+namespace Feller
+{
+/**
+ SystemClock. This clock policy reads `std::chrono::system_clock`. This is the clock used by
+\ref EventLog.
+
+ Each clock policy in this file provides a `time_point` type and a static `now()` method. The
+time point is always a `std::chrono::system_clock` time point, regardless of how it was measured:
+this means that the choice of clock does not change how logs are stored, formatted or serialised.
+The policies only differ in the cost, resolution and monotonicity of `now()`.
+**/
+class SystemClock
+{
+public:
+  /**
+     time_point. This is the type of time returned by this clock.
+  **/
+  using time_point = std::chrono::time_point<std::chrono::system_clock>;
+
+  /**
+     now. This method returns the current wall-clock time. The result may jump if the system time
+  is changed. This function does not throw.
+     \return the current time.
+  **/
+  static inline time_point now() noexcept { return std::chrono::system_clock::now(); }
+};
+
+/**
+ SteadyClock. This clock policy reads `std::chrono::steady_clock`, and converts the result to
+wall-clock time using an offset that is measured once. The result is monotonic: it does not jump
+if the system time is changed whilst the program runs.
+**/
+class SteadyClock
+{
+public:
+  /**
+     time_point. This is the type of time returned by this clock.
+  **/
+  using time_point = std::chrono::time_point<std::chrono::system_clock>;
+
+  /**
+     now. This method returns the current time. This function does not throw.
+     \return the current time.
+  **/
+  static inline time_point now() noexcept;
+
+private:
+  /**
+     offset. This method returns the wall-clock time at which the steady clock read zero. This is
+  measured on the first call.
+     \return the wall-clock time of the steady clock's epoch.
+  **/
+  static inline time_point::duration offset() noexcept;
+};
+
+/**
+ CoarseClock. This clock policy reads `CLOCK_MONOTONIC_COARSE`, and converts the result to
+wall-clock time using an offset that is measured once. This clock is only updated once per
+scheduler tick (typically every 1-4ms), but reading it is much cheaper than reading the other
+clocks. This makes it a good choice for high-volume logs that only need to be ordered roughly.
+On platforms without `CLOCK_MONOTONIC_COARSE` this clock behaves like \ref SteadyClock.
+**/
+class CoarseClock
+{
+public:
+  /**
+     time_point. This is the type of time returned by this clock.
+  **/
+  using time_point = std::chrono::time_point<std::chrono::system_clock>;
+
+  /**
+     now. This method returns the current time, to the resolution of the coarse clock. This
+  function does not throw.
+     \return the current time.
+  **/
+  static inline time_point now() noexcept;
+
+private:
+  /**
+     read. This method returns the raw value of the coarse clock.
+     \return the time since the coarse clock's epoch.
+  **/
+  static inline time_point::duration read() noexcept;
+
+  /**
+     offset. This method returns the wall-clock time at which the coarse clock read zero. This is
+  measured on the first call.
+     \return the wall-clock time of the coarse clock's epoch.
+  **/
+  static inline time_point::duration offset() noexcept;
+};
+
+/**
+ TscClock. This clock policy reads the CPU's time-stamp counter via `rdtsc`. This is the
+cheapest way to get a nanosecond resolution timestamp on x86, as it does not call into the
+kernel or the vDSO at all. On other platforms the counter is replaced by
+`std::chrono::steady_clock`.
+
+ The counter is converted to wall-clock time using a calibration that is measured once, on the
+first use of this clock: the counter is timed against `std::chrono::steady_clock` over a short
+interval, and then paired with a single reading of the system clock. This takes
+`calibration_interval`, and so programs may wish to call `calibrate` at startup. After that, the
+conversion is a single fixed-point multiplication. Callers that want to defer even this (for
+example, when timing short spans) can store the raw `ticks()` and call `to_time_point` later.
+
+ This clock assumes that the counter runs at a constant rate and is synchronised across cores,
+which is the case on all recent x86 processors (see `constant_tsc` and `nonstop_tsc` in
+`/proc/cpuinfo`). The calibration is accurate to a few parts per million, so times drift slowly
+away from the system clock in long-running programs.
+**/
+class TscClock
+{
+public:
+  /**
+     time_point. This is the type of time returned by this clock.
+  **/
+  using time_point = std::chrono::time_point<std::chrono::system_clock>;
+
+  /**
+     tick_type. This is the type of a raw counter reading.
+  **/
+  using tick_type = std::uint64_t;
+
+  /**
+     calibration_interval. This is the length of time that the counter is timed against the
+  steady clock for during calibration.
+  **/
+  static constexpr std::chrono::milliseconds calibration_interval{10};
+
+  /**
+     now. This method returns the current time. This function does not throw.
+     \return the current time.
+  **/
+  static inline time_point now() noexcept;
+
+  /**
+     ticks. This method returns the raw value of the counter. This function does not throw.
+     \return the current value of the counter.
+  **/
+  static inline tick_type ticks() noexcept;
+
+  /**
+     to_time_point. This method converts a value returned by `ticks` to wall-clock time. This
+  function does not throw.
+     \param ticks: the value of the counter.
+     \return the wall-clock time at which the counter had the value `ticks`.
+  **/
+  static inline time_point to_time_point(tick_type ticks) noexcept;
+
+  /**
+     calibrate. This method calibrates this clock, if it has not been calibrated already. This
+  does not need to be called, but doing so moves the cost of calibration out of the first
+  call to `now`. This function does not throw.
+  **/
+  static inline void calibrate() noexcept;
+
+  /**
+     ticks_per_second. This method returns the measured frequency of the counter. This function
+  does not throw.
+     \return the number of ticks per second.
+  **/
+  static double ticks_per_second() noexcept;
+
+private:
+  /**
+     Calibration. This struct holds the conversion from ticks to wall-clock time. The time at
+  `ticks` is `base_time + ((ticks - base_ticks) * multiplier) >> shift` nanoseconds.
+  **/
+  struct Calibration
+  {
+    tick_type base_ticks;
+    std::int64_t base_time;
+    std::uint64_t multiplier;
+  };
+
+  /**
+     shift. This is the number of fractional bits in Calibration::multiplier.
+  **/
+  static constexpr unsigned shift = 32;
+
+  /**
+     calibration. This method returns the calibration, measuring it on the first call.
+     \return the calibration for this clock.
+  **/
+  static inline const Calibration &calibration() noexcept;
+
+  /**
+     measure. This method measures the calibration. This takes `calibration_interval`.
+     \return a new calibration.
+  **/
+  static Calibration measure() noexcept;
+};
+
+/// INLINE FUNCTIONS
+inline auto SteadyClock::offset() noexcept -> time_point::duration
+{
+  static const auto value =
+      std::chrono::system_clock::now().time_since_epoch() -
+      std::chrono::duration_cast<time_point::duration>(
+          std::chrono::steady_clock::now().time_since_epoch());
+  return value;
+}
+
+inline auto SteadyClock::now() noexcept -> time_point
+{
+  const auto since = std::chrono::steady_clock::now().time_since_epoch();
+  return time_point{offset() + std::chrono::duration_cast<time_point::duration>(since)};
+}
+
+inline auto CoarseClock::read() noexcept -> time_point::duration
+{
+#if defined(CLOCK_MONOTONIC_COARSE)
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  return std::chrono::duration_cast<time_point::duration>(std::chrono::seconds{ts.tv_sec} +
+                                                          std::chrono::nanoseconds{ts.tv_nsec});
+#else
+  return std::chrono::duration_cast<time_point::duration>(
+      std::chrono::steady_clock::now().time_since_epoch());
+#endif
+}
+
+inline auto CoarseClock::offset() noexcept -> time_point::duration
+{
+  static const auto value = std::chrono::system_clock::now().time_since_epoch() - read();
+  return value;
+}
+
+inline auto CoarseClock::now() noexcept -> time_point { return time_point{offset() + read()}; }
+
+inline auto TscClock::ticks() noexcept -> tick_type
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<tick_type>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now().time_since_epoch())
+                                    .count());
+#endif
+}
+
+inline auto TscClock::calibration() noexcept -> const Calibration &
+{
+  static const Calibration value = measure();
+  return value;
+}
+
+inline void TscClock::calibrate() noexcept { static_cast<void>(calibration()); }
+
+inline auto TscClock::to_time_point(const tick_type ticks) noexcept -> time_point
+{
+  __extension__ using int128 = __int128;
+  const auto &c = calibration();
+  // The difference is signed, so that ticks read before the calibration are still converted.
+  const auto delta = static_cast<std::int64_t>(ticks - c.base_ticks);
+  const auto ns    = static_cast<std::int64_t>((int128{delta} * c.multiplier) >> shift);
+  return time_point{std::chrono::duration_cast<time_point::duration>(
+      std::chrono::nanoseconds{c.base_time + ns})};
+}
+
+inline auto TscClock::now() noexcept -> time_point { return to_time_point(ticks()); }
+
+}  // namespace Feller
+
+#endif
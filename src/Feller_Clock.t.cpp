@@ -0,0 +1,88 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_Clock.hpp"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using Time = std::chrono::time_point<std::chrono::system_clock>;
+
+// Every clock should agree with the system clock to within this tolerance.
+static constexpr std::chrono::milliseconds tolerance{50};
+
+template <typename Clock> static void check_wall_clock()
+{
+  const auto before = std::chrono::system_clock::now();
+  const Time now    = Clock::now();
+  const auto after  = std::chrono::system_clock::now();
+  EXPECT_GE(now, before - tolerance);
+  EXPECT_LE(now, after + tolerance);
+}
+
+template <typename Clock> static void check_monotonic()
+{
+  auto last = Clock::now();
+  for (unsigned i = 0; i < 100000; i++)
+  {
+    const auto now = Clock::now();
+    ASSERT_GE(now, last);
+    last = now;
+  }
+}
+
+TEST(Clock, testSystemClock) { check_wall_clock<Feller::SystemClock>(); }
+
+TEST(Clock, testSteadyClock)
+{
+  check_wall_clock<Feller::SteadyClock>();
+  check_monotonic<Feller::SteadyClock>();
+}
+
+TEST(Clock, testCoarseClock)
+{
+  check_wall_clock<Feller::CoarseClock>();
+  check_monotonic<Feller::CoarseClock>();
+}
+
+TEST(Clock, testTscClock)
+{
+  Feller::TscClock::calibrate();
+  check_wall_clock<Feller::TscClock>();
+  check_monotonic<Feller::TscClock>();
+  EXPECT_GT(Feller::TscClock::ticks_per_second(), 0.0);
+}
+
+TEST(Clock, testTscTicks)
+{
+  // Raw ticks can be converted later, and the conversion is consistent with now().
+  const auto start = Feller::TscClock::ticks();
+  std::this_thread::sleep_for(std::chrono::milliseconds{20});
+  const auto end = Feller::TscClock::ticks();
+
+  const auto elapsed =
+      Feller::TscClock::to_time_point(end) - Feller::TscClock::to_time_point(start);
+  EXPECT_GE(elapsed, std::chrono::milliseconds{20});
+  EXPECT_LT(elapsed, std::chrono::seconds{1});
+
+  const auto expected = static_cast<double>(end - start) / Feller::TscClock::ticks_per_second();
+  const auto actual   = std::chrono::duration<double>(elapsed).count();
+  EXPECT_LT(std::abs(actual - expected), 1e-6);
+}
@@ -0,0 +1,689 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_COLUMNAR_LOG_STORAGE
+#define INCLUDED_FELLER_COLUMNAR_LOG_STORAGE
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Feller_Feller.hpp"
+
+#include "Feller_AuxData.hpp"
+#include "Feller_Data.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_StringTable.hpp"
+
+namespace Feller
+{
+/**
+ ColumnarLogStorage. This class implements a struct-of-arrays store for event logs. Rather than
+holding each \ref EventLog as a single object, this class splits every field into its own
+contiguous column:
+
+ - the time of each log.
+ - the name of each log, as its id in the global \ref StringTable. Since \ref EventLog already
+   interns its name, storing a name is just a copy of an integer.
+ - the parameters of every log, in a single flat array, along with the offset of the first
+   parameter of each log.
+ - the auxiliary data of each log. Most logs carry none, so each log only stores a 4 byte index
+   into a side table that holds the data of the logs that do.
+
+ This means that a pass that only reads the time and the name of each log (which is most analysis
+passes) streams through 12 bytes per log, rather than dragging every string, parameter vector and
+data pointer through the cache.
+
+ For existing callers, iterators dereference to a \ref log_view: a small proxy that exposes the
+same read-only interface as \ref EventLog (`name`, `time`, `size`, `cbegin`, `cend`, `aux` and
+`to_string`) and converts to a full \ref EventLog on demand. Hot loops may instead use the columns
+directly via `times`, `name_ids` and `name_of`.
+
+ \tparam LogType: the type of log to be stored in this class. This must be \ref EventLog.
+ \tparam KeyType: not used in this class.
+**/
+template <typename LogType, typename KeyType = char /*unused*/> class ColumnarLogStorage
+{
+  static_assert(std::is_same<LogType, EventLog>::value,
+                "Error: ColumnarLogStorage can only store EventLog objects.");
+
+public:
+  /**
+     size_type. This type is used to represent sizes and indices in this object.
+  **/
+  using size_type = std::size_t;
+
+  /**
+     time_type. This is the type of the time column.
+  **/
+  using time_type = std::chrono::time_point<std::chrono::system_clock>;
+
+  /**
+     name_id. This is the type of the name column. Each id refers to an entry in the global
+  \ref StringTable.
+  **/
+  using name_id = StringTable::id_type;
+
+  /**
+     no_name. This id is returned by `find_name` for names that have never been interned.
+  **/
+  static constexpr name_id no_name = StringTable::npos;
+
+  /**
+     parameter_iterator. This type is used to iterate over the parameters of a single log.
+  **/
+  using parameter_iterator = EventLog::const_iterator;
+
+  /**
+     log_view. This class is a read-only view of a single log in this object. This mirrors the
+  getters of \ref EventLog. A view is invalidated by any insertion.
+  **/
+  class log_view
+  {
+  public:
+    /// These behave exactly as the methods of the same name in \ref EventLog.
+    inline const std::string &name() const noexcept;
+    inline time_type time() const noexcept;
+    inline size_type size() const noexcept;
+    inline parameter_iterator cbegin() const noexcept;
+    inline parameter_iterator cend() const noexcept;
+    inline const AuxData &aux() const noexcept;
+    inline std::string to_string() const;
+
+    /**
+       to_log. This method builds a copy of the viewed log. This function may throw due to
+    allocation failures.
+       \return a copy of the log.
+    **/
+    inline LogType to_log() const;
+
+    /// This conversion allows a view to be passed wherever a log is expected.
+    inline operator LogType() const { return to_log(); }
+
+    /**
+       ==. A view compares equal to a log if the log is a copy of the viewed log.
+    **/
+    inline friend bool operator==(const log_view &lhs, const LogType &rhs) noexcept
+    {
+      return lhs.equals(rhs);
+    }
+    inline friend bool operator==(const LogType &lhs, const log_view &rhs) noexcept
+    {
+      return rhs.equals(lhs);
+    }
+    inline friend bool operator!=(const log_view &lhs, const LogType &rhs) noexcept
+    {
+      return !lhs.equals(rhs);
+    }
+    inline friend bool operator!=(const LogType &lhs, const log_view &rhs) noexcept
+    {
+      return !rhs.equals(lhs);
+    }
+
+    inline friend std::ostream &operator<<(std::ostream &os, const log_view &view)
+    {
+      os << view.to_string();
+      return os;
+    }
+
+  private:
+    friend class ColumnarLogStorage;
+    log_view(const ColumnarLogStorage *storage, const size_type index)
+        : m_storage{storage}, m_index{index}
+    {
+    }
+
+    inline bool equals(const LogType &log) const noexcept;
+
+    const ColumnarLogStorage *m_storage;
+    size_type m_index;
+  };
+
+  /**
+     const_iterator. This class provides random access to the logs in this object. Since logs
+  are not stored as objects, this is a proxy iterator: dereferencing it returns a \ref log_view
+  by value.
+  **/
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = log_view;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = log_view;
+
+    /**
+       pointer. This holds a view so that `it->name()` works.
+    **/
+    struct pointer
+    {
+      log_view view;
+      const log_view *operator->() const noexcept { return &view; }
+    };
+
+    const_iterator() = default;
+
+    reference operator*() const { return log_view{m_storage, static_cast<size_type>(m_index)}; }
+    pointer operator->() const { return pointer{**this}; }
+    reference operator[](const difference_type n) const { return *(*this + n); }
+
+    const_iterator &operator++()
+    {
+      ++m_index;
+      return *this;
+    }
+
+    const_iterator operator++(int)
+    {
+      auto tmp = *this;
+      ++m_index;
+      return tmp;
+    }
+
+    const_iterator &operator--()
+    {
+      --m_index;
+      return *this;
+    }
+
+    const_iterator operator--(int)
+    {
+      auto tmp = *this;
+      --m_index;
+      return tmp;
+    }
+
+    const_iterator &operator+=(const difference_type n)
+    {
+      m_index += n;
+      return *this;
+    }
+
+    const_iterator &operator-=(const difference_type n)
+    {
+      m_index -= n;
+      return *this;
+    }
+
+    friend const_iterator operator+(const_iterator it, const difference_type n) { return it += n; }
+    friend const_iterator operator+(const difference_type n, const_iterator it) { return it += n; }
+    friend const_iterator operator-(const_iterator it, const difference_type n) { return it -= n; }
+    friend difference_type operator-(const const_iterator &lhs, const const_iterator &rhs)
+    {
+      return lhs.m_index - rhs.m_index;
+    }
+
+    friend bool operator==(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return lhs.m_storage == rhs.m_storage && lhs.m_index == rhs.m_index;
+    }
+    friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return !(lhs == rhs);
+    }
+    friend bool operator<(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return lhs.m_index < rhs.m_index;
+    }
+    friend bool operator>(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return rhs < lhs;
+    }
+    friend bool operator<=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return !(rhs < lhs);
+    }
+    friend bool operator>=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return !(lhs < rhs);
+    }
+
+  private:
+    friend class ColumnarLogStorage;
+    const_iterator(const ColumnarLogStorage *storage, const difference_type index)
+        : m_storage{storage}, m_index{index}
+    {
+    }
+
+    const ColumnarLogStorage *m_storage{nullptr};
+    difference_type m_index{0};
+  };
+
+  /**
+     ColumnarLogStorage. This constructor builds an empty store. The parameter offsets column
+  always holds one more entry than there are logs, so this constructor may throw due to
+  allocation failures.
+  **/
+  ColumnarLogStorage();
+
+  /**
+     insert. This method copies `log` into the columns of this object. This function may throw
+  due to allocation failures: in this case the log is not stored.
+     \param log: the log to be copied into this object.
+  **/
+  inline void insert(const LogType &log);
+
+  /**
+     insert. This method moves `log` into the columns of this object. Only the auxiliary data is
+  moved, as EventLog does not allow its strings to be moved out.
+     \param log: the log to be moved into this object.
+  **/
+  inline void insert(LogType &&log);
+
+  /**
+     emplace_back. This method builds a log from `args` and moves it into this object.
+     \param args: the arguments to be forwarded to the constructor of the log.
+  **/
+  template <typename... Args> inline void emplace_back(Args &&...args);
+
+  /**
+     operator[]. This method returns a view of the `index`-th log in this object.
+     \param index: the position of the log.
+     \return a view of the log.
+  **/
+  inline log_view operator[](const size_type index) const noexcept;
+
+  /**
+     size. This method returns the number of logs in this object.
+     \return the number of logs in this object.
+  **/
+  inline size_type size() const noexcept;
+
+  /**
+     times. This method returns the time column. The `i`-th entry is the time of the `i`-th log.
+     \return a const reference to the time column.
+  **/
+  inline const std::vector<time_type> &times() const noexcept;
+
+  /**
+     name_ids. This method returns the name column. The `i`-th entry is the id of the name of
+  the `i`-th log.
+     \return a const reference to the name column.
+  **/
+  inline const std::vector<name_id> &name_ids() const noexcept;
+
+  /**
+     name_of. This method returns the name with id `id`. The behaviour of this function is
+  undefined if `id` was not returned by this object.
+     \param id: the id of the name.
+     \return a const reference to the name.
+  **/
+  inline const std::string &name_of(const name_id id) const noexcept;
+
+  /**
+     find_name. This method returns the id of `name`, if `name` has been interned. This allows
+  a scan to compare names as integers. This method does not intern `name`, and does not throw.
+     \param name: the name to be found.
+     \return the id of `name`, or `no_name` if `name` has never been interned.
+  **/
+  inline name_id find_name(const std::string &name) const noexcept;
+
+  /**
+     cbegin. This method returns a const iterator to the first log in this object.
+     \return a const iterator to the first log.
+  **/
+  inline const_iterator cbegin() const noexcept;
+
+  /**
+     cend. This method returns a const iterator to one past the last log in this object.
+     \return a const iterator to the end of the logs.
+  **/
+  inline const_iterator cend() const noexcept;
+
+  /// Overloads of cbegin and cend to allow range-based for loops.
+  inline const_iterator begin() const noexcept;
+  inline const_iterator end() const noexcept;
+
+  /**
+     clear. This method removes every log from this object. Names stay in the global
+  \ref StringTable, so that names that are logged again are not re-interned.
+  **/
+  inline void clear() noexcept;
+
+  /**
+      operator<<. Prints a string representation of the object ``st`` to the
+      specified ostream ``os`. This method may throw.
+      \tparam LT: the type stored in st.
+      \param os: the stream to print the storage object to.
+      \param st: the object to be printed.
+      \return the os parameter.
+   **/
+  template <typename LT, typename KT>
+  inline friend std::ostream &operator<<(std::ostream &os, const ColumnarLogStorage<LT, KT> &st);
+
+private:
+  /**
+     make_room. This method ensures that `column` can hold one more entry without reallocating.
+  Like push_back, this grows the column geometrically.
+     \param column: the column to be grown.
+  **/
+  template <typename T> static inline void make_room(std::vector<T> &column);
+
+  /**
+     append. This method implements each of the insertion methods.
+     \param log: the log to be inserted.
+     \param aux: the auxiliary data of the log. This is only moved from once nothing else can
+  throw.
+  **/
+  inline void append(const LogType &log, AuxData &&aux);
+
+  /**
+     aux_id. This is the type of the auxiliary data column. Each id refers to an entry in m_aux.
+  **/
+  using aux_id = std::uint32_t;
+
+  /**
+     no_aux. This id is stored for logs that do not have any auxiliary data.
+  **/
+  static constexpr aux_id no_aux = std::numeric_limits<aux_id>::max();
+
+  /**
+     m_times. This is the time column.
+  **/
+  std::vector<time_type> m_times{};
+
+  /**
+     m_names. This is the name column.
+  **/
+  std::vector<name_id> m_names{};
+
+  /**
+     m_offsets. The parameters of the `i`-th log are in [m_offsets[i], m_offsets[i + 1]) of
+  m_parameters.
+  **/
+  std::vector<size_type> m_offsets{};
+
+  /**
+     m_parameters. These are the parameters of every log, one log after another. This is the same
+  type of vector as in \ref EventLog, so that views can hand out EventLog::const_iterator.
+  **/
+  std::pmr::vector<EventLog::parameter_type> m_parameters{};
+
+  /**
+     m_aux_ids. This is the auxiliary data column. It holds `no_aux` for logs without any.
+  **/
+  std::vector<aux_id> m_aux_ids{};
+
+  /**
+     m_aux. This is the auxiliary data of the logs that have any, in insertion order.
+  **/
+  std::vector<AuxData> m_aux{};
+};
+
+/// INLINE FUNCTIONS
+template <typename LogType, typename KeyType>
+Feller::ColumnarLogStorage<LogType, KeyType>::ColumnarLogStorage() : m_offsets(1, 0)
+{
+}
+
+template <typename LogType, typename KeyType>
+inline std::ostream &operator<<(std::ostream &os, const ColumnarLogStorage<LogType, KeyType> &st)
+{
+  for (const auto v : st)
+  {
+    os << v;
+  }
+  return os;
+}
+
+template <typename LogType, typename KeyType>
+template <typename T>
+inline void Feller::ColumnarLogStorage<LogType, KeyType>::make_room(std::vector<T> &column)
+{
+  if (column.size() == column.capacity())
+  {
+    column.reserve(column.empty() ? 16 : 2 * column.size());
+  }
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::ColumnarLogStorage<LogType, KeyType>::append(const LogType &log,
+                                                                 AuxData &&aux)
+{
+  // Each column is grown before anything is written, so that a failure leaves the columns
+  // consistent with each other.
+  make_room(m_times);
+  make_room(m_names);
+  make_room(m_offsets);
+  make_room(m_aux_ids);
+  if (aux != nullptr)
+  {
+    if (m_aux.size() == no_aux)
+    {
+      throw std::length_error("Error: too many logs with auxiliary data.");
+    }
+    make_room(m_aux);
+  }
+
+  const auto first = m_parameters.size();
+  try
+  {
+    m_parameters.insert(m_parameters.end(), log.cbegin(), log.cend());
+  }
+  catch (...)
+  {
+    m_parameters.resize(first);
+    throw;
+  }
+
+  m_times.push_back(log.time());
+  m_names.push_back(log.interned_name().id());
+  m_offsets.push_back(m_parameters.size());
+  if (aux == nullptr)
+  {
+    m_aux_ids.push_back(no_aux);
+    return;
+  }
+  m_aux_ids.push_back(static_cast<aux_id>(m_aux.size()));
+  m_aux.push_back(std::move(aux));
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::ColumnarLogStorage<LogType, KeyType>::insert(const LogType &log)
+{
+  append(log, AuxData{log.aux()});
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::ColumnarLogStorage<LogType, KeyType>::insert(LogType &&log)
+{
+  // The aux data is only moved once the log has been stored.
+  append(log, std::move(log.aux()));
+}
+
+template <typename LogType, typename KeyType>
+template <typename... Args>
+inline void Feller::ColumnarLogStorage<LogType, KeyType>::emplace_back(Args &&...args)
+{
+  insert(LogType(std::forward<Args>(args)...));
+}
+
+template <typename LogType, typename KeyType>
+inline auto
+Feller::ColumnarLogStorage<LogType, KeyType>::operator[](const size_type index) const noexcept
+    -> log_view
+{
+  return log_view{this, index};
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ColumnarLogStorage<LogType, KeyType>::size() const noexcept -> size_type
+{
+  return m_times.size();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ColumnarLogStorage<LogType, KeyType>::times() const noexcept
+    -> const std::vector<time_type> &
+{
+  return m_times;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ColumnarLogStorage<LogType, KeyType>::name_ids() const noexcept
+    -> const std::vector<name_id> &
+{
+  return m_names;
+}
+
+template <typename LogType, typename KeyType>
+inline const std::string &
+Feller::ColumnarLogStorage<LogType, KeyType>::name_of(const name_id id) const noexcept
+{
+  return StringTable::global().str(id);
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ColumnarLogStorage<LogType, KeyType>::find_name(
+    const std::string &name) const noexcept -> name_id
+{
+  return StringTable::global().find(name);
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ColumnarLogStorage<LogType, KeyType>::cbegin() const noexcept
+    -> const_iterator
+{
+  return const_iterator{this, 0};
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ColumnarLogStorage<LogType, KeyType>::cend() const noexcept -> const_iterator
+{
+  return const_iterator{this, static_cast<std::ptrdiff_t>(m_times.size())};
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ColumnarLogStorage<LogType, KeyType>::begin() const noexcept -> const_iterator
+{
+  return cbegin();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ColumnarLogStorage<LogType, KeyType>::end() const noexcept -> const_iterator
+{
+  return cend();
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::ColumnarLogStorage<LogType, KeyType>::clear() noexcept
+{
+  m_times.clear();
+  m_names.clear();
+  m_offsets.resize(1);
+  m_parameters.clear();
+  m_aux_ids.clear();
+  m_aux.clear();
+}
+
+template <typename LogType, typename KeyType>
+inline const std::string &
+Feller::ColumnarLogStorage<LogType, KeyType>::log_view::name() const noexcept
+{
+  return StringTable::global().str(m_storage->m_names[m_index]);
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ColumnarLogStorage<LogType, KeyType>::log_view::time() const noexcept
+    -> time_type
+{
+  return m_storage->m_times[m_index];
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ColumnarLogStorage<LogType, KeyType>::log_view::size() const noexcept
+    -> size_type
+{
+  return m_storage->m_offsets[m_index + 1] - m_storage->m_offsets[m_index];
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ColumnarLogStorage<LogType, KeyType>::log_view::cbegin() const noexcept
+    -> parameter_iterator
+{
+  const auto offset = static_cast<std::ptrdiff_t>(m_storage->m_offsets[m_index]);
+  return m_storage->m_parameters.cbegin() + offset;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ColumnarLogStorage<LogType, KeyType>::log_view::cend() const noexcept
+    -> parameter_iterator
+{
+  const auto offset = static_cast<std::ptrdiff_t>(m_storage->m_offsets[m_index + 1]);
+  return m_storage->m_parameters.cbegin() + offset;
+}
+
+template <typename LogType, typename KeyType>
+inline const AuxData &
+Feller::ColumnarLogStorage<LogType, KeyType>::log_view::aux() const noexcept
+{
+  static const AuxData none{};
+  const auto id = m_storage->m_aux_ids[m_index];
+  return id == no_aux ? none : m_storage->m_aux[id];
+}
+
+template <typename LogType, typename KeyType>
+inline LogType Feller::ColumnarLogStorage<LogType, KeyType>::log_view::to_log() const
+{
+  LogType log{name(), time()};
+  log.reserve(size());
+  for (auto it = cbegin(); it != cend(); ++it)
+  {
+    log.emplace_back(*it);
+  }
+
+  log.aux() = aux();
+  return log;
+}
+
+template <typename LogType, typename KeyType>
+inline std::string Feller::ColumnarLogStorage<LogType, KeyType>::log_view::to_string() const
+{
+  return to_log().to_string();
+}
+
+template <typename LogType, typename KeyType>
+inline bool
+Feller::ColumnarLogStorage<LogType, KeyType>::log_view::equals(const LogType &log) const noexcept
+{
+  if (m_storage->m_names[m_index] != log.interned_name().id() || time() != log.time() ||
+      !std::equal(cbegin(), cend(), log.cbegin(), log.cend()))
+  {
+    return false;
+  }
+
+  if (aux() == nullptr || log.aux() == nullptr)
+  {
+    return aux() == log.aux();
+  }
+  return *aux() == *log.aux();
+}
+
+}  // namespace Feller
+
+#endif
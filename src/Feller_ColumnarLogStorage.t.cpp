@@ -0,0 +1,172 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_ColumnarLogStorage.hpp"
+#include "Feller_ContiguousLogStorage.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_LogEverything.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_NoLock.hpp"
+#include "Feller_TestData.hpp"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+using Storage = Feller::ColumnarLogStorage<Feller::EventLog>;
+
+Feller::EventLog make_log(const unsigned i)
+{
+  Feller::EventLog log{"Log " + std::to_string(i % 3), std::chrono::system_clock::now()};
+  for (unsigned j = 0; j < i % 4; j++)
+  {
+    log.emplace_back("key" + std::to_string(j), std::to_string(i));
+  }
+  if (i % 5 == 0)
+  {
+    log.aux() = std::make_unique<Feller::TestData>();
+  }
+  return log;
+}
+
+TEST(ColumnarLogStorage, testInsertAndView)
+{
+  Storage storage;
+  std::vector<Feller::EventLog> logs;
+  for (unsigned i = 0; i < 100; i++)
+  {
+    logs.push_back(make_log(i));
+    storage.insert(logs.back());
+  }
+
+  ASSERT_EQ(storage.size(), logs.size());
+  for (unsigned i = 0; i < logs.size(); i++)
+  {
+    const auto view = storage[i];
+    EXPECT_EQ(view.name(), logs[i].name());
+    EXPECT_EQ(view.time(), logs[i].time());
+    EXPECT_EQ(view.size(), logs[i].size());
+    EXPECT_TRUE(std::equal(view.cbegin(), view.cend(), logs[i].cbegin(), logs[i].cend()));
+    EXPECT_EQ(view.aux() == nullptr, logs[i].aux() == nullptr);
+    EXPECT_EQ(view, logs[i]);
+    EXPECT_EQ(view.to_log(), logs[i]);
+    EXPECT_EQ(view.to_string(), logs[i].to_string());
+  }
+
+  EXPECT_TRUE(std::equal(storage.cbegin(), storage.cend(), logs.cbegin(), logs.cend()));
+  EXPECT_EQ(storage.cbegin()->name(), "Log 0");
+  EXPECT_EQ((storage.cend() - 1)->name(), "Log 0");
+  EXPECT_NE(storage[1], logs[2]);
+}
+
+TEST(ColumnarLogStorage, testMoveKeepsAux)
+{
+  Storage storage;
+  auto log        = make_log(0);
+  const auto copy = log;
+  auto *const aux = log.aux().get();
+  storage.insert(std::move(log));
+  EXPECT_EQ(storage[0].aux().get(), aux);
+  EXPECT_EQ(storage[0], copy);
+}
+
+TEST(ColumnarLogStorage, testSparseAux)
+{
+  // Only every fifth log has aux data, and each view must still find its own.
+  Storage storage;
+  for (unsigned round = 0; round < 2; round++)
+  {
+    storage.clear();
+    std::vector<Feller::Data *> expected;
+    for (unsigned i = 0; i < 23; i++)
+    {
+      auto log = make_log(i + round);
+      expected.push_back(log.aux().get());
+      storage.insert(std::move(log));
+    }
+    for (unsigned i = 0; i < expected.size(); i++)
+    {
+      EXPECT_EQ(storage[i].aux().get(), expected[i]);
+    }
+  }
+}
+
+TEST(ColumnarLogStorage, testColumns)
+{
+  Storage storage;
+  for (unsigned i = 0; i < 9; i++)
+  {
+    storage.insert(make_log(i));
+  }
+
+  // Names are interned, so there is only one id per distinct name.
+  const auto id = storage.find_name("Log 1");
+  ASSERT_NE(id, Storage::no_name);
+  EXPECT_EQ(storage.name_of(id), "Log 1");
+  EXPECT_EQ(storage.find_name("Missing"), Storage::no_name);
+  EXPECT_EQ(std::count(storage.name_ids().cbegin(), storage.name_ids().cend(), id), 3);
+  EXPECT_EQ(storage.times().size(), 9);
+  EXPECT_EQ(storage.times()[4], storage[4].time());
+}
+
+TEST(ColumnarLogStorage, testClear)
+{
+  Storage storage;
+  storage.insert(make_log(3));
+  storage.clear();
+  EXPECT_EQ(storage.size(), 0);
+  EXPECT_EQ(storage.cbegin(), storage.cend());
+
+  const auto log = make_log(2);
+  storage.insert(log);
+  EXPECT_EQ(storage[0], log);
+  EXPECT_EQ(storage[0].size(), 2);
+}
+
+TEST(ColumnarLogStorage, testPrint)
+{
+  Storage storage;
+  Feller::ContiguousLogStorage<Feller::EventLog> contiguous;
+  for (unsigned i = 0; i < 5; i++)
+  {
+    storage.insert(make_log(i));
+    contiguous.insert(make_log(i));
+  }
+
+  std::ostringstream lhs, rhs;
+  lhs << storage;
+  rhs << contiguous;
+  EXPECT_EQ(lhs.str().size(), rhs.str().size());
+}
+
+TEST(ColumnarLogStorage, testWithLogger)
+{
+  Feller::Logger<Feller::EventLog, char, Feller::ColumnarLogStorage, Feller::NoLock,
+                 Feller::LogEverything>
+      logger;
+  logger.insert(Feller::EventLog{"abc", "def"});
+  logger.emplace("ghi");
+  ASSERT_EQ(logger.size(), 2);
+
+  std::vector<std::string> names;
+  for (const auto v : logger)
+  {
+    names.push_back(v.name());
+  }
+  EXPECT_EQ(names, (std::vector<std::string>{"Inserted", "ghi"}));
+  EXPECT_EQ(logger.cbegin()->cbegin()->second, "def");
+}
@@ -19,6 +19,7 @@
 #ifndef INCLUDED_FELLER_CONTIGUOUS_LOG_STORAGE
 #define INCLUDED_FELLER_CONTIGUOUS_LOG_STORAGE
 
+#include <memory_resource>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -30,19 +31,40 @@ namespace Feller
 /**
  ContiguousLogStorage. This class implements a contiguous container that stores
 particular logs. This type stores all data contiguously: more specifically, for
-some log type LogT, this class inherits from std::vector<LogT> and provides an
+some log type LogT, this class inherits from std::pmr::vector<LogT> and provides an
 additional friend function for serialisation. Note that this class publicly
 inherits from std::vector so that maximal functionality can exist for clients of
 this particular class.
 
+ Every allocation made by this class comes from a `std::pmr::memory_resource`, which
+is the default resource (i.e global new and delete) unless one is passed to the
+constructor. Allocator-aware logs (such as \ref EventLog) are given the same
+resource, so that their own allocations come from it too. This means that, with a
+`std::pmr::monotonic_buffer_resource`, a whole store can be torn down by releasing
+the resource, rather than by one free per log.
  \tparam LogType: the type of log to be stored in this class.
  \tparam KeyType: not used in this class.
 **/
-
 template <typename LogType, typename KeyType = char /*unused*/>
-class ContiguousLogStorage : public std::vector<LogType>
+class ContiguousLogStorage : public std::pmr::vector<LogType>
 {
 public:
+  /**
+     ContiguousLogStorage. This constructor builds an empty store that uses the default memory
+  resource.
+  **/
+  ContiguousLogStorage() = default;
+
+  /**
+     ContiguousLogStorage. This constructor builds an empty store that allocates from `resource`.
+  This does not take ownership of `resource`, which must outlive this object.
+     \param resource: the memory resource to allocate from.
+  **/
+  explicit ContiguousLogStorage(std::pmr::memory_resource *const resource) noexcept
+      : std::pmr::vector<LogType>(resource)
+  {
+  }
+
   /**
       operator<<. Prints a string representation of the object ``st`` to the
       specified ostream ``os`. This method may throw.
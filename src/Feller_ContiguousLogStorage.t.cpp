@@ -18,8 +18,12 @@
  ****/
 
 #include "Feller_ContiguousLogStorage.hpp"
+#include "Feller_EventLog.hpp"
 #include "gtest/gtest.h"
 
+#include <memory_resource>
+#include <string>
+
 TEST(ContiguousLogStorage, testOstream)
 {
 
@@ -63,3 +67,40 @@ TEST(ContiguousLogStorage, testInsertMove)
   EXPECT_EQ(log.size(), 1);
   EXPECT_EQ(log[0], d);
 }
+
+TEST(ContiguousLogStorage, testMemoryResource)
+{
+  const std::string value = "a value that is long enough to be allocated";
+  const Feller::EventLog copied{"key", value};
+  Feller::EventLog moved{"key", value};
+
+  std::pmr::monotonic_buffer_resource resource;
+  Feller::ContiguousLogStorage<Feller::EventLog> log{&resource};
+
+  // Any allocation from the default resource now throws, so every allocation made below for the
+  // stored logs must come from `resource`.
+  auto *const previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+  try
+  {
+    for (unsigned i = 0; i < 100; i++)
+    {
+      log.emplace_back("key", value);
+    }
+    log.insert(copied);
+    log.insert(std::move(moved));
+  }
+  catch (...)
+  {
+    std::pmr::set_default_resource(previous);
+    throw;
+  }
+  std::pmr::set_default_resource(previous);
+
+  ASSERT_EQ(log.size(), 102);
+  for (const auto &stored : log)
+  {
+    EXPECT_EQ(stored.get_allocator().resource(), &resource);
+    ASSERT_EQ(stored.size(), 1);
+    EXPECT_EQ(stored.cbegin()->second, value);
+  }
+}
@@ -0,0 +1,99 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_DataArena.hpp"
+
+Feller::DataArena::DataArena(DataArena &&other) noexcept
+    : m_chunk_size{other.m_chunk_size}, m_chunks{std::move(other.m_chunks)},
+      m_next{std::exchange(other.m_next, 0)}, m_large{std::move(other.m_large)},
+      m_objects{std::move(other.m_objects)}, m_pos{std::exchange(other.m_pos, nullptr)},
+      m_end{std::exchange(other.m_end, nullptr)}
+{
+  other.m_chunks.clear();
+  other.m_large.clear();
+  other.m_objects.clear();
+}
+
+auto Feller::DataArena::operator=(DataArena &&other) noexcept -> DataArena &
+{
+  if (this != &other)
+  {
+    release();
+    m_chunk_size = other.m_chunk_size;
+    m_chunks     = std::move(other.m_chunks);
+    m_next       = std::exchange(other.m_next, 0);
+    m_large      = std::move(other.m_large);
+    m_objects    = std::move(other.m_objects);
+    m_pos        = std::exchange(other.m_pos, nullptr);
+    m_end        = std::exchange(other.m_end, nullptr);
+    other.m_chunks.clear();
+    other.m_large.clear();
+    other.m_objects.clear();
+  }
+  return *this;
+}
+
+void Feller::DataArena::release() noexcept
+{
+  for (auto it = m_objects.rbegin(); it != m_objects.rend(); ++it)
+  {
+    (*it)->~Data();
+  }
+
+  m_objects.clear();
+  m_large.clear();
+  m_next = 0;
+  m_pos  = nullptr;
+  m_end  = nullptr;
+}
+
+void *Feller::DataArena::allocate(const std::size_t size, const std::size_t align)
+{
+  const auto aligned = [align](unsigned char *const pos) {
+    const auto address = reinterpret_cast<std::uintptr_t>(pos);
+    return pos + ((align - address % align) % align);
+  };
+
+  auto *start = aligned(m_pos);
+  if (m_pos != nullptr && start + size <= m_end)
+  {
+    m_pos = start + size;
+    return start;
+  }
+
+  // Objects that could never fit in a chunk get a chunk of their own, leaving the current chunk
+  // as it is. Each chunk is stored before it is used, so that it is freed if push_back throws.
+  if (size + align > m_chunk_size)
+  {
+    m_large.push_back(std::unique_ptr<unsigned char[]>{new unsigned char[size + align]});
+    return aligned(m_large.back().get());
+  }
+
+  if (m_next == m_chunks.size())
+  {
+    m_chunks.push_back(std::unique_ptr<unsigned char[]>{new unsigned char[m_chunk_size]});
+  }
+
+  m_pos = aligned(m_chunks[m_next].get());
+  m_end = m_chunks[m_next].get() + m_chunk_size;
+  ++m_next;
+
+  start = m_pos;
+  m_pos = start + size;
+  return start;
+}
@@ -0,0 +1,202 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_DATA_ARENA
+#define INCLUDED_FELLER_DATA_ARENA
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Feller_Feller.hpp"
+
+#include "Feller_Data.hpp"
+
+namespace Feller
+{
+/**
+ ArenaDeleter. This is the deleter used for \ref Data allocated from a \ref DataArena. Objects in
+an arena are owned by the arena, so this deleter does nothing: the object is destroyed when the
+arena is released.
+**/
+struct ArenaDeleter
+{
+  inline void operator()(const Data *) const noexcept {}
+};
+
+/**
+ arena_ptr. This is the type of a handle to \ref Data allocated from a \ref DataArena. This can be
+assigned to the aux data of a log (see \ref AuxData).
+**/
+template <typename T> using arena_ptr = std::unique_ptr<T, ArenaDeleter>;
+
+/**
+ DataArena. This class allocates \ref Data objects with a bump pointer, out of large chunks of
+memory, and releases them all at once. This is designed for logs with large auxiliary data: rather
+than paying a call to global new and delete per object, each allocation is a few instructions, and
+releasing millions of objects runs their destructors and resets a bump pointer.
+
+ The arena owns every object that it allocates. Each object lives until `release` is called (or
+the arena is destroyed), regardless of what happens to the handles returned by `make`. This means
+that logs holding arena data must not be used once the arena has been released: \ref Logger
+releases its arena in `clear`, once its store has been cleared. Copying a log copies arena data to
+the heap (via \ref Data::copy), so copies are not affected.
+
+ `make` is thread-safe: it takes a mutex that is private to the arena, so many threads may build
+data in one arena at once, even if they share a \ref Logger that has no lock of its own (e.g
+one that uses \ref NoLock). An uncontended lock costs far less than a call to global new. The
+other methods are not thread-safe: in particular, `release` must not run at the same time as
+`make`, or whilst any log holding arena data is in use.
+**/
+class DataArena
+{
+public:
+  /**
+     default_chunk_size. This is the size of each chunk if no size is specified.
+  **/
+  static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+  /**
+     DataArena. This constructor builds an empty arena. No memory is allocated until the first
+  call to `make`.
+     \param chunk_size: the size of each chunk. Larger objects get a chunk of their own.
+  **/
+  explicit DataArena(const std::size_t chunk_size = default_chunk_size) noexcept
+      : m_chunk_size{chunk_size}
+  {
+  }
+
+  // The objects in an arena belong to that arena, so arenas can be moved but not copied.
+  DataArena(const DataArena &)            = delete;
+  DataArena &operator=(const DataArena &) = delete;
+  DataArena(DataArena &&other) noexcept;
+  DataArena &operator=(DataArena &&other) noexcept;
+
+  /**
+     ~DataArena. This destroys every object in the arena and frees its memory.
+  **/
+  ~DataArena() { release(); }
+
+  /**
+     make. This method builds a `T` from `args` inside the arena. This method is safe to call from
+  many threads at once. This method may throw due to allocation failures, or if the constructor of
+  `T` throws.
+     \tparam T: the type of data to be built. This must derive from \ref Data.
+     \param args: the arguments to be forwarded to the constructor of `T`.
+     \return a handle to the new object. This does not own the object.
+  **/
+  template <typename T, typename... Args> inline arena_ptr<T> make(Args &&...args);
+
+  /**
+     release. This method destroys every object in the arena, newest first. Any handle to an
+  object in this arena is left dangling. Chunks of the default size are kept and reused by later
+  calls to `make`, much like `std::vector::clear`: they are only freed when the arena is destroyed.
+  **/
+  void release() noexcept;
+
+  /**
+     size. This method returns the number of live objects in the arena.
+     \return the number of live objects in the arena.
+  **/
+  inline std::size_t size() const noexcept { return m_objects.size(); }
+
+  /**
+     chunks. This method returns the number of chunks held by the arena, including those kept for
+  reuse.
+     \return the number of chunks held by the arena.
+  **/
+  inline std::size_t chunks() const noexcept { return m_chunks.size() + m_large.size(); }
+
+private:
+  /**
+     allocate. This method returns `size` bytes aligned to `align`, moving to the next chunk if
+  the current chunk is full.
+  **/
+  void *allocate(std::size_t size, std::size_t align);
+
+  /**
+     m_chunk_size. This is the size of each chunk.
+  **/
+  std::size_t m_chunk_size;
+
+  /**
+     m_chunks. These are the chunks of size `m_chunk_size`. The first `m_next` are in use.
+  **/
+  std::vector<std::unique_ptr<unsigned char[]>> m_chunks{};
+
+  /**
+     m_next. This is the index of the next chunk in m_chunks to be used.
+  **/
+  std::size_t m_next{0};
+
+  /**
+     m_large. These are the chunks holding objects larger than a chunk. These are freed on
+  release.
+  **/
+  std::vector<std::unique_ptr<unsigned char[]>> m_large{};
+
+  /**
+     m_objects. These are the live objects, oldest first. These are kept in an array (rather than
+  e.g an intrusive list) so that release does not chase pointers from one object to the next.
+  **/
+  std::vector<Data *> m_objects{};
+
+  /**
+     m_pos. This is the next free byte in the current chunk.
+  **/
+  unsigned char *m_pos{nullptr};
+
+  /**
+     m_end. This is one past the end of the current chunk.
+  **/
+  unsigned char *m_end{nullptr};
+
+  /**
+     m_mutex. This serialises calls to `make`. This is not moved along with the arena.
+  **/
+  std::mutex m_mutex{};
+};
+
+/// INLINE FUNCTIONS
+template <typename T, typename... Args> inline arena_ptr<T> DataArena::make(Args &&...args)
+{
+  static_assert(std::is_base_of_v<Data, T>, "Error: DataArena can only hold types of Data");
+  std::lock_guard<std::mutex> lock{m_mutex};
+  auto *const object = ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+  // The object is destroyed if it cannot be tracked, as nothing else would ever destroy it.
+  try
+  {
+    m_objects.push_back(object);
+  }
+  catch (...)
+  {
+    object->~T();
+    throw;
+  }
+  return arena_ptr<T>{object};
+}
+
+}  // namespace Feller
+
+#endif
@@ -0,0 +1,250 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_DataArena.hpp"
+#include "Feller_AuxData.hpp"
+#include "Feller_EventLog.hpp"
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// This counts live objects, so that we can check that the arena destroys everything it holds.
+static int nr_live = 0;
+
+struct Counted : public Feller::Data
+{
+  explicit Counted(const int v) : value{v} { ++nr_live; }
+  Counted(const Counted &other) noexcept : value{other.value} { ++nr_live; }
+  ~Counted() override { --nr_live; }
+  bool operator==(const Data &other) const noexcept override
+  {
+    const auto *const counted = dynamic_cast<const Counted *>(&other);
+    return counted != nullptr && counted->value == value;
+  }
+  std::string to_string() const override { return std::to_string(value); }
+  std::unique_ptr<Data> copy() const override { return std::make_unique<Counted>(*this); }
+
+  int value;
+};
+
+// This has a stricter alignment than anything else in the arena.
+struct alignas(64) Aligned : public Counted
+{
+  using Counted::Counted;
+  std::unique_ptr<Data> copy() const override { return std::make_unique<Aligned>(*this); }
+};
+
+// This is larger than a chunk.
+struct Huge : public Counted
+{
+  using Counted::Counted;
+  std::unique_ptr<Data> copy() const override { return std::make_unique<Huge>(*this); }
+  char padding[Feller::DataArena::default_chunk_size]{};
+};
+
+TEST(DataArena, testEmpty)
+{
+  Feller::DataArena arena;
+  EXPECT_EQ(arena.size(), 0);
+  EXPECT_EQ(arena.chunks(), 0);
+  arena.release();
+  EXPECT_EQ(arena.size(), 0);
+}
+
+TEST(DataArena, testMakeAndRelease)
+{
+  nr_live = 0;
+  Feller::DataArena arena{1024};
+  for (int i = 0; i < 1000; i++)
+  {
+    auto data = arena.make<Counted>(i);
+    ASSERT_EQ(data->value, i);
+  }
+
+  // The handles are gone, but the arena still owns the data.
+  EXPECT_EQ(nr_live, 1000);
+  EXPECT_EQ(arena.size(), 1000);
+  const auto chunks = arena.chunks();
+  EXPECT_GT(chunks, 1);
+
+  arena.release();
+  EXPECT_EQ(nr_live, 0);
+  EXPECT_EQ(arena.size(), 0);
+
+  // The chunks are kept, and reused after a release.
+  for (int i = 0; i < 1000; i++)
+  {
+    arena.make<Counted>(i);
+  }
+  EXPECT_EQ(nr_live, 1000);
+  EXPECT_EQ(arena.chunks(), chunks);
+}
+
+TEST(DataArena, testDestructor)
+{
+  nr_live = 0;
+  {
+    Feller::DataArena arena;
+    arena.make<Counted>(1);
+    arena.make<Counted>(2);
+    EXPECT_EQ(nr_live, 2);
+  }
+  EXPECT_EQ(nr_live, 0);
+}
+
+TEST(DataArena, testAlignmentAndSize)
+{
+  nr_live = 0;
+  Feller::DataArena arena{256};
+  for (int i = 0; i < 16; i++)
+  {
+    arena.make<Counted>(i);
+    const auto aligned = arena.make<Aligned>(i);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(aligned.get()) % alignof(Aligned), 0);
+  }
+
+  // Objects larger than a chunk get a chunk of their own.
+  const auto huge = arena.make<Huge>(7);
+  EXPECT_EQ(huge->value, 7);
+  EXPECT_EQ(arena.size(), 33);
+  const auto chunks = arena.chunks();
+  arena.release();
+  EXPECT_EQ(nr_live, 0);
+
+  // Large chunks are freed on release.
+  EXPECT_EQ(arena.chunks(), chunks - 1);
+}
+
+TEST(DataArena, testMove)
+{
+  nr_live = 0;
+  Feller::DataArena arena;
+  arena.make<Counted>(1);
+
+  Feller::DataArena other{std::move(arena)};
+  EXPECT_EQ(arena.size(), 0);
+  EXPECT_EQ(other.size(), 1);
+  EXPECT_EQ(nr_live, 1);
+
+  arena.make<Counted>(2);
+  other = std::move(arena);
+  EXPECT_EQ(other.size(), 1);
+  EXPECT_EQ(nr_live, 1);
+
+  other.release();
+  EXPECT_EQ(nr_live, 0);
+}
+
+TEST(DataArena, testConcurrentMake)
+{
+  // Counted is not used here, as its counter is not atomic.
+  struct Value : public Feller::Data
+  {
+    explicit Value(const unsigned v) noexcept : value{v} {}
+    bool operator==(const Data &) const noexcept override { return false; }
+    std::string to_string() const override { return std::to_string(value); }
+    std::unique_ptr<Data> copy() const override { return std::make_unique<Value>(*this); }
+    unsigned value;
+  };
+
+  // Enough objects are made that each thread moves through several chunks.
+  constexpr unsigned nr_threads = 4;
+  constexpr unsigned nr_values  = 4096;
+  Feller::DataArena arena{1024};
+  std::vector<std::vector<Feller::arena_ptr<Value>>> made(nr_threads);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < nr_threads; t++)
+  {
+    threads.emplace_back([&arena, &made, t] {
+      for (unsigned i = 0; i < nr_values; i++)
+      {
+        made[t].push_back(arena.make<Value>(t * nr_values + i));
+      }
+    });
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  EXPECT_EQ(arena.size(), nr_threads * nr_values);
+  for (unsigned t = 0; t < nr_threads; t++)
+  {
+    for (unsigned i = 0; i < nr_values; i++)
+    {
+      EXPECT_EQ(made[t][i]->value, t * nr_values + i);
+    }
+  }
+}
+
+TEST(DataArena, testAuxData)
+{
+  nr_live = 0;
+  Feller::DataArena arena;
+  {
+    Feller::AuxData aux{arena.make<Counted>(5)};
+    EXPECT_TRUE(aux.is_arena());
+    EXPECT_FALSE(aux.is_inline());
+    EXPECT_EQ(aux->to_string(), "5");
+
+    // Moving keeps the data in the arena.
+    Feller::AuxData moved{std::move(aux)};
+    EXPECT_EQ(aux, nullptr);
+    EXPECT_TRUE(moved.is_arena());
+
+    // Copying makes a heap copy, which outlives the arena.
+    Feller::AuxData copy{moved};
+    EXPECT_FALSE(copy.is_arena());
+    EXPECT_FALSE(copy.is_inline());
+    EXPECT_EQ(*copy, *moved);
+    EXPECT_EQ(nr_live, 2);
+
+    // Resetting does not destroy arena data.
+    moved.reset();
+    EXPECT_EQ(nr_live, 2);
+
+    arena.release();
+    EXPECT_EQ(nr_live, 1);
+    EXPECT_EQ(copy->to_string(), "5");
+  }
+  EXPECT_EQ(nr_live, 0);
+}
+
+TEST(DataArena, testEventLog)
+{
+  nr_live = 0;
+  Feller::DataArena arena;
+  Feller::EventLog log{"abc"};
+  log.aux() = arena.make<Counted>(3);
+  EXPECT_TRUE(log.aux().is_arena());
+
+  const auto copy = log;
+  EXPECT_FALSE(copy.aux().is_arena());
+  EXPECT_EQ(copy, log);
+
+  // Overwriting the log after a release must not touch the released data.
+  arena.release();
+  log = copy;
+  EXPECT_EQ(log.aux()->to_string(), "3");
+  EXPECT_EQ(nr_live, 2);
+}
@@ -40,11 +40,37 @@ using SingleThreadedEventLogger =
 /**
    MultiThreadedEventLogger. This declaration instantiates a contiguously stored
 event logger with locking based on a mutex. This logger locks the logs using a
-std::mutex: this only allows a single thread to write to the logger at once.
+std::mutex: this only allows a single thread to write to the logger at once. The logging mode is
+held atomically, so it may be switched whilst other threads are logging.
 **/
 using MultiThreadedEventLogger =
     Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage, Feller::MutexLock,
-                   Feller::ConditionalLoggingPolicy>;
+                   Feller::AtomicConditionalLoggingPolicy>;
+/**
+   MultiThreadedLockFreeEventLogger. This declaration instantiates an event logger that is backed
+by a lock-free ring buffer with no outer locking. Any number of threads may insert into this logger
+at once, with each insertion claiming a slot using a single atomic operation. Note that the logs
+should only be read once all writers are finished.
+**/
+using MultiThreadedLockFreeEventLogger =
+    Feller::Logger<Feller::EventLog, char, Feller::RingBufferLogStorage, Feller::NoLock,
+                   Feller::AtomicConditionalLoggingPolicy>;
+/**
+   MultiThreadedThreadEventLogger. This declaration instantiates a \ref MultiThreadedEventLogger
+that stores \ref ThreadEventLog logs. Each log records the index of the thread that built it and
+the CPU that thread was running on, so that a dump of this logger can be used to diagnose
+scheduling and contention problems.
+**/
+using MultiThreadedThreadEventLogger =
+    Feller::Logger<Feller::ThreadEventLog, char, Feller::ContiguousLogStorage, Feller::MutexLock,
+                   Feller::AtomicConditionalLoggingPolicy>;
+/**
+   MetricLogger. This declaration instantiates a logger of counters and gauges (see
+\ref MetricLog) that aggregates updates in place with no outer locking. Any number of threads may
+update metrics at once: a counter update is a single relaxed atomic add into a per-thread shard.
+**/
+using MetricLogger = Feller::Logger<Feller::MetricLog, char, Feller::MetricLogStorage,
+                                    Feller::NoLock, Feller::AtomicConditionalLoggingPolicy>;
 }  // namespace Feller
 
 #endif
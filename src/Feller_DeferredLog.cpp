@@ -0,0 +1,64 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_DeferredLog.hpp"
+
+auto Feller::DeferredLog::to_log() const -> EventLog
+{
+  const auto &site = LogSite::at(m_site);
+  EventLog log{site.name(), m_time};
+  log.reserve(m_nr_args);
+
+  std::size_t pos = 0;
+  for (std::size_t i = 0; i < m_nr_args; i++)
+  {
+    // Any argument beyond the keys of the site gets an empty key.
+    const auto key  = i < site.keys().size() ? site.keys()[i] : InternedString{};
+    const auto type = static_cast<ParameterValue::Type>(m_bytes[pos++]);
+    switch (type)
+    {
+    case ParameterValue::Type::STRING:
+    {
+      const std::size_t length = m_bytes[pos++];
+      const auto *const text = reinterpret_cast<const char *>(m_bytes + pos);
+      log.emplace_back(key, ParameterValue::string_type(text, length));
+      pos += length;
+      break;
+    }
+    case ParameterValue::Type::INTEGER:
+      log.emplace_back(key, get<std::int64_t>(pos));
+      break;
+    case ParameterValue::Type::UNSIGNED:
+      log.emplace_back(key, get<std::uint64_t>(pos));
+      break;
+    case ParameterValue::Type::DOUBLE:
+      log.emplace_back(key, get<double>(pos));
+      break;
+    case ParameterValue::Type::BOOLEAN:
+      log.emplace_back(key, get<bool>(pos));
+      break;
+    case ParameterValue::Type::DURATION:
+      log.emplace_back(key, ParameterValue::duration{get<std::int64_t>(pos)});
+      break;
+    }
+  }
+
+  return log;
+}
+
+std::string Feller::DeferredLog::to_string() const { return to_log().to_string(); }
@@ -0,0 +1,292 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_DEFERRED_LOG
+#define INCLUDED_FELLER_DEFERRED_LOG
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "Feller_Feller.hpp"
+
+#include "Feller_EventLog.hpp"
+#include "Feller_LogSite.hpp"
+#include "Feller_ParameterValue.hpp"
+
+namespace Feller
+{
+/**
+ DeferredLog. This class is a log type for the hottest paths in a program. Rather than building an
+\ref EventLog (with its name, parameter vector and strings), a deferred log only records the id of
+its \ref LogSite, its creation time and the raw bytes of its arguments, in a fixed-size record of
+64 bytes. All formatting is deferred until the log is read: `to_log` rebuilds the equivalent
+\ref EventLog, and `to_string` (and hence printing a storage of deferred logs) produces exactly the
+text that the equivalent \ref EventLog would produce.
+
+ Each argument is stored as a single type byte (see \ref ParameterValue::Type), followed by the
+value: integers, doubles and durations as 8 raw bytes, booleans as a single byte and strings as a
+single length byte followed by the characters. Strings are copied, so any string may be passed.
+Since the record has a fixed size, at most `capacity` bytes of arguments are stored: any argument
+that does not fit is dropped (and strings are cut short), and the log is marked as truncated.
+
+ This class is trivially copyable, so storing a deferred log is a copy of 64 bytes. For example:
+
+   logger.insert(Feller::DeferredLog{FELLER_LOG_SITE("Entered f", "x", "y"), x, y});
+**/
+class DeferredLog
+{
+public:
+  /**
+     time_type. This is the type used to store the creation time of a log.
+  **/
+  using time_type = std::chrono::time_point<std::chrono::system_clock>;
+
+  /**
+     capacity. This is the number of bytes available for the arguments of a log.
+  **/
+  static constexpr std::size_t capacity = 48;
+
+  /**
+     DeferredLog. This constructor builds an empty log, attributed to the unknown site (see \ref
+  LogSite::unknown_id). This exists so that deferred logs can be held in storage that default
+  constructs its logs (such as \ref RingBufferLogStorage). Such a log decodes to an empty log
+  named after the unknown site.
+  **/
+  DeferredLog() noexcept : m_bytes{} {}
+
+  /**
+     DeferredLog. This constructor records a log for `site`, created now, with the arguments
+  `args`. Each argument must be a bool, an integer, a floating point value, a duration or a
+  string (i.e anything that converts to a std::string_view). This constructor does not allocate
+  and does not throw.
+     \param site: the site of this log.
+     \param args: the values of the parameters of this log, in the order of the keys of `site`.
+  **/
+  template <typename... Args>
+  explicit DeferredLog(const LogSite &site, const Args &...args) noexcept
+      : m_site{site.id()}, m_time{std::chrono::system_clock::now()}
+  {
+    (put(args), ...);
+  }
+
+  /**
+     site_id. This method returns the id of the site of this log.
+     \return the id of the site of this log.
+  **/
+  inline LogSite::id_type site_id() const noexcept { return m_site; }
+
+  /**
+     site. This method returns the site of this log. This looks the site up in the registry, which
+     does not lock.
+     \return the site of this log.
+  **/
+  inline const LogSite &site() const noexcept { return LogSite::at(m_site); }
+
+  /**
+     time. This method returns the time that this log was created.
+     \return the time that this log was created.
+  **/
+  inline time_type time() const noexcept { return m_time; }
+
+  /**
+     size. This method returns the number of arguments stored in this log.
+     \return the number of arguments stored in this log.
+  **/
+  inline std::size_t size() const noexcept { return m_nr_args; }
+
+  /**
+     truncated. This method returns true if some argument did not fit in this log.
+     \return true if this log is truncated, false otherwise.
+  **/
+  inline bool truncated() const noexcept { return m_truncated; }
+
+  /**
+     to_log. This method decodes this log into the equivalent \ref EventLog: the name and keys
+  are taken from the site of this log, and each argument becomes a \ref ParameterValue. This
+  method may throw due to allocation failures.
+     \return the equivalent event log.
+  **/
+  EventLog to_log() const;
+
+  /**
+     to_string. This method produces the same string as `to_log().to_string()`.
+     \return a string representing this object.
+  **/
+  std::string to_string() const;
+
+  /**
+     ==. Two deferred logs are equal if they have the same site, time and arguments.
+  **/
+  inline friend bool operator==(const DeferredLog &lhs, const DeferredLog &rhs) noexcept
+  {
+    return lhs.m_site == rhs.m_site && lhs.m_time == rhs.m_time &&
+           lhs.m_nr_args == rhs.m_nr_args && lhs.m_truncated == rhs.m_truncated &&
+           lhs.m_size == rhs.m_size && std::memcmp(lhs.m_bytes, rhs.m_bytes, lhs.m_size) == 0;
+  }
+  inline friend bool operator!=(const DeferredLog &lhs, const DeferredLog &rhs) noexcept
+  {
+    return !(lhs == rhs);
+  }
+
+  inline friend std::ostream &operator<<(std::ostream &os, const DeferredLog &log)
+  {
+    os << log.to_string();
+    return os;
+  }
+
+private:
+  /**
+     put. This method appends a single argument to this log.
+     \tparam T: the type of the argument.
+     \param value: the argument to be appended.
+  **/
+  template <typename T> inline void put(const T &value) noexcept;
+
+  /// Overload of put for durations, which are stored in nanoseconds.
+  template <typename Rep, typename Period>
+  inline void put(const std::chrono::duration<Rep, Period> &value) noexcept;
+
+  /**
+     put_fixed. This method appends a fixed-size argument of type `type` to this log.
+  **/
+  template <typename T> inline void put_fixed(ParameterValue::Type type, const T value) noexcept;
+
+  /**
+     put_text. This method appends a string argument to this log, cutting it short if needed.
+  **/
+  inline void put_text(std::string_view text) noexcept;
+
+  /**
+     get. This method reads a fixed-size value at `pos`, and advances `pos` past it.
+  **/
+  template <typename T> inline T get(std::size_t &pos) const noexcept;
+
+  /**
+     m_site. This is the id of the site of this log.
+  **/
+  LogSite::id_type m_site{LogSite::unknown_id};
+
+  /**
+     m_size. This is the number of bytes of m_bytes that are in use.
+  **/
+  std::uint8_t m_size{0};
+
+  /**
+     m_nr_args. This is the number of arguments stored in m_bytes.
+  **/
+  std::uint8_t m_nr_args{0};
+
+  /**
+     m_truncated. This is true if some argument did not fit in m_bytes.
+  **/
+  bool m_truncated{false};
+
+  /**
+     m_time. This is the time that this log was created.
+  **/
+  time_type m_time{};
+
+  /**
+     m_bytes. These are the encoded arguments of this log. Only the first m_size bytes are
+  meaningful. This is deliberately not initialised by the recording constructor.
+  **/
+  unsigned char m_bytes[capacity];
+};
+
+/// INLINE FUNCTIONS
+template <typename T> inline void DeferredLog::put(const T &value) noexcept
+{
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    put_fixed(ParameterValue::Type::BOOLEAN, value);
+  }
+  else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+  {
+    put_fixed(ParameterValue::Type::INTEGER, static_cast<std::int64_t>(value));
+  }
+  else if constexpr (std::is_integral_v<T>)
+  {
+    put_fixed(ParameterValue::Type::UNSIGNED, static_cast<std::uint64_t>(value));
+  }
+  else if constexpr (std::is_floating_point_v<T>)
+  {
+    put_fixed(ParameterValue::Type::DOUBLE, static_cast<double>(value));
+  }
+  else
+  {
+    put_text(std::string_view{value});
+  }
+}
+
+template <typename Rep, typename Period>
+inline void DeferredLog::put(const std::chrono::duration<Rep, Period> &value) noexcept
+{
+  const auto count = std::chrono::duration_cast<ParameterValue::duration>(value).count();
+  put_fixed(ParameterValue::Type::DURATION, static_cast<std::int64_t>(count));
+}
+
+template <typename T>
+inline void DeferredLog::put_fixed(const ParameterValue::Type type, const T value) noexcept
+{
+  if (m_truncated || m_size + 1 + sizeof(T) > capacity)
+  {
+    m_truncated = true;
+    return;
+  }
+
+  m_bytes[m_size] = static_cast<unsigned char>(type);
+  std::memcpy(m_bytes + m_size + 1, &value, sizeof(T));
+  m_size = static_cast<std::uint8_t>(m_size + 1 + sizeof(T));
+  ++m_nr_args;
+}
+
+inline void DeferredLog::put_text(const std::string_view text) noexcept
+{
+  if (m_truncated || std::size_t{m_size} + 2 > capacity)
+  {
+    m_truncated = true;
+    return;
+  }
+
+  const auto length   = std::min<std::size_t>(text.size(), capacity - m_size - 2);
+  m_truncated         = length < text.size();
+  m_bytes[m_size]     = static_cast<unsigned char>(ParameterValue::Type::STRING);
+  m_bytes[m_size + 1] = static_cast<unsigned char>(length);
+  std::memcpy(m_bytes + m_size + 2, text.data(), length);
+  m_size = static_cast<std::uint8_t>(m_size + 2 + length);
+  ++m_nr_args;
+}
+
+template <typename T> inline T DeferredLog::get(std::size_t &pos) const noexcept
+{
+  T value;
+  std::memcpy(&value, m_bytes + pos, sizeof(T));
+  pos += sizeof(T);
+  return value;
+}
+
+}  // namespace Feller
+
+#endif
@@ -0,0 +1,146 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_ContiguousLogStorage.hpp"
+#include "Feller_DeferredLog.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_LogEverything.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_NoLock.hpp"
+#include "Feller_RingBufferLogStorage.hpp"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+TEST(DeferredLog, testLayout)
+{
+  EXPECT_EQ(sizeof(Feller::DeferredLog), 64);
+  EXPECT_TRUE(std::is_trivially_copyable_v<Feller::DeferredLog>);
+}
+
+TEST(DeferredLog, testDecode)
+{
+  const std::string text{"text"};
+  const Feller::DeferredLog log{
+      FELLER_LOG_SITE("Deferred", "i", "d", "b", "t", "s", "c"),
+      -5, 0.5, true, std::chrono::microseconds(2), text, "literal"};
+
+  EXPECT_EQ(log.size(), 6);
+  EXPECT_FALSE(log.truncated());
+  EXPECT_EQ(log.site().name(), "Deferred");
+
+  // Decoding produces the same log (and hence the same text) as logging the values directly.
+  Feller::EventLog expected{"Deferred", log.time()};
+  expected.emplace_back("i", -5);
+  expected.emplace_back("d", 0.5);
+  expected.emplace_back("b", true);
+  expected.emplace_back("t", std::chrono::microseconds(2));
+  expected.emplace_back("s", text);
+  expected.emplace_back("c", "literal");
+
+  const auto decoded = log.to_log();
+  EXPECT_EQ(decoded, expected);
+  EXPECT_EQ(log.to_string(), expected.to_string());
+
+  std::ostringstream os;
+  os << log;
+  EXPECT_EQ(os.str(), expected.to_string());
+}
+
+TEST(DeferredLog, testMissingKeys)
+{
+  const Feller::DeferredLog log{FELLER_LOG_SITE("Short", "a"), 1, 2};
+  const auto decoded = log.to_log();
+  ASSERT_EQ(decoded.size(), 2);
+  EXPECT_EQ(decoded.cbegin()->first, "a");
+  EXPECT_EQ((decoded.cbegin() + 1)->first, "");
+  EXPECT_EQ((decoded.cbegin() + 1)->second, Feller::ParameterValue{2});
+}
+
+TEST(DeferredLog, testTruncation)
+{
+  // Five 9-byte integers fill 45 of the 48 bytes, so only 1 character of the string fits.
+  const Feller::DeferredLog cut{FELLER_LOG_SITE("Cut"), 1, 2, 3, 4, 5, "abc", 6};
+  EXPECT_TRUE(cut.truncated());
+  EXPECT_EQ(cut.size(), 6);
+  EXPECT_EQ((cut.to_log().cbegin() + 5)->second, "a");
+
+  const Feller::DeferredLog full{FELLER_LOG_SITE("Full"), std::string(100, 'x')};
+  EXPECT_TRUE(full.truncated());
+  EXPECT_EQ(full.to_log().cbegin()->second, std::string(Feller::DeferredLog::capacity - 2, 'x'));
+}
+
+TEST(DeferredLog, testDefault)
+{
+  // A default constructed log belongs to the unknown site, so it can be decoded too.
+  const Feller::DeferredLog log;
+  EXPECT_EQ(log.site_id(), Feller::LogSite::unknown_id);
+  EXPECT_EQ(&log.site(), &Feller::LogSite::at(Feller::LogSite::unknown_id));
+  const auto decoded = log.to_log();
+  EXPECT_EQ(decoded.name(), "Unknown site");
+  EXPECT_EQ(decoded.size(), 0);
+}
+
+TEST(DeferredLog, testEquality)
+{
+  const auto &site = FELLER_LOG_SITE("Equality", "x");
+  const Feller::DeferredLog a{site, 1};
+  const Feller::DeferredLog b{a};
+  const Feller::DeferredLog c{site, 2};
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+}
+
+TEST(DeferredLog, testLogger)
+{
+  Feller::Logger<Feller::DeferredLog, char, Feller::ContiguousLogStorage, Feller::NoLock,
+                 Feller::LogEverything>
+      logger;
+  for (unsigned i = 0; i < 3; i++)
+  {
+    logger.insert(Feller::DeferredLog{FELLER_LOG_SITE("Iteration", "i"), i});
+  }
+
+  ASSERT_EQ(logger.size(), 3);
+  EXPECT_EQ(logger.cbegin()->site_id(), (logger.cbegin() + 2)->site_id());
+
+  std::ostringstream os;
+  os << logger;
+  std::string expected;
+  for (const auto &log : logger)
+  {
+    expected += log.to_log().to_string();
+  }
+  EXPECT_EQ(os.str(), expected);
+}
+
+TEST(DeferredLog, testRingBuffer)
+{
+  // Deferred logs can also live in storage that default constructs its slots.
+  Feller::RingBufferLogStorage<Feller::DeferredLog> storage{4};
+  for (unsigned i = 0; i < 10; i++)
+  {
+    storage.insert(Feller::DeferredLog{FELLER_LOG_SITE("Ring", "i"), i});
+  }
+  ASSERT_EQ(storage.size(), 10);
+  EXPECT_EQ(*((storage.cbegin() + 9)->to_log().cbegin()->second.get_if<std::uint64_t>()), 9);
+}
@@ -18,34 +18,42 @@
  ****/
 #include "Feller_EventLog.hpp"
 
+#include <algorithm>
+
 void Feller::EventLog::clear() { m_parameters.clear(); }
 
 void Feller::EventLog::resize(const Feller::EventLog::size_type size) { m_parameters.resize(size); }
 
 void Feller::EventLog::set_zero()
 {
+  // Vectors may only be swapped if they share an allocator, so the new vector uses ours.
   using vec_type = decltype(m_parameters);
-  vec_type().swap(m_parameters);
+  vec_type(m_parameters.get_allocator()).swap(m_parameters);
 }
 
-void Feller::EventLog::emplace_back(const std::string &key, const std::string &value)
+void Feller::EventLog::emplace_back(const InternedString key, ParameterValue value)
 {
-  emplace_back(std::pair<std::string, std::string>(key, value));
+  m_parameters.emplace_back(key, std::move(value));
 }
 
 void Feller::EventLog::emplace_back(const std::pair<std::string, std::string> &value)
 {
-  m_parameters.emplace_back(value);
+  m_parameters.emplace_back(value.first, value.second);
 }
 
 void Feller::EventLog::emplace_back(std::pair<std::string, std::string> &&value)
 {
-  m_parameters.emplace_back(std::move(value));
+  m_parameters.emplace_back(value.first, std::move(value.second));
 }
 
-void Feller::EventLog::emplace_back(std::string &&key, std::string &&value)
+void Feller::EventLog::emplace_back(const parameter_type &value)
 {
-  emplace_back(std::pair<std::string, std::string>(std::move(key), std::move(value)));
+  m_parameters.emplace_back(value);
+}
+
+void Feller::EventLog::emplace_back(parameter_type &&value)
+{
+  m_parameters.emplace_back(std::move(value));
 }
 
 void Feller::EventLog::reserve(const Feller::EventLog::size_type size)
@@ -53,27 +61,41 @@ void Feller::EventLog::reserve(const Feller::EventLog::size_type size)
   m_parameters.reserve(size);
 }
 
+void Feller::EventLog::assign(EventLog &&other)
+{
+  m_name = other.m_name;
+  m_time = other.m_time;
+  m_parameters.clear();
+  m_parameters.reserve(other.m_parameters.size());
+  for (auto &parameter : other.m_parameters)
+  {
+    m_parameters.emplace_back(std::move(parameter));
+  }
+  m_aux = std::move(other.m_aux);
+}
+
 auto Feller::EventLog::capacity() const noexcept -> Feller::EventLog::size_type
 {
   return m_parameters.capacity();
 }
 
-auto Feller::EventLog::to_string() const -> std::string
-{
-  // Firstly we need to convert the time to a string
-  // This is a remarkably involved process for some reason.
-  // The neatest way I found of doing this was found at:
-  // https://gist.github.com/polaris/adee936198995a6f8c697c419d21f734
-  std::time_t t  = std::chrono::system_clock::to_time_t(m_time);
-  std::string ts = std::ctime(&t);
-  ts.resize(ts.size() - 1);
+auto Feller::EventLog::to_string() const -> std::string { return to_string(nullptr, nullptr); }
 
-  auto str = "Name:" + m_name + "\nTime:" + Util::time_to_string(m_time) + "\nParameters:\n";
+auto Feller::EventLog::to_string(const parameter_type *const first,
+                                 const parameter_type *const last) const -> std::string
+{
+  std::string str = "Name:" + m_name.str() + "\nTime:";
+  Util::append_time(str, m_time);
+  str += "\nParameters:\n";
 
-  for (const auto &p : m_parameters)
-  {
-    str += p.first + "," + p.second + "\n";
-  }
+  const auto append = [&str](const parameter_type &p) {
+    str += p.first.str();
+    str += ',';
+    p.second.append_to(str);
+    str += '\n';
+  };
+  std::for_each(first, last, append);
+  std::for_each(m_parameters.cbegin(), m_parameters.cend(), append);
 
   str += "Aux data: ";
 
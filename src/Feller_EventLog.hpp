@@ -21,12 +21,18 @@
 
 #include <chrono>
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "Feller_Feller.hpp"
 
+#include "Feller_AuxData.hpp"
+#include "Feller_Clock.hpp"
 #include "Feller_Data.hpp"
+#include "Feller_ParameterValue.hpp"
+#include "Feller_StringTable.hpp"
 #include "Feller_Util.hpp"
 
 namespace Feller
@@ -53,28 +59,36 @@ class EventLog
       The typical usage of this is to give some information about the
       event log. For example, if you entered a function f(),
       you may wish to set the name of the log as "entered f".
+      The name is interned (see \ref StringTable), so copying a log never
+      copies its name and comparing names is an integer comparison.
   **/
-  std::string m_name{};
+  InternedString m_name{};
   /** m_time. This variable corresponds to the time the event log was created.
       The typical use of this variable is to provide some sort of chronology to
-      a series of logs. This variable is not externally modifiable.
+      a series of logs. This variable is not externally modifiable. Unless a
+  time is given explicitly, this is read from \ref SystemClock when the log is
+  built (see \ref ClockedEventLog for logs that use other clocks).
   **/
-  std::chrono::time_point<std::chrono::system_clock> m_time{std::chrono::system_clock::now()};
-
-  /** m_parameters. This variable is used to hold string representations
-      of additional data. This variable can be used to represent arguments to a
-      function: for example, you may wish to represent the particular value of
-  an argument upon entering a function.
+  std::chrono::time_point<std::chrono::system_clock> m_time{SystemClock::now()};
+
+  /** m_parameters. This variable is used to hold additional key/value data.
+      This variable can be used to represent arguments to a function: for
+      example, you may wish to represent the particular value of an argument
+  upon entering a function. As with the name, each key is interned. Each value
+  is a \ref ParameterValue, so numbers are stored as numbers and are only
+  formatted by to_string. The vector (and each string value) is allocated
+  from the memory resource that this log was built with (see allocator_type).
   **/
-  std::vector<std::pair<std::string, std::string>> m_parameters{};
+  std::pmr::vector<std::pair<InternedString, ParameterValue>> m_parameters{};
 
   /** m_aux.
       In some situations the basic nature of this class may not be enough to
   encode the right level of information. For these cases, we provide a simple
-  pointer that can be used to attach auxiliary information. This event log owns
+  holder that can be used to attach auxiliary information. This event log owns
   the auxiliary data: the data is deleted upon destruction of the event log.
+  Small data is held inline (see \ref AuxData), so it costs no allocation.
   **/
-  std::unique_ptr<Data> m_aux{nullptr};
+  AuxData m_aux{nullptr};
 
 public:
   // Expose the size type for this object too.
@@ -86,6 +100,13 @@ public:
   **/
   using size_type = decltype(m_parameters)::size_type;
 
+  /**
+     parameter_type. This is the type of a single key/value parameter. The key is
+     interned, but converts implicitly to a const std::string reference. The
+     value is a \ref ParameterValue.
+  **/
+  using parameter_type = decltype(m_parameters)::value_type;
+
   /**
      const_iterator. This specifies the constant iterator type that is exposed
      by this class. Since this class only exposes iterators to the m_parameters
@@ -93,6 +114,23 @@ public:
   **/
   using const_iterator = decltype(m_parameters)::const_iterator;
 
+  /**
+     allocator_type. This is the allocator used for the parameters of this log.
+     Declaring this type means that `std::pmr` containers (such as
+     \ref ContiguousLogStorage) pass their allocator to each log that they build,
+     so that the parameters of stored logs, and their strings, are allocated from
+     the memory resource of the container. The name is interned, and so it is
+     never allocated per log.
+  **/
+  using allocator_type = std::pmr::polymorphic_allocator<parameter_type>;
+
+  /**
+     time_point. This is the type of the time held by this log. This is the same for every
+     clock policy (e.g \ref SteadyClock), so logs that were timed by different clocks can be stored
+     and compared together.
+  **/
+  using time_point = std::chrono::time_point<std::chrono::system_clock>;
+
   // GETTERS
 
   /** name. This function returns a const reference to the name of this event
@@ -103,6 +141,13 @@ public:
   **/
   inline const std::string &name() const noexcept;
 
+  /** interned_name. This function returns the interned handle for the name of
+  this event log. This is useful for callers that want to compare or store names
+  without touching the text. This function does not throw.
+      \return the interned name of this event log.
+  **/
+  inline InternedString interned_name() const noexcept;
+
   /** cbegin. This function returns a const iterator to the first element of the
       parameters vector. This function does not throw and does not allow
   modifications to this object. This function is undefined if invoked on an
@@ -125,16 +170,27 @@ public:
   **/
   inline size_type size() const noexcept;
 
-  /** aux. This function returns a reference to the m_aux pointer.
+  /** get_allocator. This function returns the allocator used for the parameters
+  of this log. This function does not throw.
+      \return the allocator used for the parameters of this log.
+  **/
+  inline allocator_type get_allocator() const noexcept;
+
+  /** aux. This function returns a reference to the m_aux holder.
       Note that this function
       does not transfer membership from this event log. In other words, if the
   event log is deleted then the data referred to by aux will also be deleted.
-  This function will either return a valid pointer (if the data member has been
-  initialised) and will return nullptr otherwise. This function does not throw,
+  The holder behaves like a std::unique_ptr: it either holds valid data or
+  compares equal to nullptr. Data may be attached by assigning a
+  std::unique_ptr, or (without allocating, for small types) via
+  `aux().emplace<T>(...)`. This function does not throw,
   but it is not const as modifications are permitted via the returned reference.
-      \return a copy of the m_aux member variable.
+      \return a reference to the m_aux member variable.
   **/
-  inline std::unique_ptr<Feller::Data> &aux() noexcept;
+  inline AuxData &aux() noexcept;
+
+  /// Overload of aux for const logs. This does not allow modifications via the returned reference.
+  inline const AuxData &aux() const noexcept;
 
   /** time. This function returns the time that this event log was created.
       This function creates a copy of the internal member and returns it by
@@ -190,7 +246,7 @@ public:
   EventLog() = default;
 
   /**
-     operator=. This implements the copy assignment operator. Here we follow the rule of three
+     operator=. This implements the copy assignment operator. Here we follow the rule of five
      and assume that we need to do this for the compiler.
      This is essentially the same as just default constructing the object.
      \param other: the log that is to be copied.
@@ -201,62 +257,128 @@ public:
     this->m_name       = other.m_name;
     this->m_time       = other.m_time;
     this->m_parameters = other.m_parameters;
-    if (other.m_aux)
-    {
-      this->m_aux = other.m_aux->copy();
-    }
-    else
-    {
-      this->m_aux = nullptr;
-    }
+    this->m_aux        = other.m_aux;
     return *this;
   }
 
   /**
      EventLog(const EventLog& other). This is a copy constructor for another
   EventLog object. This constructor uses the automatic copy methods for the
-  value member variables (e.g m_name) and copies the pointer to data manually.
-  If the pointer `other.m_aux` is the nullptr, then this constructor will return
+  value member variables (e.g m_name), including the auxiliary data.
+  If `other.m_aux` is the nullptr, then this constructor will return
   a Log with m_aux = nullptr. Else, this constructor will deep copy the Data
-  object pointed to by `other.m_aux` and store the pointer in this object's
-  `m_aux`. This method may throw, but it does not modify the passed in
-  parameter. \param other: the event log that is to be copied.
+  held by `other.m_aux`: inline data is copy constructed in place, and other
+  data is copied via Data::copy. This method may throw, but it does not modify
+  the passed in parameter. \param other: the event log that is to be copied.
   **/
   EventLog(const EventLog &other)
-      : m_name{other.m_name}, m_time{other.m_time}, m_parameters{other.m_parameters}, m_aux{nullptr}
+      : m_name{other.m_name}, m_time{other.m_time}, m_parameters{other.m_parameters},
+        m_aux{other.m_aux}
   {
-    // We must first check that we can safely dereference here.
-    if (other.m_aux)
-    {
-      m_aux = other.m_aux->copy();
-    }
   }
 
+  /**
+     EventLog(EventLog&& other). This is the move constructor for this class. This constructor
+  steals the name, parameters and auxiliary data from `other` without allocating or calling
+  Data::copy. This leaves `other` in a valid but unspecified state. This method does not throw,
+  which allows containers such as std::vector to move (rather than copy) logs when they grow.
+  The new log uses the same memory resource as `other`.
+     \param other: the event log that is to be moved from.
+  **/
+  EventLog(EventLog &&other) noexcept = default;
+
+  /**
+     operator=. This implements the move assignment operator. As with the move constructor, this
+  does not allocate and does not throw, provided that both logs use the same memory resource.
+  Otherwise, the parameters are copied into the memory resource of this log, which may allocate
+  and hence throw: this is why, unlike the move constructor, this operator is not noexcept.
+     \param other: the log that is to be moved from.
+     \return a reference to ``this`` object.
+  **/
+  EventLog &operator=(EventLog &&other) = default;
+
+  /**
+     ~EventLog. This is the destructor for this class. This frees the auxiliary data, if any.
+  **/
+  ~EventLog() = default;
+
   /**
      EventLog. These constructors set the name field.
      This constructor should be most useful when creating event
      logs with human-readable names. \param name: the name of this log.
   **/
-  EventLog(const std::string &name) : m_name{name}, m_time{}, m_parameters{}, m_aux{nullptr} {}
-  EventLog(std::string name) : m_name{name}, m_time{}, m_parameters{}, m_aux{nullptr} {}
-  EventLog(const char *const name) : m_name{name}, m_time{}, m_parameters{}, m_aux{nullptr} {}
+  EventLog(const std::string &name) : m_name{name}, m_parameters{}, m_aux{nullptr} {}
+  EventLog(std::string name) : m_name{name}, m_parameters{}, m_aux{nullptr} {}
+  EventLog(const char *const name) : m_name{name}, m_parameters{}, m_aux{nullptr} {}
+  EventLog(const InternedString name) : m_name{name}, m_parameters{}, m_aux{nullptr} {}
+
+  /**
+     EventLog. This constructor sets the name and the creation time of this log. This is useful
+  when rebuilding logs that were recorded elsewhere (e.g by \ref BinaryReader), or when the
+  time was read from a clock other than \ref SystemClock.
+     \param name: the name of this log.
+     \param time: the time that this log was created.
+  **/
+  EventLog(const InternedString name, const time_point time)
+      : m_name{name}, m_time{time}, m_parameters{}, m_aux{nullptr}
+  {
+  }
+
+  /**
+     EventLog. These constructors are the allocator-extended forms of the constructors in this
+  class. Each builds the same log, but allocates its parameters with `alloc`. These are used by
+  `std::pmr` containers, which pass their own allocator to each log. Note that copying or moving
+  from a log that uses a different memory resource copies its parameters into `alloc`.
+     \param alloc: the allocator for the parameters of this log.
+  **/
+  EventLog(std::allocator_arg_t, const allocator_type &alloc) noexcept : m_parameters{alloc} {}
+  // This copies or moves `other`. This is a template so that names do not convert to a log here.
+  template <typename Other,
+            std::enable_if_t<std::is_same_v<std::decay_t<Other>, EventLog>, int> = 0>
+  EventLog(std::allocator_arg_t, const allocator_type &alloc, Other &&other)
+      : m_name{other.m_name}, m_time{other.m_time},
+        m_parameters{std::forward<Other>(other).m_parameters, alloc},
+        m_aux{std::forward<Other>(other).m_aux}
+  {
+  }
+  EventLog(std::allocator_arg_t, const allocator_type &alloc, const InternedString name)
+      : m_name{name}, m_parameters{alloc}, m_aux{nullptr}
+  {
+  }
+  EventLog(std::allocator_arg_t, const allocator_type &alloc, const InternedString name,
+           const time_point time)
+      : m_name{name}, m_time{time}, m_parameters{alloc}, m_aux{nullptr}
+  {
+  }
+  template <typename Value,
+            std::enable_if_t<std::is_constructible_v<ParameterValue, std::allocator_arg_t,
+                                                     const ParameterValue::allocator_type &,
+                                                     Value &&>,
+                             int> = 0>
+  EventLog(std::allocator_arg_t, const allocator_type &alloc, const InternedString key,
+           Value &&value)
+      : m_name{"Inserted"}, m_parameters{alloc}, m_aux{nullptr}
+  {
+    // The value is built in place, so that a string value is allocated with `alloc` directly.
+    m_parameters.emplace_back(key, std::forward<Value>(value));
+  }
 
   /// These constructors build a log and immediately insert two values
   /// into the parameters set.
   EventLog(const std::string &key, const std::string &value)
-      : m_name{"Inserted"}, m_time{}, m_parameters{}, m_aux{nullptr}
+      : m_name{"Inserted"}, m_parameters{}, m_aux{nullptr}
   {
     m_parameters.emplace_back(key, value);
   }
 
   EventLog(std::string key, std::string value)
-      : m_name{"Inserted"}, m_time{}, m_parameters{}, m_aux{nullptr}
+      : m_name{"Inserted"}, m_parameters{}, m_aux{nullptr}
   {
-    m_parameters.emplace_back(std::move(key), std::move(value));
+    m_parameters.emplace_back(key, std::move(value));
   }
 
   EventLog(const char *const key, const char *const value)
-      : m_name{"Inserted"}, m_time{}, m_parameters{}, m_aux{nullptr}
+      : m_name{"Inserted"}, m_parameters{}, m_aux{nullptr}
   {
     m_parameters.emplace_back(key, value);
   }
@@ -264,24 +386,34 @@ public:
   EventLog(const char *const key, const std::string value) : EventLog(key, value.c_str()) {}
   EventLog(const std::string value, const char *const key) : EventLog(value.c_str(), key) {}
 
+  /**
+     EventLog. This constructor builds a log and immediately inserts a single
+     parameter of any type supported by \ref ParameterValue. For example,
+     `EventLog{"count", 5}` stores the integer 5 without formatting it.
+     \param key: the key of the parameter.
+     \param value: the value of the parameter.
+  **/
+  EventLog(const InternedString key, ParameterValue value)
+      : m_name{"Inserted"}, m_parameters{}, m_aux{nullptr}
+  {
+    m_parameters.emplace_back(key, std::move(value));
+  }
+
   // MANIPULATORS
 
   /**
      emplace_back.
-     This method accepts a key/value pair (`key`,`value`) and places a copy of
-  this pair into the back of the parameter vector. This method may throw an
+     This method accepts a key/value pair (`key`,`value`) and places this pair
+  into the back of the parameter vector. The value may be a string, or any other
+  type supported by \ref ParameterValue: numbers, booleans and durations are
+  stored as is, without being formatted. This method may throw an
   exception in the case of memory being depleted. Note that this method does not
   pre-reserve any memory and, as a result, it should ideally be used after a
   corresponding call to ``reserve``.
-     \param key: the string to be inserted into the back of the event log,
-  representing a key.
-     \param value: the string to be inserted into the back of the event log,
-  representing a value.
+     \param key: the key to be inserted into the back of the event log.
+     \param value: the value to be inserted into the back of the event log.
   **/
-  void emplace_back(const std::string &key, const std::string &value);
-
-  /// Overload of emplace back for rvalue refs.
-  void emplace_back(std::string &&key, std::string &&value);
+  void emplace_back(const InternedString key, ParameterValue value);
 
   /**
      emplace_back. This method accepts a pair of strings (wrapped in
@@ -297,6 +429,10 @@ public:
   /// Overload of emplace_back for rvalue ref.
   void emplace_back(std::pair<std::string, std::string> &&value);
 
+  /// Overloads of emplace_back for parameters whose key is already interned.
+  void emplace_back(const parameter_type &value);
+  void emplace_back(parameter_type &&value);
+
   /**
      reserve.
      This method accepts a ``size`` variable of type ``size_type`` and reserves
@@ -338,6 +474,17 @@ public:
   **/
   void set_zero();
 
+  /**
+     assign. This method moves the name, time, parameters and auxiliary data of `other` into this
+  log. Unlike move assignment, this keeps the parameter vector of this log: the parameters of
+  `other` are moved into it element by element. This means that a log that is overwritten many
+  times (e.g a slot in \ref FlightRecorderLogStorage) does not allocate once its capacity is large
+  enough. This function may throw due to allocation failures: in this case this log is left in a
+  valid but unspecified state.
+     \param other: the log that is to be moved from.
+  **/
+  void assign(EventLog &&other);
+
   // UTILITY
   /**
      to_string. Produces a string representation of this event log.
@@ -349,17 +496,103 @@ public:
      \return a string representing this object.
   **/
   std::string to_string() const;
+
+protected:
+  /**
+     to_string. This produces the same string as `to_string()`, except that the parameters in
+  [first, last) are written before those of this log. This allows derived classes (e.g \ref
+  ThreadEventLog) to format fields that they do not store as parameters.
+     \param first: the first extra parameter.
+     \param last: one past the last extra parameter.
+     \return a string representing this object.
+  **/
+  std::string to_string(const parameter_type *first, const parameter_type *last) const;
+};
+
+/**
+    \brief ClockedEventLog. This class is an \ref EventLog whose time is read from
+  `ClockPolicy` (e.g \ref TscClock) rather than from \ref SystemClock. For
+  example, `Logger<ClockedEventLog<TscClock>, ...>` stores logs that are timed
+  with the CPU's time-stamp counter. Since the time of every log is a
+  `std::chrono::system_clock` time point, these logs behave exactly like event
+  logs in every other respect: they may be stored, formatted and serialised in
+  the same way.
+  \tparam ClockPolicy: the clock used to time each log. This type must provide a
+  static `now()` method that returns an `EventLog::time_point`.
+**/
+template <typename ClockPolicy> class ClockedEventLog : public EventLog
+{
+public:
+  /**
+     clock_type. This is the clock used to time each log.
+  **/
+  using clock_type = ClockPolicy;
+
+  /**
+     ClockedEventLog. These constructors mirror those of \ref EventLog, but read the time of the
+  log from `ClockPolicy`.
+     \param name: the name of this log.
+  **/
+  ClockedEventLog() : EventLog(InternedString{}, ClockPolicy::now()) {}
+  ClockedEventLog(const InternedString name) : EventLog(name, ClockPolicy::now()) {}
+  ClockedEventLog(const InternedString name, const time_point time) : EventLog(name, time) {}
+
+  /**
+     ClockedEventLog. This constructor builds a log and immediately inserts a single parameter.
+     \param key: the key of the parameter.
+     \param value: the value of the parameter.
+  **/
+  ClockedEventLog(const InternedString key, ParameterValue value)
+      : EventLog("Inserted", ClockPolicy::now())
+  {
+    emplace_back(key, std::move(value));
+  }
+
+  /**
+     ClockedEventLog. These constructors are the allocator-extended forms of the constructors in
+  this class (see \ref EventLog).
+     \param alloc: the allocator for the parameters of this log.
+  **/
+  ClockedEventLog(std::allocator_arg_t, const allocator_type &alloc)
+      : EventLog(std::allocator_arg, alloc, InternedString{}, ClockPolicy::now())
+  {
+  }
+  ClockedEventLog(std::allocator_arg_t, const allocator_type &alloc, const ClockedEventLog &other)
+      : EventLog(std::allocator_arg, alloc, static_cast<const EventLog &>(other))
+  {
+  }
+  ClockedEventLog(std::allocator_arg_t, const allocator_type &alloc, ClockedEventLog &&other)
+      : EventLog(std::allocator_arg, alloc, static_cast<EventLog &&>(other))
+  {
+  }
+  ClockedEventLog(std::allocator_arg_t, const allocator_type &alloc, const InternedString name)
+      : EventLog(std::allocator_arg, alloc, name, ClockPolicy::now())
+  {
+  }
+  ClockedEventLog(std::allocator_arg_t, const allocator_type &alloc, const InternedString key,
+                  ParameterValue value)
+      : EventLog(std::allocator_arg, alloc, "Inserted", ClockPolicy::now())
+  {
+    emplace_back(key, std::move(value));
+  }
 };
 
 //// INLINE FUNCTIONS
 
-inline const std::string &EventLog::name() const noexcept { return m_name; }
+inline const std::string &EventLog::name() const noexcept { return m_name.str(); }
+inline InternedString EventLog::interned_name() const noexcept { return m_name; }
 inline std::chrono::time_point<std::chrono::system_clock> EventLog::time() const noexcept
 {
   return m_time;
 }
 inline EventLog::size_type EventLog::size() const noexcept { return m_parameters.size(); }
-inline std::unique_ptr<Data> &EventLog::aux() noexcept { return m_aux; }
+inline auto EventLog::get_allocator() const noexcept -> allocator_type
+{
+  return m_parameters.get_allocator();
+}
+
+inline AuxData &EventLog::aux() noexcept { return m_aux; }
+inline const AuxData &EventLog::aux() const noexcept { return m_aux; }
 inline EventLog::const_iterator EventLog::cbegin() const noexcept { return m_parameters.cbegin(); }
 inline EventLog::const_iterator EventLog::cend() const noexcept { return m_parameters.cend(); }
 
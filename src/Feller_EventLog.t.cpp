@@ -20,13 +20,20 @@
 #include "Feller_TestData.hpp"
 #include "gtest/gtest.h"
 
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
 TEST(EventLog, testInit)
 {
   Feller::EventLog l{};
   // Firstly, this log is empty: so no size should be set
   EXPECT_EQ(l.size(), 0);
   // Secondly we expect the current time to be ~ the one on insertion
-  const auto is_gt = l.time() < std::chrono::system_clock::now();
+  const auto is_gt = l.time() <= std::chrono::system_clock::now();
   EXPECT_EQ(is_gt, true);
   // And, of course, we expect the name to be blank.
   EXPECT_EQ(l.name(), "");
@@ -215,3 +222,129 @@ TEST(EventLog, testConstructWithStringParams)
   std::pair<std::string, std::string> pari(std::string("Abc"), std::string("def"));
   EXPECT_EQ(*(l.cbegin()), pari);
 }
+
+TEST(EventLog, testMove)
+{
+  static_assert(std::is_nothrow_move_constructible<Feller::EventLog>::value,
+                "Error: EventLog should be nothrow move constructible");
+  // Move assignment may copy the parameters if the two logs use different memory resources.
+  static_assert(!std::is_nothrow_move_assignable<Feller::EventLog>::value,
+                "Error: EventLog move assignment may allocate, so it must not be noexcept");
+
+  Feller::EventLog l1{"Test"};
+  l1.emplace_back("abc", "def");
+  l1.aux() = std::make_unique<Feller::TestData>();
+  const auto *aux = l1.aux().get();
+  const auto copy = l1;
+
+  // Moving must steal the aux data rather than copying it.
+  Feller::EventLog l2{std::move(l1)};
+  EXPECT_EQ(l2, copy);
+  EXPECT_EQ(l2.aux().get(), aux);
+
+  Feller::EventLog l3{};
+  l3 = std::move(l2);
+  EXPECT_EQ(l3, copy);
+  EXPECT_EQ(l3.aux().get(), aux);
+}
+
+TEST(EventLog, testAllocator)
+{
+  // This value is too long for the small string optimisation, so it must be allocated.
+  const std::string value = "a value that is long enough to be allocated";
+  std::array<std::byte, 4096> buffer;
+  std::pmr::monotonic_buffer_resource resource{buffer.data(), buffer.size(),
+                                               std::pmr::null_memory_resource()};
+
+  Feller::EventLog log{std::allocator_arg, &resource, "key", value};
+  EXPECT_EQ(log.get_allocator().resource(), &resource);
+  ASSERT_EQ(log.size(), 1);
+  EXPECT_EQ(log.cbegin()->second, value);
+  EXPECT_EQ(log.cbegin()->second.get_if<Feller::ParameterValue::string_type>()
+                ->get_allocator()
+                .resource(),
+            &resource);
+
+  log.emplace_back("other", value);
+  log.set_zero();
+  EXPECT_EQ(log.get_allocator().resource(), &resource);
+
+  // Copies use the default resource, unless they are given an allocator.
+  log.emplace_back("key", value);
+  const Feller::EventLog copy{log};
+  EXPECT_EQ(copy, log);
+  EXPECT_EQ(copy.get_allocator().resource(), std::pmr::get_default_resource());
+
+  const Feller::EventLog other{std::allocator_arg, &resource, copy};
+  EXPECT_EQ(other, copy);
+  EXPECT_EQ(other.get_allocator().resource(), &resource);
+}
+
+TEST(EventLog, testMoveAssignDifferentResource)
+{
+  const std::string value = "a value that is long enough to be allocated";
+  std::array<std::byte, 4096> buffer;
+  std::pmr::monotonic_buffer_resource resource{buffer.data(), buffer.size(),
+                                               std::pmr::null_memory_resource()};
+
+  // The parameters are copied into the resource of the target, rather than stolen.
+  Feller::EventLog target{std::allocator_arg, &resource, "key", "old"};
+  Feller::EventLog source{"Test"};
+  source.emplace_back("key", value);
+  const Feller::EventLog copy{source};
+  target = std::move(source);
+  EXPECT_EQ(target, copy);
+  EXPECT_EQ(target.get_allocator().resource(), &resource);
+  EXPECT_EQ(target.cbegin()->second.get_if<Feller::ParameterValue::string_type>()
+                ->get_allocator()
+                .resource(),
+            &resource);
+
+  // If the target's resource is exhausted, the assignment throws.
+  std::array<std::byte, 16> small;
+  std::pmr::monotonic_buffer_resource exhausted{small.data(), small.size(),
+                                                std::pmr::null_memory_resource()};
+  Feller::EventLog full{std::allocator_arg, &exhausted};
+  EXPECT_THROW(full = Feller::EventLog{copy}, std::bad_alloc);
+}
+
+TEST(EventLog, testTimeIsSet)
+{
+  // Every constructor that does not take a time reads the clock.
+  const auto before = std::chrono::system_clock::now();
+  const Feller::EventLog named{"abc"};
+  const Feller::EventLog inserted{"abc", "def"};
+  const Feller::EventLog typed{"abc", 5};
+  const auto after = std::chrono::system_clock::now();
+
+  for (const auto *const log : {&named, &inserted, &typed})
+  {
+    EXPECT_GE(log->time(), before);
+    EXPECT_LE(log->time(), after);
+  }
+}
+
+TEST(EventLog, testClockedEventLog)
+{
+  using Log        = Feller::ClockedEventLog<Feller::SteadyClock>;
+  const auto first = Log{"abc"};
+  const Log second{"abc", "def"};
+  EXPECT_EQ(first.name(), "abc");
+  EXPECT_EQ(second.name(), "Inserted");
+  ASSERT_EQ(second.size(), 1);
+  EXPECT_EQ(second.cbegin()->second, "def");
+  EXPECT_LE(first.time(), second.time());
+
+  // An explicit time is kept as is.
+  const Feller::EventLog::time_point time{std::chrono::seconds{5}};
+  EXPECT_EQ((Log{"abc", time}).time(), time);
+
+  // These logs may be stored in allocator-aware containers too.
+  std::pmr::vector<Log> logs;
+  logs.emplace_back("abc");
+  logs.emplace_back("abc", 5);
+  logs.push_back(first);
+  logs.push_back(Log{second});
+  EXPECT_EQ(logs[2], first);
+  EXPECT_EQ(logs[3], second);
+}
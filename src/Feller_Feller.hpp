@@ -48,6 +48,27 @@ logs.
 **/
 template <typename LogType, typename KeyType> class ContiguousLogStorage;
 
+/**
+  \brief The purpose of this component is to provide a bounded, lock-free
+  multi-producer/single-consumer container for logs of a specified type. Use this if
+your application inserts logs from many threads at once.
+**/
+template <typename LogType, typename KeyType> class RingBufferLogStorage;
+
+/**
+  \brief The purpose of this component is to provide a container for logs where
+  each thread writes into its own shard without synchronisation. Readers see a single,
+time-ordered view of all shards.
+**/
+template <typename LogType, typename KeyType> class ShardedLogStorage;
+
+/**
+  \brief The purpose of this component is to provide a container for logs that is
+  made of fixed-size blocks. Use this if your application needs stable log addresses or
+cannot tolerate the latency of relocating every log when the store grows.
+**/
+template <typename LogType, typename KeyType> class SegmentedLogStorage;
+
 /**
  \brief The purpose of this component is to allow you to extend the amount of
  data that is collected in each log.
@@ -95,6 +116,140 @@ class NoLock;
 template <typename LogType, typename KeyType, template <typename...> class StoragePolicy,
           typename LockPolicy, typename LoggingPolicy>
 class Logger;
+/**
+   \brief The purpose of this component is to represent an update to a counter or a gauge.
+**/
+class MetricLog;
+/**
+   \brief The purpose of this component is to aggregate metric updates in place, keeping a single
+   running value per metric rather than one record per update.
+**/
+template <typename LogType, typename KeyType> class MetricLogStorage;
+/**
+   \brief The purpose of this component is to record which thread built a log, and which CPU
+   that thread was running on.
+**/
+class ThreadEventLog;
+/**
+   \brief The purpose of this component is to export logs in the Chrome Trace Event format, so
+   that they can be viewed in chrome://tracing or Perfetto.
+**/
+class ChromeTraceWriter;
+/**
+   \brief The purpose of this component is to time a scope, inserting a single log with its
+   duration into a \ref Logger when the scope ends.
+**/
+template <typename LoggerType, typename ClockPolicy> class ScopedSpan;
+/**
+   \brief The purpose of these components is to read the time for a log. Each is a clock policy
+   that returns wall-clock time, but they differ in cost, resolution and monotonicity.
+**/
+class SystemClock;
+class SteadyClock;
+class CoarseClock;
+class TscClock;
+/**
+   \brief The purpose of this component is to time an \ref EventLog with a clock policy other
+   than \ref SystemClock.
+**/
+template <typename ClockPolicy> class ClockedEventLog;
+/**
+   \brief The purpose of this component is to convert times to text quickly, with sub-second
+   precision, without the locale and timezone machinery of std::ctime.
+**/
+class TimeFormatter;
+/**
+   \brief The purpose of this component is to allocate auxiliary \ref Data in large chunks, so
+   that it can be allocated cheaply and released all at once.
+**/
+class DataArena;
+/**
+   \brief The purpose of this component is to hold the auxiliary \ref Data of a log, storing
+   small data inline rather than on the heap.
+**/
+class AuxData;
+
+/**
+   \brief The purpose of this component is to record logs on hot paths as a call site id and the
+   raw bytes of their arguments, deferring all formatting until the logs are read.
+**/
+class DeferredLog;
+
+/**
+   \brief The purpose of this component is to register each call site that records a
+   \ref DeferredLog, along with the name and keys of its logs.
+**/
+class LogSite;
+
+/**
+   \brief The purpose of this component is to hold a typed parameter value (such as an integer or
+   a duration) without formatting it.
+**/
+class ParameterValue;
+
+/**
+   \brief The purpose of this component is to intern event names and parameter keys, so that each
+   distinct string is stored once and is identified by a small integer.
+**/
+class StringTable;
+
+/**
+   \brief The purpose of this component is to provide a cheap, integer-sized handle to a string in
+   the global \ref StringTable.
+**/
+class InternedString;
+
+/**
+   \brief The purpose of this component is to store event logs column by column, so that scans
+   over a few fields only touch those fields.
+**/
+template <typename LogType, typename KeyType> class ColumnarLogStorage;
+
+/**
+   \brief The purpose of this component is to answer time range queries over logs in O(log n).
+**/
+template <typename LogType, typename KeyType> class TimeIndexedLogStorage;
+
+/**
+   \brief The purpose of this component is to index logs by key in an open-addressing hash table.
+**/
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+class KeyedLogStorage;
+
+/**
+   \brief The purpose of this component is to keep only the most recent logs in a fixed number of
+   preallocated slots.
+**/
+template <typename LogType, typename KeyType> class FlightRecorderLogStorage;
+
+/**
+   \brief The purpose of this component is to store logs in a growable memory-mapped file.
+**/
+template <typename LogType, typename KeyType> class MappedLogStorage;
+
+/**
+   \brief The purpose of this component is to write event logs to a stream in a compact binary
+   format.
+**/
+class BinaryWriter;
+
+/**
+   \brief The purpose of this component is to read event logs that were written by a
+   \ref BinaryWriter.
+**/
+class BinaryReader;
+
+/**
+   \brief The purpose of this component is to provide a logger whose insertions only enqueue logs,
+   with a background thread moving them into a wrapped \ref Logger.
+**/
+template <typename LoggerType> class AsyncLogger;
+
+/**
+   \brief This enum describes what an \ref AsyncLogger does when a queue is full.
+**/
+enum class Backpressure;
+
 /**
      \brief The purpose of this component is to allow setting the logging mode statically.
 **/
@@ -103,6 +258,11 @@ template <Feller::LoggingMode logging> class StaticLoggingPolicy;
     \brief The purpose of this component is to allow setting the logging mode at runtime.
 **/
 class ConditionalLoggingPolicy;
+/**
+    \brief The purpose of this component is to allow setting the logging mode at runtime, whilst
+    other threads are logging.
+**/
+class AtomicConditionalLoggingPolicy;
 
 /**
  \brief The purpose of this namespace is to contain any utility functions that
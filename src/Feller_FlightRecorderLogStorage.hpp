@@ -0,0 +1,453 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_FLIGHT_RECORDER_LOG_STORAGE
+#define INCLUDED_FELLER_FLIGHT_RECORDER_LOG_STORAGE
+
+#include <cstddef>
+#include <iterator>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "Feller_Feller.hpp"
+
+namespace Feller
+{
+/**
+ FlightRecorderLogStorage. This class implements a fixed-capacity circular store that only keeps
+the most recent logs. All `capacity` slots are allocated on construction, and once every slot is
+in use each insertion overwrites the oldest log. This is useful in production, where the full log
+history is too large to keep but the last few events are wanted when something goes wrong.
+
+ Inserting a log by const reference copy-assigns it into its slot, so the strings and parameter
+vector of the previous occupant are reused rather than reallocated: once each slot has held a log
+of a given size, inserting logs no larger than this does not allocate. Inserting an rvalue moves
+the log into its slot. If the log provides an `assign(LogType &&)` method (as \ref EventLog does)
+this is used, so that the slot keeps its parameter vector and only the parameters themselves are
+moved; otherwise the log is move-assigned. Either way, the memory used by this class is bounded
+once it has warmed up.
+
+ The one exception is auxiliary data built with \ref Logger::make_aux. That data belongs to the
+logger's arena, and is only released by `Logger::clear`: overwriting a log does not release it.
+Hence a logger that uses this class and `make_aux` grows without bound unless it is cleared
+regularly. Logs in a flight recorder should hold their auxiliary data inline or on the heap (see
+\ref AuxData) instead, as that data is freed when its slot is overwritten.
+
+ Iteration goes from the oldest log to the newest, and iterators are random-access. Note that any
+insertion invalidates every iterator, as the oldest log changes.
+
+ \tparam LogType: the type of log to be stored in this class. This type must be default
+constructible and assignable.
+ \tparam KeyType: not used in this class.
+**/
+template <typename LogType, typename KeyType = char /*unused*/> class FlightRecorderLogStorage
+{
+public:
+  /**
+     size_type. This type is used to represent sizes and indices in this object.
+  **/
+  using size_type = std::size_t;
+
+  /**
+     default_capacity. This is the number of slots if no capacity is specified.
+  **/
+  static constexpr size_type default_capacity = 1024;
+
+  /**
+     const_iterator. This class provides random access to the logs in this object, from the
+  oldest log to the newest.
+  **/
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = LogType;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const LogType *;
+    using reference         = const LogType &;
+
+    const_iterator() = default;
+
+    reference operator*() const { return (*m_storage)[static_cast<size_type>(m_index)]; }
+    pointer operator->() const { return &**this; }
+    reference operator[](const difference_type n) const { return *(*this + n); }
+
+    const_iterator &operator++()
+    {
+      ++m_index;
+      return *this;
+    }
+
+    const_iterator operator++(int)
+    {
+      auto tmp = *this;
+      ++m_index;
+      return tmp;
+    }
+
+    const_iterator &operator--()
+    {
+      --m_index;
+      return *this;
+    }
+
+    const_iterator operator--(int)
+    {
+      auto tmp = *this;
+      --m_index;
+      return tmp;
+    }
+
+    const_iterator &operator+=(const difference_type n)
+    {
+      m_index += n;
+      return *this;
+    }
+
+    const_iterator &operator-=(const difference_type n)
+    {
+      m_index -= n;
+      return *this;
+    }
+
+    friend const_iterator operator+(const_iterator it, const difference_type n) { return it += n; }
+    friend const_iterator operator+(const difference_type n, const_iterator it) { return it += n; }
+    friend const_iterator operator-(const_iterator it, const difference_type n) { return it -= n; }
+    friend difference_type operator-(const const_iterator &lhs, const const_iterator &rhs)
+    {
+      return lhs.m_index - rhs.m_index;
+    }
+
+    friend bool operator==(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return lhs.m_storage == rhs.m_storage && lhs.m_index == rhs.m_index;
+    }
+    friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return !(lhs == rhs);
+    }
+    friend bool operator<(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return lhs.m_index < rhs.m_index;
+    }
+    friend bool operator>(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return rhs < lhs;
+    }
+    friend bool operator<=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return !(rhs < lhs);
+    }
+    friend bool operator>=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return !(lhs < rhs);
+    }
+
+  private:
+    friend class FlightRecorderLogStorage;
+    const_iterator(const FlightRecorderLogStorage *storage, const difference_type index)
+        : m_storage{storage}, m_index{index}
+    {
+    }
+
+    const FlightRecorderLogStorage *m_storage{nullptr};
+    difference_type m_index{0};
+  };
+
+  /**
+     FlightRecorderLogStorage. This constructor allocates `capacity` default-constructed logs.
+  A capacity of zero is treated as one. This constructor may throw due to allocation failures.
+     \param capacity: the number of logs to keep.
+  **/
+  explicit FlightRecorderLogStorage(const size_type capacity = default_capacity);
+
+  /**
+     insert. This method copies `log` into the slot of the oldest log. This reuses the memory
+  held by that slot where possible. This function may throw due to allocation failures: in this
+  case the slot is left in a valid but unspecified state.
+     \param log: the log to be copied into this object.
+  **/
+  inline void insert(const LogType &log);
+
+  /**
+     insert. This method moves `log` into the slot of the oldest log. Where possible this keeps
+  the capacity of that slot, as described above. This function may throw due to allocation
+  failures: in this case the slot is left in a valid but unspecified state.
+     \param log: the log to be moved into this object.
+  **/
+  inline void insert(LogType &&log);
+
+  /**
+     emplace_back. This method builds a log from `args` and moves it into the slot of the oldest
+  log.
+     \param args: the arguments to be forwarded to the constructor of the log.
+  **/
+  template <typename... Args> inline void emplace_back(Args &&...args);
+
+  /**
+     operator[]. This method returns the `index`-th oldest log in this object. The behaviour of
+  this function is undefined if `index >= size()`.
+     \param index: the position of the log, where 0 is the oldest.
+     \return a const reference to the log.
+  **/
+  inline const LogType &operator[](const size_type index) const noexcept;
+
+  /**
+     size. This method returns the number of logs in this object. This is never more than the
+  capacity. This function does not throw.
+     \return the number of logs in this object.
+  **/
+  inline size_type size() const noexcept;
+
+  /**
+     capacity. This method returns the maximum number of logs kept by this object.
+     \return the number of slots.
+  **/
+  inline size_type capacity() const noexcept;
+
+  /**
+     overwritten. This method returns the number of logs that have been overwritten since
+  construction or the last call to `clear`.
+     \return the number of overwritten logs.
+  **/
+  inline size_type overwritten() const noexcept;
+
+  /**
+     cbegin. This method returns a const iterator to the oldest log in this object.
+     \return a const iterator to the first log.
+  **/
+  inline const_iterator cbegin() const noexcept;
+
+  /**
+     cend. This method returns a const iterator to one past the newest log in this object.
+     \return a const iterator to the end of the logs.
+  **/
+  inline const_iterator cend() const noexcept;
+
+  /// Overloads of cbegin and cend to allow range-based for loops.
+  inline const_iterator begin() const noexcept;
+  inline const_iterator end() const noexcept;
+
+  /**
+     clear. This method removes every log from this object. The slots are not freed, so their
+  memory is reused by later insertions.
+  **/
+  inline void clear() noexcept;
+
+  /**
+      operator<<. Prints a string representation of the object ``st`` to the
+      specified ostream ``os`. This method may throw.
+      \tparam LT: the type stored in st.
+      \param os: the stream to print the storage object to.
+      \param st: the object to be printed.
+      \return the os parameter.
+   **/
+  template <typename LT, typename KT>
+  inline friend std::ostream &operator<<(std::ostream &os,
+                                         const FlightRecorderLogStorage<LT, KT> &st);
+
+private:
+  /**
+     next_slot. This method returns the slot that the next log is written to.
+  **/
+  inline LogType &next_slot() noexcept;
+
+  /**
+     advance. This method records that the next slot has been written. This is called after the
+  write, so that a write that throws is not counted.
+  **/
+  inline void advance() noexcept;
+
+  /**
+     assign. These functions move `log` into `slot`, via `LogType::assign` if there is such a
+  method and via move assignment otherwise. The last parameter only selects the overload.
+     \param slot: the slot to be overwritten.
+     \param log: the log to be moved from.
+  **/
+  template <typename T>
+  static inline auto assign(T &slot, T &&log, int) -> decltype(slot.assign(std::move(log)));
+  template <typename T> static inline void assign(T &slot, T &&log, long);
+
+  /**
+     m_slots. These are the slots of the ring. This vector never changes size after construction.
+  **/
+  std::vector<LogType> m_slots;
+
+  /**
+     m_next. This is the index of the slot that the next log is written to. Once the ring is
+  full, this is also the slot of the oldest log.
+  **/
+  size_type m_next{0};
+
+  /**
+     m_size. This is the number of slots that hold a log.
+  **/
+  size_type m_size{0};
+
+  /**
+     m_overwritten. This is the number of logs that have been overwritten.
+  **/
+  size_type m_overwritten{0};
+};
+
+/// INLINE FUNCTIONS
+template <typename LogType, typename KeyType>
+Feller::FlightRecorderLogStorage<LogType, KeyType>::FlightRecorderLogStorage(
+    const size_type capacity)
+    : m_slots(capacity == 0 ? 1 : capacity)
+{
+}
+
+template <typename LogType, typename KeyType>
+inline std::ostream &operator<<(std::ostream &os,
+                                const FlightRecorderLogStorage<LogType, KeyType> &st)
+{
+  for (auto &v : st)
+  {
+    os << v;
+  }
+  return os;
+}
+
+template <typename LogType, typename KeyType>
+inline LogType &Feller::FlightRecorderLogStorage<LogType, KeyType>::next_slot() noexcept
+{
+  return m_slots[m_next];
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::FlightRecorderLogStorage<LogType, KeyType>::advance() noexcept
+{
+  m_next = (m_next + 1 == m_slots.size()) ? 0 : m_next + 1;
+  if (m_size == m_slots.size())
+  {
+    ++m_overwritten;
+  }
+  else
+  {
+    ++m_size;
+  }
+}
+
+template <typename LogType, typename KeyType>
+template <typename T>
+inline auto Feller::FlightRecorderLogStorage<LogType, KeyType>::assign(T &slot, T &&log, int)
+    -> decltype(slot.assign(std::move(log)))
+{
+  return slot.assign(std::move(log));
+}
+
+template <typename LogType, typename KeyType>
+template <typename T>
+inline void Feller::FlightRecorderLogStorage<LogType, KeyType>::assign(T &slot, T &&log, long)
+{
+  slot = std::move(log);
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::FlightRecorderLogStorage<LogType, KeyType>::insert(const LogType &log)
+{
+  next_slot() = log;
+  advance();
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::FlightRecorderLogStorage<LogType, KeyType>::insert(LogType &&log)
+{
+  assign(next_slot(), std::move(log), 0);
+  advance();
+}
+
+template <typename LogType, typename KeyType>
+template <typename... Args>
+inline void Feller::FlightRecorderLogStorage<LogType, KeyType>::emplace_back(Args &&...args)
+{
+  assign(next_slot(), LogType(std::forward<Args>(args)...), 0);
+  advance();
+}
+
+template <typename LogType, typename KeyType>
+inline const LogType &
+Feller::FlightRecorderLogStorage<LogType, KeyType>::operator[](const size_type index) const noexcept
+{
+  // Until the ring is full the oldest log is in slot 0, and afterwards it is in slot m_next.
+  const auto oldest = (m_size == m_slots.size()) ? m_next : 0;
+  const auto slot   = oldest + index;
+  return m_slots[slot >= m_slots.size() ? slot - m_slots.size() : slot];
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::FlightRecorderLogStorage<LogType, KeyType>::size() const noexcept -> size_type
+{
+  return m_size;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::FlightRecorderLogStorage<LogType, KeyType>::capacity() const noexcept
+    -> size_type
+{
+  return m_slots.size();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::FlightRecorderLogStorage<LogType, KeyType>::overwritten() const noexcept
+    -> size_type
+{
+  return m_overwritten;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::FlightRecorderLogStorage<LogType, KeyType>::cbegin() const noexcept
+    -> const_iterator
+{
+  return const_iterator{this, 0};
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::FlightRecorderLogStorage<LogType, KeyType>::cend() const noexcept
+    -> const_iterator
+{
+  return const_iterator{this, static_cast<typename const_iterator::difference_type>(m_size)};
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::FlightRecorderLogStorage<LogType, KeyType>::begin() const noexcept
+    -> const_iterator
+{
+  return cbegin();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::FlightRecorderLogStorage<LogType, KeyType>::end() const noexcept
+    -> const_iterator
+{
+  return cend();
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::FlightRecorderLogStorage<LogType, KeyType>::clear() noexcept
+{
+  m_next        = 0;
+  m_size        = 0;
+  m_overwritten = 0;
+}
+
+}  // namespace Feller
+
+#endif
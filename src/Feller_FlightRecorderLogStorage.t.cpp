@@ -0,0 +1,165 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_AllocationCounter.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_FlightRecorderLogStorage.hpp"
+#include "Feller_LogEverything.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_NoLock.hpp"
+#include "Feller_TestData.hpp"
+#include "Feller_TestLogs.hpp"
+#include "gtest/gtest.h"
+
+#include <memory>
+
+using Storage = Feller::FlightRecorderLogStorage<Feller::EventLog>;
+
+TEST(FlightRecorderLogStorage, testCapacity)
+{
+  EXPECT_EQ(Storage{}.capacity(), Storage::default_capacity);
+  EXPECT_EQ(Storage{3}.capacity(), 3);
+  EXPECT_EQ(Storage{0}.capacity(), 1);
+}
+
+TEST(FlightRecorderLogStorage, testOverwritesOldest)
+{
+  Storage storage{3};
+  EXPECT_EQ(storage.cbegin(), storage.cend());
+
+  storage.insert(numbered(0));
+  storage.insert(numbered(1));
+  EXPECT_EQ(names(storage), (std::vector<std::string>{"0", "1"}));
+  EXPECT_EQ(storage.overwritten(), 0);
+
+  for (unsigned i = 2; i < 8; i++)
+  {
+    storage.insert(numbered(i));
+  }
+
+  ASSERT_EQ(storage.size(), 3);
+  EXPECT_EQ(storage.overwritten(), 5);
+  EXPECT_EQ(names(storage), (std::vector<std::string>{"5", "6", "7"}));
+  EXPECT_EQ(storage[0].name(), "5");
+  EXPECT_EQ((storage.cend() - 1)->name(), "7");
+  EXPECT_EQ(storage.cend() - storage.cbegin(), 3);
+}
+
+TEST(FlightRecorderLogStorage, testClear)
+{
+  Storage storage{2};
+  for (unsigned i = 0; i < 5; i++)
+  {
+    storage.insert(numbered(i));
+  }
+
+  storage.clear();
+  EXPECT_EQ(storage.size(), 0);
+  EXPECT_EQ(storage.overwritten(), 0);
+  EXPECT_EQ(storage.capacity(), 2);
+
+  storage.insert(numbered(9));
+  EXPECT_EQ(names(storage), std::vector<std::string>{"9"});
+}
+
+TEST(FlightRecorderLogStorage, testCopyReusesCapacity)
+{
+  constexpr unsigned capacity = 16;
+  Storage storage{capacity};
+
+  // These strings are too long for the small string optimisation.
+  Feller::EventLog log{"A name that is long enough to be allocated"};
+  log.emplace_back("A key that is long enough to be allocated", std::string(100, 'v'));
+  log.emplace_back("Another key that is long enough to be allocated", std::string(100, 'w'));
+
+  // The first lap allocates the memory for each slot.
+  for (unsigned i = 0; i < capacity; i++)
+  {
+    storage.insert(log);
+  }
+
+  const auto before = nr_allocations;
+  for (unsigned i = 0; i < 10 * capacity; i++)
+  {
+    storage.insert(log);
+  }
+
+  EXPECT_EQ(nr_allocations, before);
+  EXPECT_EQ(storage[0], log);
+}
+
+TEST(FlightRecorderLogStorage, testMoveDoesNotAllocate)
+{
+  Storage storage{1};
+  const auto make = [] {
+    Feller::EventLog log{"A name that is long enough to be allocated"};
+    log.emplace_back("A key that is long enough to be allocated", std::string(100, 'v'));
+    return log;
+  };
+
+  // The first insertion allocates the parameter vector of the slot, and later ones reuse it.
+  storage.insert(make());
+  auto log        = make();
+  const auto copy = log;
+
+  const auto before = nr_allocations;
+  storage.insert(std::move(log));
+  EXPECT_EQ(nr_allocations, before);
+  EXPECT_EQ(storage[0], copy);
+}
+
+TEST(FlightRecorderLogStorage, testMoveReusesCapacity)
+{
+  Storage storage{1};
+  Feller::EventLog large{"large"};
+  for (unsigned i = 0; i < 8; i++)
+  {
+    large.emplace_back("key", "value");
+  }
+  storage.insert(std::move(large));
+  ASSERT_GE(storage[0].capacity(), 8);
+
+  // Moving a smaller log into the slot keeps the parameter vector of the slot.
+  Feller::EventLog small{"small"};
+  small.emplace_back("key", "other");
+  small.aux() = std::make_unique<Feller::TestData>();
+  const auto *const aux = small.aux().get();
+  const auto copy       = small;
+  storage.insert(std::move(small));
+  EXPECT_EQ(storage[0], copy);
+  EXPECT_GE(storage[0].capacity(), 8);
+  EXPECT_EQ(storage[0].aux().get(), aux);
+
+  // The same holds for logs that are built in place.
+  storage.emplace_back("key", "value");
+  EXPECT_EQ(storage[0].name(), "Inserted");
+  EXPECT_GE(storage[0].capacity(), 8);
+}
+
+TEST(FlightRecorderLogStorage, testWithLogger)
+{
+  Feller::Logger<Feller::EventLog, char, Feller::FlightRecorderLogStorage, Feller::NoLock,
+                 Feller::LogEverything>
+      logger{2u};
+  logger.insert(Feller::EventLog{"a"});
+  logger.emplace("b");
+  logger.emplace("c");
+  ASSERT_EQ(logger.size(), 2);
+  EXPECT_EQ(logger.cbegin()->name(), "b");
+  EXPECT_EQ((logger.cbegin() + 1)->name(), "c");
+}
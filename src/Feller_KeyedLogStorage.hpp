@@ -0,0 +1,518 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_KEYED_LOG_STORAGE
+#define INCLUDED_FELLER_KEYED_LOG_STORAGE
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "Feller_Feller.hpp"
+
+namespace Feller
+{
+/**
+ KeyedLogStorage. This class implements a store that indexes logs by a key, such as a request id,
+so that every log for a given key can be retrieved without scanning the whole store.
+
+ Briefly, logs are held contiguously in insertion order, exactly as in \ref ContiguousLogStorage.
+Alongside the logs this class keeps an open-addressing hash table (with linear probing) from each
+key to the first and last log with that key, and each log records the position of the next log
+with the same key. Hence finding a key is a short probe over a flat array, and iterating over the
+logs for a key follows a chain of indices through the log vector: unlike std::unordered_multimap,
+there is no allocation per log and no pointer chasing between separate nodes. The table is never
+more than half full, and growing it only rehashes the keys: the logs are not touched.
+
+ Logs that are inserted without a key (e.g via the insert methods that \ref Logger always uses)
+are stored but not indexed.
+
+ \tparam LogType: the type of log to be stored in this class.
+ \tparam KeyType: the type of key used to index logs. This must be default constructible and
+copy assignable.
+ \tparam Hash: the hash function used for keys.
+ \tparam KeyEqual: the function used to compare keys for equality.
+**/
+template <typename LogType, typename KeyType = char, typename Hash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class KeyedLogStorage
+{
+public:
+  /**
+     size_type. This type is used to represent sizes and indices in this object.
+  **/
+  using size_type = std::size_t;
+
+  /**
+     const_iterator. This type is used to iterate over every log in insertion order.
+  **/
+  using const_iterator = typename std::vector<LogType>::const_iterator;
+
+  /**
+     key_iterator. This class iterates over the logs that share a single key, in insertion order.
+  **/
+  class key_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = LogType;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const LogType *;
+    using reference         = const LogType &;
+
+    key_iterator() = default;
+
+    reference operator*() const { return m_storage->m_logs[m_index]; }
+    pointer operator->() const { return &**this; }
+
+    key_iterator &operator++()
+    {
+      m_index = m_storage->m_next[m_index];
+      return *this;
+    }
+
+    key_iterator operator++(int)
+    {
+      auto tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    friend bool operator==(const key_iterator &lhs, const key_iterator &rhs) noexcept
+    {
+      return lhs.m_index == rhs.m_index;
+    }
+    friend bool operator!=(const key_iterator &lhs, const key_iterator &rhs) noexcept
+    {
+      return !(lhs == rhs);
+    }
+
+  private:
+    friend class KeyedLogStorage;
+    key_iterator(const KeyedLogStorage *storage, const size_type index)
+        : m_storage{storage}, m_index{index}
+    {
+    }
+
+    const KeyedLogStorage *m_storage{nullptr};
+    size_type m_index{npos};
+  };
+
+  /**
+     insert. This method copies `log` into this object without a key. This function may throw
+  due to allocation failures.
+     \param log: the log to be copied into this object.
+  **/
+  inline void insert(const LogType &log);
+
+  /// Overload of insert for rvalue refs.
+  inline void insert(LogType &&log);
+
+  /**
+     insert. This method copies `log` into this object and indexes it under `key`. This function
+  may throw due to allocation failures: in this case the log is not stored.
+     \param key: the key of the log.
+     \param log: the log to be copied into this object.
+  **/
+  inline void insert(const KeyType &key, const LogType &log);
+
+  /// Overload of insert for rvalue refs.
+  inline void insert(const KeyType &key, LogType &&log);
+
+  /**
+     emplace_back. This method builds a log from `args` at the end of this object, without a key.
+     \param args: the arguments to be forwarded to the constructor of the log.
+  **/
+  template <typename... Args> inline void emplace_back(Args &&...args);
+
+  /**
+     find. This method returns an iterator to the oldest log with `key`. This function does not
+  modify this object.
+     \param key: the key to be found.
+     \return an iterator into the whole store, or cend() if no log has `key`.
+  **/
+  inline const_iterator find(const KeyType &key) const;
+
+  /**
+     equal_range. This method returns the range of logs with `key`, oldest first. This function
+  does not modify this object.
+     \param key: the key to be found.
+     \return a pair of iterators over the logs with `key`. These are equal if there are none.
+  **/
+  inline std::pair<key_iterator, key_iterator> equal_range(const KeyType &key) const;
+
+  /**
+     count. This method returns the number of logs with `key`.
+     \param key: the key to be counted.
+     \return the number of logs with `key`.
+  **/
+  inline size_type count(const KeyType &key) const;
+
+  /**
+     keys. This method returns the number of distinct keys in this object.
+     \return the number of keys.
+  **/
+  inline size_type keys() const noexcept;
+
+  /**
+     size. This method returns the number of logs in this object, with or without a key.
+     \return the number of logs in this object.
+  **/
+  inline size_type size() const noexcept;
+
+  /**
+     cbegin. This method returns a const iterator to the oldest log in this object.
+     \return a const iterator to the first log.
+  **/
+  inline const_iterator cbegin() const noexcept;
+
+  /**
+     cend. This method returns a const iterator to one past the newest log in this object.
+     \return a const iterator to the end of the logs.
+  **/
+  inline const_iterator cend() const noexcept;
+
+  /// Overloads of cbegin and cend to allow range-based for loops.
+  inline const_iterator begin() const noexcept;
+  inline const_iterator end() const noexcept;
+
+  /**
+     clear. This method removes every log and key from this object. Note that the memory is not
+  freed.
+  **/
+  inline void clear() noexcept;
+
+  /**
+      operator<<. Prints a string representation of the object ``st`` to the
+      specified ostream ``os`. This method may throw.
+      \param os: the stream to print the storage object to.
+      \param st: the object to be printed.
+      \return the os parameter.
+   **/
+  template <typename LT, typename KT, typename H, typename KE>
+  inline friend std::ostream &operator<<(std::ostream &os,
+                                         const KeyedLogStorage<LT, KT, H, KE> &st);
+
+private:
+  /**
+     npos. This index marks the end of a chain, and an empty bucket.
+  **/
+  static constexpr size_type npos = std::numeric_limits<size_type>::max();
+
+  /**
+     initial_buckets. This is the number of buckets allocated by the first keyed insertion.
+  **/
+  static constexpr size_type initial_buckets = 16;
+
+  /**
+     Bucket. This struct is a single entry in the hash table. The hash is kept so that probing
+  and growing rarely need to compare or rehash keys.
+  **/
+  struct Bucket
+  {
+    std::size_t hash{0};
+    size_type first{npos};
+    size_type last{npos};
+    size_type count{0};
+    KeyType key{};
+  };
+
+  /**
+     locate. This method returns the index of the bucket for `key`. This is either the bucket
+  holding `key`, or the empty bucket where `key` would be placed. The table must not be empty.
+     \param key: the key to be found.
+     \param hash: the hash of `key`.
+     \return the index of a bucket.
+  **/
+  inline size_type locate(const KeyType &key, std::size_t hash) const;
+
+  /**
+     lookup. This method returns the bucket holding `key`, if any.
+     \return a pointer to the bucket, or nullptr if `key` is not in this object.
+  **/
+  inline const Bucket *lookup(const KeyType &key) const;
+
+  /**
+     grow. This method doubles the number of buckets and moves every key across.
+  **/
+  inline void grow();
+
+  /**
+     insert_keyed. This method implements the keyed insertion methods.
+  **/
+  template <typename T> inline void insert_keyed(const KeyType &key, T &&log);
+
+  /**
+     m_logs. This vector holds every log in insertion order.
+  **/
+  std::vector<LogType> m_logs{};
+
+  /**
+     m_next. For each log, this is the index of the next log with the same key, or npos.
+  **/
+  std::vector<size_type> m_next{};
+
+  /**
+     m_buckets. This is the hash table. The number of buckets is zero or a power of two.
+  **/
+  std::vector<Bucket> m_buckets{};
+
+  /**
+     m_keys. This is the number of buckets that are in use.
+  **/
+  size_type m_keys{0};
+
+  /**
+     m_hash. This is used to hash keys.
+  **/
+  Hash m_hash{};
+
+  /**
+     m_equal. This is used to compare keys.
+  **/
+  KeyEqual m_equal{};
+};
+
+/// INLINE FUNCTIONS
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline std::ostream &operator<<(std::ostream &os,
+                                const KeyedLogStorage<LogType, KeyType, Hash, KeyEqual> &st)
+{
+  for (auto &v : st)
+  {
+    os << v;
+  }
+  return os;
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline void Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::insert(const LogType &log)
+{
+  emplace_back(log);
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline void Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::insert(LogType &&log)
+{
+  emplace_back(std::move(log));
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+template <typename... Args>
+inline void Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::emplace_back(Args &&...args)
+{
+  m_next.push_back(npos);
+  try
+  {
+    m_logs.emplace_back(std::forward<Args>(args)...);
+  }
+  catch (...)
+  {
+    m_next.pop_back();
+    throw;
+  }
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline void Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::insert(const KeyType &key,
+                                                                              const LogType &log)
+{
+  insert_keyed(key, log);
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline void Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::insert(const KeyType &key,
+                                                                              LogType &&log)
+{
+  insert_keyed(key, std::move(log));
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+template <typename T>
+inline void Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::insert_keyed(
+    const KeyType &key, T &&log)
+{
+  // Growing first means that the table is unchanged if anything below throws.
+  if (2 * (m_keys + 1) > m_buckets.size())
+  {
+    grow();
+  }
+
+  const auto hash  = m_hash(key);
+  auto &bucket     = m_buckets[locate(key, hash)];
+  const bool fresh = bucket.first == npos;
+  if (fresh)
+  {
+    bucket.key = key;
+  }
+
+  emplace_back(std::forward<T>(log));
+  const auto index = m_logs.size() - 1;
+  if (fresh)
+  {
+    bucket.hash  = hash;
+    bucket.first = index;
+    bucket.count = 0;
+    ++m_keys;
+  }
+  else
+  {
+    m_next[bucket.last] = index;
+  }
+
+  bucket.last = index;
+  ++bucket.count;
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline auto Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::locate(
+    const KeyType &key, const std::size_t hash) const -> size_type
+{
+  const auto mask = m_buckets.size() - 1;
+  for (auto i = hash & mask;; i = (i + 1) & mask)
+  {
+    const auto &bucket = m_buckets[i];
+    if (bucket.first == npos || (bucket.hash == hash && m_equal(bucket.key, key)))
+    {
+      return i;
+    }
+  }
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline auto Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::lookup(
+    const KeyType &key) const -> const Bucket *
+{
+  if (m_keys == 0)
+  {
+    return nullptr;
+  }
+
+  const auto &bucket = m_buckets[locate(key, m_hash(key))];
+  return bucket.first == npos ? nullptr : &bucket;
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline void Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::grow()
+{
+  std::vector<Bucket> buckets(m_buckets.empty() ? initial_buckets : 2 * m_buckets.size());
+  const auto mask = buckets.size() - 1;
+  for (auto &bucket : m_buckets)
+  {
+    if (bucket.first == npos)
+    {
+      continue;
+    }
+
+    // Every key is distinct, so we only need to find an empty bucket.
+    auto i = bucket.hash & mask;
+    while (buckets[i].first != npos)
+    {
+      i = (i + 1) & mask;
+    }
+    buckets[i] = std::move(bucket);
+  }
+
+  m_buckets.swap(buckets);
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline auto Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::find(
+    const KeyType &key) const -> const_iterator
+{
+  const auto *const bucket = lookup(key);
+  return bucket ? m_logs.cbegin() + static_cast<std::ptrdiff_t>(bucket->first) : m_logs.cend();
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline auto Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::equal_range(
+    const KeyType &key) const -> std::pair<key_iterator, key_iterator>
+{
+  const auto *const bucket = lookup(key);
+  return {key_iterator{this, bucket ? bucket->first : npos}, key_iterator{this, npos}};
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline auto Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::count(
+    const KeyType &key) const -> size_type
+{
+  const auto *const bucket = lookup(key);
+  return bucket ? bucket->count : 0;
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline auto Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::keys() const noexcept
+    -> size_type
+{
+  return m_keys;
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline auto Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::size() const noexcept
+    -> size_type
+{
+  return m_logs.size();
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline auto Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::cbegin() const noexcept
+    -> const_iterator
+{
+  return m_logs.cbegin();
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline auto Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::cend() const noexcept
+    -> const_iterator
+{
+  return m_logs.cend();
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline auto Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::begin() const noexcept
+    -> const_iterator
+{
+  return cbegin();
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline auto Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::end() const noexcept
+    -> const_iterator
+{
+  return cend();
+}
+
+template <typename LogType, typename KeyType, typename Hash, typename KeyEqual>
+inline void Feller::KeyedLogStorage<LogType, KeyType, Hash, KeyEqual>::clear() noexcept
+{
+  m_logs.clear();
+  m_next.clear();
+  for (auto &bucket : m_buckets)
+  {
+    bucket.first = npos;
+  }
+  m_keys = 0;
+}
+
+}  // namespace Feller
+
+#endif
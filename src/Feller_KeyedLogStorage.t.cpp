@@ -0,0 +1,141 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_ConditionalLoggingPolicy.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_KeyedLogStorage.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_NoLock.hpp"
+#include "Feller_TestLogs.hpp"
+#include "gtest/gtest.h"
+
+#include <string>
+
+using Storage = Feller::KeyedLogStorage<Feller::EventLog, std::string>;
+
+TEST(KeyedLogStorage, testEmpty)
+{
+  Storage storage;
+  EXPECT_EQ(storage.size(), 0);
+  EXPECT_EQ(storage.keys(), 0);
+  EXPECT_EQ(storage.find("a"), storage.cend());
+  EXPECT_EQ(storage.count("a"), 0);
+  const auto range = storage.equal_range("a");
+  EXPECT_EQ(range.first, range.second);
+}
+
+TEST(KeyedLogStorage, testInsertAndFind)
+{
+  Storage storage;
+  storage.insert("a", numbered(0));
+  storage.insert(numbered(1));
+  storage.insert("b", numbered(2));
+  storage.insert("a", numbered(3));
+  const auto log = numbered(4);
+  storage.insert("a", log);
+
+  EXPECT_EQ(storage.size(), 5);
+  EXPECT_EQ(storage.keys(), 2);
+  EXPECT_EQ(storage.count("a"), 3);
+  EXPECT_EQ(storage.count("b"), 1);
+
+  // Iteration over the whole store is in insertion order, keyed or not.
+  std::vector<std::string> all;
+  for (const auto &v : storage)
+  {
+    all.push_back(v.name());
+  }
+  EXPECT_EQ(all, (std::vector<std::string>{"0", "1", "2", "3", "4"}));
+
+  EXPECT_EQ(storage.find("a") - storage.cbegin(), 0);
+  EXPECT_EQ(storage.find("b")->name(), "2");
+  EXPECT_EQ(names(storage.equal_range("a")), (std::vector<std::string>{"0", "3", "4"}));
+  EXPECT_EQ(names(storage.equal_range("b")), std::vector<std::string>{"2"});
+}
+
+TEST(KeyedLogStorage, testManyKeys)
+{
+  // This grows the table several times and checks that every chain survives.
+  Storage storage;
+  constexpr unsigned nr_keys = 1000;
+  for (unsigned i = 0; i < 3 * nr_keys; i++)
+  {
+    storage.insert("request " + std::to_string(i % nr_keys), numbered(i));
+  }
+
+  EXPECT_EQ(storage.keys(), nr_keys);
+  for (unsigned k = 0; k < nr_keys; k++)
+  {
+    const auto expected = std::vector<std::string>{
+        std::to_string(k), std::to_string(k + nr_keys), std::to_string(k + 2 * nr_keys)};
+    ASSERT_EQ(names(storage.equal_range("request " + std::to_string(k))), expected);
+  }
+  EXPECT_EQ(storage.count("request " + std::to_string(nr_keys)), 0);
+}
+
+// This hash sends every key to the same bucket, so every lookup has to probe.
+struct BadHash
+{
+  std::size_t operator()(const int) const noexcept { return 7; }
+};
+
+TEST(KeyedLogStorage, testCollisions)
+{
+  Feller::KeyedLogStorage<Feller::EventLog, int, BadHash> storage;
+  for (unsigned i = 0; i < 100; i++)
+  {
+    storage.insert(static_cast<int>(i % 10), numbered(i));
+  }
+
+  EXPECT_EQ(storage.keys(), 10);
+  for (int k = 0; k < 10; k++)
+  {
+    EXPECT_EQ(storage.count(k), 10);
+    EXPECT_EQ(storage.find(k)->name(), std::to_string(k));
+  }
+  EXPECT_EQ(storage.find(10), storage.cend());
+}
+
+TEST(KeyedLogStorage, testClear)
+{
+  Storage storage;
+  storage.insert("a", numbered(0));
+  storage.insert("b", numbered(1));
+  storage.clear();
+  EXPECT_EQ(storage.size(), 0);
+  EXPECT_EQ(storage.keys(), 0);
+  EXPECT_EQ(storage.count("a"), 0);
+
+  storage.insert("b", numbered(2));
+  EXPECT_EQ(storage.count("b"), 1);
+  EXPECT_EQ(names(storage.equal_range("b")), std::vector<std::string>{"2"});
+}
+
+TEST(KeyedLogStorage, testWithLogger)
+{
+  Feller::Logger<Feller::EventLog, std::string, Feller::KeyedLogStorage, Feller::NoLock,
+                 Feller::ConditionalLoggingPolicy>
+      logger;
+  logger.switchMode(Feller::LoggingMode::IMPORTANT);
+  logger.insert("request", numbered(0), Feller::LoggingMode::IMPORTANT);
+  logger.insert("request", numbered(1), Feller::LoggingMode::EVERYTHING);
+  logger.insert(numbered(2), Feller::LoggingMode::IMPORTANT);
+
+  EXPECT_EQ(logger.size(), 2);
+  EXPECT_EQ(names(logger.equal_range("request")), std::vector<std::string>{"0"});
+}
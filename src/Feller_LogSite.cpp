@@ -0,0 +1,157 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_LogSite.hpp"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+namespace
+{
+/**
+   Registry. This struct holds every registered site. The sites are owned by a deque, so that
+   registering a site never moves the others, and registration is serialised by a mutex. Lookups
+   by id do not lock: as in \ref Feller::StringTable, the address of each site is also published in
+   a list of segments that double in size, so that existing entries never move.
+**/
+struct Registry
+{
+  /**
+     first_segment_shift. The first segment holds 2^first_segment_shift sites, and each later
+  segment holds twice as many as the one before.
+  **/
+  static constexpr unsigned first_segment_shift = 6;
+
+  /**
+     nr_segments. This is enough segments to hold 2^32 sites.
+  **/
+  static constexpr unsigned nr_segments = 33 - first_segment_shift;
+
+  using entry_type = std::atomic<const Feller::LogSite *>;
+
+  Registry();
+  ~Registry();
+
+  /**
+     push. This method registers `site`, whose id must be the current size. The caller must hold
+  `mutex`, unless this object is being constructed.
+  **/
+  const Feller::LogSite &push(Feller::LogSite site);
+
+  /**
+     segment_of. This function returns the segment holding `id`, and the offset of `id` within
+  that segment.
+  **/
+  static void segment_of(Feller::LogSite::id_type id, unsigned &segment,
+                         std::size_t &offset) noexcept;
+
+  std::mutex mutex;
+  std::deque<Feller::LogSite> sites;
+  std::atomic<entry_type *> segments[nr_segments];
+  std::atomic<std::size_t> size{0};
+};
+
+Registry::Registry()
+{
+  for (auto &segment : segments)
+  {
+    segment.store(nullptr, std::memory_order_relaxed);
+  }
+
+  // A new site has the unknown id, which is also the first id.
+  push(Feller::LogSite{"", 0, "Unknown site"});
+}
+
+Registry::~Registry()
+{
+  for (auto &segment : segments)
+  {
+    delete[] segment.load(std::memory_order_relaxed);
+  }
+}
+
+const Feller::LogSite &Registry::push(Feller::LogSite site)
+{
+  const auto id = site.id();
+  unsigned segment;
+  std::size_t offset;
+  segment_of(id, segment, offset);
+  if (segments[segment].load(std::memory_order_relaxed) == nullptr)
+  {
+    const auto nr_entries = std::size_t{1} << (first_segment_shift + segment);
+    segments[segment].store(new entry_type[nr_entries](), std::memory_order_release);
+  }
+
+  // The site is published after it is built, so any reader that finds it sees all of it.
+  sites.push_back(std::move(site));
+  segments[segment].load(std::memory_order_relaxed)[offset].store(&sites.back(),
+                                                                  std::memory_order_release);
+  size.store(static_cast<std::size_t>(id) + 1, std::memory_order_release);
+  return sites.back();
+}
+
+void Registry::segment_of(const Feller::LogSite::id_type id, unsigned &segment,
+                          std::size_t &offset) noexcept
+{
+  // Segment i starts at id 2^(s + i) - 2^s, where s is first_segment_shift.
+  const auto shifted = static_cast<std::uint64_t>(id) + (std::uint64_t{1} << first_segment_shift);
+  const auto top     = 63u - static_cast<unsigned>(__builtin_clzll(shifted));
+  segment            = top - first_segment_shift;
+  offset             = static_cast<std::size_t>(shifted - (std::uint64_t{1} << top));
+}
+
+Registry &registry()
+{
+  static Registry instance;
+  return instance;
+}
+}  // namespace
+
+Feller::LogSite::LogSite(const char *const file, const unsigned line, const char *const name,
+                         std::initializer_list<const char *> keys)
+    : m_file{file}, m_line{line}, m_name{name}, m_keys{}
+{
+  m_keys.reserve(keys.size());
+  for (const auto key : keys)
+  {
+    m_keys.emplace_back(key);
+  }
+}
+
+auto Feller::LogSite::add(LogSite site) -> const LogSite &
+{
+  auto &reg = registry();
+  std::lock_guard<std::mutex> lock{reg.mutex};
+  site.m_id = static_cast<id_type>(reg.size.load(std::memory_order_relaxed));
+  return reg.push(std::move(site));
+}
+
+auto Feller::LogSite::at(const id_type id) noexcept -> const LogSite &
+{
+  unsigned segment;
+  std::size_t offset;
+  Registry::segment_of(id, segment, offset);
+  return *registry().segments[segment].load(std::memory_order_acquire)[offset].load(
+      std::memory_order_acquire);
+}
+
+std::size_t Feller::LogSite::size() noexcept
+{
+  return registry().size.load(std::memory_order_acquire);
+}
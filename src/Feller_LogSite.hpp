@@ -0,0 +1,158 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_LOG_SITE
+#define INCLUDED_FELLER_LOG_SITE
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include "Feller_Feller.hpp"
+
+#include "Feller_StringTable.hpp"
+
+namespace Feller
+{
+/**
+ LogSite. This class describes a single place in the code that records a \ref DeferredLog: the
+name of the logs it records, the keys of their parameters, and the file and line of the call. Each
+site is registered once, in a process-wide registry, and is identified by a small integer id. A
+deferred log then only needs to record the id of its site, rather than its name and keys.
+
+ Sites are normally registered via the FELLER_LOG_SITE macro below, which registers each call site
+the first time it runs and then simply returns the same site. Note that this happens at run time,
+rather than at compile time: the first run of each call site takes the registry's lock, and ids
+are handed out in the order in which call sites are first reached, so they may differ between runs
+of a program. Only registration locks: looking a site up by id (see `at`) is lock-free, so logs
+can be decoded whilst other threads are still registering sites.
+
+ Site 0 is always registered, as the "unknown site": it has no keys, and is the site of logs that
+were never given one (e.g a default constructed \ref DeferredLog).
+**/
+class LogSite
+{
+public:
+  /**
+     id_type. This is the type used to identify a site.
+  **/
+  using id_type = std::uint32_t;
+
+  /**
+     unknown_id. This is the id of the unknown site, which is registered before any other.
+  **/
+  static constexpr id_type unknown_id = 0;
+
+  /**
+     LogSite. This constructor describes a site. This does not register the site: see `add`.
+  This constructor may throw due to allocation failures.
+     \param file: the file of the call site. This must outlive the site (e.g a string literal).
+     \param line: the line of the call site.
+     \param name: the name of the logs recorded at this site.
+     \param keys: the keys of the parameters of the logs recorded at this site, in order.
+  **/
+  LogSite(const char *const file, const unsigned line, const char *const name,
+          std::initializer_list<const char *> keys);
+
+  /// Overload of the constructor above that takes the keys as separate arguments.
+  template <typename... Keys>
+  LogSite(const char *const file, const unsigned line, const char *const name, const Keys... keys)
+      : LogSite(file, line, name, {static_cast<const char *>(keys)...})
+  {
+  }
+
+  /**
+     add. This function registers `site` and assigns it an id. This function is safe to call from
+  many threads at once. This function may throw due to allocation failures.
+     \param site: the site to be registered.
+     \return a reference to the registered site, which is valid for the lifetime of the process.
+  **/
+  static const LogSite &add(LogSite site);
+
+  /**
+     at. This function returns the registered site with id `id`. This function is lock-free, and
+  is safe to call from many threads at once, including whilst other sites are being registered.
+  The behaviour of this function is undefined if `id` is neither `unknown_id` nor was returned by
+  `add`.
+     \param id: the id of the site.
+     \return a reference to the site.
+  **/
+  static const LogSite &at(const id_type id) noexcept;
+
+  /**
+     size. This function returns the number of registered sites, including the unknown site. This
+  function is lock-free.
+     \return the number of registered sites.
+  **/
+  static std::size_t size() noexcept;
+
+  /// Accessors for each field of the site.
+  inline id_type id() const noexcept { return m_id; }
+  inline const char *file() const noexcept { return m_file; }
+  inline unsigned line() const noexcept { return m_line; }
+  inline InternedString name() const noexcept { return m_name; }
+  inline const std::vector<InternedString> &keys() const noexcept { return m_keys; }
+
+private:
+  /**
+     m_id. This is the id of this site. This is only meaningful once the site is registered.
+  **/
+  id_type m_id{unknown_id};
+
+  /**
+     m_file. This is the file of the call site.
+  **/
+  const char *m_file;
+
+  /**
+     m_line. This is the line of the call site.
+  **/
+  unsigned m_line;
+
+  /**
+     m_name. This is the name of the logs recorded at this site.
+  **/
+  InternedString m_name;
+
+  /**
+     m_keys. These are the keys of the parameters of the logs recorded at this site.
+  **/
+  std::vector<InternedString> m_keys;
+};
+
+}  // namespace Feller
+
+/**
+   FELLER_LOG_SITE. This macro returns the \ref LogSite for the current line, registering it the
+   first time the line runs (under the registry's lock). The arguments are the name of the site
+   followed by its keys. After the first run, this costs a single check of a function-local
+   static. For example:
+
+   logger.insert(Feller::DeferredLog{FELLER_LOG_SITE("Entered f", "x", "y"), x, y});
+
+   records a log named "Entered f" with the parameters "x" and "y".
+**/
+#define FELLER_LOG_SITE(...)                                                                       \
+  ([]() -> const ::Feller::LogSite & {                                                             \
+    static const ::Feller::LogSite &feller_site =                                                  \
+        ::Feller::LogSite::add(::Feller::LogSite{__FILE__, __LINE__, __VA_ARGS__});                \
+    return feller_site;                                                                            \
+  }())
+
+#endif
@@ -0,0 +1,103 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_LogSite.hpp"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr unsigned loop_line = __LINE__ + 1;
+const Feller::LogSite &site_in_loop() { return FELLER_LOG_SITE("In loop", "i"); }
+
+TEST(LogSite, testAdd)
+{
+  const auto before = Feller::LogSite::size();
+  const auto &site  = Feller::LogSite::add(Feller::LogSite{"file.cpp", 10, "Name", "a", "b"});
+  EXPECT_EQ(Feller::LogSite::size(), before + 1);
+  EXPECT_EQ(&Feller::LogSite::at(site.id()), &site);
+  EXPECT_EQ(site.file(), std::string{"file.cpp"});
+  EXPECT_EQ(site.line(), 10);
+  EXPECT_EQ(site.name(), "Name");
+  ASSERT_EQ(site.keys().size(), 2);
+  EXPECT_EQ(site.keys()[0], "a");
+  EXPECT_EQ(site.keys()[1], "b");
+}
+
+TEST(LogSite, testMacroRegistersOnce)
+{
+  const auto &first = site_in_loop();
+  const auto size   = Feller::LogSite::size();
+  for (unsigned i = 0; i < 10; i++)
+  {
+    EXPECT_EQ(&site_in_loop(), &first);
+  }
+  EXPECT_EQ(Feller::LogSite::size(), size);
+  EXPECT_EQ(first.name(), "In loop");
+  EXPECT_EQ(first.line(), loop_line);
+}
+
+TEST(LogSite, testMacroSitesAreDistinct)
+{
+  const auto &a = FELLER_LOG_SITE("A");
+  const auto &b = FELLER_LOG_SITE("B", "x", "y", "z");
+  EXPECT_NE(a.id(), b.id());
+  EXPECT_TRUE(a.keys().empty());
+  EXPECT_EQ(b.keys().size(), 3);
+  EXPECT_EQ(b.name(), "B");
+}
+
+TEST(LogSite, testUnknownSite)
+{
+  // The unknown site is registered before any other, so it can always be looked up.
+  EXPECT_GE(Feller::LogSite::size(), 1);
+  const auto &unknown = Feller::LogSite::at(Feller::LogSite::unknown_id);
+  EXPECT_EQ(unknown.id(), Feller::LogSite::unknown_id);
+  EXPECT_EQ(unknown.name(), "Unknown site");
+  EXPECT_TRUE(unknown.keys().empty());
+  EXPECT_NE(FELLER_LOG_SITE("Known").id(), Feller::LogSite::unknown_id);
+}
+
+TEST(LogSite, testConcurrentLookup)
+{
+  // Sites can be looked up whilst others are being registered, including when the registry grows.
+  const auto &site = Feller::LogSite::add(Feller::LogSite{"file.cpp", 1, "Looked up"});
+  std::atomic<bool> done{false};
+  std::thread reader([&site, &done] {
+    while (!done.load(std::memory_order_acquire))
+    {
+      EXPECT_EQ(&Feller::LogSite::at(site.id()), &site);
+    }
+  });
+
+  std::vector<Feller::LogSite::id_type> ids;
+  for (unsigned i = 0; i < 1000; i++)
+  {
+    ids.push_back(Feller::LogSite::add(Feller::LogSite{"file.cpp", i, "Added", "k"}).id());
+  }
+  done.store(true, std::memory_order_release);
+  reader.join();
+
+  for (unsigned i = 0; i < ids.size(); i++)
+  {
+    EXPECT_EQ(Feller::LogSite::at(ids[i]).id(), ids[i]);
+    EXPECT_EQ(Feller::LogSite::at(ids[i]).line(), i);
+  }
+}
@@ -19,6 +19,10 @@
 #ifndef INCLUDED_FELLER_LOGGER
 #define INCLUDED_FELLER_LOGGER
 
+#include <type_traits>
+#include <utility>
+
+#include "Feller_DataArena.hpp"
 #include "Feller_Feller.hpp"
 #include "Feller_LoggingMode.hpp"
 
@@ -43,8 +47,8 @@ namespace Feller
  Feller_EventLog.hpp.
 
    \tparam KeyType. This parameter describes a key if the log is written as a key/value
-   pair. For example, if the storage policy is an unordered-map, then this parameter
-   acts as the key type for that map. By default this is set to be a char type, as
+   pair. For example, if the storage policy is \ref KeyedLogStorage (a hash-indexed store), then
+   this parameter acts as the key type for that store. By default this is set to be a char type, as
    this is not necessarily always used.
 
    \tparam StoragePolicy. This parameter describes how the logs are stored
@@ -120,6 +124,28 @@ public:
   **/
   using const_iterator = typename StoragePolicy<LogType, KeyType>::const_iterator;
 
+  // CONSTRUCTORS
+
+  /**
+     Logger(). This is the default constructor for this class. Here we simply
+     allow the compiler to default construct each of the policies.
+  **/
+  Logger() = default;
+
+  /**
+     Logger. This constructor forwards all of its arguments to the constructor of the
+  StoragePolicy, default constructing the other policies. This is useful for storage policies
+  that need configuring at construction time (e.g the capacity of a \ref RingBufferLogStorage).
+     \param arg: the first argument to forward to the StoragePolicy.
+     \param args: the remaining arguments to forward to the StoragePolicy.
+  **/
+  template <typename Arg, typename... Args,
+            typename = std::enable_if_t<!std::is_base_of<Logger, std::decay_t<Arg>>::value>>
+  explicit Logger(Arg &&arg, Args &&...args)
+      : storage_policy(std::forward<Arg>(arg), std::forward<Args>(args)...)
+  {
+  }
+
   // INLINE MODIFIERS
 
   /**
@@ -140,6 +166,65 @@ public:
   inline void insert(const LogType &log,
                      const Feller::LoggingMode priority = Feller::LoggingMode::EVERYTHING);
 
+  /**
+     insert. This method moves `log` into the store under `key`. This requires the StoragePolicy
+  to index logs by key (e.g \ref KeyedLogStorage).
+     Note that this method may throw due to std::bad_alloc,
+     and this function will modify this object.
+     \param key: the key of the log.
+     \param log: the log to be moved into the store.
+     \param priority: the priority of the log. This determines whether the log will be inserted.
+  **/
+  inline void insert(const KeyType &key, LogType &&log,
+                     const Feller::LoggingMode priority = Feller::LoggingMode::EVERYTHING);
+
+  /**
+     insert. This method copies `log` into the store under `key`. This requires the StoragePolicy
+  to index logs by key (e.g \ref KeyedLogStorage).
+     Note that this method may throw due to std::bad_alloc,
+     and this function will modify this object.
+     \param key: the key of the log.
+     \param log: the log to be copied into the store.
+     \param priority: the priority of the log. This determines whether the log will be inserted.
+  **/
+  inline void insert(const KeyType &key, const LogType &log,
+                     const Feller::LoggingMode priority = Feller::LoggingMode::EVERYTHING);
+
+  /**
+     emplace. This method constructs a log directly inside the store from `args`, with
+  the highest priority. This avoids constructing a temporary log and then moving it into the
+  store. This requires the StoragePolicy to provide an emplace_back method.
+     Note that this method may throw due to std::bad_alloc,
+     and this function will modify this object.
+     \param args: the arguments to be forwarded to the constructor of the log.
+  **/
+  template <typename... Args> inline void emplace(Args &&...args);
+
+  /**
+     emplace. This method constructs a log directly inside the store from `args`, provided that
+  `priority` is accepted by the LoggingPolicy. If it is not, then no log is constructed.
+     \param priority: the priority of the log. This determines whether the log will be inserted.
+     \param args: the arguments to be forwarded to the constructor of the log.
+  **/
+  template <typename... Args>
+  inline void emplace(const Feller::LoggingMode priority, Args &&...args);
+
+  /**
+     insert_lazy. This method inserts the log returned by `make_log` into the store, provided
+  that `priority` is accepted by the LoggingPolicy. Crucially, `make_log` is only called if the log
+  is accepted: this means that any work needed to build the log (e.g std::to_string calls or
+  string concatenations) is skipped entirely for filtered-out logs. Note that `make_log` is
+  called before the lock is taken, and so it should not touch this logger.
+     Note that this method may throw due to std::bad_alloc,
+     and this function will modify this object.
+     \tparam MakeLog: the type of the callable. This must be callable with no arguments and
+  return something convertible to a LogType.
+     \param priority: the priority of the log. This determines whether the log will be inserted.
+     \param make_log: the callable that builds the log.
+  **/
+  template <typename MakeLog>
+  inline void insert_lazy(const Feller::LoggingMode priority, MakeLog &&make_log);
+
   /**
      operator<<. Prints a string representation of this object to the
      specified Ostream ``os`. This method may throw.
@@ -149,11 +234,43 @@ public:
   template <typename Ostream> inline Ostream &operator<<(Ostream &os);
 
   /**
-     clear. This method clears the store, resetting the size to 0.
+     make_aux. This method builds auxiliary data of type `T` from `args` in the arena of this
+  logger. This is much cheaper than a heap allocation for large data, and all such data is
+  released at once by `clear`. The result can be assigned to the aux data of a log (see
+  \ref AuxData). Note that the data only lives until this logger is cleared or destroyed, so logs
+  that hold it must not be used after that point (copies of such logs are unaffected). This method
+  is safe to call from many threads at once whatever the lock policy, as the arena has a lock of
+  its own (see \ref DataArena). Since the data is only released by `clear`, this should not be
+  used with a storage policy that overwrites old logs (such as \ref FlightRecorderLogStorage):
+  the data of each overwritten log would be kept until the next `clear`.
+     Note that this method may throw due to std::bad_alloc, or if the constructor of `T` throws.
+     \tparam T: the type of data to be built. This must derive from \ref Data.
+     \param args: the arguments to be forwarded to the constructor of `T`.
+     \return a handle to the new data.
+  **/
+  template <typename T, typename... Args> inline arena_ptr<T> make_aux(Args &&...args);
+
+  /**
+     aux_arena. This method returns the arena that holds the data built by `make_aux`.
+     \return a reference to the arena.
+  **/
+  inline const DataArena &aux_arena() const noexcept { return m_arena; }
+
+  /**
+     clear. This method clears the store, resetting the size to 0, and then releases every
+  piece of data built by `make_aux`.
      Note that this operation is not guaranteed to free the memory associated
   with the store. This method does not throw.
   **/
   inline void clear() noexcept;
+
+private:
+  /**
+     m_arena. This holds the data built by `make_aux`. Since members are destroyed before bases,
+  the arena is released before the store is destroyed; this is safe because \ref AuxData never
+  destroys arena data itself.
+  **/
+  DataArena m_arena{};
 };
 
 template <typename LogType, typename KeyType, template <typename...> class StoragePolicy,
@@ -164,7 +281,7 @@ inline void Feller::Logger<LogType, KeyType, StoragePolicy, LockPolicy, LoggingP
   if (!this->shouldLog(priority))
     return;
   auto lock = this->getWorkingLock();
-  StoragePolicy<LogType, KeyType>::insert(log);
+  StoragePolicy<LogType, KeyType>::insert(std::move(log));
 }
 
 template <typename LogType, typename KeyType, template <typename...> class StoragePolicy,
@@ -177,15 +294,97 @@ inline void Feller::Logger<LogType, KeyType, StoragePolicy, LockPolicy, LoggingP
   auto lock = this->getWorkingLock();
   StoragePolicy<LogType, KeyType>::insert(log);
 }
+
+template <typename LogType, typename KeyType, template <typename...> class StoragePolicy,
+          typename LockPolicy, typename LoggingPolicy>
+inline void Feller::Logger<LogType, KeyType, StoragePolicy, LockPolicy, LoggingPolicy>::insert(
+    const KeyType &key, LogType &&log, const Feller::LoggingMode priority)
+{
+  if (!this->shouldLog(priority))
+    return;
+  auto lock = this->getWorkingLock();
+  StoragePolicy<LogType, KeyType>::insert(key, std::move(log));
+}
+
+template <typename LogType, typename KeyType, template <typename...> class StoragePolicy,
+          typename LockPolicy, typename LoggingPolicy>
+inline void Feller::Logger<LogType, KeyType, StoragePolicy, LockPolicy, LoggingPolicy>::insert(
+    const KeyType &key, const LogType &log, const Feller::LoggingMode priority)
+{
+  if (!this->shouldLog(priority))
+    return;
+  auto lock = this->getWorkingLock();
+  StoragePolicy<LogType, KeyType>::insert(key, log);
+}
+
+template <typename LogType, typename KeyType, template <typename...> class StoragePolicy,
+          typename LockPolicy, typename LoggingPolicy>
+template <typename MakeLog>
+inline void Feller::Logger<LogType, KeyType, StoragePolicy, LockPolicy, LoggingPolicy>::insert_lazy(
+    const Feller::LoggingMode priority, MakeLog &&make_log)
+{
+  if (!this->shouldLog(priority))
+    return;
+  LogType log = std::forward<MakeLog>(make_log)();
+  auto lock   = this->getWorkingLock();
+  StoragePolicy<LogType, KeyType>::insert(std::move(log));
+}
+
+template <typename LogType, typename KeyType, template <typename...> class StoragePolicy,
+          typename LockPolicy, typename LoggingPolicy>
+template <typename... Args>
+inline void
+Feller::Logger<LogType, KeyType, StoragePolicy, LockPolicy, LoggingPolicy>::emplace(Args &&...args)
+{
+  emplace(Feller::LoggingMode::EVERYTHING, std::forward<Args>(args)...);
+}
+
+template <typename LogType, typename KeyType, template <typename...> class StoragePolicy,
+          typename LockPolicy, typename LoggingPolicy>
+template <typename... Args>
+inline void Feller::Logger<LogType, KeyType, StoragePolicy, LockPolicy, LoggingPolicy>::emplace(
+    const Feller::LoggingMode priority, Args &&...args)
+{
+  if (!this->shouldLog(priority))
+    return;
+  auto lock = this->getWorkingLock();
+  StoragePolicy<LogType, KeyType>::emplace_back(std::forward<Args>(args)...);
+}
+
 template <typename LogType, typename KeyType, template <typename...> class StoragePolicy,
           typename LockPolicy, typename LoggingPolicy>
 inline void
 Feller::Logger<LogType, KeyType, StoragePolicy, LockPolicy, LoggingPolicy>::clear() noexcept
 {
   auto lock = this->getWorkingLock();
-  this->clear();
+  StoragePolicy<LogType, KeyType>::clear();
+  m_arena.release();
+}
+
+template <typename LogType, typename KeyType, template <typename...> class StoragePolicy,
+          typename LockPolicy, typename LoggingPolicy>
+template <typename T, typename... Args>
+inline arena_ptr<T>
+Feller::Logger<LogType, KeyType, StoragePolicy, LockPolicy, LoggingPolicy>::make_aux(Args &&...args)
+{
+  // The arena locks itself, so the working lock is not needed here.
+  return m_arena.make<T>(std::forward<Args>(args)...);
 }
 
 }  // namespace Feller
 
+/**
+   FELLER_INSERT_LAZY. This macro inserts a log built from the remaining arguments into `logger`,
+   provided that `priority` is accepted by the logger. The arguments are only evaluated if the log
+   is accepted. For example:
+
+   FELLER_INSERT_LAZY(logger, Feller::LoggingMode::EVERYTHING, "Iteration", std::to_string(i));
+
+   only calls std::to_string if the logger is currently logging everything.
+**/
+#define FELLER_INSERT_LAZY(logger, priority, ...)                                                  \
+  (logger).insert_lazy((priority), [&]() {                                                         \
+    return typename std::decay_t<decltype(logger)>::log_type{__VA_ARGS__};                         \
+  })
+
 #endif
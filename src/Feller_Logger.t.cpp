@@ -17,14 +17,21 @@
  *
  ****/
 #include "Feller_Logger.hpp"
+#include "Feller_AllocationCounter.hpp"
 #include "Feller_ContiguousLogStorage.hpp"
 #include "Feller_EventLog.hpp"
+#include "Feller_FlightRecorderLogStorage.hpp"
 #include "Feller_MutexLock.hpp"
+#include "Feller_NoLock.hpp"
 #include "Feller_LogEverything.hpp"
 #include "Feller_LogNothing.hpp"
 #include "Feller_ConditionalLoggingPolicy.hpp"
+#include "Feller_TestData.hpp"
 #include "gtest/gtest.h"
 
+#include <thread>
+#include <vector>
+
 // Note; this file defines a very particular type of
 // Logger. The way to test this class is to first test each
 // policy separately, and then test the logger in general. This
@@ -84,3 +91,201 @@ TEST(Logger, testInsertWithConditionalGuard)
     }
   }
 }
+
+TEST(Logger, testInsertMoveDoesNotAllocate)
+{
+  LoggerType logger{};
+  logger.reserve(1);
+
+  // The name and parameters are long enough to defeat the small string optimisation.
+  Feller::EventLog l{"A name that is far too long to fit inside a small string"};
+  l.emplace_back("A key that is far too long to fit inside a small string",
+                 "A value that is far too long to fit inside a small string");
+  l.aux()         = std::make_unique<Feller::TestData>();
+  const auto copy = l;
+
+  const auto before = nr_allocations;
+  logger.insert(std::move(l));
+  EXPECT_EQ(nr_allocations, before);
+  EXPECT_EQ(*(logger.cbegin()), copy);
+
+  // Growing the store should only allocate the new buffer: each log must be moved across.
+  const auto before_growth = nr_allocations;
+  logger.reserve(2);
+  EXPECT_EQ(nr_allocations, before_growth + 1);
+  EXPECT_EQ(*(logger.cbegin()), copy);
+}
+
+TEST(Logger, testEmplace)
+{
+  LoggerType logger{};
+  logger.emplace("Test");
+  logger.emplace("abc", "def");
+  ASSERT_EQ(logger.size(), 2);
+  EXPECT_EQ(logger.cbegin()->name(), "Test");
+  EXPECT_EQ((logger.cbegin() + 1)->size(), 1);
+}
+
+TEST(Logger, testEmplaceWithConditionalGuard)
+{
+  Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage, Feller::MutexLock,
+                 Feller::ConditionalLoggingPolicy>
+      logger;
+  logger.switchMode(Feller::LoggingMode::IMPORTANT);
+  logger.emplace(Feller::LoggingMode::EVERYTHING, "Test");
+  EXPECT_EQ(logger.size(), 0);
+  logger.emplace(Feller::LoggingMode::IMPORTANT, "Test");
+  EXPECT_EQ(logger.size(), 1);
+}
+
+TEST(Logger, testInsertLazyWithStaticGuard)
+{
+  // With LogNothing the callable must never run.
+  Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage, Feller::MutexLock,
+                 Feller::LogNothing>
+      logger;
+  bool called = false;
+  logger.insert_lazy(Feller::LoggingMode::IMPORTANT, [&called]() {
+    called = true;
+    return Feller::EventLog{"Test"};
+  });
+  EXPECT_EQ(called, false);
+  EXPECT_EQ(logger.size(), 0);
+}
+
+TEST(Logger, testInsertLazyWithConditionalGuard)
+{
+  Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage, Feller::MutexLock,
+                 Feller::ConditionalLoggingPolicy>
+      logger;
+
+  unsigned calls  = 0;
+  const auto make = [&calls]() {
+    ++calls;
+    return Feller::EventLog{"Test"};
+  };
+  const auto size    = static_cast<unsigned>(Feller::LoggingMode::SIZE);
+  unsigned curr_size = 0;
+  for (unsigned i = 0; i < size; i++)
+  {
+    logger.switchMode(static_cast<Feller::LoggingMode>(i));
+    for (unsigned j = 0; j < size; j++)
+    {
+      logger.insert_lazy(static_cast<Feller::LoggingMode>(j), make);
+      curr_size += static_cast<unsigned>((i != 0) && (j <= i));
+      EXPECT_EQ(logger.size(), curr_size);
+      EXPECT_EQ(calls, curr_size);
+    }
+  }
+}
+
+TEST(Logger, testInsertLazyMacro)
+{
+  Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage, Feller::MutexLock,
+                 Feller::ConditionalLoggingPolicy>
+      logger;
+
+  unsigned evaluated = 0;
+  const auto value   = [&evaluated]() {
+    ++evaluated;
+    return std::string{"def"};
+  };
+
+  logger.switchMode(Feller::LoggingMode::IMPORTANT);
+  FELLER_INSERT_LAZY(logger, Feller::LoggingMode::EVERYTHING, "abc", value());
+  EXPECT_EQ(evaluated, 0);
+  EXPECT_EQ(logger.size(), 0);
+
+  FELLER_INSERT_LAZY(logger, Feller::LoggingMode::IMPORTANT, "abc", value());
+  EXPECT_EQ(evaluated, 1);
+  ASSERT_EQ(logger.size(), 1);
+  // Each log is timed when it is built, so only the contents are compared here.
+  const auto &log = *(logger.cbegin());
+  EXPECT_EQ(log.name(), "Inserted");
+  ASSERT_EQ(log.size(), 1);
+  EXPECT_EQ(*(log.cbegin()), (Feller::EventLog::parameter_type{"abc", "def"}));
+}
+
+TEST(Logger, testClear)
+{
+  LoggerType logger;
+  for (unsigned i = 0; i < 10; i++)
+  {
+    logger.emplace("abc");
+  }
+
+  ASSERT_EQ(logger.size(), 10);
+  logger.clear();
+  EXPECT_EQ(logger.size(), 0);
+  EXPECT_EQ(logger.cbegin(), logger.cend());
+}
+
+TEST(Logger, testMakeAux)
+{
+  LoggerType logger;
+  for (int i = 0; i < 100; i++)
+  {
+    Feller::EventLog log{"abc"};
+    log.aux() = logger.make_aux<Feller::TestData>();
+    logger.insert(std::move(log));
+  }
+
+  ASSERT_EQ(logger.aux_arena().size(), 100);
+  EXPECT_TRUE(logger.cbegin()->aux().is_arena());
+  EXPECT_EQ(logger.cbegin()->aux()->to_string(), "None");
+
+  logger.clear();
+  EXPECT_EQ(logger.size(), 0);
+  EXPECT_EQ(logger.aux_arena().size(), 0);
+}
+
+TEST(Logger, testMakeAuxWithoutLock)
+{
+  // The arena locks itself, so make_aux is safe even if the logger does no locking.
+  Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage, Feller::NoLock,
+                 Feller::LogEverything>
+      logger;
+  constexpr unsigned nr_threads = 4;
+  constexpr unsigned nr_aux     = 1000;
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < nr_threads; t++)
+  {
+    threads.emplace_back([&logger] {
+      for (unsigned i = 0; i < nr_aux; i++)
+      {
+        logger.make_aux<Feller::TestData>();
+      }
+    });
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  EXPECT_EQ(logger.aux_arena().size(), nr_threads * nr_aux);
+  logger.clear();
+  EXPECT_EQ(logger.aux_arena().size(), 0);
+}
+
+TEST(Logger, testMakeAuxWithRetainedSlots)
+{
+  // A flight recorder keeps its slots alive across a clear. Refilling those slots must not touch
+  // the data that the clear released.
+  Feller::Logger<Feller::EventLog, char, Feller::FlightRecorderLogStorage, Feller::MutexLock,
+                 Feller::LogEverything>
+      logger{4};
+
+  for (unsigned round = 0; round < 3; round++)
+  {
+    for (int i = 0; i < 8; i++)
+    {
+      Feller::EventLog log{"abc"};
+      log.aux() = logger.make_aux<Feller::TestData>();
+      logger.insert(std::move(log));
+    }
+
+    EXPECT_EQ(logger.aux_arena().size(), 8);
+    logger.clear();
+    EXPECT_EQ(logger.aux_arena().size(), 0);
+  }
+}
@@ -0,0 +1,568 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_MAPPED_LOG_STORAGE
+#define INCLUDED_FELLER_MAPPED_LOG_STORAGE
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Feller_Feller.hpp"
+
+#include "Feller_BinaryFormat.hpp"
+#include "Feller_EventLog.hpp"
+
+namespace Feller
+{
+/**
+ MappedLogStorage. This class implements a storage policy that appends logs to a memory-mapped
+file, rather than holding them on the heap. This allows the logs of long runs to exceed the size
+of main memory: the kernel pages cold parts of the file out to disk. If a path is given then the
+logs also survive the process; the default constructor uses an unnamed temporary file instead,
+whose logs are lost when the process exits.
+
+ Briefly, each log is encoded in the binary format of \ref BinaryWriter and copied to the end of
+the mapping. If the mapping is full then the file is grown with `ftruncate` and the mapping with
+`mremap`, so that (unlike a vector) existing logs are never copied. The mapping is advised as
+sequential, as logs are only ever appended or scanned in order. On destruction the file is
+truncated to the logs that were written: hence the file is a valid binary stream that can be read
+back with \ref read_binary. If the process exits without destroying this object then the file
+is left with zero padding after the last log, which readers take as the end of the stream. Each
+log is committed by writing its first byte last, so a log that was being written when the process
+died is not read back.
+
+ Since logs are stored encoded, iteration decodes each log on the fly: iterators dereference to a
+log held inside the iterator itself, and are invalidated by any insertion. Auxiliary data is only
+rebuilt if a decoder is supplied on construction.
+
+ This class is only available on Linux. This class is not thread-safe, and should be used with a
+locking lock policy (such as \ref MutexLock) if it is shared.
+
+ \tparam LogType: the type of log to be stored in this class. This must be \ref EventLog.
+ \tparam KeyType: not used in this class.
+**/
+template <typename LogType, typename KeyType = char /*unused*/> class MappedLogStorage
+{
+  static_assert(std::is_same<LogType, EventLog>::value,
+                "Error: MappedLogStorage can only store EventLog objects.");
+
+public:
+  /**
+     size_type. This type is used to represent sizes in this object.
+  **/
+  using size_type = std::size_t;
+
+  /**
+     const_iterator. This type is used to iterate over the logs in this object.
+  **/
+  class const_iterator;
+
+  /**
+     initial_size. This is the size, in bytes, of a newly created file.
+  **/
+  static constexpr size_type initial_size = 1 << 20;
+
+  /**
+     MappedLogStorage. This constructor stores logs in an unnamed temporary file, which is
+  removed when this object is destroyed: the logs do not outlive this object, let alone the
+  process. Use the path constructor to keep them. This constructor throws std::system_error if
+  the file cannot be created or mapped.
+  **/
+  MappedLogStorage();
+
+  /**
+     MappedLogStorage. This constructor stores logs in the file at `path`. Any existing contents
+  of the file are discarded. This constructor throws std::system_error if the file cannot be
+  opened or mapped.
+     \param path: the location of the file.
+     \param decoder: the function used to rebuild auxiliary data when iterating. If this is empty
+  then auxiliary data is dropped on iteration.
+  **/
+  explicit MappedLogStorage(const std::string &path, Binary::aux_decoder decoder = {});
+
+  // This class owns a file and a mapping, so copying makes no sense.
+  MappedLogStorage(const MappedLogStorage &)            = delete;
+  MappedLogStorage &operator=(const MappedLogStorage &) = delete;
+
+  /**
+     ~MappedLogStorage. This destructor truncates the file to the logs that were written, then
+  unmaps and closes it.
+  **/
+  ~MappedLogStorage();
+
+  /**
+     insert. This method appends `log` to the file. This function throws std::system_error if
+  the file cannot be grown, and may also throw due to allocation failures. In either case the log
+  is not stored.
+     \param log: the log to be appended.
+  **/
+  inline void insert(const LogType &log);
+
+  /// Overload of insert for rvalue refs. Since logs are encoded, this is the same as a copy.
+  inline void insert(LogType &&log);
+
+  /**
+     emplace_back. This method builds a log from `args` and appends it to the file.
+     \param args: the arguments to be forwarded to the constructor of the log.
+  **/
+  template <typename... Args> inline void emplace_back(Args &&...args);
+
+  /**
+     size. This method returns the number of logs in this object. This function does not throw.
+     \return the number of logs in this object.
+  **/
+  inline size_type size() const noexcept;
+
+  /**
+     bytes. This method returns the number of bytes of the file that are in use. This function
+  does not throw.
+     \return the number of bytes used.
+  **/
+  inline size_type bytes() const noexcept;
+
+  /**
+     cbegin. This method returns a const iterator to the oldest log in this object. This decodes
+  the first log, and hence may throw due to allocation failures.
+     \return a const iterator to the first log.
+  **/
+  inline const_iterator cbegin() const;
+
+  /**
+     cend. This method returns a const iterator to one past the newest log in this object.
+     \return a const iterator to the end of the logs.
+  **/
+  inline const_iterator cend() const;
+
+  /// Overloads of cbegin and cend to allow range-based for loops.
+  inline const_iterator begin() const;
+  inline const_iterator end() const;
+
+  /**
+     clear. This method removes every log from this object. The file keeps its current size.
+  **/
+  inline void clear() noexcept;
+
+  /**
+     sync. This method truncates the file (and the mapping) to the logs that were written and
+  flushes them to disk. Note that both are grown again on the next insertion.
+     \return true on success, false otherwise.
+  **/
+  inline bool sync() noexcept;
+
+  /**
+      operator<<. Prints a string representation of the object ``st`` to the
+      specified ostream ``os`. This method may throw.
+      \tparam LT: the type stored in st.
+      \param os: the stream to print the storage object to.
+      \param st: the object to be printed.
+      \return the os parameter.
+   **/
+  template <typename LT, typename KT>
+  inline friend std::ostream &operator<<(std::ostream &os, const MappedLogStorage<LT, KT> &st);
+
+private:
+  /**
+     open. This method implements the constructors: it takes ownership of `fd`, maps it and
+  writes the stream header.
+     \param fd: the file descriptor to be mapped.
+  **/
+  inline void open(int fd);
+
+  /**
+     reserve. This method grows the file and the mapping so that they hold at least `size` bytes.
+     \param size: the minimum number of bytes needed.
+  **/
+  inline void reserve(size_type size);
+
+  /**
+     advise. This method tells the kernel how the mapping is going to be used.
+  **/
+  inline void advise() const noexcept;
+
+  /**
+     m_fd. This is the file descriptor of the file.
+  **/
+  int m_fd{-1};
+
+  /**
+     m_data. This is the start of the mapping.
+  **/
+  char *m_data{nullptr};
+
+  /**
+     m_capacity. This is the size of the file and of the mapping, in bytes.
+  **/
+  size_type m_capacity{0};
+
+  /**
+     m_header. This is the size of the stream header, in bytes.
+  **/
+  size_type m_header{0};
+
+  /**
+     m_bytes. This is the number of bytes of the mapping that are in use, including the header.
+  **/
+  size_type m_bytes{0};
+
+  /**
+     m_size. This is the number of logs in this object.
+  **/
+  size_type m_size{0};
+
+  /**
+     m_previous. This is the timestamp of the last log, which the next log is encoded against.
+  **/
+  std::int64_t m_previous{0};
+
+  /**
+     m_scratch. Each log is encoded into this buffer before being copied into the mapping. This
+  is kept between insertions so that it rarely allocates.
+  **/
+  std::string m_scratch{};
+
+  /**
+     m_decoder. This is used to rebuild auxiliary data when iterating, if set.
+  **/
+  Binary::aux_decoder m_decoder{};
+};
+
+/**
+ const_iterator. This is a forward iterator that decodes each log as it is reached.
+**/
+template <typename LogType, typename KeyType>
+class MappedLogStorage<LogType, KeyType>::const_iterator
+{
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type        = LogType;
+  using difference_type   = std::ptrdiff_t;
+  using pointer           = const LogType *;
+  using reference         = const LogType &;
+
+  const_iterator() = default;
+
+  inline reference operator*() const noexcept { return m_log; }
+  inline pointer operator->() const noexcept { return &m_log; }
+  inline const_iterator &operator++();
+  inline const_iterator operator++(int);
+
+  inline friend bool operator==(const const_iterator &lhs, const const_iterator &rhs) noexcept
+  {
+    return lhs.m_pos == rhs.m_pos;
+  }
+
+  inline friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+  {
+    return !(lhs == rhs);
+  }
+
+private:
+  friend class MappedLogStorage;
+
+  /**
+     const_iterator. This constructor decodes the log at `pos`, if any.
+  **/
+  inline const_iterator(const char *pos, const char *end, const Binary::aux_decoder *decoder);
+
+  /**
+     decode. This method decodes the log at m_pos into m_log.
+  **/
+  inline void decode();
+
+  /// m_pos is the start of the current log, and m_next is the start of the log after it.
+  const char *m_pos{nullptr};
+  const char *m_next{nullptr};
+  const char *m_end{nullptr};
+  const Binary::aux_decoder *m_decoder{nullptr};
+  std::int64_t m_previous{0};
+  LogType m_log{};
+};
+
+/// INLINE FUNCTIONS
+template <typename LogType, typename KeyType>
+Feller::MappedLogStorage<LogType, KeyType>::MappedLogStorage()
+{
+  // O_TMPFILE creates a file with no name, so nothing is left behind if the process dies.
+  const char *const dir = std::getenv("TMPDIR");
+  open(::open(dir ? dir : "/tmp", O_TMPFILE | O_RDWR, 0600));
+}
+
+template <typename LogType, typename KeyType>
+Feller::MappedLogStorage<LogType, KeyType>::MappedLogStorage(const std::string &path,
+                                                             Binary::aux_decoder decoder)
+    : m_decoder{std::move(decoder)}
+{
+  open(::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644));
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::MappedLogStorage<LogType, KeyType>::open(const int fd)
+{
+  if (fd == -1)
+  {
+    throw std::system_error(errno, std::generic_category(), "MappedLogStorage: open");
+  }
+
+  m_fd = fd;
+  if (::ftruncate(m_fd, static_cast<off_t>(initial_size)) == -1)
+  {
+    const auto error = errno;
+    ::close(m_fd);
+    throw std::system_error(error, std::generic_category(), "MappedLogStorage: ftruncate");
+  }
+
+  auto *const data = ::mmap(nullptr, initial_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (data == MAP_FAILED)
+  {
+    const auto error = errno;
+    ::close(m_fd);
+    throw std::system_error(error, std::generic_category(), "MappedLogStorage: mmap");
+  }
+
+  m_data     = static_cast<char *>(data);
+  m_capacity = initial_size;
+  advise();
+
+  // The header is short enough that this does not allocate.
+  Binary::put_header(m_scratch);
+  std::memcpy(m_data, m_scratch.data(), m_scratch.size());
+  m_header = m_scratch.size();
+  m_bytes  = m_header;
+}
+
+template <typename LogType, typename KeyType>
+Feller::MappedLogStorage<LogType, KeyType>::~MappedLogStorage()
+{
+  ::munmap(m_data, m_capacity);
+  // There is nothing sensible to do if this fails: the file merely keeps some trailing zeroes.
+  static_cast<void>(::ftruncate(m_fd, static_cast<off_t>(m_bytes)));
+  ::close(m_fd);
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::MappedLogStorage<LogType, KeyType>::advise() const noexcept
+{
+  ::madvise(m_data, m_capacity, MADV_SEQUENTIAL);
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::MappedLogStorage<LogType, KeyType>::reserve(const size_type size)
+{
+  if (size <= m_capacity)
+  {
+    return;
+  }
+
+  auto capacity = m_capacity;
+  while (capacity < size)
+  {
+    capacity *= 2;
+  }
+
+  if (::ftruncate(m_fd, static_cast<off_t>(capacity)) == -1)
+  {
+    throw std::system_error(errno, std::generic_category(), "MappedLogStorage: ftruncate");
+  }
+
+  // The kernel can usually extend the mapping in place. If not, it moves the page tables rather
+  // than the data.
+  auto *const data = ::mremap(m_data, m_capacity, capacity, MREMAP_MAYMOVE);
+  if (data == MAP_FAILED)
+  {
+    const auto error = errno;
+    static_cast<void>(::ftruncate(m_fd, static_cast<off_t>(m_capacity)));
+    throw std::system_error(error, std::generic_category(), "MappedLogStorage: mremap");
+  }
+
+  m_data     = static_cast<char *>(data);
+  m_capacity = capacity;
+  advise();
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::MappedLogStorage<LogType, KeyType>::insert(const LogType &log)
+{
+  m_scratch.clear();
+  auto previous = m_previous;
+  Binary::put_record(m_scratch, log, previous);
+  // One more byte is needed for the end marker.
+  const auto size = m_scratch.size();
+  reserve(m_bytes + size + 1);
+
+  // The end marker at m_bytes is only replaced once the rest of the log is in place, so that
+  // the file never ends in a partial log.
+  std::memcpy(m_data + m_bytes + 1, m_scratch.data() + 1, size - 1);
+  m_data[m_bytes + size] = static_cast<char>(Binary::end_marker);
+  std::atomic_signal_fence(std::memory_order_release);
+  m_data[m_bytes] = m_scratch[0];
+  m_bytes += size;
+  m_previous = previous;
+  ++m_size;
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::MappedLogStorage<LogType, KeyType>::insert(LogType &&log)
+{
+  insert(static_cast<const LogType &>(log));
+}
+
+template <typename LogType, typename KeyType>
+template <typename... Args>
+inline void Feller::MappedLogStorage<LogType, KeyType>::emplace_back(Args &&...args)
+{
+  insert(LogType(std::forward<Args>(args)...));
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MappedLogStorage<LogType, KeyType>::size() const noexcept -> size_type
+{
+  return m_size;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MappedLogStorage<LogType, KeyType>::bytes() const noexcept -> size_type
+{
+  return m_bytes;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MappedLogStorage<LogType, KeyType>::cbegin() const -> const_iterator
+{
+  return const_iterator{m_data + m_header, m_data + m_bytes, &m_decoder};
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MappedLogStorage<LogType, KeyType>::cend() const -> const_iterator
+{
+  return const_iterator{m_data + m_bytes, m_data + m_bytes, &m_decoder};
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MappedLogStorage<LogType, KeyType>::begin() const -> const_iterator
+{
+  return cbegin();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MappedLogStorage<LogType, KeyType>::end() const -> const_iterator
+{
+  return cend();
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::MappedLogStorage<LogType, KeyType>::clear() noexcept
+{
+  m_bytes    = m_header;
+  m_size     = 0;
+  m_previous = 0;
+  // The old logs are still in the file, so they must be cut off.
+  if (m_bytes < m_capacity)
+  {
+    m_data[m_bytes] = static_cast<char>(Binary::end_marker);
+  }
+}
+
+template <typename LogType, typename KeyType>
+inline bool Feller::MappedLogStorage<LogType, KeyType>::sync() noexcept
+{
+  if (::msync(m_data, m_bytes, MS_SYNC) != 0 ||
+      ::ftruncate(m_fd, static_cast<off_t>(m_bytes)) != 0)
+  {
+    return false;
+  }
+
+  // The mapping must shrink with the file: otherwise later insertions would write to pages past
+  // the end of the file, which raises SIGBUS. Shrinking a mapping never moves it.
+  auto *const data = ::mremap(m_data, m_capacity, m_bytes, 0);
+  if (data == MAP_FAILED)
+  {
+    static_cast<void>(::ftruncate(m_fd, static_cast<off_t>(m_capacity)));
+    return false;
+  }
+
+  m_data     = static_cast<char *>(data);
+  m_capacity = m_bytes;
+  return true;
+}
+
+template <typename LogType, typename KeyType>
+inline std::ostream &operator<<(std::ostream &os, const MappedLogStorage<LogType, KeyType> &st)
+{
+  for (auto &v : st)
+  {
+    os << v;
+  }
+  return os;
+}
+
+template <typename LogType, typename KeyType>
+inline Feller::MappedLogStorage<LogType, KeyType>::const_iterator::const_iterator(
+    const char *pos, const char *end, const Binary::aux_decoder *decoder)
+    : m_pos{pos}, m_next{pos}, m_end{end}, m_decoder{decoder}
+{
+  decode();
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::MappedLogStorage<LogType, KeyType>::const_iterator::decode()
+{
+  m_pos = m_next;
+  if (m_pos == m_end)
+  {
+    return;
+  }
+
+  // Every record in the mapping was written by insert, so this cannot fail.
+  Binary::MemorySource source{m_pos + 1, m_end};
+  Binary::get_record(source, m_log, m_previous, *m_decoder);
+  m_next = source.pos;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MappedLogStorage<LogType, KeyType>::const_iterator::operator++()
+    -> const_iterator &
+{
+  decode();
+  return *this;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MappedLogStorage<LogType, KeyType>::const_iterator::operator++(int)
+    -> const_iterator
+{
+  auto old = *this;
+  ++(*this);
+  return old;
+}
+
+}  // namespace Feller
+
+#endif
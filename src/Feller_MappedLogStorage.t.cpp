@@ -0,0 +1,204 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_BinaryFormat.hpp"
+#include "Feller_ContiguousLogStorage.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_LogEverything.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_MappedLogStorage.hpp"
+#include "Feller_MutexLock.hpp"
+#include "Feller_TestData.hpp"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <fstream>
+#include <unistd.h>
+
+using Storage = Feller::MappedLogStorage<Feller::EventLog>;
+
+// This gives each test its own file, and removes it afterwards.
+struct TempPath
+{
+  std::string path{"feller_mapped_" + std::to_string(::getpid()) + "_" +
+                   ::testing::UnitTest::GetInstance()->current_test_info()->name()};
+  ~TempPath() { std::remove(path.c_str()); }
+};
+
+Feller::EventLog make_log(const unsigned i)
+{
+  Feller::EventLog log{"Log " + std::to_string(i), std::chrono::system_clock::now()};
+  log.emplace_back("index", std::to_string(i));
+  return log;
+}
+
+TEST(MappedLogStorage, testInsertAndIterate)
+{
+  Storage storage;
+  EXPECT_EQ(storage.size(), 0);
+  EXPECT_EQ(storage.cbegin(), storage.cend());
+
+  // This is large enough to grow the file several times.
+  std::vector<Feller::EventLog> logs;
+  const unsigned size = 100000;
+  for (unsigned i = 0; i < size; i++)
+  {
+    logs.push_back(make_log(i));
+    storage.insert(logs.back());
+  }
+
+  ASSERT_EQ(storage.size(), size);
+  EXPECT_GT(storage.bytes(), Storage::initial_size);
+  EXPECT_TRUE(std::equal(storage.cbegin(), storage.cend(), logs.cbegin(), logs.cend()));
+}
+
+TEST(MappedLogStorage, testClear)
+{
+  Storage storage;
+  storage.insert(make_log(0));
+  const auto bytes = storage.bytes();
+  storage.clear();
+  EXPECT_EQ(storage.size(), 0);
+  EXPECT_EQ(storage.cbegin(), storage.cend());
+
+  const auto log = make_log(1);
+  storage.insert(log);
+  EXPECT_EQ(*storage.cbegin(), log);
+  EXPECT_LT(storage.bytes(), 2 * bytes);
+}
+
+TEST(MappedLogStorage, testFileSurvives)
+{
+  TempPath temp;
+  Feller::ContiguousLogStorage<Feller::EventLog> expected;
+  {
+    Storage storage{temp.path};
+    for (unsigned i = 0; i < 1000; i++)
+    {
+      expected.insert(make_log(i));
+      storage.insert(expected.back());
+    }
+  }
+
+  std::ifstream in{temp.path, std::ios::binary};
+  Feller::ContiguousLogStorage<Feller::EventLog> out;
+  ASSERT_TRUE(Feller::read_binary(in, out));
+  EXPECT_EQ(out, expected);
+}
+
+TEST(MappedLogStorage, testReadWhileOpen)
+{
+  // While the storage is alive the file is still padded with zeroes, as it would be after a
+  // crash. Readers must stop at the last log.
+  TempPath temp;
+  Storage storage{temp.path};
+  Feller::ContiguousLogStorage<Feller::EventLog> expected;
+  for (unsigned i = 0; i < 100; i++)
+  {
+    expected.insert(make_log(i));
+    storage.insert(expected.back());
+  }
+
+  const auto read_back = [&temp]() {
+    std::ifstream in{temp.path, std::ios::binary};
+    Feller::ContiguousLogStorage<Feller::EventLog> out;
+    EXPECT_TRUE(Feller::read_binary(in, out));
+    return out;
+  };
+  EXPECT_EQ(read_back(), expected);
+
+  // The old logs are still in the file after a clear, but must not be read back.
+  storage.clear();
+  expected.clear();
+  EXPECT_TRUE(read_back().empty());
+  for (unsigned i = 0; i < 10; i++)
+  {
+    expected.insert(make_log(i));
+    storage.insert(expected.back());
+  }
+  EXPECT_EQ(read_back(), expected);
+}
+
+TEST(MappedLogStorage, testSync)
+{
+  TempPath temp;
+  Storage storage{temp.path};
+  const auto log = make_log(0);
+  storage.insert(log);
+  ASSERT_TRUE(storage.sync());
+
+  // The file can be read whilst the storage is still alive, and is grown again on insertion.
+  std::ifstream in{temp.path, std::ios::binary};
+  Feller::ContiguousLogStorage<Feller::EventLog> out;
+  ASSERT_TRUE(Feller::read_binary(in, out));
+  ASSERT_EQ(out.size(), 1);
+  EXPECT_EQ(out[0], log);
+
+  // This crosses several pages past the synced end of the file.
+  std::vector<Feller::EventLog> logs{log};
+  for (unsigned i = 1; i < 2000; i++)
+  {
+    logs.push_back(make_log(i));
+    storage.insert(logs.back());
+  }
+  ASSERT_EQ(storage.size(), logs.size());
+  EXPECT_TRUE(std::equal(storage.cbegin(), storage.cend(), logs.cbegin()));
+
+  ASSERT_TRUE(storage.sync());
+  storage.insert(make_log(2000));
+  EXPECT_EQ(storage.size(), logs.size() + 1);
+}
+
+TEST(MappedLogStorage, testAux)
+{
+  TempPath temp;
+  Storage storage{temp.path,
+                  [](const std::string &) { return std::make_unique<Feller::TestData>(); }};
+  Feller::EventLog log{"Aux", std::chrono::system_clock::now()};
+  log.aux() = std::make_unique<Feller::TestData>();
+  storage.insert(log);
+  EXPECT_EQ(*storage.cbegin(), log);
+
+  // Without a decoder the data is dropped.
+  Storage plain;
+  plain.insert(log);
+  EXPECT_EQ(plain.cbegin()->aux(), nullptr);
+}
+
+TEST(MappedLogStorage, testBadPath)
+{
+  EXPECT_THROW(Storage{"/this/path/does/not/exist"}, std::system_error);
+}
+
+TEST(MappedLogStorage, testWithLogger)
+{
+  TempPath temp;
+  Feller::Logger<Feller::EventLog, char, Feller::MappedLogStorage, Feller::MutexLock,
+                 Feller::LogEverything>
+      logger{temp.path};
+  logger.insert(Feller::EventLog{"abc"});
+  logger.emplace("def");
+  ASSERT_EQ(logger.size(), 2);
+
+  std::vector<std::string> names;
+  for (const auto &v : logger)
+  {
+    names.push_back(v.name());
+  }
+  EXPECT_EQ(names, (std::vector<std::string>{"abc", "def"}));
+}
@@ -0,0 +1,49 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_MetricLog.hpp"
+
+auto Feller::MetricLog::to_event_log(const EventLog::time_point time) const -> EventLog
+{
+  EventLog log{m_name, time};
+  if (m_kind == Kind::COUNTER)
+  {
+    log.emplace_back(counter_key(), m_count);
+  }
+  else
+  {
+    log.emplace_back(gauge_key(), m_gauge);
+  }
+  return log;
+}
+
+auto Feller::MetricLog::to_string() const -> std::string
+{
+  std::string str = "Name:" + m_name.str();
+  if (m_kind == Kind::COUNTER)
+  {
+    str += "\nCounter:";
+    str += std::to_string(m_count);
+  }
+  else
+  {
+    str += "\nGauge:";
+    str += std::to_string(m_gauge);
+  }
+  return str;
+}
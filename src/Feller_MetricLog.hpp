@@ -0,0 +1,229 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_METRIC_LOG
+#define INCLUDED_FELLER_METRIC_LOG
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "Feller_Feller.hpp"
+
+#include "Feller_EventLog.hpp"
+#include "Feller_StringTable.hpp"
+
+namespace Feller
+{
+/**
+    \brief MetricLog. This class represents a single update to a named metric: either "add
+  `delta` to counter X" or "set gauge Y to `value`". Unlike an \ref EventLog, a metric log holds
+  no time and no parameters, so it never allocates and is trivially copyable. This makes it cheap
+  to build on the hot path.
+
+    Metric logs are designed to be aggregated in place by \ref MetricLogStorage, which keeps a
+  single running value per name rather than one record per update. They may be stored in any
+  other storage policy too, in which case each update is kept.
+
+    Aggregated metrics can be exported alongside event logs, either by converting them with
+  `to_event_log` or by writing them to a \ref ChromeTraceWriter as counter events.
+**/
+class MetricLog
+{
+public:
+  /**
+     Kind. This enum describes what sort of metric is being updated.
+  **/
+  enum class Kind : std::uint8_t
+  {
+    COUNTER,
+    GAUGE
+  };
+
+  /**
+     count_type. This is the type used to represent the value of a counter.
+  **/
+  using count_type = std::int64_t;
+
+  /**
+     MetricLog. This constructor builds an update that adds nothing to the counter with an empty
+  name.
+  **/
+  MetricLog() noexcept = default;
+
+  /**
+     counter. This function builds an update that adds `delta` to the counter called `name`.
+     This function does not throw.
+     \param name: the name of the counter.
+     \param delta: the amount to add to the counter. This may be negative.
+     \return the update.
+  **/
+  static inline MetricLog counter(const InternedString name, const count_type delta = 1) noexcept;
+
+  /**
+     gauge. This function builds an update that sets the gauge called `name` to `value`.
+     This function does not throw.
+     \param name: the name of the gauge.
+     \param value: the new value of the gauge.
+     \return the update.
+  **/
+  static inline MetricLog gauge(const InternedString name, const double value) noexcept;
+
+  /**
+     name. This method returns the name of the metric. This function does not throw.
+     \return the name of the metric.
+  **/
+  inline const std::string &name() const noexcept;
+
+  /**
+     interned_name. This method returns the interned name of the metric. This function does not
+  throw.
+     \return a handle to the name of the metric.
+  **/
+  inline InternedString interned_name() const noexcept;
+
+  /**
+     kind. This method returns the kind of the metric. This function does not throw.
+     \return the kind of the metric.
+  **/
+  inline Kind kind() const noexcept;
+
+  /**
+     count. This method returns the amount that this update adds to a counter, or the running
+  total if this log was read from a \ref MetricLogStorage. This is 0 for gauges. This function
+  does not throw.
+     \return the count.
+  **/
+  inline count_type count() const noexcept;
+
+  /**
+     gauge. This method returns the value of a gauge. This is 0 for counters. This function does
+  not throw.
+     \return the value of the gauge.
+  **/
+  inline double gauge() const noexcept;
+
+  /**
+     to_event_log. This method converts this metric into an \ref EventLog at `time`, so that it
+  can be stored, formatted or exported with other event logs. The event log has the name of this
+  metric and a single parameter: "counter" (holding the count) or "gauge" (holding the value).
+  This function may throw due to allocation failures.
+     \param time: the time of the event log. This is typically the time the metric was read.
+     \return the event log.
+  **/
+  EventLog to_event_log(const EventLog::time_point time = SystemClock::now()) const;
+
+  /**
+     to_string. This method returns a string representation of this metric. This function may
+  throw due to allocation failures.
+     \return a string representation of this metric.
+  **/
+  std::string to_string() const;
+
+  /**
+     counter_key. This function returns the key under which `to_event_log` stores a count.
+     \return the key "counter".
+  **/
+  static inline InternedString counter_key();
+
+  /**
+     gauge_key. This function returns the key under which `to_event_log` stores a gauge.
+     \return the key "gauge".
+  **/
+  static inline InternedString gauge_key();
+
+  /// Metric logs are equal if they have the same name, kind and value.
+  inline friend bool operator==(const MetricLog &lhs, const MetricLog &rhs) noexcept
+  {
+    return lhs.m_name == rhs.m_name && lhs.m_kind == rhs.m_kind && lhs.m_count == rhs.m_count &&
+           lhs.m_gauge == rhs.m_gauge;
+  }
+  inline friend bool operator!=(const MetricLog &lhs, const MetricLog &rhs) noexcept
+  {
+    return !(lhs == rhs);
+  }
+
+private:
+  /**
+     MetricLog. This constructor builds an update from each of its parts.
+  **/
+  MetricLog(const InternedString name, const Kind kind, const count_type count,
+            const double gauge) noexcept
+      : m_name{name}, m_kind{kind}, m_count{count}, m_gauge{gauge}
+  {
+  }
+
+  /**
+     m_name. This is the name of the metric.
+  **/
+  InternedString m_name{};
+
+  /**
+     m_kind. This is the kind of the metric.
+  **/
+  Kind m_kind{Kind::COUNTER};
+
+  /**
+     m_count. This is the amount added to a counter.
+  **/
+  count_type m_count{};
+
+  /**
+     m_gauge. This is the value of a gauge.
+  **/
+  double m_gauge{};
+};
+
+/// INLINE FUNCTIONS
+inline MetricLog MetricLog::counter(const InternedString name, const count_type delta) noexcept
+{
+  return MetricLog{name, Kind::COUNTER, delta, 0.0};
+}
+
+inline MetricLog MetricLog::gauge(const InternedString name, const double value) noexcept
+{
+  return MetricLog{name, Kind::GAUGE, 0, value};
+}
+
+inline const std::string &MetricLog::name() const noexcept { return m_name.str(); }
+inline InternedString MetricLog::interned_name() const noexcept { return m_name; }
+inline MetricLog::Kind MetricLog::kind() const noexcept { return m_kind; }
+inline MetricLog::count_type MetricLog::count() const noexcept { return m_count; }
+inline double MetricLog::gauge() const noexcept { return m_gauge; }
+
+inline InternedString MetricLog::counter_key()
+{
+  static const InternedString key{"counter"};
+  return key;
+}
+
+inline InternedString MetricLog::gauge_key()
+{
+  static const InternedString key{"gauge"};
+  return key;
+}
+
+inline std::ostream &operator<<(std::ostream &os, const MetricLog &log)
+{
+  os << log.to_string();
+  return os;
+}
+
+}  // namespace Feller
+
+#endif
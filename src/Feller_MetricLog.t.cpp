@@ -0,0 +1,83 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_MetricLog.hpp"
+#include "Feller_EventLog.hpp"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <type_traits>
+
+TEST(MetricLog, testInit)
+{
+  const Feller::MetricLog log;
+  EXPECT_EQ(log.name(), "");
+  EXPECT_EQ(log.kind(), Feller::MetricLog::Kind::COUNTER);
+  EXPECT_EQ(log.count(), 0);
+  EXPECT_EQ(log.gauge(), 0.0);
+  static_assert(std::is_trivially_copyable_v<Feller::MetricLog>);
+}
+
+TEST(MetricLog, testCounter)
+{
+  const auto one = Feller::MetricLog::counter("requests");
+  EXPECT_EQ(one.name(), "requests");
+  EXPECT_EQ(one.interned_name(), Feller::InternedString{"requests"});
+  EXPECT_EQ(one.kind(), Feller::MetricLog::Kind::COUNTER);
+  EXPECT_EQ(one.count(), 1);
+
+  EXPECT_EQ(Feller::MetricLog::counter("requests", -4).count(), -4);
+  EXPECT_EQ(one, Feller::MetricLog::counter("requests", 1));
+  EXPECT_NE(one, Feller::MetricLog::counter("requests", 2));
+  EXPECT_NE(one, Feller::MetricLog::counter("errors", 1));
+}
+
+TEST(MetricLog, testGauge)
+{
+  const auto gauge = Feller::MetricLog::gauge("load", 0.75);
+  EXPECT_EQ(gauge.name(), "load");
+  EXPECT_EQ(gauge.kind(), Feller::MetricLog::Kind::GAUGE);
+  EXPECT_EQ(gauge.gauge(), 0.75);
+  EXPECT_EQ(gauge.count(), 0);
+  EXPECT_NE(gauge, Feller::MetricLog::counter("load", 0));
+}
+
+TEST(MetricLog, testToEventLog)
+{
+  const Feller::EventLog::time_point time{std::chrono::seconds{10}};
+  const auto counter = Feller::MetricLog::counter("requests", 3).to_event_log(time);
+  EXPECT_EQ(counter.name(), "requests");
+  EXPECT_EQ(counter.time(), time);
+  ASSERT_EQ(counter.size(), 1);
+  EXPECT_EQ(counter.cbegin()->first, Feller::MetricLog::counter_key());
+  EXPECT_EQ(*counter.cbegin()->second.get_if<std::int64_t>(), 3);
+
+  const auto gauge = Feller::MetricLog::gauge("load", 0.5).to_event_log(time);
+  ASSERT_EQ(gauge.size(), 1);
+  EXPECT_EQ(gauge.cbegin()->first, Feller::MetricLog::gauge_key());
+  EXPECT_EQ(*gauge.cbegin()->second.get_if<double>(), 0.5);
+}
+
+TEST(MetricLog, testOstream)
+{
+  std::stringstream ss;
+  ss << Feller::MetricLog::counter("requests", 3) << '\n' << Feller::MetricLog::gauge("load", 2);
+  EXPECT_EQ(ss.str(), "Name:requests\nCounter:3\nName:load\nGauge:2.000000");
+}
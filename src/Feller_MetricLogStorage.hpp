@@ -0,0 +1,532 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_METRIC_LOG_STORAGE
+#define INCLUDED_FELLER_METRIC_LOG_STORAGE
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "Feller_Feller.hpp"
+
+#include "Feller_MetricLog.hpp"
+#include "Feller_StringTable.hpp"
+#include "Feller_ThreadInfo.hpp"
+
+namespace Feller
+{
+/**
+ MetricLogStorage. This class implements a container that aggregates metric updates (see
+\ref MetricLog) in place. Rather than storing one record per update, this class keeps a single
+running value per metric name: inserting a counter update adds to the counter, and inserting a
+gauge update overwrites the gauge. This means that the memory used by this class depends only on
+the number of distinct metrics, and that inserting never allocates.
+
+ Briefly, each name is given a slot in a fixed-size, open-addressed table the first time that it
+is seen. Gauges are held in a single atomic per slot. Counters are held in several shards, each of
+which has its own cache lines: each thread adds to the shard picked by its index (see
+\ref Thread::index), and so a counter update is a table lookup followed by a single relaxed atomic
+add that does not contend with other threads. The shards are folded into a single value by
+`cbegin`, which takes a snapshot of every metric.
+
+ This class is designed to be used with a lock policy that does no locking (such as
+\ref NoLock): concurrent calls to `insert` are safe without any outer lock. The reading side of
+this class (i.e `size`, `find`, `cbegin` and `cend`) may also be called whilst other threads are
+inserting, in which case it sees a recent value of each metric. However, reads must not race
+with each other, and `clear` must not race with anything.
+
+ Each name should only be used for a single kind of metric. The kind of a metric is the kind of
+the first update that uses its name.
+
+ \tparam LogType: the type of metric to be stored in this class (e.g \ref MetricLog). This type
+must provide `interned_name`, `kind`, `count` and `gauge` methods, along with static `counter`
+and `gauge` functions that build a log, just as \ref MetricLog does.
+ \tparam KeyType: not used in this class.
+**/
+template <typename LogType, typename KeyType = char /*unused*/> class MetricLogStorage
+{
+public:
+  /**
+     size_type. This type is used to represent sizes in this object.
+  **/
+  using size_type = std::size_t;
+
+  /**
+     const_iterator. This type is used to iterate over the metrics in this object. Metrics are
+  visited in the order in which their names were first seen.
+  **/
+  using const_iterator = typename std::vector<LogType>::const_iterator;
+
+  /**
+     count_type. This is the type used to represent the value of a counter.
+  **/
+  using count_type = typename LogType::count_type;
+
+  /**
+     default_capacity. This is the number of distinct metrics that may be stored if no capacity is
+  specified.
+  **/
+  static constexpr size_type default_capacity = 256;
+
+  /**
+     max_shards. This is the largest number of counter shards that this class uses by default.
+  **/
+  static constexpr size_type max_shards = 64;
+
+  /**
+     MetricLogStorage. This constructor builds a store that can hold at least `capacity` distinct
+  metrics, spreading each counter over `nr_shards` shards. Both numbers are rounded up to the next
+  power of two. This constructor may throw due to allocation failures.
+     \param capacity: the minimum number of distinct metrics.
+     \param nr_shards: the number of shards per counter. By default, this is the number of
+  hardware threads (up to max_shards).
+  **/
+  explicit MetricLogStorage(const size_type capacity  = default_capacity,
+                            const size_type nr_shards = default_shards());
+
+  /**
+     insert. This method applies `log` to the metric that it names. This method is safe to call
+  from many threads at once. This method only throws if `log` names a new metric and this object
+  is full, in which case std::length_error is thrown and nothing is changed.
+     \param log: the update to be applied.
+  **/
+  inline void insert(const LogType &log);
+
+  /**
+     emplace_back. This method builds an update from `args` and applies it (see `insert`).
+     \param args: the arguments to be forwarded to the constructor of the log.
+  **/
+  template <typename... Args> inline void emplace_back(Args &&...args);
+
+  /**
+     find. This method returns the current value of the metric called `name`. This function may
+  throw due to allocation failures.
+     \param name: the name of the metric.
+     \return the metric, or an empty optional if no update has used `name`.
+  **/
+  inline std::optional<LogType> find(const InternedString name) const;
+
+  /**
+     size. This method returns the number of distinct metrics in this object. Metrics that are new
+  since the last snapshot are added to it, but the values already in it are left alone. This
+  function may throw due to allocation failures.
+     \return the number of metrics.
+  **/
+  inline size_type size() const;
+
+  /**
+     capacity. This method returns the number of distinct metrics that this object can hold.
+  This function does not throw.
+     \return the capacity of this object.
+  **/
+  inline size_type capacity() const noexcept;
+
+  /**
+     nr_shards. This method returns the number of shards per counter. This function does not
+  throw.
+     \return the number of shards.
+  **/
+  inline size_type nr_shards() const noexcept;
+
+  /**
+     cbegin. This method folds the shards into a new snapshot and returns a const iterator to its
+  first metric. Note that the values seen via the iterators are those at the time of the fold.
+  Since folding never moves the snapshot, folding again does not invalidate iterators: it does
+  however overwrite the values that they refer to.
+     \return a const iterator to the first metric.
+  **/
+  inline const_iterator cbegin() const;
+
+  /**
+     cend. This method returns a const iterator to one past the last metric in the snapshot. Like
+  `size`, this adds any new metrics to the snapshot without changing the values already in it,
+  so calling this on every step of a loop is safe.
+     \return a const iterator to the end of the metrics.
+  **/
+  inline const_iterator cend() const;
+
+  /// Overloads of cbegin and cend to allow range-based for loops.
+  inline const_iterator begin() const;
+  inline const_iterator end() const;
+
+  /**
+     clear. This method removes every metric from this object. This method does not throw.
+  **/
+  inline void clear() noexcept;
+
+  /**
+      operator<<. Prints a string representation of the object ``st`` to the
+      specified ostream ``os`. This method may throw.
+      \tparam LT: the type stored in st.
+      \param os: the stream to print the storage object to.
+      \param st: the object to be printed.
+      \return the os parameter.
+   **/
+  template <typename LT, typename KT>
+  inline friend std::ostream &operator<<(std::ostream &os, const MetricLogStorage<LT, KT> &st);
+
+private:
+  using id_type = InternedString::id_type;
+  using Kind    = typename LogType::Kind;
+
+  /**
+     Slot. This struct represents a single metric. Each slot is placed on its own cache line, so
+  that setting one gauge does not slow down lookups of other metrics. The `name` of an unused
+  slot is StringTable::npos.
+  **/
+  struct alignas(64) Slot
+  {
+    std::atomic<id_type> name{StringTable::npos};
+    std::atomic<Kind> kind{Kind::COUNTER};
+    std::atomic<double> gauge{0.0};
+  };
+
+  /**
+     default_shards. This function returns the number of hardware threads, capped at max_shards.
+  **/
+  static inline size_type default_shards() noexcept;
+
+  /**
+     round_up. This function returns the smallest power of two that is at least `size`.
+  **/
+  static inline size_type round_up(const size_type size) noexcept;
+
+  /**
+     claim. This method returns the index of the slot for `name`, claiming a slot for it (as a
+  metric of kind `kind`) if there is none yet.
+     \return the index of the slot, or m_mask + 1 if this object is full.
+  **/
+  inline size_type claim(const InternedString name, const Kind kind) noexcept;
+
+  /**
+     lookup. This method returns the index of the slot for `name`.
+     \return the index of the slot, or m_mask + 1 if `name` has no slot.
+  **/
+  inline size_type lookup(const InternedString name) const noexcept;
+
+  /**
+     fold. This method brings the snapshot up to date with the slots.
+     \param refresh: if false, only metrics that are not yet in the snapshot are read.
+  **/
+  inline void fold(bool refresh) const;
+
+  /**
+     read. This method returns the current value of the metric in slot `slot`.
+  **/
+  inline LogType read(const size_type slot) const;
+
+  /**
+     m_slots. This is the table of metrics. This array holds `m_mask + 1` slots.
+  **/
+  std::unique_ptr<Slot[]> m_slots;
+
+  /**
+     m_mask. This is the number of slots minus one. This is used to map names to slots.
+  **/
+  size_type m_mask;
+
+  /**
+     m_counts. These are the counter shards. Shard `s` of the counter in slot `i` lives at
+  `s * m_stride + i`. The stride is padded by a cache line, so that no two shards share a line.
+  **/
+  std::unique_ptr<std::atomic<count_type>[]> m_counts;
+
+  /**
+     m_stride. This is the distance between consecutive shards of the same counter.
+  **/
+  size_type m_stride;
+
+  /**
+     m_shard_mask. This is the number of shards minus one. This is used to map threads to shards.
+  **/
+  size_type m_shard_mask;
+
+  /**
+     m_order. This holds the index (plus one) of each claimed slot, in the order in which they were
+  claimed. A zero entry is a slot that is still being claimed.
+  **/
+  std::unique_ptr<std::atomic<size_type>[]> m_order;
+
+  /**
+     m_nr_metrics. This is the number of slots that have been claimed.
+  **/
+  alignas(64) std::atomic<size_type> m_nr_metrics{0};
+
+  /**
+     m_metrics. This is the snapshot: it holds the value of each metric as of the last fold. The
+  capacity of this vector is reserved up front, so folding never invalidates iterators.
+  **/
+  mutable std::vector<LogType> m_metrics{};
+};
+
+/// INLINE FUNCTIONS
+template <typename LogType, typename KeyType>
+Feller::MetricLogStorage<LogType, KeyType>::MetricLogStorage(const size_type capacity,
+                                                             const size_type nr_shards)
+    : m_slots{}, m_mask{}, m_counts{}, m_stride{}, m_shard_mask{}, m_order{}
+{
+  constexpr size_type per_line = 64 / sizeof(std::atomic<count_type>);
+  const auto size              = round_up(capacity);
+  const auto shards            = round_up(nr_shards);
+
+  m_slots      = std::make_unique<Slot[]>(size);
+  m_mask       = size - 1;
+  m_stride     = (size + per_line - 1) / per_line * per_line + per_line;
+  m_shard_mask = shards - 1;
+  m_counts     = std::make_unique<std::atomic<count_type>[]>(shards * m_stride);
+  m_order      = std::make_unique<std::atomic<size_type>[]>(size);
+  m_metrics.reserve(size);
+}
+
+template <typename LogType, typename KeyType>
+inline std::ostream &operator<<(std::ostream &os, const MetricLogStorage<LogType, KeyType> &st)
+{
+  for (auto &v : st)
+  {
+    os << v;
+  }
+  return os;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MetricLogStorage<LogType, KeyType>::default_shards() noexcept -> size_type
+{
+  const size_type nr_threads = std::thread::hardware_concurrency();
+  return nr_threads == 0 ? 1 : std::min(nr_threads, max_shards);
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MetricLogStorage<LogType, KeyType>::round_up(const size_type size) noexcept
+    -> size_type
+{
+  size_type out = 1;
+  while (out < size)
+  {
+    out <<= 1;
+  }
+  return out;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MetricLogStorage<LogType, KeyType>::claim(const InternedString name,
+                                                              const Kind kind) noexcept
+    -> size_type
+{
+  // Ids are handed out densely, so they are already well spread over the table.
+  const auto id = name.id();
+  auto index    = static_cast<size_type>(id) & m_mask;
+  for (size_type probe = 0; probe <= m_mask; probe++, index = (index + 1) & m_mask)
+  {
+    auto &slot   = m_slots[index];
+    auto current = slot.name.load(std::memory_order_acquire);
+    if (current == StringTable::npos &&
+        slot.name.compare_exchange_strong(current, id, std::memory_order_acq_rel))
+    {
+      // The kind is published to readers along with the order entry.
+      slot.kind.store(kind, std::memory_order_relaxed);
+      const auto position = m_nr_metrics.fetch_add(1, std::memory_order_relaxed);
+      m_order[position].store(index + 1, std::memory_order_release);
+      return index;
+    }
+
+    // If the exchange failed then `current` is whoever claimed the slot first, which may be us.
+    if (current == id)
+    {
+      return index;
+    }
+  }
+
+  return m_mask + 1;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MetricLogStorage<LogType, KeyType>::lookup(const InternedString name) const
+    noexcept -> size_type
+{
+  const auto id = name.id();
+  auto index    = static_cast<size_type>(id) & m_mask;
+  for (size_type probe = 0; probe <= m_mask; probe++, index = (index + 1) & m_mask)
+  {
+    const auto current = m_slots[index].name.load(std::memory_order_acquire);
+    if (current == id)
+    {
+      return index;
+    }
+
+    if (current == StringTable::npos)
+    {
+      break;
+    }
+  }
+
+  return m_mask + 1;
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::MetricLogStorage<LogType, KeyType>::insert(const LogType &log)
+{
+  const auto index = claim(log.interned_name(), log.kind());
+  if (index > m_mask)
+  {
+    throw std::length_error("MetricLogStorage: too many distinct metrics");
+  }
+
+  if (log.kind() == Kind::COUNTER)
+  {
+    const auto shard = static_cast<size_type>(Thread::index()) & m_shard_mask;
+    m_counts[shard * m_stride + index].fetch_add(log.count(), std::memory_order_relaxed);
+  }
+  else
+  {
+    m_slots[index].gauge.store(log.gauge(), std::memory_order_relaxed);
+  }
+}
+
+template <typename LogType, typename KeyType>
+template <typename... Args>
+inline void Feller::MetricLogStorage<LogType, KeyType>::emplace_back(Args &&...args)
+{
+  insert(LogType(std::forward<Args>(args)...));
+}
+
+template <typename LogType, typename KeyType>
+inline LogType Feller::MetricLogStorage<LogType, KeyType>::read(const size_type slot) const
+{
+  const auto name = InternedString::from_id(m_slots[slot].name.load(std::memory_order_relaxed));
+  if (m_slots[slot].kind.load(std::memory_order_relaxed) == Kind::GAUGE)
+  {
+    return LogType::gauge(name, m_slots[slot].gauge.load(std::memory_order_relaxed));
+  }
+
+  count_type total{};
+  for (size_type shard = 0; shard <= m_shard_mask; shard++)
+  {
+    total += m_counts[shard * m_stride + slot].load(std::memory_order_relaxed);
+  }
+  return LogType::counter(name, total);
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::MetricLogStorage<LogType, KeyType>::fold(const bool refresh) const
+{
+  const auto nr_metrics = m_nr_metrics.load(std::memory_order_acquire);
+  for (size_type position = refresh ? 0 : m_metrics.size(); position < nr_metrics; position++)
+  {
+    const auto slot = m_order[position].load(std::memory_order_acquire);
+    if (slot == 0)
+    {
+      // This metric is still being claimed, so it (and anything after it) is not yet visible.
+      break;
+    }
+
+    if (position < m_metrics.size())
+    {
+      m_metrics[position] = read(slot - 1);
+    }
+    else
+    {
+      m_metrics.push_back(read(slot - 1));
+    }
+  }
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MetricLogStorage<LogType, KeyType>::find(const InternedString name) const
+    -> std::optional<LogType>
+{
+  const auto index = lookup(name);
+  if (index > m_mask)
+  {
+    return std::nullopt;
+  }
+  return read(index);
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MetricLogStorage<LogType, KeyType>::size() const -> size_type
+{
+  fold(false);
+  return m_metrics.size();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MetricLogStorage<LogType, KeyType>::capacity() const noexcept -> size_type
+{
+  return m_mask + 1;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MetricLogStorage<LogType, KeyType>::nr_shards() const noexcept -> size_type
+{
+  return m_shard_mask + 1;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MetricLogStorage<LogType, KeyType>::cbegin() const -> const_iterator
+{
+  fold(true);
+  return m_metrics.cbegin();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MetricLogStorage<LogType, KeyType>::cend() const -> const_iterator
+{
+  fold(false);
+  return m_metrics.cend();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MetricLogStorage<LogType, KeyType>::begin() const -> const_iterator
+{
+  return cbegin();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::MetricLogStorage<LogType, KeyType>::end() const -> const_iterator
+{
+  return cend();
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::MetricLogStorage<LogType, KeyType>::clear() noexcept
+{
+  for (size_type i = 0; i <= m_mask; i++)
+  {
+    m_slots[i].name.store(StringTable::npos, std::memory_order_relaxed);
+    m_slots[i].kind.store(Kind::COUNTER, std::memory_order_relaxed);
+    m_slots[i].gauge.store(0.0, std::memory_order_relaxed);
+    m_order[i].store(0, std::memory_order_relaxed);
+  }
+  for (size_type i = 0; i < (m_shard_mask + 1) * m_stride; i++)
+  {
+    m_counts[i].store(0, std::memory_order_relaxed);
+  }
+  m_nr_metrics.store(0, std::memory_order_release);
+  m_metrics.clear();
+}
+
+}  // namespace Feller
+
+#endif
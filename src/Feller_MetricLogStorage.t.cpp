@@ -0,0 +1,207 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_MetricLogStorage.hpp"
+#include "Feller_AtomicConditionalLoggingPolicy.hpp"
+#include "Feller_Decl.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_MetricLog.hpp"
+#include "Feller_NoLock.hpp"
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Storage = Feller::MetricLogStorage<Feller::MetricLog>;
+
+TEST(MetricLogStorage, testInit)
+{
+  const Storage storage;
+  EXPECT_EQ(storage.size(), 0);
+  EXPECT_EQ(storage.capacity(), Storage::default_capacity);
+  EXPECT_GE(storage.nr_shards(), 1);
+  EXPECT_EQ(storage.cbegin(), storage.cend());
+  EXPECT_FALSE(storage.find("requests").has_value());
+}
+
+TEST(MetricLogStorage, testSizesArePowersOfTwo)
+{
+  const Storage storage{5, 3};
+  EXPECT_EQ(storage.capacity(), 8);
+  EXPECT_EQ(storage.nr_shards(), 4);
+}
+
+TEST(MetricLogStorage, testCounter)
+{
+  // Updates to the same counter are aggregated, rather than stored individually.
+  Storage storage;
+  storage.insert(Feller::MetricLog::counter("requests"));
+  storage.insert(Feller::MetricLog::counter("requests", 4));
+  storage.insert(Feller::MetricLog::counter("requests", -2));
+
+  ASSERT_EQ(storage.size(), 1);
+  EXPECT_EQ(*storage.cbegin(), Feller::MetricLog::counter("requests", 3));
+  EXPECT_EQ(storage.find("requests"), Feller::MetricLog::counter("requests", 3));
+}
+
+TEST(MetricLogStorage, testGauge)
+{
+  // Gauges keep the last value that was set.
+  Storage storage;
+  storage.insert(Feller::MetricLog::gauge("load", 0.5));
+  storage.insert(Feller::MetricLog::gauge("load", 0.25));
+
+  ASSERT_EQ(storage.size(), 1);
+  EXPECT_EQ(*storage.cbegin(), Feller::MetricLog::gauge("load", 0.25));
+}
+
+TEST(MetricLogStorage, testOrder)
+{
+  // Metrics are visited in the order in which they were first seen, and are refreshed on read.
+  Storage storage{4};
+  storage.insert(Feller::MetricLog::counter("c"));
+  storage.insert(Feller::MetricLog::gauge("b", 1.0));
+  storage.insert(Feller::MetricLog::counter("a"));
+  storage.insert(Feller::MetricLog::counter("c"));
+
+  std::vector<Feller::MetricLog> expected{Feller::MetricLog::counter("c", 2),
+                                          Feller::MetricLog::gauge("b", 1.0),
+                                          Feller::MetricLog::counter("a", 1)};
+  EXPECT_EQ(std::vector<Feller::MetricLog>(storage.cbegin(), storage.cend()), expected);
+
+  storage.insert(Feller::MetricLog::counter("a", 9));
+  storage.insert(Feller::MetricLog::counter("d"));
+  expected[2] = Feller::MetricLog::counter("a", 10);
+  expected.push_back(Feller::MetricLog::counter("d"));
+  EXPECT_EQ(std::vector<Feller::MetricLog>(storage.cbegin(), storage.cend()), expected);
+}
+
+TEST(MetricLogStorage, testSnapshot)
+{
+  // Only cbegin refreshes the snapshot: cend and size may be called on every step of a loop
+  // without changing the values that the loop is looking at.
+  Storage storage{4};
+  storage.insert(Feller::MetricLog::counter("a"));
+  const auto it     = storage.cbegin();
+  const auto &first = *it;
+
+  storage.insert(Feller::MetricLog::counter("a", 5));
+  storage.insert(Feller::MetricLog::counter("b"));
+  EXPECT_EQ(storage.size(), 2);
+  ASSERT_EQ(storage.cend() - it, 2);
+  EXPECT_EQ(first, Feller::MetricLog::counter("a", 1));
+  EXPECT_EQ(*(it + 1), Feller::MetricLog::counter("b", 1));
+
+  EXPECT_EQ(*storage.cbegin(), Feller::MetricLog::counter("a", 6));
+  EXPECT_EQ(first, Feller::MetricLog::counter("a", 6));
+}
+
+TEST(MetricLogStorage, testFull)
+{
+  // A full store still accepts updates to existing metrics, but rejects new ones.
+  Storage storage{2};
+  storage.insert(Feller::MetricLog::counter("a"));
+  storage.insert(Feller::MetricLog::counter("b"));
+  EXPECT_THROW(storage.insert(Feller::MetricLog::counter("c")), std::length_error);
+  EXPECT_NO_THROW(storage.insert(Feller::MetricLog::counter("a")));
+
+  EXPECT_EQ(storage.size(), 2);
+  EXPECT_EQ(storage.find("a"), Feller::MetricLog::counter("a", 2));
+  EXPECT_FALSE(storage.find("c").has_value());
+}
+
+TEST(MetricLogStorage, testClear)
+{
+  Storage storage;
+  storage.insert(Feller::MetricLog::counter("requests", 5));
+  storage.insert(Feller::MetricLog::gauge("load", 0.5));
+  storage.clear();
+  EXPECT_EQ(storage.size(), 0);
+  EXPECT_FALSE(storage.find("requests").has_value());
+
+  storage.insert(Feller::MetricLog::counter("requests"));
+  EXPECT_EQ(storage.find("requests"), Feller::MetricLog::counter("requests"));
+}
+
+TEST(MetricLogStorage, testOstream)
+{
+  Storage storage;
+  storage.insert(Feller::MetricLog::counter("requests", 2));
+  std::stringstream ss;
+  ss << storage;
+  EXPECT_EQ(ss.str(), Feller::MetricLog::counter("requests", 2).to_string());
+}
+
+TEST(MetricLogStorage, testManyThreads)
+{
+  // Threads add to their own shards, so no updates are lost and names are only claimed once.
+  constexpr unsigned nr_threads = 8;
+  constexpr unsigned per_thread = 10000;
+  Storage storage{16, 4};
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < nr_threads; t++)
+  {
+    threads.emplace_back([&storage, t]() {
+      const Feller::InternedString own{"thread " + std::to_string(t)};
+      for (unsigned i = 0; i < per_thread; i++)
+      {
+        storage.insert(Feller::MetricLog::counter("shared"));
+        storage.insert(Feller::MetricLog::counter(own, 2));
+      }
+    });
+  }
+
+  // Reading whilst the threads are running sees a consistent set of names.
+  EXPECT_LE(storage.size(), nr_threads + 1);
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  EXPECT_EQ(storage.size(), nr_threads + 1);
+  EXPECT_EQ(storage.find("shared"), Feller::MetricLog::counter("shared", nr_threads * per_thread));
+  for (unsigned t = 0; t < nr_threads; t++)
+  {
+    const auto name = "thread " + std::to_string(t);
+    EXPECT_EQ(storage.find(name), Feller::MetricLog::counter(name, 2 * per_thread));
+  }
+}
+
+TEST(MetricLogStorage, testMetricLogger)
+{
+  Feller::MetricLogger logger;
+  logger.insert(Feller::MetricLog::counter("requests"));
+  logger.emplace(Feller::MetricLog::counter("requests"));
+  logger.insert(Feller::MetricLog::gauge("load", 0.5));
+
+  // Filtered updates are never applied.
+  logger.switchMode(Feller::LoggingMode::IMPORTANT);
+  logger.insert(Feller::MetricLog::counter("requests"));
+  logger.insert(Feller::MetricLog::counter("requests"), Feller::LoggingMode::IMPORTANT);
+
+  EXPECT_EQ(logger.size(), 2);
+  EXPECT_EQ(logger.find("requests"), Feller::MetricLog::counter("requests", 3));
+  EXPECT_EQ(logger.find("load"), Feller::MetricLog::gauge("load", 0.5));
+
+  logger.clear();
+  EXPECT_EQ(logger.size(), 0);
+}
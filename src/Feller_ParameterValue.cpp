@@ -0,0 +1,54 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_ParameterValue.hpp"
+
+#include <charconv>
+
+void Feller::ParameterValue::append_to(std::string &out) const
+{
+  // This is enough for any 64-bit integer and for the shortest form of any double.
+  char buffer[32];
+  const auto end = buffer + sizeof(buffer);
+  const auto put = [&out, &buffer](const std::to_chars_result result) {
+    out.append(buffer, result.ptr);
+  };
+
+  switch (type())
+  {
+  case Type::STRING:
+    out += std::string_view{*get_if<string_type>()};
+    break;
+  case Type::INTEGER:
+    put(std::to_chars(buffer, end, *get_if<std::int64_t>()));
+    break;
+  case Type::UNSIGNED:
+    put(std::to_chars(buffer, end, *get_if<std::uint64_t>()));
+    break;
+  case Type::DOUBLE:
+    put(std::to_chars(buffer, end, *get_if<double>()));
+    break;
+  case Type::BOOLEAN:
+    out += *get_if<bool>() ? "true" : "false";
+    break;
+  case Type::DURATION:
+    put(std::to_chars(buffer, end, get_if<duration>()->count()));
+    out += "ns";
+    break;
+  }
+}
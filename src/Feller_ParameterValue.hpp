@@ -0,0 +1,280 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_PARAMETER_VALUE
+#define INCLUDED_FELLER_PARAMETER_VALUE
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "Feller_Feller.hpp"
+
+namespace Feller
+{
+/**
+ ParameterValue. This class holds the value of a single parameter of an \ref EventLog. Rather than
+forcing every value through a string, this class stores integers, doubles, booleans, durations and
+strings natively, alongside a tag recording which one is held. This means that logging a number is
+a store of 8 bytes: the value is only formatted when the log is turned into text (see `to_string`).
+
+ Values are built implicitly from the type that they hold. Signed integers are widened to
+`std::int64_t`, unsigned integers to `std::uint64_t`, floating point values to `double` and
+durations to nanoseconds. Note that `char` is an integer type, and is hence stored as a number.
+
+ Strings are held as `std::pmr::string`, and this class is allocator-aware: when it is built with
+an allocator (e.g as part of an \ref EventLog stored in a `std::pmr` container), its string is
+allocated from the same memory resource.
+**/
+class ParameterValue
+{
+public:
+  /**
+     Type. This enum describes the type of value held. The order matches the order of the types in
+  `m_value`.
+  **/
+  enum class Type : std::uint8_t
+  {
+    STRING,
+    INTEGER,
+    UNSIGNED,
+    DOUBLE,
+    BOOLEAN,
+    DURATION
+  };
+
+  /**
+     duration. This is the type used to store durations.
+  **/
+  using duration = std::chrono::nanoseconds;
+
+  /**
+     string_type. This is the type used to store strings.
+  **/
+  using string_type = std::pmr::string;
+
+  /**
+     allocator_type. This is the allocator used for strings. Declaring this type means that
+  `std::pmr` containers pass their allocator to this class on construction.
+  **/
+  using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+  /**
+     ParameterValue. This constructor builds an empty string. This does not allocate.
+  **/
+  ParameterValue() noexcept = default;
+
+  /**
+     ParameterValue. These constructors build a string value, using the default memory resource.
+  These may throw due to allocation failures.
+     \param value: the string to be stored.
+  **/
+  ParameterValue(const std::string &value)
+      : m_value{std::in_place_index<0>, value.data(), value.size()}
+  {
+  }
+  ParameterValue(string_type &&value) noexcept : m_value{std::in_place_index<0>, std::move(value)}
+  {
+  }
+  ParameterValue(const char *const value) : m_value{std::in_place_index<0>, value} {}
+
+  /**
+     ParameterValue. This constructor builds a boolean value.
+     \param value: the boolean to be stored.
+  **/
+  ParameterValue(const bool value) noexcept : m_value{std::in_place_index<4>, value} {}
+
+  /**
+     ParameterValue. This constructor builds an integer value. Signed integers are stored as
+  `std::int64_t` and unsigned integers as `std::uint64_t`.
+     \tparam T: the type of the integer.
+     \param value: the integer to be stored.
+  **/
+  template <typename T,
+            std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+  ParameterValue(const T value) noexcept
+      : m_value{std::in_place_index<std::is_signed_v<T> ? 1 : 2>, value}
+  {
+  }
+
+  /**
+     ParameterValue. This constructor builds a floating point value, which is stored as a double.
+     \tparam T: the type of the floating point value.
+     \param value: the value to be stored.
+  **/
+  template <typename T, std::enable_if_t<std::is_floating_point_v<T>, int> = 0>
+  ParameterValue(const T value) noexcept : m_value{std::in_place_index<3>, value}
+  {
+  }
+
+  /**
+     ParameterValue. This constructor builds a duration, which is stored in nanoseconds.
+     \param value: the duration to be stored.
+  **/
+  template <typename Rep, typename Period>
+  ParameterValue(const std::chrono::duration<Rep, Period> value) noexcept
+      : m_value{std::in_place_index<5>, std::chrono::duration_cast<duration>(value)}
+  {
+  }
+
+  /// Copying and moving. These follow the rules for std::pmr::string: copies use the default
+  /// memory resource, moves keep the memory resource of the source, and assignments keep the
+  /// memory resource of the target (and so may allocate).
+  ParameterValue(const ParameterValue &)            = default;
+  ParameterValue(ParameterValue &&) noexcept        = default;
+  ParameterValue &operator=(const ParameterValue &) = default;
+  ParameterValue &operator=(ParameterValue &&)      = default;
+
+  /**
+     ParameterValue. These constructors are the allocator-extended forms of the constructors
+  above: any string is allocated with `alloc`. Moving from a value that uses a different memory
+  resource copies its string. These may throw due to allocation failures.
+     \param alloc: the allocator for the string.
+     \param value: the value to be stored.
+  **/
+  ParameterValue(std::allocator_arg_t, const allocator_type &alloc) noexcept
+      : m_value{std::in_place_index<0>, alloc}
+  {
+  }
+  template <typename T, std::enable_if_t<std::is_constructible_v<ParameterValue, T &&>, int> = 0>
+  ParameterValue(std::allocator_arg_t, const allocator_type &alloc, T &&value)
+      : m_value{std::in_place_index<0>, alloc}
+  {
+    // Assigning to the string keeps its allocator, whereas replacing the variant would not.
+    if constexpr (std::is_same_v<std::decay_t<T>, ParameterValue>)
+    {
+      // A string is stolen if both use the same memory resource, and copied otherwise.
+      if (value.type() == Type::STRING)
+      {
+        std::get<0>(m_value) = std::get<0>(std::forward<T>(value).m_value);
+      }
+      else
+      {
+        m_value = std::forward<T>(value).m_value;
+      }
+    }
+    else if constexpr (std::is_convertible_v<T &&, std::string_view>)
+    {
+      std::get<0>(m_value) = std::string_view{value};
+    }
+    else
+    {
+      m_value = ParameterValue(std::forward<T>(value)).m_value;
+    }
+  }
+
+  /**
+     type. This method returns the type of value held.
+     \return the type of value held.
+  **/
+  inline Type type() const noexcept { return static_cast<Type>(m_value.index()); }
+
+  /**
+     get_if. This method returns a pointer to the held value, if it has type `T`. `T` must be one
+  of `string_type`, `std::int64_t`, `std::uint64_t`, `double`, `bool` or `duration`.
+     \tparam T: the type of value requested.
+     \return a pointer to the value, or nullptr if this object holds a different type.
+  **/
+  template <typename T> inline const T *get_if() const noexcept { return std::get_if<T>(&m_value); }
+
+  /**
+     append_to. This method appends the text of this value to `out`. Strings are appended as is,
+  booleans as "true" or "false", durations as a count of nanoseconds followed by "ns" and numbers
+  in their shortest round-trip form. This method may throw due to allocation failures.
+     \param out: the string to be appended to.
+  **/
+  void append_to(std::string &out) const;
+
+  /**
+     to_string. This method returns the text of this value, as written by `append_to`.
+     \return the text of this value.
+  **/
+  inline std::string to_string() const;
+
+  /**
+     ==. Two values are equal if they hold the same type and the same value. In particular, the
+  integer 1 is not equal to the string "1".
+  **/
+  inline friend bool operator==(const ParameterValue &lhs, const ParameterValue &rhs) noexcept
+  {
+    return lhs.m_value == rhs.m_value;
+  }
+  inline friend bool operator!=(const ParameterValue &lhs, const ParameterValue &rhs) noexcept
+  {
+    return !(lhs == rhs);
+  }
+
+  /// Comparisons with text. These are true only if this object holds an equal string.
+  inline friend bool operator==(const ParameterValue &lhs, const std::string &rhs) noexcept
+  {
+    const auto str = lhs.get_if<string_type>();
+    return str != nullptr && std::string_view{*str} == rhs;
+  }
+  inline friend bool operator==(const std::string &lhs, const ParameterValue &rhs) noexcept
+  {
+    return rhs == lhs;
+  }
+  inline friend bool operator!=(const ParameterValue &lhs, const std::string &rhs) noexcept
+  {
+    return !(lhs == rhs);
+  }
+  inline friend bool operator!=(const std::string &lhs, const ParameterValue &rhs) noexcept
+  {
+    return !(rhs == lhs);
+  }
+  inline friend bool operator==(const ParameterValue &lhs, const char *const rhs) noexcept
+  {
+    const auto str = lhs.get_if<string_type>();
+    return str != nullptr && *str == rhs;
+  }
+  inline friend bool operator!=(const ParameterValue &lhs, const char *const rhs) noexcept
+  {
+    return !(lhs == rhs);
+  }
+
+  inline friend std::ostream &operator<<(std::ostream &os, const ParameterValue &value)
+  {
+    os << value.to_string();
+    return os;
+  }
+
+private:
+  /**
+     m_value. This holds the value itself. The index of the held alternative is the \ref Type.
+  **/
+  std::variant<string_type, std::int64_t, std::uint64_t, double, bool, duration> m_value{};
+};
+
+/// INLINE FUNCTIONS
+inline std::string ParameterValue::to_string() const
+{
+  std::string out;
+  append_to(out);
+  return out;
+}
+
+}  // namespace Feller
+
+#endif
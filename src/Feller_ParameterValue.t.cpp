@@ -0,0 +1,105 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_EventLog.hpp"
+#include "Feller_ParameterValue.hpp"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+using Value = Feller::ParameterValue;
+
+TEST(ParameterValue, testDefault)
+{
+  const Value value;
+  EXPECT_EQ(value.type(), Value::Type::STRING);
+  EXPECT_EQ(value, "");
+  EXPECT_EQ(value.to_string(), "");
+}
+
+TEST(ParameterValue, testTypes)
+{
+  EXPECT_EQ(Value{"abc"}.type(), Value::Type::STRING);
+  EXPECT_EQ(Value{std::string{"abc"}}.type(), Value::Type::STRING);
+  EXPECT_EQ(Value{-1}.type(), Value::Type::INTEGER);
+  EXPECT_EQ(Value{short{1}}.type(), Value::Type::INTEGER);
+  EXPECT_EQ(Value{1u}.type(), Value::Type::UNSIGNED);
+  EXPECT_EQ(Value{std::size_t{1}}.type(), Value::Type::UNSIGNED);
+  EXPECT_EQ(Value{1.5}.type(), Value::Type::DOUBLE);
+  EXPECT_EQ(Value{1.5f}.type(), Value::Type::DOUBLE);
+  EXPECT_EQ(Value{true}.type(), Value::Type::BOOLEAN);
+  EXPECT_EQ(Value{std::chrono::seconds(1)}.type(), Value::Type::DURATION);
+}
+
+TEST(ParameterValue, testGetIf)
+{
+  const Value value{42};
+  ASSERT_NE(value.get_if<std::int64_t>(), nullptr);
+  EXPECT_EQ(*value.get_if<std::int64_t>(), 42);
+  EXPECT_EQ(value.get_if<Value::string_type>(), nullptr);
+  EXPECT_EQ(value.get_if<double>(), nullptr);
+
+  const Value duration{std::chrono::microseconds(3)};
+  ASSERT_NE(duration.get_if<Value::duration>(), nullptr);
+  EXPECT_EQ(duration.get_if<Value::duration>()->count(), 3000);
+}
+
+TEST(ParameterValue, testToString)
+{
+  EXPECT_EQ(Value{"abc"}.to_string(), "abc");
+  EXPECT_EQ(Value{-42}.to_string(), "-42");
+  EXPECT_EQ(Value{std::numeric_limits<std::int64_t>::min()}.to_string(), "-9223372036854775808");
+  EXPECT_EQ(Value{std::numeric_limits<std::uint64_t>::max()}.to_string(), "18446744073709551615");
+  EXPECT_EQ(Value{0.1}.to_string(), "0.1");
+  EXPECT_EQ(Value{1e300}.to_string(), "1e+300");
+  EXPECT_EQ(Value{true}.to_string(), "true");
+  EXPECT_EQ(Value{false}.to_string(), "false");
+  EXPECT_EQ(Value{std::chrono::milliseconds(2)}.to_string(), "2000000ns");
+
+  std::string out{"x="};
+  Value{7u}.append_to(out);
+  EXPECT_EQ(out, "x=7");
+}
+
+TEST(ParameterValue, testEquality)
+{
+  EXPECT_EQ(Value{1}, Value{1l});
+  EXPECT_NE(Value{1}, Value{2});
+  // Values of different types never compare equal, even if their text is the same.
+  EXPECT_NE(Value{1}, Value{1u});
+  EXPECT_NE(Value{1}, Value{"1"});
+  EXPECT_NE(Value{1}, "1");
+  EXPECT_EQ(Value{"1"}, "1");
+  EXPECT_EQ(Value{"1"}, std::string{"1"});
+}
+
+TEST(ParameterValue, testEventLog)
+{
+  Feller::EventLog log{"count", 5};
+  log.emplace_back("ratio", 0.5);
+  log.emplace_back("ok", true);
+  log.emplace_back("name", "abc");
+
+  ASSERT_EQ(log.size(), 4);
+  EXPECT_EQ(log.cbegin()->second, Value{5});
+  EXPECT_EQ((log.cbegin() + 1)->second.type(), Value::Type::DOUBLE);
+  EXPECT_NE(log.to_string().find("count,5\nratio,0.5\nok,true\nname,abc\n"), std::string::npos);
+}
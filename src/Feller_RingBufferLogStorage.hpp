@@ -0,0 +1,392 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_RING_BUFFER_LOG_STORAGE
+#define INCLUDED_FELLER_RING_BUFFER_LOG_STORAGE
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "Feller_Feller.hpp"
+
+namespace Feller
+{
+/**
+ RingBufferLogStorage. This class implements a bounded, multi-producer/single-consumer ring buffer
+that stores particular logs. This class is designed to be used with a lock policy that does no
+locking (such as \ref NoLock): concurrent calls to `insert` are safe without any outer lock.
+
+ Briefly, producers claim a slot in the ring with a single atomic increment, write their log into
+that slot and then publish it by bumping the slot's sequence number. The consumer side of this
+class (i.e `size`, `cbegin`, `cend` and `clear`) drains every published slot, in order, into a
+contiguous vector of logs that is retained for iteration. If a producer finds that its slot has
+not yet been drained then it attempts to drain the ring itself, yielding if another thread is
+already doing so. This means that the ring never loses logs and never deadlocks, even if nobody
+ever reads from the store.
+
+ Note that the consumer side of this class is not safe to call concurrently with insertions:
+iterators are into the retained vector, and hence may be invalidated by a drain. In practice this
+means that the store should only be read once all producers have finished.
+
+ \tparam LogType: the type of log to be stored in this class. This type must be default
+constructible and assignable.
+ \tparam KeyType: not used in this class.
+**/
+template <typename LogType, typename KeyType = char /*unused*/> class RingBufferLogStorage
+{
+public:
+  /**
+     size_type. This type is used to represent sizes and positions in this object.
+  **/
+  using size_type = std::size_t;
+
+  /**
+     const_iterator. This type is used to iterate over the drained logs in this object.
+  **/
+  using const_iterator = typename std::vector<LogType>::const_iterator;
+
+  /**
+     default_capacity. This is the number of slots in the ring if no capacity is specified.
+  **/
+  static constexpr size_type default_capacity = 4096;
+
+  /**
+     RingBufferLogStorage. This constructor builds a ring with at least `capacity` slots.
+     The capacity is rounded up to the next power of two so that slot lookup is a mask.
+     This constructor may throw due to allocation failures.
+     \param capacity: the minimum number of slots in the ring.
+  **/
+  explicit RingBufferLogStorage(const size_type capacity = default_capacity);
+
+  /**
+     insert. This method copies `log` into the ring. This method is safe to call from many
+  threads at once. This function may throw due to allocation failures: in this case the log is
+  not stored.
+     \param log: the log to be copied into this object.
+  **/
+  inline void insert(const LogType &log);
+
+  /**
+     insert. This method moves `log` into the ring. This method is safe to call from many
+  threads at once.
+     \param log: the log to be moved into this object.
+  **/
+  inline void insert(LogType &&log);
+
+  /**
+     emplace_back. This method builds a log from `args` and moves it into the ring. Since each
+  slot always holds a live log, the log is built before the slot is claimed. This method is safe
+  to call from many threads at once.
+     \param args: the arguments to be forwarded to the constructor of the log.
+  **/
+  template <typename... Args> inline void emplace_back(Args &&...args);
+
+  /**
+     size. This method returns the number of logs that have been published to this object.
+     Note that logs that are mid-insertion are not counted. This function may throw, as it drains
+  the ring.
+     \return the number of logs in this object.
+  **/
+  inline size_type size() const;
+
+  /**
+     capacity. This method returns the number of slots in the ring. This function does not
+  throw.
+     \return the number of slots in the ring.
+  **/
+  inline size_type capacity() const noexcept;
+
+  /**
+     cbegin. This method returns a const iterator to the oldest log in this object.
+     \return a const iterator to the first log.
+  **/
+  inline const_iterator cbegin() const;
+
+  /**
+     cend. This method returns a const iterator to one past the newest log in this object.
+     \return a const iterator to the end of the logs.
+  **/
+  inline const_iterator cend() const;
+
+  /// Overloads of cbegin and cend to allow range-based for loops.
+  inline const_iterator begin() const;
+  inline const_iterator end() const;
+
+  /**
+     clear. This method removes every published log from this object. Note that the ring itself
+  is not freed.
+  **/
+  inline void clear();
+
+  /**
+      operator<<. Prints a string representation of the object ``st`` to the
+      specified ostream ``os`. This method may throw.
+      \tparam LT: the type stored in st.
+      \param os: the stream to print the storage object to.
+      \param st: the object to be printed.
+      \return the os parameter.
+   **/
+  template <typename LT, typename KT>
+  inline friend std::ostream &operator<<(std::ostream &os, const RingBufferLogStorage<LT, KT> &st);
+
+private:
+  /**
+     Slot. This struct represents a single entry in the ring. Each slot is placed on its own
+  cache line so that producers writing neighbouring slots do not contend with each other.
+  The `sequence` variable encodes the state of the slot: if `sequence == ticket` then the slot is
+  free for the producer holding `ticket`, and if `sequence == ticket + 1` then the slot has been
+  published and can be drained.
+  **/
+  struct alignas(64) Slot
+  {
+    std::atomic<size_type> sequence{0};
+    bool valid{false};
+    LogType value{};
+  };
+
+  /**
+     publish. This method implements each of the insertion methods. This method blocks if the
+  slot that the caller claims has not yet been drained.
+     \tparam T: the type of the log being inserted.
+     \param log: the log to be inserted.
+  **/
+  template <typename T> inline void publish(T &&log);
+
+  /**
+     try_drain. This method attempts to move every published slot into the retained vector.
+  This method returns without doing anything if another thread is already draining.
+     \return true if this thread drained the ring, false otherwise.
+  **/
+  inline bool try_drain() const;
+
+  /**
+     drain. This method drains the ring, waiting for any other drainer to finish first.
+  **/
+  inline void drain() const;
+
+  /**
+     m_slots. This is the ring itself. This array holds `m_mask + 1` slots.
+  **/
+  std::unique_ptr<Slot[]> m_slots;
+
+  /**
+     m_mask. This is the number of slots minus one. This is used to map tickets to slots.
+  **/
+  size_type m_mask;
+
+  /**
+     m_head. This is the next ticket to be handed to a producer.
+  **/
+  alignas(64) std::atomic<size_type> m_head{0};
+
+  /**
+     m_draining. This flag is set whilst a thread is draining the ring: this ensures that there is
+  only ever a single consumer.
+  **/
+  alignas(64) mutable std::atomic_flag m_draining = ATOMIC_FLAG_INIT;
+
+  /**
+     m_tail. This is the next ticket to be drained. This is only modified by the drainer.
+  **/
+  mutable size_type m_tail{0};
+
+  /**
+     m_logs. This vector retains every log that has been drained from the ring.
+  **/
+  mutable std::vector<LogType> m_logs{};
+};
+
+/// INLINE FUNCTIONS
+template <typename LogType, typename KeyType>
+Feller::RingBufferLogStorage<LogType, KeyType>::RingBufferLogStorage(const size_type capacity)
+    : m_slots{}, m_mask{}
+{
+  size_type size = 1;
+  while (size < capacity)
+  {
+    size <<= 1;
+  }
+
+  m_slots = std::make_unique<Slot[]>(size);
+  m_mask  = size - 1;
+  for (size_type i = 0; i < size; i++)
+  {
+    m_slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+template <typename LogType, typename KeyType>
+inline std::ostream &operator<<(std::ostream &os, const RingBufferLogStorage<LogType, KeyType> &st)
+{
+  for (auto &v : st)
+  {
+    os << v;
+  }
+  return os;
+}
+
+template <typename LogType, typename KeyType>
+template <typename T>
+inline void Feller::RingBufferLogStorage<LogType, KeyType>::publish(T &&log)
+{
+  const auto ticket = m_head.fetch_add(1, std::memory_order_relaxed);
+  auto &slot        = m_slots[ticket & m_mask];
+
+  // If the slot is still occupied from the previous lap then somebody has to drain it.
+  // We try to do this ourselves, and otherwise back off until the drainer is done.
+  while (slot.sequence.load(std::memory_order_acquire) != ticket)
+  {
+    if (!try_drain())
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  // The consumer expects this ticket to be published, so we must publish it even on failure.
+  try
+  {
+    slot.value = std::forward<T>(log);
+    slot.valid = true;
+  }
+  catch (...)
+  {
+    slot.valid = false;
+    slot.sequence.store(ticket + 1, std::memory_order_release);
+    throw;
+  }
+
+  slot.sequence.store(ticket + 1, std::memory_order_release);
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::RingBufferLogStorage<LogType, KeyType>::insert(const LogType &log)
+{
+  publish(log);
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::RingBufferLogStorage<LogType, KeyType>::insert(LogType &&log)
+{
+  publish(std::move(log));
+}
+
+template <typename LogType, typename KeyType>
+template <typename... Args>
+inline void Feller::RingBufferLogStorage<LogType, KeyType>::emplace_back(Args &&...args)
+{
+  publish(LogType(std::forward<Args>(args)...));
+}
+
+template <typename LogType, typename KeyType>
+inline bool Feller::RingBufferLogStorage<LogType, KeyType>::try_drain() const
+{
+  if (m_draining.test_and_set(std::memory_order_acquire))
+  {
+    return false;
+  }
+
+  // This guard releases the flag even if the vector throws on growth.
+  struct Release
+  {
+    std::atomic_flag &flag;
+    ~Release() { flag.clear(std::memory_order_release); }
+  } release{m_draining};
+
+  const auto size = m_mask + 1;
+  for (;;)
+  {
+    auto &slot = m_slots[m_tail & m_mask];
+    if (slot.sequence.load(std::memory_order_acquire) != m_tail + 1)
+    {
+      break;
+    }
+
+    if (slot.valid)
+    {
+      m_logs.push_back(std::move(slot.value));
+    }
+
+    slot.sequence.store(m_tail + size, std::memory_order_release);
+    ++m_tail;
+  }
+
+  return true;
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::RingBufferLogStorage<LogType, KeyType>::drain() const
+{
+  while (!try_drain())
+  {
+    std::this_thread::yield();
+  }
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::RingBufferLogStorage<LogType, KeyType>::size() const -> size_type
+{
+  drain();
+  return m_logs.size();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::RingBufferLogStorage<LogType, KeyType>::capacity() const noexcept -> size_type
+{
+  return m_mask + 1;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::RingBufferLogStorage<LogType, KeyType>::cbegin() const -> const_iterator
+{
+  drain();
+  return m_logs.cbegin();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::RingBufferLogStorage<LogType, KeyType>::cend() const -> const_iterator
+{
+  drain();
+  return m_logs.cend();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::RingBufferLogStorage<LogType, KeyType>::begin() const -> const_iterator
+{
+  return cbegin();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::RingBufferLogStorage<LogType, KeyType>::end() const -> const_iterator
+{
+  return cend();
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::RingBufferLogStorage<LogType, KeyType>::clear()
+{
+  drain();
+  m_logs.clear();
+}
+
+}  // namespace Feller
+
+#endif
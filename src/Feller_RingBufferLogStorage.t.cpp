@@ -0,0 +1,177 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "Feller_RingBufferLogStorage.hpp"
+#include "Feller_Decl.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_NoLock.hpp"
+#include "Feller_AtomicConditionalLoggingPolicy.hpp"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+TEST(RingBufferLogStorage, testInit)
+{
+  Feller::RingBufferLogStorage<int> log;
+  EXPECT_EQ(log.size(), 0);
+  EXPECT_EQ(log.capacity(), Feller::RingBufferLogStorage<int>::default_capacity);
+  EXPECT_EQ(log.cbegin(), log.cend());
+}
+
+TEST(RingBufferLogStorage, testCapacityIsPowerOfTwo)
+{
+  Feller::RingBufferLogStorage<int> log{100};
+  EXPECT_EQ(log.capacity(), 128);
+}
+
+TEST(RingBufferLogStorage, testInsert)
+{
+  Feller::RingBufferLogStorage<int> log;
+  ASSERT_EQ(log.size(), 0);
+
+  const auto c = static_cast<int>(rand());
+  log.insert(c);
+  EXPECT_EQ(log.size(), 1);
+  EXPECT_EQ(*log.cbegin(), c);
+}
+
+TEST(RingBufferLogStorage, testInsertMove)
+{
+  // Note; this uses string because int is trivially copiable (and thus
+  // moving it has no effect).
+  Feller::RingBufferLogStorage<std::string> log;
+  std::string c = "abcdef";
+  auto d        = c;
+  log.insert(std::move(c));
+  EXPECT_EQ(log.size(), 1);
+  EXPECT_EQ(*log.cbegin(), d);
+}
+
+TEST(RingBufferLogStorage, testWrapAround)
+{
+  // Inserting more than the capacity forces the producer to drain the ring itself.
+  Feller::RingBufferLogStorage<unsigned> log{8};
+  const auto size = 8 + static_cast<unsigned>(rand()) % 4096;
+  for (unsigned i = 0; i < size; i++)
+  {
+    log.insert(i);
+  }
+
+  ASSERT_EQ(log.size(), size);
+  unsigned curr = 0;
+  for (const auto &v : log)
+  {
+    EXPECT_EQ(v, curr++);
+  }
+}
+
+TEST(RingBufferLogStorage, testOstream)
+{
+  Feller::RingBufferLogStorage<int> log;
+  const auto size = static_cast<unsigned>(rand()) % 4096;
+
+  std::string curr;
+
+  for (unsigned i = 0; i < size; i++)
+  {
+    const auto c = static_cast<int>(rand());
+    log.insert(c);
+    curr += std::to_string(c);
+  }
+
+  std::ostringstream os;
+  os << log;
+  EXPECT_EQ(os.str(), curr);
+}
+
+TEST(RingBufferLogStorage, testClear)
+{
+  Feller::RingBufferLogStorage<int> log{4};
+  for (int i = 0; i < 10; i++)
+  {
+    log.insert(i);
+  }
+  ASSERT_EQ(log.size(), 10);
+  log.clear();
+  EXPECT_EQ(log.size(), 0);
+  log.insert(1);
+  EXPECT_EQ(log.size(), 1);
+}
+
+TEST(RingBufferLogStorage, testManyProducers)
+{
+  // Each thread inserts an increasing sequence: we check that nothing is lost and that each
+  // thread's logs appear in the order they were inserted.
+  constexpr unsigned nr_threads = 8;
+  constexpr unsigned per_thread = 10000;
+  Feller::RingBufferLogStorage<std::pair<unsigned, unsigned>> log{64};
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < nr_threads; t++)
+  {
+    threads.emplace_back([&log, t]() {
+      for (unsigned i = 0; i < per_thread; i++)
+      {
+        log.insert(std::make_pair(t, i));
+      }
+    });
+  }
+
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  ASSERT_EQ(log.size(), nr_threads * per_thread);
+  std::vector<unsigned> next(nr_threads, 0);
+  for (const auto &v : log)
+  {
+    EXPECT_EQ(v.second, next[v.first]);
+    ++next[v.first];
+  }
+}
+
+TEST(RingBufferLogStorage, testLockFreeLogger)
+{
+  Feller::MultiThreadedLockFreeEventLogger logger{16u};
+  EXPECT_EQ(logger.capacity(), 16);
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < 4; t++)
+  {
+    threads.emplace_back([&logger]() {
+      for (unsigned i = 0; i < 100; i++)
+      {
+        logger.insert(Feller::EventLog{"Test"});
+      }
+    });
+  }
+
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  EXPECT_EQ(logger.size(), 400);
+  for (const auto &v : logger)
+  {
+    EXPECT_EQ(v.name(), "Test");
+  }
+}
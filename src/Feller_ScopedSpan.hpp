@@ -0,0 +1,360 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_SCOPED_SPAN
+#define INCLUDED_FELLER_SCOPED_SPAN
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "Feller_Feller.hpp"
+
+#include "Feller_Clock.hpp"
+#include "Feller_LoggingMode.hpp"
+#include "Feller_StaticLoggingPolicy.hpp"
+#include "Feller_StringTable.hpp"
+#include "Feller_ThreadInfo.hpp"
+
+namespace Feller
+{
+namespace Span
+{
+/**
+   ThreadState. This struct holds the span bookkeeping for a single thread.
+**/
+struct ThreadState
+{
+  /**
+     thread_id. This is the index of the thread (see \ref Thread::index). This means that spans
+  and \ref ThreadEventLog agree on the id of each thread.
+  **/
+  std::uint64_t thread_id;
+
+  /**
+     nr_spans. This is the number of spans that this thread has started.
+  **/
+  std::uint64_t nr_spans;
+
+  /**
+     current. This is the id of the innermost active span on this thread, or 0 if there is none.
+  **/
+  std::uint64_t current;
+};
+
+/**
+   thread_state. This function returns the span bookkeeping for the calling thread. This function
+   does not throw.
+   \return a reference to the state of the calling thread.
+**/
+ThreadState &thread_state() noexcept;
+
+/**
+   duration_key. This function returns the key under which the duration of a span is stored.
+   \return the key "duration".
+**/
+inline InternedString duration_key();
+
+/**
+   id_key. This function returns the key under which the id of a span is stored. Span ids are
+   unique across threads.
+   \return the key "span_id".
+**/
+inline InternedString id_key();
+
+/**
+   parent_key. This function returns the key under which the id of the parent of a span is stored.
+   This is 0 for spans that have no parent.
+   \return the key "parent_id".
+**/
+inline InternedString parent_key();
+
+/**
+   thread_key. This function returns the key under which the id of the thread that recorded a
+   span is stored (see \ref ThreadState).
+   \return the key "thread_id".
+**/
+inline InternedString thread_key();
+}  // namespace Span
+
+/**
+ ScopedSpan. This class times a scope. The clock is read when the span is built, and again when
+it is destroyed: at that point a single log is inserted into the logger, holding the name of the
+span, the start time and the following parameters (see \ref Span):
+
+ - "duration": the time that the scope took.
+ - "span_id": an id for this span, which is unique across threads.
+ - "parent_id": the id of the innermost span that was active on the same thread when this span
+   started, or 0 if there was none. Spans hence form a tree per thread.
+ - "thread_id": a small id for the thread that recorded the span.
+
+ For example:
+
+   {
+     Feller::ScopedSpan span{logger, "parse"};
+     parse(input);
+   }
+
+ inserts one log named "parse" into `logger`. The \ref FELLER_SCOPED_SPAN macro does the same
+without needing a name for the variable.
+
+ Whether the span is recorded is decided once, when it is built, via the LoggingPolicy of the
+logger: if the span is filtered out then the clock is never read. If the LoggingPolicy never logs
+(e.g \ref LogNothing) then this class does no work at all, and so it compiles away entirely.
+
+ Since the log is inserted by the destructor, any exception thrown whilst inserting it (e.g
+std::bad_alloc) is swallowed: the span is simply not recorded.
+
+ \tparam LoggerType: the type of logger to insert into (e.g \ref Logger). The log type of this
+logger must be constructible from a name and a start time (e.g \ref EventLog), and must provide
+an emplace_back method for the duration.
+ \tparam ClockPolicy: the clock used to time the span (see \ref SteadyClock). This defaults to a
+monotonic clock, so that durations are never negative.
+**/
+template <typename LoggerType, typename ClockPolicy = SteadyClock> class ScopedSpan
+{
+public:
+  /**
+     time_point. This is the type of time returned by the clock.
+  **/
+  using time_point = typename ClockPolicy::time_point;
+
+  /**
+     duration. This is the type of the time that a span took.
+  **/
+  using duration = typename time_point::duration;
+
+  /**
+     enabled. This is false if the logger can never record a span, and true otherwise.
+  **/
+  static constexpr bool enabled = !logs_nothing_v<typename LoggerType::logging_type>;
+
+  /**
+     ScopedSpan. This constructor starts a span named `name`, provided that `priority` is
+  accepted by `logger`. This function does not throw.
+     \param logger: the logger to insert the span into. This must outlive the span.
+     \param name: the name of the span.
+     \param priority: the priority of the span.
+  **/
+  inline ScopedSpan(LoggerType &logger, const InternedString name,
+                    const LoggingMode priority = LoggingMode::EVERYTHING) noexcept;
+
+  /**
+     ~ScopedSpan. This destructor ends the span and inserts it into the logger, if it is active.
+  This function does not throw.
+  **/
+  inline ~ScopedSpan();
+
+  /// Spans are tied to a scope, so they cannot be copied or moved.
+  ScopedSpan(const ScopedSpan &)            = delete;
+  ScopedSpan &operator=(const ScopedSpan &) = delete;
+
+  /**
+     active. This method returns true if this span will be recorded when it ends.
+     \return true if this span is active, false otherwise.
+  **/
+  inline bool active() const noexcept;
+
+  /**
+     cancel. This method stops this span from being recorded. This is useful for scopes that
+  exit early without doing the work that is being timed.
+  **/
+  inline void cancel() noexcept;
+
+  /**
+     elapsed. This method returns the time since this span started. This reads the clock.
+     \return the time since this span started, or zero if this span is not active.
+  **/
+  inline duration elapsed() const noexcept;
+
+  /**
+     id. This method returns the id of this span.
+     \return the id of this span, or 0 if this span was filtered out.
+  **/
+  inline std::uint64_t id() const noexcept { return m_id; }
+
+  /**
+     parent. This method returns the id of the parent of this span.
+     \return the id of the parent of this span, or 0 if there is none.
+  **/
+  inline std::uint64_t parent() const noexcept { return m_parent; }
+
+private:
+  /**
+     m_logger. This is the logger that the span is inserted into, or nullptr if this span is
+  not active.
+  **/
+  LoggerType *m_logger{nullptr};
+
+  /**
+     m_name. This is the name of this span.
+  **/
+  InternedString m_name{};
+
+  /**
+     m_priority. This is the priority that the span is inserted with.
+  **/
+  LoggingMode m_priority{LoggingMode::EVERYTHING};
+
+  /**
+     m_state. This is the bookkeeping of the thread that started this span, or nullptr if this
+  span was filtered out. This is kept even if the span is cancelled, so that children of a
+  cancelled span still find the right parent.
+  **/
+  Span::ThreadState *m_state{nullptr};
+
+  /**
+     m_id. This is the id of this span.
+  **/
+  std::uint64_t m_id{0};
+
+  /**
+     m_parent. This is the id of the parent of this span.
+  **/
+  std::uint64_t m_parent{0};
+
+  /**
+     m_start. This is the time that this span started.
+  **/
+  time_point m_start{};
+};
+
+/// INLINE FUNCTIONS
+inline InternedString Span::duration_key()
+{
+  static const InternedString key{"duration"};
+  return key;
+}
+
+inline InternedString Span::id_key()
+{
+  static const InternedString key{"span_id"};
+  return key;
+}
+
+inline InternedString Span::parent_key()
+{
+  static const InternedString key{"parent_id"};
+  return key;
+}
+
+inline InternedString Span::thread_key() { return Thread::index_key(); }
+
+template <typename LoggerType, typename ClockPolicy>
+inline ScopedSpan<LoggerType, ClockPolicy>::ScopedSpan(LoggerType &logger,
+                                                       const InternedString name,
+                                                       const LoggingMode priority) noexcept
+{
+  if constexpr (enabled)
+  {
+    if (logger.shouldLog(priority))
+    {
+      // Span ids are the thread id followed by a per-thread count, so no atomics are needed.
+      // Ids are hence unique for the first 2^32 spans on each thread.
+      m_state          = &Span::thread_state();
+      m_id             = (m_state->thread_id << 32) | ++m_state->nr_spans;
+      m_parent         = m_state->current;
+      m_state->current = m_id;
+
+      m_logger   = &logger;
+      m_name     = name;
+      m_priority = priority;
+      m_start    = ClockPolicy::now();
+    }
+  }
+}
+
+template <typename LoggerType, typename ClockPolicy>
+inline ScopedSpan<LoggerType, ClockPolicy>::~ScopedSpan()
+{
+  if constexpr (enabled)
+  {
+    if (m_state == nullptr)
+    {
+      return;
+    }
+
+    const auto end   = ClockPolicy::now();
+    m_state->current = m_parent;
+    if (m_logger == nullptr)
+    {
+      return;
+    }
+
+    try
+    {
+      using log_type = typename LoggerType::log_type;
+      log_type log{m_name, m_start};
+      log.reserve(log.size() + 4);
+      log.emplace_back(Span::duration_key(), end - m_start);
+      log.emplace_back(Span::id_key(), m_id);
+      log.emplace_back(Span::parent_key(), m_parent);
+      // A ThreadEventLog has already recorded the thread.
+      if constexpr (!std::is_base_of_v<ThreadEventLog, log_type>)
+      {
+        log.emplace_back(Span::thread_key(), m_state->thread_id);
+      }
+      m_logger->insert(std::move(log), m_priority);
+    }
+    catch (...)
+    {
+      // Destructors must not throw, so a span that cannot be stored is dropped.
+    }
+  }
+}
+
+template <typename LoggerType, typename ClockPolicy>
+inline bool ScopedSpan<LoggerType, ClockPolicy>::active() const noexcept
+{
+  return m_logger != nullptr;
+}
+
+template <typename LoggerType, typename ClockPolicy>
+inline void ScopedSpan<LoggerType, ClockPolicy>::cancel() noexcept
+{
+  m_logger = nullptr;
+}
+
+template <typename LoggerType, typename ClockPolicy>
+inline auto ScopedSpan<LoggerType, ClockPolicy>::elapsed() const noexcept -> duration
+{
+  return active() ? ClockPolicy::now() - m_start : duration{};
+}
+
+}  // namespace Feller
+
+#define FELLER_SPAN_CONCAT_IMPL(a, b) a##b
+#define FELLER_SPAN_CONCAT(a, b) FELLER_SPAN_CONCAT_IMPL(a, b)
+
+/**
+   FELLER_SCOPED_SPAN. This macro times the rest of the enclosing scope, inserting a span named
+   `name` into `logger` when the scope ends (see \ref ScopedSpan). The name is interned once per
+   call site, rather than every time the span is built. For example:
+
+   void parse(const std::string &input)
+   {
+     FELLER_SCOPED_SPAN(logger, "parse");
+     ...
+   }
+**/
+#define FELLER_SCOPED_SPAN(logger, name)                                                           \
+  static const Feller::InternedString FELLER_SPAN_CONCAT(feller_span_name_, __LINE__){name};       \
+  const Feller::ScopedSpan<std::decay_t<decltype(logger)>> FELLER_SPAN_CONCAT(                     \
+      feller_span_, __LINE__){(logger), FELLER_SPAN_CONCAT(feller_span_name_, __LINE__)}
+
+#endif
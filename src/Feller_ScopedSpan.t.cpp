@@ -0,0 +1,226 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_ScopedSpan.hpp"
+#include "Feller_ConditionalLoggingPolicy.hpp"
+#include "Feller_ContiguousLogStorage.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_LogEverything.hpp"
+#include "Feller_LogNothing.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_NoLock.hpp"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+using LoggerType = Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage,
+                                  Feller::NoLock, Feller::LogEverything>;
+using Duration   = Feller::ParameterValue::duration;
+
+static const Feller::ParameterValue &parameter(const Feller::EventLog &log,
+                                                const Feller::InternedString key)
+{
+  for (auto it = log.cbegin(); it != log.cend(); ++it)
+  {
+    if (it->first == key)
+    {
+      return it->second;
+    }
+  }
+  ADD_FAILURE() << "The log has no " << key.str();
+  static const Feller::ParameterValue none;
+  return none;
+}
+
+static Duration duration_of(const Feller::EventLog &log)
+{
+  const auto *const duration = parameter(log, Feller::Span::duration_key()).get_if<Duration>();
+  return duration == nullptr ? Duration{} : *duration;
+}
+
+static std::uint64_t id_of(const Feller::EventLog &log, const Feller::InternedString key)
+{
+  const auto *const id = parameter(log, key).get_if<std::uint64_t>();
+  return id == nullptr ? 0 : *id;
+}
+
+TEST(ScopedSpan, testRecordsDuration)
+{
+  LoggerType logger;
+  const auto before = std::chrono::system_clock::now();
+  {
+    Feller::ScopedSpan<LoggerType> span{logger, "sleep"};
+    EXPECT_TRUE(span.active());
+    std::this_thread::sleep_for(std::chrono::milliseconds{2});
+    EXPECT_GE(span.elapsed(), std::chrono::milliseconds{2});
+    // Nothing is inserted until the span ends.
+    EXPECT_EQ(logger.size(), 0);
+  }
+  const auto after = std::chrono::system_clock::now();
+
+  ASSERT_EQ(logger.size(), 1);
+  const auto &log = *logger.cbegin();
+  EXPECT_EQ(log.name(), "sleep");
+  EXPECT_GE(duration_of(log), std::chrono::milliseconds{2});
+  EXPECT_LE(duration_of(log), after - before);
+  // The start time comes from a steady clock, so it is only close to the system clock.
+  EXPECT_GE(log.time(), before - std::chrono::milliseconds{50});
+  EXPECT_LE(log.time(), after + std::chrono::milliseconds{50});
+}
+
+TEST(ScopedSpan, testNested)
+{
+  LoggerType logger;
+  {
+    Feller::ScopedSpan<LoggerType> outer{logger, "outer"};
+    {
+      Feller::ScopedSpan<LoggerType> inner{logger, "inner"};
+    }
+  }
+
+  // Spans are inserted as they end, so the inner span comes first.
+  ASSERT_EQ(logger.size(), 2);
+  const auto &inner = *logger.cbegin();
+  const auto &outer = *(logger.cbegin() + 1);
+  EXPECT_EQ(inner.name(), "inner");
+  EXPECT_EQ(outer.name(), "outer");
+  EXPECT_LE(outer.time(), inner.time());
+  EXPECT_GE(duration_of(outer), duration_of(inner));
+}
+
+TEST(ScopedSpan, testHierarchy)
+{
+  LoggerType logger;
+  std::uint64_t outer_id = 0;
+  {
+    Feller::ScopedSpan<LoggerType> outer{logger, "outer"};
+    outer_id = outer.id();
+    EXPECT_EQ(outer.parent(), 0);
+    {
+      Feller::ScopedSpan<LoggerType> first{logger, "first"};
+      EXPECT_EQ(first.parent(), outer_id);
+      // A cancelled span is still the parent of the spans inside it.
+      first.cancel();
+      Feller::ScopedSpan<LoggerType> nested{logger, "nested"};
+      EXPECT_EQ(nested.parent(), first.id());
+    }
+    Feller::ScopedSpan<LoggerType> second{logger, "second"};
+    EXPECT_EQ(second.parent(), outer_id);
+  }
+  Feller::ScopedSpan<LoggerType> root{logger, "root"};
+  EXPECT_EQ(root.parent(), 0);
+
+  ASSERT_EQ(logger.size(), 3);
+  const auto thread = Feller::Span::thread_state().thread_id;
+  for (const auto &log : logger)
+  {
+    EXPECT_EQ(id_of(log, Feller::Span::thread_key()), thread);
+  }
+  EXPECT_EQ(id_of(*(logger.cbegin() + 1), Feller::Span::parent_key()), outer_id);
+  EXPECT_EQ(id_of(*(logger.cbegin() + 2), Feller::Span::id_key()), outer_id);
+  EXPECT_EQ(id_of(*(logger.cbegin() + 2), Feller::Span::parent_key()), 0);
+}
+
+TEST(ScopedSpan, testThreads)
+{
+  // Each thread has its own id and its own tree of spans.
+  LoggerType logger;
+  LoggerType other;
+  Feller::ScopedSpan<LoggerType> outer{logger, "outer"};
+  std::thread thread([&other] { Feller::ScopedSpan<LoggerType> span{other, "thread"}; });
+  thread.join();
+
+  ASSERT_EQ(other.size(), 1);
+  const auto &log = *other.cbegin();
+  EXPECT_EQ(id_of(log, Feller::Span::parent_key()), 0);
+  EXPECT_NE(id_of(log, Feller::Span::thread_key()), Feller::Span::thread_state().thread_id);
+  EXPECT_NE(id_of(log, Feller::Span::id_key()), outer.id());
+}
+
+TEST(ScopedSpan, testCancel)
+{
+  LoggerType logger;
+  {
+    Feller::ScopedSpan<LoggerType> span{logger, "cancelled"};
+    span.cancel();
+    EXPECT_FALSE(span.active());
+    EXPECT_EQ(span.elapsed(), Duration{});
+  }
+  EXPECT_EQ(logger.size(), 0);
+}
+
+TEST(ScopedSpan, testPriority)
+{
+  using Conditional = Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage,
+                                     Feller::NoLock, Feller::ConditionalLoggingPolicy>;
+  Conditional logger;
+  logger.switchMode(Feller::LoggingMode::IMPORTANT);
+  {
+    Feller::ScopedSpan<Conditional> filtered{logger, "filtered"};
+    Feller::ScopedSpan<Conditional> kept{logger, "kept", Feller::LoggingMode::IMPORTANT};
+    EXPECT_FALSE(filtered.active());
+    EXPECT_TRUE(kept.active());
+  }
+
+  ASSERT_EQ(logger.size(), 1);
+  EXPECT_EQ(logger.cbegin()->name(), "kept");
+}
+
+TEST(ScopedSpan, testLogNothing)
+{
+  using Nothing = Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage,
+                                 Feller::NoLock, Feller::LogNothing>;
+  static_assert(!Feller::ScopedSpan<Nothing>::enabled);
+  static_assert(Feller::ScopedSpan<LoggerType>::enabled);
+
+  Nothing logger;
+  {
+    Feller::ScopedSpan<Nothing> span{logger, "nothing"};
+    EXPECT_FALSE(span.active());
+  }
+  EXPECT_EQ(logger.size(), 0);
+}
+
+TEST(ScopedSpan, testOtherClock)
+{
+  LoggerType logger;
+  {
+    Feller::ScopedSpan<LoggerType, Feller::TscClock> span{logger, "tsc"};
+  }
+  ASSERT_EQ(logger.size(), 1);
+  EXPECT_GE(duration_of(*logger.cbegin()), Duration{});
+}
+
+static void timed(LoggerType &logger)
+{
+  FELLER_SCOPED_SPAN(logger, "timed");
+  FELLER_SCOPED_SPAN(logger, "also timed");
+}
+
+TEST(ScopedSpan, testMacro)
+{
+  LoggerType logger;
+  timed(logger);
+  timed(logger);
+
+  ASSERT_EQ(logger.size(), 4);
+  EXPECT_EQ(logger.cbegin()->name(), "also timed");
+  EXPECT_EQ((logger.cbegin() + 1)->name(), "timed");
+}
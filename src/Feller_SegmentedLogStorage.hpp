@@ -0,0 +1,478 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_SEGMENTED_LOG_STORAGE
+#define INCLUDED_FELLER_SEGMENTED_LOG_STORAGE
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "Feller_Feller.hpp"
+
+namespace Feller
+{
+/**
+ SegmentedLogStorage. This class implements a container that stores particular logs in a series of
+fixed-size blocks. Each block holds `block_size` logs (a power of two), and blocks are only
+allocated when the previous block is full. Unlike \ref ContiguousLogStorage, this class never moves
+or copies a log once it has been inserted: growing the store only allocates a new block and appends
+a pointer to the block table. This means that appending has no latency spikes and that the address
+of each log is stable for the lifetime of the log.
+
+ Logs are addressed by index: the top bits of the index select the block, and the bottom bits
+select the log within the block. As a result this class provides random-access iterators.
+
+ \tparam LogType: the type of log to be stored in this class.
+ \tparam KeyType: not used in this class.
+**/
+template <typename LogType, typename KeyType = char /*unused*/> class SegmentedLogStorage
+{
+private:
+  /**
+     Element. This struct provides uninitialised storage for a single log. Logs are constructed
+  in place when they are inserted.
+  **/
+  struct Element
+  {
+    alignas(LogType) unsigned char bytes[sizeof(LogType)];
+  };
+
+public:
+  /**
+     size_type. This type is used to represent sizes and indices in this object.
+  **/
+  using size_type = std::size_t;
+
+  /**
+     block_shift. This is the base two logarithm of the number of logs held in each block.
+  **/
+  static constexpr size_type block_shift = 10;
+
+  /**
+     block_size. This is the number of logs held in each block.
+  **/
+  static constexpr size_type block_size = size_type{1} << block_shift;
+
+  /**
+     const_iterator. This class provides random access to the logs in this object.
+  **/
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = LogType;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const LogType *;
+    using reference         = const LogType &;
+
+    const_iterator() = default;
+
+    reference operator*() const { return (*m_storage)[static_cast<size_type>(m_index)]; }
+    pointer operator->() const { return &**this; }
+    reference operator[](const difference_type n) const { return *(*this + n); }
+
+    const_iterator &operator++()
+    {
+      ++m_index;
+      return *this;
+    }
+
+    const_iterator operator++(int)
+    {
+      auto tmp = *this;
+      ++m_index;
+      return tmp;
+    }
+
+    const_iterator &operator--()
+    {
+      --m_index;
+      return *this;
+    }
+
+    const_iterator operator--(int)
+    {
+      auto tmp = *this;
+      --m_index;
+      return tmp;
+    }
+
+    const_iterator &operator+=(const difference_type n)
+    {
+      m_index += n;
+      return *this;
+    }
+
+    const_iterator &operator-=(const difference_type n)
+    {
+      m_index -= n;
+      return *this;
+    }
+
+    friend const_iterator operator+(const_iterator it, const difference_type n) { return it += n; }
+    friend const_iterator operator+(const difference_type n, const_iterator it) { return it += n; }
+    friend const_iterator operator-(const_iterator it, const difference_type n) { return it -= n; }
+    friend difference_type operator-(const const_iterator &lhs, const const_iterator &rhs)
+    {
+      return lhs.m_index - rhs.m_index;
+    }
+
+    friend bool operator==(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return lhs.m_storage == rhs.m_storage && lhs.m_index == rhs.m_index;
+    }
+    friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return !(lhs == rhs);
+    }
+    friend bool operator<(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return lhs.m_index < rhs.m_index;
+    }
+    friend bool operator>(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return rhs < lhs;
+    }
+    friend bool operator<=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return !(rhs < lhs);
+    }
+    friend bool operator>=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return !(lhs < rhs);
+    }
+
+  private:
+    friend class SegmentedLogStorage;
+    const_iterator(const SegmentedLogStorage *storage, const difference_type index)
+        : m_storage{storage}, m_index{index}
+    {
+    }
+
+    const SegmentedLogStorage *m_storage{nullptr};
+    difference_type m_index{0};
+  };
+
+  // CONSTRUCTORS
+
+  /**
+     SegmentedLogStorage(). This is the default constructor for this class. No blocks are
+  allocated until the first insertion.
+  **/
+  SegmentedLogStorage() = default;
+
+  /**
+     SegmentedLogStorage(const SegmentedLogStorage &other). This constructor copies each log in
+  `other` into this object. This method may throw.
+     \param other: the store to be copied.
+  **/
+  SegmentedLogStorage(const SegmentedLogStorage &other);
+
+  /**
+     SegmentedLogStorage(SegmentedLogStorage &&other). This constructor takes ownership of the
+  blocks in `other`. No logs are moved or copied.
+     \param other: the store to be moved from.
+  **/
+  SegmentedLogStorage(SegmentedLogStorage &&other) noexcept;
+
+  /**
+     operator=. This implements the copy assignment operator via copy-and-swap.
+     \param other: the store to be copied.
+     \return a reference to ``this`` object.
+  **/
+  SegmentedLogStorage &operator=(const SegmentedLogStorage &other);
+
+  /**
+     operator=. This implements the move assignment operator.
+     \param other: the store to be moved from.
+     \return a reference to ``this`` object.
+  **/
+  SegmentedLogStorage &operator=(SegmentedLogStorage &&other) noexcept;
+
+  /**
+     ~SegmentedLogStorage. This destroys each log in this object and frees every block.
+  **/
+  ~SegmentedLogStorage();
+
+  // MODIFIERS
+
+  /**
+     insert. This method copies the `log` into this object. This function is required for use
+  inside other classes, such as \ref Logger. This function may throw.
+     \param log: the log to be copied into this object.
+  **/
+  inline void insert(const LogType &log);
+
+  /**
+     insert. This method moves the `log` into this object. This function is required for use
+  inside other classes, such as \ref Logger. This function may throw.
+     \param log: the log to be moved into this object.
+  **/
+  inline void insert(LogType &&log);
+
+  /**
+     emplace_back. This method constructs a new log at the end of this object from `args`.
+  No existing logs are moved. This method may throw: in this case, this object is unchanged.
+     \param args: the arguments to be forwarded to the constructor of the log.
+     \return a reference to the new log.
+  **/
+  template <typename... Args> inline LogType &emplace_back(Args &&...args);
+
+  /**
+     clear. This method destroys every log in this object. The blocks themselves are retained,
+  in keeping with the contract of std::vector::clear.
+  **/
+  inline void clear() noexcept;
+
+  // ACCESSORS
+
+  /**
+     operator[]. This method returns a reference to the log at position `index`. The behaviour of
+  this function is undefined if `index >= size()`.
+     \param index: the position of the log.
+     \return a const reference to the log.
+  **/
+  inline const LogType &operator[](const size_type index) const noexcept;
+
+  /**
+     size. This method returns the number of logs in this object.
+     \return the number of logs in this object.
+  **/
+  inline size_type size() const noexcept;
+
+  /**
+     capacity. This method returns the number of logs that can be held without allocating.
+     \return the capacity of this object.
+  **/
+  inline size_type capacity() const noexcept;
+
+  /**
+     empty. This method returns true if there are no logs in this object.
+     \return true if this object is empty, false otherwise.
+  **/
+  inline bool empty() const noexcept;
+
+  /**
+     cbegin. This method returns a const iterator to the first log in this object.
+     \return a const iterator to the first log.
+  **/
+  inline const_iterator cbegin() const noexcept;
+
+  /**
+     cend. This method returns a const iterator to one past the last log in this object.
+     \return a const iterator to the end of the logs.
+  **/
+  inline const_iterator cend() const noexcept;
+
+  /// Overloads of cbegin and cend to allow range-based for loops.
+  inline const_iterator begin() const noexcept;
+  inline const_iterator end() const noexcept;
+
+  /**
+      operator<<. Prints a string representation of the object ``st`` to the
+      specified ostream ``os`. This method may throw.
+      \tparam LT: the type stored in st.
+      \param os: the stream to print the storage object to.
+      \param st: the object to be printed.
+      \return the os parameter.
+   **/
+  template <typename LT, typename KT>
+  inline friend std::ostream &operator<<(std::ostream &os, const SegmentedLogStorage<LT, KT> &st);
+
+private:
+  /**
+     address. This method returns the address of the slot at position `index`.
+     \param index: the position of the slot.
+     \return a pointer to the slot. This slot may not hold a live log.
+  **/
+  inline LogType *address(const size_type index) const noexcept;
+
+  /**
+     m_blocks. This is the block table. Each block holds `block_size` slots.
+  **/
+  std::vector<std::unique_ptr<Element[]>> m_blocks{};
+
+  /**
+     m_size. This is the number of live logs in this object.
+  **/
+  size_type m_size{0};
+};
+
+/// INLINE FUNCTIONS
+template <typename LogType, typename KeyType>
+Feller::SegmentedLogStorage<LogType, KeyType>::SegmentedLogStorage(const SegmentedLogStorage &other)
+    : m_blocks{}, m_size{0}
+{
+  for (const auto &log : other)
+  {
+    emplace_back(log);
+  }
+}
+
+template <typename LogType, typename KeyType>
+Feller::SegmentedLogStorage<LogType, KeyType>::SegmentedLogStorage(
+    SegmentedLogStorage &&other) noexcept
+    : m_blocks{std::move(other.m_blocks)}, m_size{other.m_size}
+{
+  other.m_blocks.clear();
+  other.m_size = 0;
+}
+
+template <typename LogType, typename KeyType>
+auto Feller::SegmentedLogStorage<LogType, KeyType>::operator=(const SegmentedLogStorage &other)
+    -> SegmentedLogStorage &
+{
+  SegmentedLogStorage tmp{other};
+  *this = std::move(tmp);
+  return *this;
+}
+
+template <typename LogType, typename KeyType>
+auto Feller::SegmentedLogStorage<LogType, KeyType>::operator=(SegmentedLogStorage &&other) noexcept
+    -> SegmentedLogStorage &
+{
+  if (this != &other)
+  {
+    clear();
+    m_blocks.swap(other.m_blocks);
+    std::swap(m_size, other.m_size);
+  }
+  return *this;
+}
+
+template <typename LogType, typename KeyType>
+Feller::SegmentedLogStorage<LogType, KeyType>::~SegmentedLogStorage()
+{
+  clear();
+}
+
+template <typename LogType, typename KeyType>
+inline std::ostream &operator<<(std::ostream &os, const SegmentedLogStorage<LogType, KeyType> &st)
+{
+  for (auto &v : st)
+  {
+    os << v;
+  }
+  return os;
+}
+
+template <typename LogType, typename KeyType>
+inline LogType *
+Feller::SegmentedLogStorage<LogType, KeyType>::address(const size_type index) const noexcept
+{
+  auto &element = m_blocks[index >> block_shift][index & (block_size - 1)];
+  return std::launder(reinterpret_cast<LogType *>(element.bytes));
+}
+
+template <typename LogType, typename KeyType>
+template <typename... Args>
+inline LogType &Feller::SegmentedLogStorage<LogType, KeyType>::emplace_back(Args &&...args)
+{
+  if (m_size == capacity())
+  {
+    // NB we deliberately avoid make_unique here, as it would zero the whole block.
+    std::unique_ptr<Element[]> block{new Element[block_size]};
+    m_blocks.push_back(std::move(block));
+  }
+
+  auto *log = ::new (static_cast<void *>(address(m_size))) LogType(std::forward<Args>(args)...);
+  ++m_size;
+  return *log;
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::SegmentedLogStorage<LogType, KeyType>::insert(const LogType &log)
+{
+  emplace_back(log);
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::SegmentedLogStorage<LogType, KeyType>::insert(LogType &&log)
+{
+  emplace_back(std::move(log));
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::SegmentedLogStorage<LogType, KeyType>::clear() noexcept
+{
+  for (size_type i = 0; i < m_size; i++)
+  {
+    address(i)->~LogType();
+  }
+  m_size = 0;
+}
+
+template <typename LogType, typename KeyType>
+inline const LogType &
+Feller::SegmentedLogStorage<LogType, KeyType>::operator[](const size_type index) const noexcept
+{
+  return *address(index);
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::SegmentedLogStorage<LogType, KeyType>::size() const noexcept -> size_type
+{
+  return m_size;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::SegmentedLogStorage<LogType, KeyType>::capacity() const noexcept -> size_type
+{
+  return m_blocks.size() * block_size;
+}
+
+template <typename LogType, typename KeyType>
+inline bool Feller::SegmentedLogStorage<LogType, KeyType>::empty() const noexcept
+{
+  return m_size == 0;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::SegmentedLogStorage<LogType, KeyType>::cbegin() const noexcept
+    -> const_iterator
+{
+  return const_iterator{this, 0};
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::SegmentedLogStorage<LogType, KeyType>::cend() const noexcept -> const_iterator
+{
+  return const_iterator{this, static_cast<typename const_iterator::difference_type>(m_size)};
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::SegmentedLogStorage<LogType, KeyType>::begin() const noexcept
+    -> const_iterator
+{
+  return cbegin();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::SegmentedLogStorage<LogType, KeyType>::end() const noexcept -> const_iterator
+{
+  return cend();
+}
+
+}  // namespace Feller
+
+#endif
@@ -0,0 +1,169 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "Feller_SegmentedLogStorage.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_NoLock.hpp"
+#include "Feller_LogEverything.hpp"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+TEST(SegmentedLogStorage, testInit)
+{
+  Feller::SegmentedLogStorage<int> log;
+  EXPECT_EQ(log.size(), 0);
+  EXPECT_EQ(log.capacity(), 0);
+  EXPECT_EQ(log.empty(), true);
+  EXPECT_EQ(log.cbegin(), log.cend());
+}
+
+TEST(SegmentedLogStorage, testInsert)
+{
+  Feller::SegmentedLogStorage<int> log;
+  const auto c = static_cast<int>(rand());
+  log.insert(c);
+  EXPECT_EQ(log.size(), 1);
+  EXPECT_EQ(log.capacity(), Feller::SegmentedLogStorage<int>::block_size);
+  EXPECT_EQ(log[0], c);
+}
+
+TEST(SegmentedLogStorage, testInsertMove)
+{
+  // Note; this uses string because int is trivially copiable (and thus
+  // moving it has no effect).
+  Feller::SegmentedLogStorage<std::string> log;
+  std::string c = "abcdef";
+  auto d        = c;
+  log.insert(std::move(c));
+  EXPECT_EQ(log.size(), 1);
+  EXPECT_EQ(log[0], d);
+}
+
+TEST(SegmentedLogStorage, testAddressesAreStable)
+{
+  // Growing across several blocks must never move an existing log.
+  Feller::SegmentedLogStorage<std::string> log;
+  const auto &first = log.emplace_back("first");
+  const auto *addr  = &first;
+  const auto size   = 4 * Feller::SegmentedLogStorage<std::string>::block_size;
+  for (unsigned i = 1; i < size; i++)
+  {
+    log.emplace_back(std::to_string(i));
+  }
+
+  EXPECT_EQ(&log[0], addr);
+  EXPECT_EQ(log[0], "first");
+  EXPECT_EQ(log.size(), size);
+  EXPECT_EQ(log.capacity(), size);
+}
+
+TEST(SegmentedLogStorage, testRandomAccess)
+{
+  Feller::SegmentedLogStorage<unsigned> log;
+  const auto size = 1 + static_cast<unsigned>(rand()) % 4096;
+  for (unsigned i = 0; i < size; i++)
+  {
+    log.insert(i);
+  }
+
+  ASSERT_EQ(std::distance(log.cbegin(), log.cend()), size);
+  auto it = log.cbegin();
+  for (unsigned i = 0; i < size; i++)
+  {
+    EXPECT_EQ(it[i], i);
+    EXPECT_EQ(*(log.cbegin() + i), i);
+  }
+
+  EXPECT_EQ(*(log.cend() - 1), size - 1);
+  EXPECT_EQ(log.cbegin() < log.cend(), true);
+  EXPECT_EQ(std::is_sorted(log.cbegin(), log.cend()), true);
+  EXPECT_EQ(std::lower_bound(log.cbegin(), log.cend(), size / 2) - log.cbegin(), size / 2);
+}
+
+TEST(SegmentedLogStorage, testClear)
+{
+  Feller::SegmentedLogStorage<std::string> log;
+  for (unsigned i = 0; i < 2000; i++)
+  {
+    log.insert("abc");
+  }
+
+  const auto capacity = log.capacity();
+  log.clear();
+  EXPECT_EQ(log.size(), 0);
+  EXPECT_EQ(log.capacity(), capacity);
+  log.insert("def");
+  EXPECT_EQ(log[0], "def");
+}
+
+TEST(SegmentedLogStorage, testCopyAndMove)
+{
+  Feller::SegmentedLogStorage<std::string> log;
+  for (unsigned i = 0; i < 2000; i++)
+  {
+    log.insert(std::to_string(i));
+  }
+
+  auto copy = log;
+  ASSERT_EQ(copy.size(), log.size());
+  EXPECT_EQ(std::equal(copy.cbegin(), copy.cend(), log.cbegin()), true);
+
+  const auto *addr = &log[0];
+  auto moved       = std::move(log);
+  EXPECT_EQ(&moved[0], addr);
+  EXPECT_EQ(moved.size(), copy.size());
+  EXPECT_EQ(log.size(), 0);
+
+  log = copy;
+  EXPECT_EQ(log.size(), copy.size());
+  EXPECT_EQ(std::equal(copy.cbegin(), copy.cend(), log.cbegin()), true);
+}
+
+TEST(SegmentedLogStorage, testOstream)
+{
+  Feller::SegmentedLogStorage<int> log;
+  const auto size = static_cast<unsigned>(rand()) % 4096;
+
+  std::string curr;
+
+  for (unsigned i = 0; i < size; i++)
+  {
+    const auto c = static_cast<int>(rand());
+    log.insert(c);
+    curr += std::to_string(c);
+  }
+
+  std::ostringstream os;
+  os << log;
+  EXPECT_EQ(os.str(), curr);
+}
+
+TEST(SegmentedLogStorage, testLogger)
+{
+  Feller::Logger<Feller::EventLog, char, Feller::SegmentedLogStorage, Feller::NoLock,
+                 Feller::LogEverything>
+      logger;
+  Feller::EventLog l{"Test"};
+  l.emplace_back("abc", "def");
+  logger.insert(l);
+  EXPECT_EQ(logger.size(), 1);
+  EXPECT_EQ(*(logger.cbegin()), l);
+}
@@ -0,0 +1,472 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_SHARDED_LOG_STORAGE
+#define INCLUDED_FELLER_SHARDED_LOG_STORAGE
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "Feller_Feller.hpp"
+
+namespace Feller
+{
+/**
+ ShardedLogStorage. This class implements a container that stores particular logs in per-thread
+shards. Briefly, each thread that inserts into this object is given its own vector of logs (a
+shard), and every subsequent insertion from that thread is a plain push_back onto that vector with
+no synchronisation at all. Since each shard lives on its own cache lines, threads never contend
+with each other on the hot path. The only synchronisation happens the first time a thread inserts
+into a particular object, as the shard must be registered.
+
+ Readers see a single, time-ordered view of every shard. This view is built lazily on read via a
+k-way merge on the `time()` of each log: logs from the same thread keep their insertion order, and
+ties between threads are broken by the order in which the threads first inserted.
+
+ Note that the reading side of this class (i.e `size`, `cbegin`, `cend` and `clear`) is not safe to
+call concurrently with insertions. In practice this means that the store should only be read once
+all writers have finished (e.g after joining the writing threads).
+
+ \tparam LogType: the type of log to be stored in this class. This type must provide a `time()`
+ method that returns something that is ordered by `<`.
+ \tparam KeyType: not used in this class.
+**/
+template <typename LogType, typename KeyType = char /*unused*/> class ShardedLogStorage
+{
+public:
+  /**
+     size_type. This type is used to represent sizes in this object.
+  **/
+  using size_type = std::size_t;
+
+private:
+  /**
+     Shard. This struct represents the logs inserted by a single thread. Each shard is
+  separately allocated and aligned to a cache line, so that no two threads write to the same line.
+  **/
+  struct alignas(64) Shard
+  {
+    /// owner. This is the thread that inserts into this shard.
+    std::thread::id owner{};
+    /// logs. These are the logs inserted by `owner`, in insertion order.
+    std::vector<LogType> logs{};
+    /// merged. This is the number of logs in this shard that are in the merged view.
+    size_type merged{0};
+  };
+
+  /**
+     Position. This struct locates a single log inside the shards.
+  **/
+  struct Position
+  {
+    size_type shard;
+    size_type index;
+  };
+
+public:
+  /**
+     const_iterator. This class iterates over the logs in this object in time order.
+     Dereferencing this iterator gives direct access to the log in its shard: no copies are made.
+  **/
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = LogType;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const LogType *;
+    using reference         = const LogType &;
+
+    const_iterator() = default;
+
+    reference operator*() const
+    {
+      const auto &position = m_storage->m_order[m_index];
+      return m_storage->m_shards[position.shard]->logs[position.index];
+    }
+
+    pointer operator->() const { return &**this; }
+
+    const_iterator &operator++()
+    {
+      ++m_index;
+      return *this;
+    }
+
+    const_iterator operator++(int)
+    {
+      auto tmp = *this;
+      ++m_index;
+      return tmp;
+    }
+
+    friend bool operator==(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return lhs.m_storage == rhs.m_storage && lhs.m_index == rhs.m_index;
+    }
+
+    friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+    {
+      return !(lhs == rhs);
+    }
+
+  private:
+    friend class ShardedLogStorage;
+    const_iterator(const ShardedLogStorage *storage, const size_type index)
+        : m_storage{storage}, m_index{index}
+    {
+    }
+
+    const ShardedLogStorage *m_storage{nullptr};
+    size_type m_index{0};
+  };
+
+  /**
+     ShardedLogStorage. This constructor builds an empty store with no shards. Each store is
+  given a unique identifier, which is used by threads to cache their shard.
+  **/
+  ShardedLogStorage();
+
+  /**
+     insert. This method copies `log` into the calling thread's shard. This method is safe to call
+  from many threads at once. This function may throw due to allocation failures.
+     \param log: the log to be copied into this object.
+  **/
+  inline void insert(const LogType &log);
+
+  /**
+     insert. This method moves `log` into the calling thread's shard. This method is safe to call
+  from many threads at once. This function may throw due to allocation failures.
+     \param log: the log to be moved into this object.
+  **/
+  inline void insert(LogType &&log);
+
+  /**
+     emplace_back. This method constructs a log from `args` directly in the calling thread's
+  shard. This method is safe to call from many threads at once.
+     \param args: the arguments to be forwarded to the constructor of the log.
+  **/
+  template <typename... Args> inline void emplace_back(Args &&...args);
+
+  /**
+     size. This method returns the number of logs across all shards in this object.
+     \return the number of logs in this object.
+  **/
+  inline size_type size() const;
+
+  /**
+     shards. This method returns the number of threads that have inserted into this object.
+     \return the number of shards in this object.
+  **/
+  inline size_type shards() const;
+
+  /**
+     cbegin. This method returns a const iterator to the earliest log in this object.
+     This method merges any new logs into the time-ordered view, and so it may throw.
+     \return a const iterator to the first log.
+  **/
+  inline const_iterator cbegin() const;
+
+  /**
+     cend. This method returns a const iterator to one past the latest log in this object.
+     This method merges any new logs into the time-ordered view, and so it may throw.
+     \return a const iterator to the end of the logs.
+  **/
+  inline const_iterator cend() const;
+
+  /// Overloads of cbegin and cend to allow range-based for loops.
+  inline const_iterator begin() const;
+  inline const_iterator end() const;
+
+  /**
+     clear. This method removes every log from every shard. The shards themselves (and their
+  memory) are retained for re-use.
+  **/
+  inline void clear();
+
+  /**
+      operator<<. Prints a string representation of the object ``st`` to the
+      specified ostream ``os`. This method may throw.
+      \tparam LT: the type stored in st.
+      \param os: the stream to print the storage object to.
+      \param st: the object to be printed.
+      \return the os parameter.
+   **/
+  template <typename LT, typename KT>
+  inline friend std::ostream &operator<<(std::ostream &os, const ShardedLogStorage<LT, KT> &st);
+
+private:
+  /**
+     local_shard. This method returns the shard of the calling thread, creating it if necessary.
+  The shard is cached in a thread_local variable, so this method only synchronises on the first
+  insertion from each thread.
+     \return the calling thread's shard.
+  **/
+  inline Shard &local_shard();
+
+  /**
+     merge. This method merges any logs that are not yet in the time-ordered view into it.
+  The caller must hold `m_registry`.
+  **/
+  inline void merge() const;
+
+  /**
+     earlier. This method returns true if the log at `lhs` happened strictly before `rhs`.
+  **/
+  inline bool earlier(const Position &lhs, const Position &rhs) const;
+
+  /**
+     next_id. This method returns a new, unique identifier for a store. Identifiers are never
+  re-used, so stale thread caches can never match a newly created store.
+  **/
+  static inline std::uint64_t next_id() noexcept;
+
+  /**
+     m_id. This is the unique identifier of this store.
+  **/
+  const std::uint64_t m_id;
+
+  /**
+     m_registry. This mutex guards the list of shards and the time-ordered view.
+  **/
+  mutable std::mutex m_registry{};
+
+  /**
+     m_shards. This holds one shard for each thread that has inserted into this store.
+  **/
+  std::vector<std::unique_ptr<Shard>> m_shards{};
+
+  /**
+     m_order. This is the time-ordered view of all merged logs.
+  **/
+  mutable std::vector<Position> m_order{};
+};
+
+/// INLINE FUNCTIONS
+template <typename LogType, typename KeyType>
+Feller::ShardedLogStorage<LogType, KeyType>::ShardedLogStorage() : m_id{next_id()}
+{
+}
+
+template <typename LogType, typename KeyType>
+inline std::uint64_t Feller::ShardedLogStorage<LogType, KeyType>::next_id() noexcept
+{
+  static std::atomic<std::uint64_t> counter{0};
+  return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+template <typename LogType, typename KeyType>
+inline std::ostream &operator<<(std::ostream &os, const ShardedLogStorage<LogType, KeyType> &st)
+{
+  for (auto &v : st)
+  {
+    os << v;
+  }
+  return os;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ShardedLogStorage<LogType, KeyType>::local_shard() -> Shard &
+{
+  struct Cache
+  {
+    std::uint64_t id{0};
+    Shard *shard{nullptr};
+  };
+  static thread_local Cache cache;
+
+  if (cache.id == m_id)
+  {
+    return *cache.shard;
+  }
+
+  std::lock_guard<std::mutex> guard{m_registry};
+  const auto me = std::this_thread::get_id();
+  Shard *shard  = nullptr;
+  for (auto &s : m_shards)
+  {
+    if (s->owner == me)
+    {
+      shard = s.get();
+      break;
+    }
+  }
+
+  if (shard == nullptr)
+  {
+    m_shards.push_back(std::make_unique<Shard>());
+    shard        = m_shards.back().get();
+    shard->owner = me;
+  }
+
+  cache.id    = m_id;
+  cache.shard = shard;
+  return *shard;
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::ShardedLogStorage<LogType, KeyType>::insert(const LogType &log)
+{
+  local_shard().logs.push_back(log);
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::ShardedLogStorage<LogType, KeyType>::insert(LogType &&log)
+{
+  local_shard().logs.push_back(std::move(log));
+}
+
+template <typename LogType, typename KeyType>
+template <typename... Args>
+inline void Feller::ShardedLogStorage<LogType, KeyType>::emplace_back(Args &&...args)
+{
+  local_shard().logs.emplace_back(std::forward<Args>(args)...);
+}
+
+template <typename LogType, typename KeyType>
+inline bool Feller::ShardedLogStorage<LogType, KeyType>::earlier(const Position &lhs,
+                                                                 const Position &rhs) const
+{
+  return m_shards[lhs.shard]->logs[lhs.index].time() < m_shards[rhs.shard]->logs[rhs.index].time();
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::ShardedLogStorage<LogType, KeyType>::merge() const
+{
+  // Each shard is already in time order, so we only need a k-way merge of the unmerged tails.
+  // The heap is ordered so that the earliest head is on top, with ties going to the lowest shard.
+  const auto later = [this](const size_type lhs, const size_type rhs) {
+    const Position l{lhs, m_shards[lhs]->merged};
+    const Position r{rhs, m_shards[rhs]->merged};
+    return earlier(r, l) || (!earlier(l, r) && lhs > rhs);
+  };
+
+  std::vector<size_type> heap;
+  for (size_type i = 0; i < m_shards.size(); i++)
+  {
+    if (m_shards[i]->merged < m_shards[i]->logs.size())
+    {
+      heap.push_back(i);
+    }
+  }
+
+  if (heap.empty())
+  {
+    return;
+  }
+
+  const auto old = m_order.size();
+  std::make_heap(heap.begin(), heap.end(), later);
+  while (!heap.empty())
+  {
+    std::pop_heap(heap.begin(), heap.end(), later);
+    auto &shard = *m_shards[heap.back()];
+    m_order.push_back(Position{heap.back(), shard.merged});
+    ++shard.merged;
+
+    if (shard.merged < shard.logs.size())
+    {
+      std::push_heap(heap.begin(), heap.end(), later);
+    }
+    else
+    {
+      heap.pop_back();
+    }
+  }
+
+  // The new run may overlap with the logs that were merged by a previous read.
+  const auto middle = m_order.begin() + static_cast<std::ptrdiff_t>(old);
+  if (old != 0 && earlier(*middle, *(middle - 1)))
+  {
+    std::inplace_merge(m_order.begin(), middle, m_order.end(),
+                       [this](const Position &lhs, const Position &rhs) {
+                         return earlier(lhs, rhs);
+                       });
+  }
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ShardedLogStorage<LogType, KeyType>::size() const -> size_type
+{
+  std::lock_guard<std::mutex> guard{m_registry};
+  size_type size = 0;
+  for (const auto &shard : m_shards)
+  {
+    size += shard->logs.size();
+  }
+  return size;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ShardedLogStorage<LogType, KeyType>::shards() const -> size_type
+{
+  std::lock_guard<std::mutex> guard{m_registry};
+  return m_shards.size();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ShardedLogStorage<LogType, KeyType>::cbegin() const -> const_iterator
+{
+  std::lock_guard<std::mutex> guard{m_registry};
+  merge();
+  return const_iterator{this, 0};
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ShardedLogStorage<LogType, KeyType>::cend() const -> const_iterator
+{
+  std::lock_guard<std::mutex> guard{m_registry};
+  merge();
+  return const_iterator{this, m_order.size()};
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ShardedLogStorage<LogType, KeyType>::begin() const -> const_iterator
+{
+  return cbegin();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::ShardedLogStorage<LogType, KeyType>::end() const -> const_iterator
+{
+  return cend();
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::ShardedLogStorage<LogType, KeyType>::clear()
+{
+  std::lock_guard<std::mutex> guard{m_registry};
+  for (auto &shard : m_shards)
+  {
+    shard->logs.clear();
+    shard->merged = 0;
+  }
+  m_order.clear();
+}
+
+}  // namespace Feller
+
+#endif
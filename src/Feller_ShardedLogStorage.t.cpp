@@ -0,0 +1,191 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "Feller_ShardedLogStorage.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_NoLock.hpp"
+#include "Feller_ConditionalLoggingPolicy.hpp"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+// This is a minimal log type that allows us to control the time of each log.
+struct TimedLog
+{
+  unsigned m_time;
+  unsigned m_thread;
+  unsigned time() const noexcept { return m_time; }
+};
+
+TEST(ShardedLogStorage, testInit)
+{
+  Feller::ShardedLogStorage<TimedLog> log;
+  EXPECT_EQ(log.size(), 0);
+  EXPECT_EQ(log.shards(), 0);
+  EXPECT_EQ(log.cbegin(), log.cend());
+}
+
+TEST(ShardedLogStorage, testInsert)
+{
+  Feller::ShardedLogStorage<Feller::EventLog> log;
+  Feller::EventLog l{"Test"};
+  l.emplace_back("abc", "def");
+  log.insert(l);
+  EXPECT_EQ(log.size(), 1);
+  EXPECT_EQ(log.shards(), 1);
+  EXPECT_EQ(*log.cbegin(), l);
+}
+
+TEST(ShardedLogStorage, testInsertMove)
+{
+  Feller::ShardedLogStorage<Feller::EventLog> log;
+  Feller::EventLog l{"Test"};
+  auto copy = l;
+  log.insert(std::move(l));
+  EXPECT_EQ(log.size(), 1);
+  EXPECT_EQ(*log.cbegin(), copy);
+}
+
+TEST(ShardedLogStorage, testMergeIsTimeOrdered)
+{
+  // Each thread inserts logs with increasing times that interleave with the other threads.
+  constexpr unsigned nr_threads = 4;
+  constexpr unsigned per_thread = 1000;
+  Feller::ShardedLogStorage<TimedLog> log;
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < nr_threads; t++)
+  {
+    threads.emplace_back([&log, t]() {
+      for (unsigned i = 0; i < per_thread; i++)
+      {
+        log.insert(TimedLog{i * nr_threads + t, t});
+      }
+    });
+  }
+
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  ASSERT_EQ(log.size(), nr_threads * per_thread);
+  EXPECT_EQ(log.shards(), nr_threads);
+  unsigned curr = 0;
+  for (const auto &v : log)
+  {
+    EXPECT_EQ(v.time(), curr++);
+  }
+}
+
+TEST(ShardedLogStorage, testMergeAfterRead)
+{
+  // Logs inserted after a read must still be merged into the right place.
+  Feller::ShardedLogStorage<TimedLog> log;
+  log.insert(TimedLog{0, 0});
+  log.insert(TimedLog{4, 0});
+  ASSERT_EQ(std::distance(log.cbegin(), log.cend()), 2);
+
+  std::thread other([&log]() {
+    log.insert(TimedLog{1, 1});
+    log.insert(TimedLog{5, 1});
+  });
+  other.join();
+  log.insert(TimedLog{6, 0});
+
+  const std::vector<unsigned> expected{0, 1, 4, 5, 6};
+  std::vector<unsigned> times;
+  for (const auto &v : log)
+  {
+    times.push_back(v.time());
+  }
+  EXPECT_EQ(times, expected);
+}
+
+TEST(ShardedLogStorage, testTiesKeepInsertionOrder)
+{
+  Feller::ShardedLogStorage<TimedLog> log;
+  for (unsigned i = 0; i < 10; i++)
+  {
+    log.insert(TimedLog{0, i});
+  }
+
+  unsigned curr = 0;
+  for (const auto &v : log)
+  {
+    EXPECT_EQ(v.m_thread, curr++);
+  }
+}
+
+TEST(ShardedLogStorage, testClear)
+{
+  Feller::ShardedLogStorage<TimedLog> log;
+  log.insert(TimedLog{0, 0});
+  ASSERT_EQ(log.size(), 1);
+  log.clear();
+  EXPECT_EQ(log.size(), 0);
+  EXPECT_EQ(log.cbegin(), log.cend());
+  log.insert(TimedLog{1, 0});
+  EXPECT_EQ(log.size(), 1);
+  EXPECT_EQ(log.cbegin()->time(), 1);
+}
+
+TEST(ShardedLogStorage, testSeparateStores)
+{
+  // The thread-local cache must not leak shards between stores.
+  Feller::ShardedLogStorage<TimedLog> log1;
+  Feller::ShardedLogStorage<TimedLog> log2;
+  log1.insert(TimedLog{0, 0});
+  log2.insert(TimedLog{1, 0});
+  log1.insert(TimedLog{2, 0});
+  EXPECT_EQ(log1.size(), 2);
+  EXPECT_EQ(log2.size(), 1);
+  EXPECT_EQ(log1.shards(), 1);
+  EXPECT_EQ(log2.shards(), 1);
+}
+
+TEST(ShardedLogStorage, testLogger)
+{
+  Feller::Logger<Feller::EventLog, char, Feller::ShardedLogStorage, Feller::NoLock,
+                 Feller::ConditionalLoggingPolicy>
+      logger;
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < 4; t++)
+  {
+    threads.emplace_back([&logger]() {
+      for (unsigned i = 0; i < 100; i++)
+      {
+        logger.insert(Feller::EventLog{"Test"});
+      }
+    });
+  }
+
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  EXPECT_EQ(logger.size(), 400);
+  for (const auto &v : logger)
+  {
+    EXPECT_EQ(v.name(), "Test");
+  }
+}
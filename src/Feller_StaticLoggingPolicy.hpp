@@ -64,6 +64,26 @@ public:
   inline constexpr Feller::LoggingMode mode() noexcept;
 };
 
+/**
+   logs_nothing. This trait is true if `LoggingPolicy` is known at compile-time to never log
+   (e.g \ref LogNothing), and false otherwise. This lets components that do work before building
+   a log (such as \ref ScopedSpan, which reads the clock) skip that work entirely.
+   \tparam LoggingPolicy: the logging policy to check.
+**/
+template <typename LoggingPolicy> struct logs_nothing : std::false_type
+{
+};
+
+template <Feller::LoggingMode logging>
+struct logs_nothing<StaticLoggingPolicy<logging>>
+    : std::bool_constant<logging == Feller::LoggingMode::NOTHING>
+{
+};
+
+/// Helper variable for logs_nothing.
+template <typename LoggingPolicy>
+inline constexpr bool logs_nothing_v = logs_nothing<LoggingPolicy>::value;
+
 /// INLINE METHODS
 template <Feller::LoggingMode logging>
 inline constexpr bool
@@ -0,0 +1,101 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_StringTable.hpp"
+
+Feller::StringTable::Index::Index(const std::size_t capacity)
+    : mask{capacity - 1}, slots{new std::atomic<std::uint64_t>[capacity]}
+{
+  for (std::size_t i = 0; i < capacity; i++)
+  {
+    slots[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+auto Feller::StringTable::global() -> StringTable &
+{
+  static StringTable table;
+  return table;
+}
+
+Feller::StringTable::StringTable()
+{
+  for (auto &segment : m_segments)
+  {
+    segment.store(nullptr, std::memory_order_relaxed);
+  }
+
+  m_indexes.push_back(std::make_unique<Index>(std::size_t{1} << first_segment_shift));
+  m_index.store(m_indexes.back().get(), std::memory_order_release);
+  insert("", hash(""));
+}
+
+Feller::StringTable::~StringTable()
+{
+  for (auto &segment : m_segments)
+  {
+    delete[] segment.load(std::memory_order_relaxed);
+  }
+}
+
+auto Feller::StringTable::insert(const std::string_view text, const std::uint32_t h) -> id_type
+{
+  std::lock_guard<std::mutex> lock{m_mutex};
+
+  // Another thread may have added this string since we last looked.
+  auto *index = m_index.load(std::memory_order_relaxed);
+  const auto found = probe(*index, text, h);
+  if (found != npos)
+  {
+    return found;
+  }
+
+  // The string is written before it is published in the index, so any reader that finds the id
+  // also sees the string.
+  const auto id = static_cast<id_type>(m_size.load(std::memory_order_relaxed));
+  unsigned segment;
+  std::size_t offset;
+  segment_of(id, segment, offset);
+  if (m_segments[segment].load(std::memory_order_relaxed) == nullptr)
+  {
+    const auto size = std::size_t{1} << (first_segment_shift + segment);
+    m_segments[segment].store(new std::string[size], std::memory_order_release);
+  }
+  m_segments[segment].load(std::memory_order_relaxed)[offset] = std::string{text};
+
+  if (2 * (static_cast<std::size_t>(id) + 1) > index->mask + 1)
+  {
+    m_indexes.push_back(std::make_unique<Index>(2 * (index->mask + 1)));
+    auto *const grown = m_indexes.back().get();
+    for (std::size_t i = 0; i <= index->mask; i++)
+    {
+      const auto word = index->slots[i].load(std::memory_order_relaxed);
+      if (word != 0)
+      {
+        place(*grown, word, static_cast<std::uint32_t>(word >> 32));
+      }
+    }
+
+    m_index.store(grown, std::memory_order_release);
+    index = grown;
+  }
+
+  place(*index, (static_cast<std::uint64_t>(h) << 32) | (static_cast<std::uint64_t>(id) + 1), h);
+  m_size.store(static_cast<std::size_t>(id) + 1, std::memory_order_release);
+  return id;
+}
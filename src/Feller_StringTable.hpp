@@ -0,0 +1,401 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_STRING_TABLE
+#define INCLUDED_FELLER_STRING_TABLE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Feller_Feller.hpp"
+
+namespace Feller
+{
+/**
+ StringTable. This class interns strings: each distinct string is stored exactly once, and is
+identified by a small integer id. Ids are handed out in order, starting from 0 (which is always the
+empty string), and a string keeps its id and its address for the lifetime of the table.
+
+ This class is designed for the case where the same few hundred event names and parameter keys
+are logged billions of times. Hence both lookups are lock-free:
+
+ - `str` maps an id to its string with two loads. The strings live in a list of segments that
+   double in size, so that existing strings never move as the table grows.
+ - `find` (and hence `intern` for a string that is already present) probes an open-addressing
+   hash table of atomic words. Each word packs 32 bits of the hash alongside the id, so most
+   mismatches are rejected without touching the string.
+
+ Only adding a new string takes a lock. When the hash table grows, a new table is built and
+published, and the old table is kept alive (but no longer written to) so that concurrent readers
+can finish their probes. A reader that misses a string in an old table simply falls back to the
+locked path, which always uses the newest table.
+
+ This class can hold at most 2^32 - 1 strings.
+**/
+class StringTable
+{
+public:
+  /**
+     id_type. This is the type of the ids handed out by this table.
+  **/
+  using id_type = std::uint32_t;
+
+  /**
+     npos. This is returned by `find` for strings that are not in the table.
+  **/
+  static constexpr id_type npos = std::numeric_limits<id_type>::max();
+
+  /**
+     global. This function returns the table shared by the whole process. This is the table used
+  by \ref InternedString.
+     \return a reference to the global table.
+  **/
+  static StringTable &global();
+
+  /**
+     StringTable. This constructor builds a table that only holds the empty string. This
+  constructor may throw due to allocation failures.
+  **/
+  StringTable();
+
+  // This class hands out references to its strings, so copying or moving makes no sense.
+  StringTable(const StringTable &)            = delete;
+  StringTable &operator=(const StringTable &) = delete;
+
+  /**
+     ~StringTable. This destructor frees every string.
+  **/
+  ~StringTable();
+
+  /**
+     intern. This method returns the id of `text`, adding it to the table if needed. This method
+  is safe to call from many threads at once, and does not lock if `text` is already present. This
+  method may throw due to allocation failures.
+     \param text: the string to be interned.
+     \return the id of `text`.
+  **/
+  inline id_type intern(std::string_view text);
+
+  /**
+     find. This method returns the id of `text` without adding it. This method is lock-free and
+  does not throw.
+     \param text: the string to be found.
+     \return the id of `text`, or npos if `text` is not in the table.
+  **/
+  inline id_type find(std::string_view text) const noexcept;
+
+  /**
+     str. This method returns the string with id `id`. This method is lock-free and does not
+  throw. The behaviour of this function is undefined if `id` was not returned by this table.
+     \param id: the id of the string.
+     \return a reference to the string. This is valid for the lifetime of the table.
+  **/
+  inline const std::string &str(id_type id) const noexcept;
+
+  /**
+     size. This method returns the number of strings in the table.
+     \return the number of strings in the table.
+  **/
+  inline std::size_t size() const noexcept;
+
+private:
+  /**
+     Index. This struct is an open-addressing hash table of packed (hash, id + 1) words. A word
+  of 0 marks an empty slot. Each table is at most half full.
+  **/
+  struct Index
+  {
+    explicit Index(std::size_t capacity);
+    std::size_t mask;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> slots;
+  };
+
+  /**
+     first_segment_shift. The first segment holds 2^first_segment_shift strings, and each later
+  segment holds twice as many as the one before.
+  **/
+  static constexpr unsigned first_segment_shift = 6;
+
+  /**
+     nr_segments. This is enough segments to hold 2^32 strings.
+  **/
+  static constexpr unsigned nr_segments = 33 - first_segment_shift;
+
+  /**
+     hash. This function returns the 32-bit hash of `text` used in the index.
+  **/
+  static inline std::uint32_t hash(std::string_view text) noexcept;
+
+  /**
+     segment_of. This function returns the segment holding `id`, and the offset of `id` within
+  that segment.
+  **/
+  static inline void segment_of(id_type id, unsigned &segment, std::size_t &offset) noexcept;
+
+  /**
+     probe. This method looks for `text` in `index`.
+     \return the id of `text`, or npos if `text` is not in `index`.
+  **/
+  inline id_type probe(const Index &index, std::string_view text, std::uint32_t h) const noexcept;
+
+  /**
+     place. This method stores `word` in the first empty slot for `h` in `index`.
+  **/
+  static inline void place(Index &index, std::uint64_t word, std::uint32_t h) noexcept;
+
+  /**
+     insert. This method implements the locked path of intern.
+  **/
+  id_type insert(std::string_view text, std::uint32_t h);
+
+  /**
+     m_segments. These hold the strings. Segment `i` holds 2^(first_segment_shift + i) strings,
+  and is allocated when the first of these strings is added.
+  **/
+  std::atomic<std::string *> m_segments[nr_segments];
+
+  /**
+     m_index. This is the newest hash table.
+  **/
+  std::atomic<Index *> m_index{nullptr};
+
+  /**
+     m_size. This is the number of strings in the table.
+  **/
+  std::atomic<std::size_t> m_size{0};
+
+  /**
+     m_mutex. This serialises the addition of new strings.
+  **/
+  std::mutex m_mutex;
+
+  /**
+     m_indexes. This owns every hash table that has been published, including old ones.
+  **/
+  std::vector<std::unique_ptr<Index>> m_indexes;
+};
+
+/**
+ InternedString. This class is a handle to a string in the global \ref StringTable. A handle is
+the size of an integer, copying it never allocates, and comparing two handles for equality is an
+integer comparison. The text is available via `str` (or an implicit conversion to
+`const std::string &`) whenever it is needed.
+**/
+class InternedString
+{
+public:
+  /**
+     id_type. This is the type of the id held by a handle.
+  **/
+  using id_type = StringTable::id_type;
+
+  /**
+     InternedString. This constructor builds a handle to the empty string. This does not touch
+  the table.
+  **/
+  InternedString() noexcept = default;
+
+  /**
+     InternedString. These constructors intern `text` in the global table. These may throw due
+  to allocation failures.
+     \param text: the string to be interned.
+  **/
+  InternedString(const std::string &text) : m_id{StringTable::global().intern(text)} {}
+  InternedString(const char *const text) : m_id{StringTable::global().intern(text)} {}
+  explicit InternedString(const std::string_view text) : m_id{StringTable::global().intern(text)}
+  {
+  }
+
+  /**
+     from_id. This function returns a handle to the string with id `id` in the global table. The
+  behaviour of this function is undefined if `id` was not returned by the global table.
+     \param id: the id of the string.
+     \return a handle to the string.
+  **/
+  static inline InternedString from_id(id_type id) noexcept;
+
+  /**
+     id. This method returns the id of this string in the global table.
+     \return the id of this string.
+  **/
+  inline id_type id() const noexcept { return m_id; }
+
+  /**
+     str. This method returns the text of this string. This does not allocate.
+     \return a reference to the text, which is valid for the lifetime of the process.
+  **/
+  inline const std::string &str() const noexcept { return StringTable::global().str(m_id); }
+
+  /// This conversion allows a handle to be used wherever a string is expected.
+  inline operator const std::string &() const noexcept { return str(); }
+
+  /// Handles compare by id. Comparisons with text compare the text.
+  inline friend bool operator==(const InternedString lhs, const InternedString rhs) noexcept
+  {
+    return lhs.m_id == rhs.m_id;
+  }
+  inline friend bool operator!=(const InternedString lhs, const InternedString rhs) noexcept
+  {
+    return lhs.m_id != rhs.m_id;
+  }
+  inline friend bool operator==(const InternedString lhs, const std::string &rhs) noexcept
+  {
+    return lhs.str() == rhs;
+  }
+  inline friend bool operator==(const std::string &lhs, const InternedString rhs) noexcept
+  {
+    return lhs == rhs.str();
+  }
+  inline friend bool operator!=(const InternedString lhs, const std::string &rhs) noexcept
+  {
+    return !(lhs == rhs);
+  }
+  inline friend bool operator!=(const std::string &lhs, const InternedString rhs) noexcept
+  {
+    return !(lhs == rhs);
+  }
+  inline friend bool operator==(const InternedString lhs, const char *const rhs) noexcept
+  {
+    return lhs.str() == rhs;
+  }
+  inline friend bool operator!=(const InternedString lhs, const char *const rhs) noexcept
+  {
+    return !(lhs == rhs);
+  }
+
+  /**
+     ==. This allows a parameter with an interned key to be compared with a plain pair of strings.
+     \tparam Value: the type of the value of the parameter.
+  **/
+  template <typename Value>
+  inline friend bool operator==(const std::pair<InternedString, Value> &lhs,
+                                const std::pair<std::string, std::string> &rhs) noexcept
+  {
+    return lhs.first == rhs.first && lhs.second == rhs.second;
+  }
+  template <typename Value>
+  inline friend bool operator==(const std::pair<std::string, std::string> &lhs,
+                                const std::pair<InternedString, Value> &rhs) noexcept
+  {
+    return rhs == lhs;
+  }
+
+  inline friend std::ostream &operator<<(std::ostream &os, const InternedString str)
+  {
+    os << str.str();
+    return os;
+  }
+
+private:
+  /**
+     m_id. This is the id of this string in the global table. 0 is the empty string.
+  **/
+  id_type m_id{0};
+};
+
+/// INLINE FUNCTIONS
+inline std::uint32_t StringTable::hash(const std::string_view text) noexcept
+{
+  const auto h = static_cast<std::uint64_t>(std::hash<std::string_view>{}(text));
+  return static_cast<std::uint32_t>(h ^ (h >> 32));
+}
+
+inline void StringTable::segment_of(const id_type id, unsigned &segment,
+                                    std::size_t &offset) noexcept
+{
+  // Segment i starts at id 2^(s + i) - 2^s, where s is first_segment_shift.
+  const auto shifted = static_cast<std::uint64_t>(id) + (std::uint64_t{1} << first_segment_shift);
+  const auto top     = 63u - static_cast<unsigned>(__builtin_clzll(shifted));
+  segment            = top - first_segment_shift;
+  offset             = static_cast<std::size_t>(shifted - (std::uint64_t{1} << top));
+}
+
+inline const std::string &StringTable::str(const id_type id) const noexcept
+{
+  unsigned segment;
+  std::size_t offset;
+  segment_of(id, segment, offset);
+  return m_segments[segment].load(std::memory_order_acquire)[offset];
+}
+
+inline auto StringTable::probe(const Index &index, const std::string_view text,
+                               const std::uint32_t h) const noexcept -> id_type
+{
+  for (auto i = h & index.mask;; i = (i + 1) & index.mask)
+  {
+    const auto word = index.slots[i].load(std::memory_order_acquire);
+    if (word == 0)
+    {
+      return npos;
+    }
+
+    const auto id = static_cast<id_type>(word) - 1;
+    if (static_cast<std::uint32_t>(word >> 32) == h && str(id) == text)
+    {
+      return id;
+    }
+  }
+}
+
+inline void StringTable::place(Index &index, const std::uint64_t word,
+                               const std::uint32_t h) noexcept
+{
+  auto i = h & index.mask;
+  while (index.slots[i].load(std::memory_order_relaxed) != 0)
+  {
+    i = (i + 1) & index.mask;
+  }
+  index.slots[i].store(word, std::memory_order_release);
+}
+
+inline auto StringTable::find(const std::string_view text) const noexcept -> id_type
+{
+  return probe(*m_index.load(std::memory_order_acquire), text, hash(text));
+}
+
+inline auto StringTable::intern(const std::string_view text) -> id_type
+{
+  const auto h  = hash(text);
+  const auto id = probe(*m_index.load(std::memory_order_acquire), text, h);
+  return id != npos ? id : insert(text, h);
+}
+
+inline std::size_t StringTable::size() const noexcept
+{
+  return m_size.load(std::memory_order_acquire);
+}
+
+inline InternedString InternedString::from_id(const id_type id) noexcept
+{
+  InternedString str;
+  str.m_id = id;
+  return str;
+}
+
+}  // namespace Feller
+
+#endif
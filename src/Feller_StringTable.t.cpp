@@ -0,0 +1,153 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_EventLog.hpp"
+#include "Feller_StringTable.hpp"
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(StringTable, testEmptyStringIsZero)
+{
+  Feller::StringTable table;
+  EXPECT_EQ(table.size(), 1);
+  EXPECT_EQ(table.find(""), 0);
+  EXPECT_EQ(table.str(0), "");
+  EXPECT_EQ(table.intern(""), 0);
+  EXPECT_EQ(table.size(), 1);
+}
+
+TEST(StringTable, testIntern)
+{
+  Feller::StringTable table;
+  EXPECT_EQ(table.find("abc"), Feller::StringTable::npos);
+
+  const auto abc = table.intern("abc");
+  const auto def = table.intern("def");
+  EXPECT_EQ(abc, 1);
+  EXPECT_EQ(def, 2);
+  EXPECT_EQ(table.intern("abc"), abc);
+  EXPECT_EQ(table.find("abc"), abc);
+  EXPECT_EQ(table.str(abc), "abc");
+  EXPECT_EQ(table.str(def), "def");
+  EXPECT_EQ(table.size(), 3);
+}
+
+TEST(StringTable, testGrowthKeepsReferences)
+{
+  // Enough strings to grow the index and allocate several segments.
+  constexpr unsigned nr_strings = 10000;
+  Feller::StringTable table;
+  const auto &first = table.str(table.intern("0"));
+  for (unsigned i = 1; i < nr_strings; i++)
+  {
+    EXPECT_EQ(table.intern(std::to_string(i)), i + 1);
+  }
+
+  EXPECT_EQ(&first, &table.str(1));
+  EXPECT_EQ(table.size(), nr_strings + 1);
+  for (unsigned i = 0; i < nr_strings; i++)
+  {
+    EXPECT_EQ(table.find(std::to_string(i)), i + 1);
+    EXPECT_EQ(table.str(i + 1), std::to_string(i));
+  }
+}
+
+TEST(StringTable, testConcurrentIntern)
+{
+  // Every thread interns the same strings in a different order: each string must get one id.
+  constexpr unsigned nr_threads = 4;
+  constexpr unsigned nr_strings = 2048;
+  Feller::StringTable table;
+  std::vector<std::vector<Feller::StringTable::id_type>> ids(
+      nr_threads, std::vector<Feller::StringTable::id_type>(nr_strings));
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < nr_threads; t++)
+  {
+    threads.emplace_back([&, t]() {
+      for (unsigned j = 0; j < nr_strings; j++)
+      {
+        const auto i = (j * (2 * t + 1)) % nr_strings;
+        ids[t][i]    = table.intern("string " + std::to_string(i));
+      }
+    });
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  EXPECT_EQ(table.size(), nr_strings + 1);
+  for (unsigned i = 0; i < nr_strings; i++)
+  {
+    EXPECT_EQ(table.str(ids[0][i]), "string " + std::to_string(i));
+    for (unsigned t = 1; t < nr_threads; t++)
+    {
+      EXPECT_EQ(ids[t][i], ids[0][i]);
+    }
+  }
+}
+
+TEST(InternedString, testDefault)
+{
+  Feller::InternedString str;
+  EXPECT_EQ(str.id(), 0);
+  EXPECT_EQ(str.str(), "");
+  EXPECT_EQ(str, Feller::InternedString{""});
+}
+
+TEST(InternedString, testCompare)
+{
+  const Feller::InternedString a{"interned a"};
+  const Feller::InternedString b{std::string{"interned b"}};
+  const Feller::InternedString c{std::string{"interned a"}};
+
+  EXPECT_EQ(a, c);
+  EXPECT_EQ(a.id(), c.id());
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, "interned a");
+  EXPECT_EQ(a, std::string{"interned a"});
+  EXPECT_NE(a, "interned b");
+  EXPECT_EQ(&a.str(), &c.str());
+  EXPECT_EQ(Feller::InternedString::from_id(b.id()), b);
+
+  const std::string &text = a;
+  EXPECT_EQ(text, "interned a");
+}
+
+TEST(InternedString, testEventLog)
+{
+  Feller::EventLog l1{"event name"};
+  Feller::EventLog l2{std::string{"event name"}, l1.time()};
+  l1.emplace_back("key", "value");
+  l2.emplace_back(std::string{"key"}, std::string{"value"});
+
+  // Logs with the same name share the same id (and the same text).
+  EXPECT_EQ(l1.interned_name(), l2.interned_name());
+  EXPECT_EQ(&l1.name(), &l2.name());
+  EXPECT_EQ(l1.cbegin()->first.id(), l2.cbegin()->first.id());
+  EXPECT_EQ(l1, l2);
+
+  const Feller::EventLog::parameter_type parameter{"key", "value"};
+  Feller::EventLog l3{"event name", l1.time()};
+  l3.emplace_back(parameter);
+  EXPECT_EQ(l1, l3);
+}
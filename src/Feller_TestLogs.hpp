@@ -0,0 +1,73 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_TEST_LOGS
+#define INCLUDED_FELLER_TEST_LOGS
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Feller_EventLog.hpp"
+
+/**
+ \brief The purpose of this component is to share the small helpers that tests use to build logs
+and to check which logs a store holds. This header is only used by tests.
+**/
+
+/**
+   numbered. This function returns a log whose name is `i`. The std::string name constructors of
+   EventLog are ambiguous, so this goes through a C string.
+   \param i: the number to be used as the name.
+   \return a log called `i`.
+**/
+inline Feller::EventLog numbered(const unsigned i)
+{
+  return Feller::EventLog{std::to_string(i).c_str()};
+}
+
+/**
+   names. This function returns the name of each log in [first, last), in order.
+   \param first: an iterator to the first log.
+   \param last: an iterator to one past the last log.
+   \return the names of the logs.
+**/
+template <typename Iterator> std::vector<std::string> names(Iterator first, const Iterator last)
+{
+  std::vector<std::string> out;
+  for (; first != last; ++first)
+  {
+    out.push_back(first->name());
+  }
+  return out;
+}
+
+/// Overload of names for the ranges returned by equal_range and friends.
+template <typename Iterator>
+std::vector<std::string> names(const std::pair<Iterator, Iterator> &range)
+{
+  return names(range.first, range.second);
+}
+
+/// Overload of names for stores and loggers.
+template <typename Store> std::vector<std::string> names(const Store &store)
+{
+  return names(store.cbegin(), store.cend());
+}
+
+#endif
@@ -0,0 +1,72 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_ThreadInfo.hpp"
+
+#include <atomic>
+
+#if defined(__linux__)
+#include <sched.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+auto Feller::Thread::next_index() noexcept -> index_type
+{
+  static std::atomic<index_type> nr_threads{0};
+  return nr_threads.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+int Feller::Thread::cpu() noexcept
+{
+#if defined(__linux__)
+  // On recent glibc this is read from memory that the kernel shares with the thread (rseq), so
+  // it does not need a system call.
+  return sched_getcpu();
+#elif defined(__x86_64__) || defined(__i386__)
+  // Kernels that support rdtscp store the CPU number in the low 12 bits of TSC_AUX.
+  unsigned aux{};
+  static_cast<void>(__rdtscp(&aux));
+  return static_cast<int>(aux & 0xfffu);
+#else
+  return -1;
+#endif
+}
+
+auto Feller::ThreadEventLog::to_event_log() const -> EventLog
+{
+  const auto parameters = thread_parameters();
+  EventLog log{name(), time()};
+  log.reserve(size() + parameters.size());
+  for (const auto &parameter : parameters)
+  {
+    log.emplace_back(parameter);
+  }
+  for (auto it = cbegin(); it != cend(); ++it)
+  {
+    log.emplace_back(*it);
+  }
+  log.aux() = aux();
+  return log;
+}
+
+auto Feller::ThreadEventLog::to_string() const -> std::string
+{
+  const auto parameters = thread_parameters();
+  return EventLog::to_string(parameters.data(), parameters.data() + parameters.size());
+}
@@ -0,0 +1,298 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_THREAD_INFO
+#define INCLUDED_FELLER_THREAD_INFO
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#include "Feller_Feller.hpp"
+
+#include "Feller_EventLog.hpp"
+#include "Feller_ParameterValue.hpp"
+#include "Feller_StringTable.hpp"
+
+namespace Feller
+{
+/**
+   Thread. This namespace contains functions for finding out where a log was recorded: which
+   thread recorded it, and which CPU that thread was running on at the time.
+**/
+namespace Thread
+{
+/**
+   index_type. This is the type used to represent the index of a thread.
+**/
+using index_type = std::uint32_t;
+
+/**
+   index. This function returns a small index for the calling thread. Indices are handed out from
+   a global counter the first time that a thread calls this function, and are then cached in a
+   thread_local variable: the first thread to ask gets 1, the next gets 2, and so on. Unlike
+   `std::this_thread::get_id`, the index is cheap to store and never needs hashing. Note that
+   indices are not reused when threads exit. This function does not throw.
+   \return the index of the calling thread.
+**/
+inline index_type index() noexcept;
+
+/**
+   next_index. This function hands out the next unused thread index. This is called once per
+   thread by `index`, which caches the result. This function does not throw.
+   \return a new index.
+**/
+index_type next_index() noexcept;
+
+/**
+   cpu. This function returns the number of the CPU that the calling thread is running on. This
+   is read via `sched_getcpu` where it is available, or via the `rdtscp` instruction otherwise.
+   Note that the thread may be migrated as soon as this function returns, so the result is only a
+   hint. This function does not throw.
+   \return the current CPU, or -1 if it cannot be found.
+**/
+int cpu() noexcept;
+
+/**
+   index_key. This function returns the key under which the index of a thread is stored. This is
+   the same key as is used by \ref ScopedSpan.
+   \return the key "thread_id".
+**/
+inline InternedString index_key();
+
+/**
+   cpu_key. This function returns the key under which the CPU of a thread is stored.
+   \return the key "cpu".
+**/
+inline InternedString cpu_key();
+
+/**
+   stamp. This function appends the index of the calling thread and its current CPU to `log`, as
+   the parameters "thread_id" and "cpu". This is for logs that do not have room for these fields:
+   \ref ThreadEventLog stores them without any parameters. This function may throw due to
+   allocation failures.
+   \tparam LogType: the type of log. This type must provide an emplace_back method.
+   \param log: the log to be stamped.
+**/
+template <typename LogType> inline void stamp(LogType &log);
+}  // namespace Thread
+
+/**
+    \brief ThreadEventLog. This class is an \ref EventLog that records which thread built it, and
+  which CPU that thread was running on (see \ref Thread). Every constructor that builds a new log
+  records both; copies keep those of the original. For example, `Logger<ThreadEventLog, ...>`
+  stores logs that can be attributed to threads and CPUs, which is useful for diagnosing
+  scheduling and contention problems.
+
+    The thread and CPU are held as fixed-width fields rather than as parameters, so recording them
+  takes 8 bytes (before padding) and never allocates. They are only turned into the parameters
+  "thread_id" and "cpu" (ahead of any others) when the log is formatted or exported: see
+  `thread_parameters`, `to_event_log`, `to_string`, \ref BinaryWriter and \ref ChromeTraceWriter.
+
+    Logs that do not need this information should use \ref EventLog, which does not pay for it.
+**/
+class ThreadEventLog : public EventLog
+{
+public:
+  /**
+     cpu_type. This is the type used to store the CPU of a log.
+  **/
+  using cpu_type = std::int32_t;
+
+  /**
+     ThreadEventLog. These constructors mirror those of \ref EventLog, but also record the thread
+     and CPU. These constructors may throw due to allocation failures.
+     \param name: the name of this log.
+     \param time: the time of this log.
+  **/
+  ThreadEventLog() : ThreadEventLog(InternedString{}) {}
+  ThreadEventLog(const InternedString name) : EventLog(name) {}
+  ThreadEventLog(const InternedString name, const time_point time) : EventLog(name, time) {}
+
+  /**
+     ThreadEventLog. This constructor builds a log and then inserts a single parameter.
+     \param key: the key of the parameter.
+     \param value: the value of the parameter.
+  **/
+  ThreadEventLog(const InternedString key, ParameterValue value) : EventLog(key, std::move(value))
+  {
+  }
+
+  /**
+     ThreadEventLog. These constructors are the allocator-extended forms of the constructors in
+  this class (see \ref EventLog).
+     \param alloc: the allocator for the parameters of this log.
+  **/
+  ThreadEventLog(std::allocator_arg_t, const allocator_type &alloc)
+      : ThreadEventLog(std::allocator_arg, alloc, InternedString{})
+  {
+  }
+  ThreadEventLog(std::allocator_arg_t, const allocator_type &alloc, const ThreadEventLog &other)
+      : EventLog(std::allocator_arg, alloc, static_cast<const EventLog &>(other)),
+        m_thread{other.m_thread}, m_cpu{other.m_cpu}
+  {
+  }
+  ThreadEventLog(std::allocator_arg_t, const allocator_type &alloc, ThreadEventLog &&other)
+      : EventLog(std::allocator_arg, alloc, static_cast<EventLog &&>(other)),
+        m_thread{other.m_thread}, m_cpu{other.m_cpu}
+  {
+  }
+  ThreadEventLog(std::allocator_arg_t, const allocator_type &alloc, const InternedString name)
+      : EventLog(std::allocator_arg, alloc, name, SystemClock::now())
+  {
+  }
+  ThreadEventLog(std::allocator_arg_t, const allocator_type &alloc, const InternedString key,
+                 ParameterValue value)
+      : EventLog(std::allocator_arg, alloc, "Inserted", SystemClock::now())
+  {
+    emplace_back(key, std::move(value));
+  }
+
+  /**
+     assign. This method moves `other` into this log, keeping the parameter vector of this log
+     (see \ref EventLog::assign). The thread and CPU are copied from `other`.
+     \param other: the log that is to be moved from.
+  **/
+  inline void assign(ThreadEventLog &&other)
+  {
+    EventLog::assign(std::move(other));
+    m_thread = other.m_thread;
+    m_cpu    = other.m_cpu;
+  }
+
+  /**
+     thread_index. This method returns the index of the thread that built this log (see \ref
+     Thread::index). This function does not throw.
+     \return the index of the thread.
+  **/
+  inline Thread::index_type thread_index() const noexcept { return m_thread; }
+
+  /**
+     cpu. This method returns the CPU that the thread was running on when it built this log (see
+     \ref Thread::cpu). This function does not throw.
+     \return the CPU, or -1 if it could not be found.
+  **/
+  inline cpu_type cpu() const noexcept { return m_cpu; }
+
+  /**
+     thread_parameters. This method returns the thread and CPU of this log as the parameters
+     "thread_id" and "cpu". This is used when formatting or exporting this log. This function may
+     throw due to allocation failures.
+     \return the parameters.
+  **/
+  inline std::array<parameter_type, 2> thread_parameters() const;
+
+  /**
+     to_event_log. This method converts this log into an \ref EventLog, with the thread and CPU
+     stored as the parameters "thread_id" and "cpu" ahead of any others. This function may throw
+     due to allocation failures.
+     \return the event log.
+  **/
+  EventLog to_event_log() const;
+
+  /**
+     to_string. This method returns a string representation of this log, in the same format as
+     \ref EventLog, with the thread and CPU written as the first two parameters. This function may
+     throw.
+     \return a string representing this object.
+  **/
+  std::string to_string() const;
+
+  /**
+     ==. This function implements an equality operator for ThreadEventLog. Two logs are equal if
+     they are equal as event logs and were recorded on the same thread and CPU.
+     \param lhs: the left log.
+     \param rhs: the right log.
+     \return true if the logs are equal, false otherwise.
+  **/
+  inline friend bool operator==(const ThreadEventLog &lhs, const ThreadEventLog &rhs) noexcept
+  {
+    return lhs.m_thread == rhs.m_thread && lhs.m_cpu == rhs.m_cpu &&
+           static_cast<const EventLog &>(lhs) == static_cast<const EventLog &>(rhs);
+  }
+  inline friend bool operator!=(const ThreadEventLog &lhs, const ThreadEventLog &rhs) noexcept
+  {
+    return !(lhs == rhs);
+  }
+
+  /**
+     <<. This function writes the string representation of `log` to `os`. This may throw.
+     \param os: the output stream to which this object is printed.
+     \param log: the log to be written to the ostream.
+     \return a reference to the input ostream parameter.
+  **/
+  inline friend std::ostream &operator<<(std::ostream &os, const ThreadEventLog &log)
+  {
+    return os << log.to_string();
+  }
+
+private:
+  /**
+     m_thread. This is the index of the thread that built this log.
+  **/
+  Thread::index_type m_thread{Thread::index()};
+
+  /**
+     m_cpu. This is the CPU that the thread was running on when it built this log.
+  **/
+  cpu_type m_cpu{Thread::cpu()};
+};
+
+/// INLINE FUNCTIONS
+inline Thread::index_type Thread::index() noexcept
+{
+  // The index is zero-initialised rather than dynamically initialised, so that reading it does
+  // not also need to check a thread_local guard. Being inline, the common case is a single load.
+  thread_local index_type value = 0;
+  if (value == 0)
+  {
+    value = next_index();
+  }
+  return value;
+}
+
+inline InternedString Thread::index_key()
+{
+  static const InternedString key{"thread_id"};
+  return key;
+}
+
+inline InternedString Thread::cpu_key()
+{
+  static const InternedString key{"cpu"};
+  return key;
+}
+
+inline std::array<ThreadEventLog::parameter_type, 2> ThreadEventLog::thread_parameters() const
+{
+  return {{{Thread::index_key(), m_thread}, {Thread::cpu_key(), m_cpu}}};
+}
+
+template <typename LogType> inline void Thread::stamp(LogType &log)
+{
+  log.reserve(log.size() + 2);
+  log.emplace_back(index_key(), index());
+  log.emplace_back(cpu_key(), cpu());
+}
+
+}  // namespace Feller
+
+#endif
@@ -0,0 +1,255 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_ThreadInfo.hpp"
+#include "Feller_AtomicConditionalLoggingPolicy.hpp"
+#include "Feller_BinaryFormat.hpp"
+#include "Feller_ChromeTrace.hpp"
+#include "Feller_ContiguousLogStorage.hpp"
+#include "Feller_Decl.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_LogEverything.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_MutexLock.hpp"
+#include "Feller_NoLock.hpp"
+#include "Feller_ScopedSpan.hpp"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const Feller::ParameterValue *parameter(const Feller::EventLog &log,
+                                               const Feller::InternedString key)
+{
+  for (auto it = log.cbegin(); it != log.cend(); ++it)
+  {
+    if (it->first == key)
+    {
+      return &it->second;
+    }
+  }
+  return nullptr;
+}
+
+static std::uint64_t thread_of(const Feller::EventLog &log)
+{
+  const auto *const value = parameter(log, Feller::Thread::index_key());
+  EXPECT_NE(value, nullptr);
+  const auto *const index = value == nullptr ? nullptr : value->get_if<std::uint64_t>();
+  return index == nullptr ? 0 : *index;
+}
+
+TEST(ThreadInfo, testIndex)
+{
+  // The index is stable within a thread, and differs between threads.
+  const auto index = Feller::Thread::index();
+  EXPECT_NE(index, 0);
+  EXPECT_EQ(Feller::Thread::index(), index);
+
+  Feller::Thread::index_type other{};
+  std::thread thread([&other] { other = Feller::Thread::index(); });
+  thread.join();
+  EXPECT_NE(other, 0);
+  EXPECT_NE(other, index);
+}
+
+TEST(ThreadInfo, testCpu)
+{
+  const auto cpu = Feller::Thread::cpu();
+  EXPECT_GE(cpu, -1);
+  if (cpu >= 0)
+  {
+    EXPECT_LT(static_cast<unsigned>(cpu), std::max(1u, std::thread::hardware_concurrency()) * 64);
+  }
+}
+
+TEST(ThreadInfo, testStamp)
+{
+  Feller::EventLog log{"stamped"};
+  log.emplace_back("key", "value");
+  Feller::Thread::stamp(log);
+
+  ASSERT_EQ(log.size(), 3);
+  EXPECT_EQ(thread_of(log), Feller::Thread::index());
+  const auto *const cpu = parameter(log, Feller::Thread::cpu_key());
+  ASSERT_NE(cpu, nullptr);
+  EXPECT_NE(cpu->get_if<std::int64_t>(), nullptr);
+}
+
+TEST(ThreadInfo, testThreadEventLog)
+{
+  // The thread and CPU are fields, so they cost no parameters. They take 8 bytes, which may be
+  // rounded up to the alignment of the log.
+  static_assert(sizeof(Feller::ThreadEventLog) <=
+                    sizeof(Feller::EventLog) + std::max<std::size_t>(8, alignof(Feller::EventLog)),
+                "Error: ThreadEventLog should only add the thread and CPU");
+
+  // Every constructor that builds a new log records the thread and CPU.
+  const Feller::ThreadEventLog empty;
+  const Feller::ThreadEventLog named{"named"};
+  const Feller::ThreadEventLog timed{"timed", Feller::SystemClock::now()};
+  const Feller::ThreadEventLog inserted{"key", 5};
+
+  for (const Feller::ThreadEventLog *log : {&empty, &named, &timed, &inserted})
+  {
+    EXPECT_EQ(log->thread_index(), Feller::Thread::index());
+    EXPECT_GE(log->cpu(), -1);
+  }
+
+  EXPECT_EQ(named.size(), 0);
+  ASSERT_EQ(inserted.size(), 1);
+  EXPECT_EQ(inserted.name(), "Inserted");
+  EXPECT_EQ(inserted.cbegin()->first, Feller::InternedString{"key"});
+  EXPECT_EQ(named.name(), "named");
+
+  // Copies keep the thread of the original, rather than recording their own.
+  Feller::ThreadEventLog copy{named};
+  std::thread thread([&copy, &named] { copy = named; });
+  thread.join();
+  EXPECT_EQ(copy, named);
+  EXPECT_EQ(copy.thread_index(), Feller::Thread::index());
+
+  // Logs built on other threads compare unequal, even if their other fields match.
+  const auto time = named.time();
+  Feller::ThreadEventLog other;
+  std::thread builder([&other, time] { other = Feller::ThreadEventLog{"named", time}; });
+  builder.join();
+  EXPECT_NE(other.thread_index(), Feller::Thread::index());
+  EXPECT_NE(other, (Feller::ThreadEventLog{"named", time}));
+
+  // Assigning into an existing log keeps the thread of the source too.
+  Feller::ThreadEventLog assigned;
+  assigned.assign(Feller::ThreadEventLog{other});
+  EXPECT_EQ(assigned, other);
+}
+
+TEST(ThreadInfo, testExport)
+{
+  // The thread and CPU only become parameters when the log is exported or formatted.
+  const Feller::ThreadEventLog log{"key", 5};
+  const auto event_log = log.to_event_log();
+  ASSERT_EQ(event_log.size(), 3);
+  EXPECT_EQ(event_log.name(), log.name());
+  EXPECT_EQ(event_log.time(), log.time());
+  EXPECT_EQ(event_log.cbegin()->first, Feller::Thread::index_key());
+  EXPECT_EQ(thread_of(event_log), log.thread_index());
+  const auto *const cpu = parameter(event_log, Feller::Thread::cpu_key());
+  ASSERT_NE(cpu, nullptr);
+  ASSERT_NE(cpu->get_if<std::int64_t>(), nullptr);
+  EXPECT_EQ(*cpu->get_if<std::int64_t>(), log.cpu());
+  EXPECT_EQ((event_log.cbegin() + 2)->first, Feller::InternedString{"key"});
+
+  EXPECT_EQ(log.to_string(), event_log.to_string());
+  std::ostringstream os;
+  os << log;
+  EXPECT_EQ(os.str(), event_log.to_string());
+
+  // The binary format stores the same parameters.
+  std::stringstream stream;
+  {
+    Feller::BinaryWriter writer{stream};
+    writer.write(log);
+    EXPECT_TRUE(writer.flush());
+  }
+  Feller::BinaryReader reader{stream};
+  Feller::EventLog read;
+  ASSERT_TRUE(reader.read(read));
+  EXPECT_EQ(read, event_log);
+
+  // Chrome traces put the log on its thread.
+  std::ostringstream trace;
+  EXPECT_TRUE(Feller::write_chrome_trace(trace, std::vector<Feller::ThreadEventLog>{log}));
+  const auto tid = "\"tid\":" + std::to_string(log.thread_index());
+  EXPECT_NE(trace.str().find(tid), std::string::npos);
+  EXPECT_NE(trace.str().find("\"cpu\":"), std::string::npos);
+  EXPECT_EQ(trace.str().find("\"thread_id\""), std::string::npos);
+}
+
+TEST(ThreadInfo, testAllocator)
+{
+  std::pmr::monotonic_buffer_resource resource;
+  std::pmr::vector<Feller::ThreadEventLog> logs{&resource};
+  logs.emplace_back("named");
+  logs.emplace_back("key", 5);
+
+  ASSERT_EQ(logs[0].size(), 0);
+  ASSERT_EQ(logs[1].size(), 1);
+  EXPECT_EQ(logs[0].get_allocator().resource(), &resource);
+  EXPECT_EQ(logs[1].thread_index(), Feller::Thread::index());
+}
+
+TEST(ThreadInfo, testMultiThreadedLogger)
+{
+  // Each log in the dump can be attributed to the thread that built it.
+  constexpr unsigned nr_threads = 4;
+  constexpr unsigned nr_logs    = 16;
+  Feller::MultiThreadedThreadEventLogger logger;
+
+  std::vector<Feller::Thread::index_type> indices(nr_threads);
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < nr_threads; i++)
+  {
+    threads.emplace_back([&logger, &indices, i] {
+      indices[i] = Feller::Thread::index();
+      for (unsigned j = 0; j < nr_logs; j++)
+      {
+        logger.insert(Feller::ThreadEventLog{"work"});
+      }
+    });
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  ASSERT_EQ(logger.size(), nr_threads * nr_logs);
+  std::multiset<std::uint64_t> seen;
+  for (auto it = logger.cbegin(); it != logger.cend(); ++it)
+  {
+    seen.insert(it->thread_index());
+  }
+  for (const auto index : indices)
+  {
+    EXPECT_EQ(seen.count(index), nr_logs);
+  }
+}
+
+TEST(ThreadInfo, testScopedSpan)
+{
+  // Spans and logs agree on thread ids, and spans do not record the thread twice.
+  using LoggerType = Feller::Logger<Feller::ThreadEventLog, char, Feller::ContiguousLogStorage,
+                                    Feller::NoLock, Feller::LogEverything>;
+  LoggerType logger;
+  {
+    Feller::ScopedSpan<LoggerType> span{logger, "span"};
+  }
+
+  ASSERT_EQ(logger.size(), 1);
+  const auto &log = *logger.cbegin();
+  EXPECT_EQ(log.size(), 3);
+  EXPECT_EQ(parameter(log, Feller::Span::thread_key()), nullptr);
+  EXPECT_EQ(log.thread_index(), Feller::Span::thread_state().thread_id);
+  EXPECT_EQ(log.thread_index(), Feller::Thread::index());
+}
@@ -0,0 +1,191 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_TimeFormatter.hpp"
+
+#include <charconv>
+#include <cstring>
+
+namespace
+{
+/**
+   digit_pairs. This holds the text for every number in [0, 100), so that digits can be written
+   two at a time.
+**/
+constexpr char digit_pairs[] = "0001020304050607080910111213141516171819"
+                               "2021222324252627282930313233343536373839"
+                               "4041424344454647484950515253545556575859"
+                               "6061626364656667686970717273747576777879"
+                               "8081828384858687888990919293949596979899";
+
+/**
+   write_digits. This function writes `value` into `out` as exactly `count` digits, zero padded.
+   \return one past the last character written.
+**/
+char *write_digits(char *const out, std::uint64_t value, const unsigned count) noexcept
+{
+  unsigned i = count;
+  for (; i > 1; i -= 2)
+  {
+    const auto pair = static_cast<unsigned>(value % 100) * 2;
+    out[i - 2]      = digit_pairs[pair];
+    out[i - 1]      = digit_pairs[pair + 1];
+    value /= 100;
+  }
+
+  if (i == 1)
+  {
+    out[0] = static_cast<char>('0' + value % 10);
+  }
+  return out + count;
+}
+
+/**
+   Civil. This struct holds a date in the proleptic Gregorian calendar.
+**/
+struct Civil
+{
+  std::int64_t year;
+  unsigned month;
+  unsigned day;
+};
+
+/**
+   civil_from_days. This function converts a number of days since 1970-01-01 to a date. This is
+   the branch-free algorithm from Howard Hinnant's "chrono-Compatible Low-Level Date Algorithms".
+**/
+Civil civil_from_days(std::int64_t days) noexcept
+{
+  days += 719468;
+  const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const auto doe         = static_cast<unsigned>(days - era * 146097);
+  const unsigned yoe     = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy     = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp      = (5 * doy + 2) / 153;
+  const unsigned day     = doy - (153 * mp + 2) / 5 + 1;
+  const unsigned month   = mp < 10 ? mp + 3 : mp - 9;
+  return Civil{static_cast<std::int64_t>(yoe) + era * 400 + (month <= 2), month, day};
+}
+
+/**
+   floor_div. This function divides `lhs` by the positive `rhs`, rounding towards -infinity.
+**/
+std::int64_t floor_div(const std::int64_t lhs, const std::int64_t rhs) noexcept
+{
+  return lhs / rhs - (lhs % rhs < 0);
+}
+}  // namespace
+
+void Feller::TimeFormatter::cache(const bool negative, const std::int64_t second) noexcept
+{
+  char *out = m_prefix;
+  if (m_format == Format::EPOCH)
+  {
+    if (negative)
+    {
+      *out++ = '-';
+    }
+    out = std::to_chars(out, std::end(m_prefix), second).ptr;
+  }
+  else
+  {
+    const auto days    = floor_div(second, 86400);
+    const auto seconds = static_cast<std::uint64_t>(second - days * 86400);
+    const auto date    = civil_from_days(days);
+
+    if (date.year >= 0 && date.year <= 9999)
+    {
+      out = write_digits(out, static_cast<std::uint64_t>(date.year), 4);
+    }
+    else
+    {
+      out = std::to_chars(out, std::end(m_prefix), date.year).ptr;
+    }
+
+    *out++ = '-';
+    out    = write_digits(out, date.month, 2);
+    *out++ = '-';
+    out    = write_digits(out, date.day, 2);
+    *out++ = 'T';
+    out    = write_digits(out, seconds / 3600, 2);
+    *out++ = ':';
+    out    = write_digits(out, seconds / 60 % 60, 2);
+    *out++ = ':';
+    out    = write_digits(out, seconds % 60, 2);
+  }
+
+  m_prefix_size = static_cast<std::uint8_t>(out - m_prefix);
+  m_second      = second;
+  m_negative    = negative;
+  m_valid       = true;
+}
+
+void Feller::TimeFormatter::append_to(std::string &out, const time_point &time)
+{
+  constexpr std::int64_t ns_per_second = 1000000000;
+  const auto ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+
+  // ISO 8601 rounds down to the second before, whereas EPOCH writes a sign and a magnitude.
+  bool negative = false;
+  std::int64_t second;
+  std::uint64_t fraction;
+  if (m_format == Format::EPOCH)
+  {
+    negative = ns < 0;
+    // This is computed in unsigned arithmetic, as the magnitude of the minimum does not fit.
+    const auto magnitude = negative ? std::uint64_t{0} - static_cast<std::uint64_t>(ns)
+                                    : static_cast<std::uint64_t>(ns);
+    second   = static_cast<std::int64_t>(magnitude / std::uint64_t{ns_per_second});
+    fraction = magnitude % std::uint64_t{ns_per_second};
+  }
+  else
+  {
+    // The remainder is taken directly, as second * ns_per_second may overflow.
+    const auto remainder = ns % ns_per_second;
+    second               = floor_div(ns, ns_per_second);
+    fraction = static_cast<std::uint64_t>(remainder < 0 ? remainder + ns_per_second : remainder);
+  }
+
+  if (!m_valid || second != m_second || negative != m_negative)
+  {
+    cache(negative, second);
+  }
+
+  // The text is built locally and appended at once, as each append has to check the capacity.
+  // The whole prefix buffer is copied, as a fixed size copy is cheaper than a call to memcpy.
+  // The largest suffix is a point, nine digits and a 'Z'.
+  char text[sizeof(m_prefix) + 11];
+  std::memcpy(text, m_prefix, sizeof(m_prefix));
+  char *end         = text + m_prefix_size;
+  const auto digits = static_cast<unsigned>(m_precision);
+  if (digits != 0)
+  {
+    constexpr std::uint64_t divisors[] = {1000000000, 100000000, 10000000, 1000000, 100000,
+                                          10000,      1000,      100,      10,      1};
+    *end++ = '.';
+    end    = write_digits(end, fraction / divisors[digits], digits);
+  }
+
+  if (m_format == Format::ISO8601)
+  {
+    *end++ = 'Z';
+  }
+
+  out.append(text, static_cast<std::size_t>(end - text));
+}
@@ -0,0 +1,167 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_TIME_FORMATTER
+#define INCLUDED_FELLER_TIME_FORMATTER
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "Feller_Feller.hpp"
+
+namespace Feller
+{
+/**
+ TimeFormatter. This class converts time points to text. This is designed for dumping many logs
+at once: unlike `std::ctime`, this class does not go through the locale or timezone machinery, it
+does not use any shared state (so separate objects may be used on separate threads), and it keeps
+sub-second precision.
+
+ Times are always written in UTC. Since consecutive logs are usually recorded within the same
+second, the text for the current second is cached: formatting a time in that second only writes
+the sub-second digits. This means that this class is not thread-safe: each thread should use its
+own object (see \ref Util::time_to_string).
+**/
+class TimeFormatter
+{
+public:
+  /**
+     time_point. This is the type of time that this class formats.
+  **/
+  using time_point = std::chrono::time_point<std::chrono::system_clock>;
+
+  /**
+     Format. This enum describes the layout of the text.
+     ISO8601: e.g "2024-01-02T03:04:05.123456Z".
+     EPOCH: the number of seconds since the epoch, e.g "1704164645.123456".
+  **/
+  enum class Format : std::uint8_t
+  {
+    ISO8601,
+    EPOCH,
+  };
+
+  /**
+     Precision. This enum describes the number of digits written after the seconds. The value of
+  each entry is the number of digits.
+  **/
+  enum class Precision : std::uint8_t
+  {
+    SECONDS      = 0,
+    MILLISECONDS = 3,
+    MICROSECONDS = 6,
+    NANOSECONDS  = 9,
+  };
+
+  /**
+     TimeFormatter. This constructor builds a formatter with the given layout and precision.
+     \param format: the layout of the text.
+     \param precision: the number of digits written after the seconds.
+  **/
+  explicit TimeFormatter(const Format format       = Format::ISO8601,
+                         const Precision precision = Precision::MICROSECONDS) noexcept
+      : m_format{format}, m_precision{precision}
+  {
+  }
+
+  /**
+     append_to. This method appends the text for `time` to `out`. This method may throw due to
+  allocation failures.
+     \param out: the string to append to.
+     \param time: the time to be formatted.
+  **/
+  void append_to(std::string &out, const time_point &time);
+
+  /**
+     to_string. This method returns the text for `time`. This method may throw due to allocation
+  failures.
+     \param time: the time to be formatted.
+     \return the text for `time`.
+  **/
+  inline std::string to_string(const time_point &time);
+
+  /**
+     format. This method returns the layout used by this formatter.
+     \return the layout used by this formatter.
+  **/
+  inline Format format() const noexcept { return m_format; }
+
+  /**
+     precision. This method returns the precision used by this formatter.
+     \return the precision used by this formatter.
+  **/
+  inline Precision precision() const noexcept { return m_precision; }
+
+private:
+  /**
+     cache. This method writes the text for the whole second `second` into m_prefix.
+     \param negative: true if the time is before the epoch. This is only used by EPOCH, which
+  writes the sign and the magnitude separately.
+     \param second: the second to be written.
+  **/
+  void cache(bool negative, std::int64_t second) noexcept;
+
+  /**
+     m_format. This is the layout of the text.
+  **/
+  Format m_format;
+
+  /**
+     m_precision. This is the number of digits written after the seconds.
+  **/
+  Precision m_precision;
+
+  /**
+     m_valid. This is true if m_prefix holds the text for m_second.
+  **/
+  bool m_valid{false};
+
+  /**
+     m_negative. This is the sign of the cached second. This is only used by EPOCH.
+  **/
+  bool m_negative{false};
+
+  /**
+     m_prefix_size. This is the number of characters in m_prefix.
+  **/
+  std::uint8_t m_prefix_size{0};
+
+  /**
+     m_second. This is the second whose text is held in m_prefix.
+  **/
+  std::int64_t m_second{0};
+
+  /**
+     m_prefix. This holds the text for m_second. This is large enough for any year that fits in
+  an int64 of nanoseconds.
+  **/
+  char m_prefix[32]{};
+};
+
+/// INLINE FUNCTIONS
+inline std::string TimeFormatter::to_string(const time_point &time)
+{
+  std::string out;
+  append_to(out, time);
+  return out;
+}
+
+}  // namespace Feller
+
+#endif
@@ -0,0 +1,130 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_TimeFormatter.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_Util.hpp"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <random>
+#include <string>
+
+using Format    = Feller::TimeFormatter::Format;
+using Precision = Feller::TimeFormatter::Precision;
+using Time      = Feller::TimeFormatter::time_point;
+
+static Time from_ns(const std::int64_t ns)
+{
+  return Time{std::chrono::duration_cast<Time::duration>(std::chrono::nanoseconds{ns})};
+}
+
+// 2024-02-29T12:34:56.123456789Z
+static const Time leap_day = from_ns(1709210096123456789);
+
+TEST(TimeFormatter, testDefaults)
+{
+  Feller::TimeFormatter formatter;
+  EXPECT_EQ(formatter.format(), Format::ISO8601);
+  EXPECT_EQ(formatter.precision(), Precision::MICROSECONDS);
+  EXPECT_EQ(formatter.to_string(Time{}), "1970-01-01T00:00:00.000000Z");
+  EXPECT_EQ(formatter.to_string(leap_day), "2024-02-29T12:34:56.123456Z");
+}
+
+TEST(TimeFormatter, testPrecision)
+{
+  EXPECT_EQ(Feller::TimeFormatter(Format::ISO8601, Precision::SECONDS).to_string(leap_day),
+            "2024-02-29T12:34:56Z");
+  EXPECT_EQ(Feller::TimeFormatter(Format::ISO8601, Precision::MILLISECONDS).to_string(leap_day),
+            "2024-02-29T12:34:56.123Z");
+  EXPECT_EQ(Feller::TimeFormatter(Format::ISO8601, Precision::NANOSECONDS).to_string(leap_day),
+            "2024-02-29T12:34:56.123456789Z");
+}
+
+TEST(TimeFormatter, testEpoch)
+{
+  Feller::TimeFormatter formatter{Format::EPOCH, Precision::NANOSECONDS};
+  EXPECT_EQ(formatter.to_string(Time{}), "0.000000000");
+  EXPECT_EQ(formatter.to_string(leap_day), "1709210096.123456789");
+  EXPECT_EQ(formatter.to_string(from_ns(-1)), "-0.000000001");
+  EXPECT_EQ(formatter.to_string(from_ns(-1500000000)), "-1.500000000");
+  EXPECT_EQ(Feller::TimeFormatter(Format::EPOCH, Precision::SECONDS).to_string(leap_day),
+            "1709210096");
+}
+
+TEST(TimeFormatter, testBeforeEpoch)
+{
+  Feller::TimeFormatter formatter{Format::ISO8601, Precision::NANOSECONDS};
+  EXPECT_EQ(formatter.to_string(from_ns(-1)), "1969-12-31T23:59:59.999999999Z");
+  EXPECT_EQ(formatter.to_string(from_ns(-2208988800000000000)), "1900-01-01T00:00:00.000000000Z");
+}
+
+TEST(TimeFormatter, testExtremes)
+{
+  Feller::TimeFormatter formatter{Format::ISO8601, Precision::NANOSECONDS};
+  EXPECT_EQ(formatter.to_string(from_ns(INT64_MAX)), "2262-04-11T23:47:16.854775807Z");
+  EXPECT_EQ(formatter.to_string(from_ns(INT64_MIN)), "1677-09-21T00:12:43.145224192Z");
+
+  Feller::TimeFormatter epoch{Format::EPOCH, Precision::NANOSECONDS};
+  EXPECT_EQ(epoch.to_string(from_ns(INT64_MAX)), "9223372036.854775807");
+  EXPECT_EQ(epoch.to_string(from_ns(INT64_MIN)), "-9223372036.854775808");
+}
+
+TEST(TimeFormatter, testAgainstGmtime)
+{
+  // Each time is formatted twice, so that both the cached and uncached paths are checked.
+  std::mt19937_64 rng{42};
+  std::uniform_int_distribution<std::int64_t> seconds{-4000000000, 8000000000};
+  Feller::TimeFormatter formatter{Format::ISO8601, Precision::SECONDS};
+
+  for (unsigned i = 0; i < 10000; i++)
+  {
+    const std::time_t t = seconds(rng);
+    std::tm tm{};
+    ASSERT_NE(gmtime_r(&t, &tm), nullptr);
+    char expected[64];
+    std::strftime(expected, sizeof(expected), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+    const auto time = std::chrono::system_clock::from_time_t(t);
+    ASSERT_EQ(formatter.to_string(time), expected);
+    ASSERT_EQ(formatter.to_string(time), expected);
+  }
+}
+
+TEST(TimeFormatter, testAppend)
+{
+  Feller::TimeFormatter formatter;
+  std::string out = "Time:";
+  formatter.append_to(out, leap_day);
+  formatter.append_to(out, leap_day + std::chrono::microseconds{1});
+  EXPECT_EQ(out, "Time:2024-02-29T12:34:56.123456Z2024-02-29T12:34:56.123457Z");
+}
+
+TEST(TimeFormatter, testUtil)
+{
+  EXPECT_EQ(Feller::Util::time_to_string(leap_day), "2024-02-29T12:34:56.123456Z");
+
+  std::string out;
+  Feller::Util::append_time(out, leap_day);
+  EXPECT_EQ(out, "2024-02-29T12:34:56.123456Z");
+
+  const Feller::EventLog log{"abc", leap_day};
+  EXPECT_NE(log.to_string().find("\nTime:2024-02-29T12:34:56.123456Z\n"), std::string::npos);
+}
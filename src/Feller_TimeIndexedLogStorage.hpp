@@ -0,0 +1,404 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#ifndef INCLUDED_FELLER_TIME_INDEXED_LOG_STORAGE
+#define INCLUDED_FELLER_TIME_INDEXED_LOG_STORAGE
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <numeric>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "Feller_Feller.hpp"
+
+namespace Feller
+{
+/**
+ TimeIndexedLogStorage. This class implements a contiguous store that answers "which logs happened
+between t0 and t1" with a binary search rather than a scan.
+
+ Briefly, logs are held contiguously in insertion order. As long as every log is at least as new
+as the one before it (which is the usual case for a single thread) the store is already sorted by
+time, and `range` simply binary searches the logs themselves. If a log arrives out of order (e.g
+because several threads share the store, and a thread is descheduled between taking a timestamp
+and inserting) then this class falls back to a side index of positions sorted by time. The side
+index is brought up to date lazily by the next query: the new positions are sorted and merged into
+the existing index, so each query only pays for the logs that were inserted since the last one.
+
+ Either way, `range` returns a pair of random-access iterators that refer directly to the stored
+logs: no log is ever copied. Note that these iterators, like those of std::vector, are invalidated
+by insertion.
+
+ \tparam LogType: the type of log to be stored in this class. This type must provide a `time()`
+method that returns something that can be compared with `<`.
+ \tparam KeyType: not used in this class.
+**/
+template <typename LogType, typename KeyType = char /*unused*/> class TimeIndexedLogStorage
+{
+public:
+  /**
+     size_type. This type is used to represent sizes and indices in this object.
+  **/
+  using size_type = std::size_t;
+
+  /**
+     time_type. This is the type of the timestamps of the stored logs.
+  **/
+  using time_type = decltype(std::declval<const LogType &>().time());
+
+  /**
+     const_iterator. This type is used to iterate over the logs in insertion order.
+  **/
+  using const_iterator = typename std::vector<LogType>::const_iterator;
+
+  /**
+     time_iterator. This class provides random access to the logs in this object in time order.
+  **/
+  class time_iterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = LogType;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const LogType *;
+    using reference         = const LogType &;
+
+    time_iterator() = default;
+
+    reference operator*() const { return m_storage->by_time(static_cast<size_type>(m_index)); }
+    pointer operator->() const { return &**this; }
+    reference operator[](const difference_type n) const { return *(*this + n); }
+
+    time_iterator &operator++()
+    {
+      ++m_index;
+      return *this;
+    }
+
+    time_iterator operator++(int)
+    {
+      auto tmp = *this;
+      ++m_index;
+      return tmp;
+    }
+
+    time_iterator &operator--()
+    {
+      --m_index;
+      return *this;
+    }
+
+    time_iterator operator--(int)
+    {
+      auto tmp = *this;
+      --m_index;
+      return tmp;
+    }
+
+    time_iterator &operator+=(const difference_type n)
+    {
+      m_index += n;
+      return *this;
+    }
+
+    time_iterator &operator-=(const difference_type n)
+    {
+      m_index -= n;
+      return *this;
+    }
+
+    friend time_iterator operator+(time_iterator it, const difference_type n) { return it += n; }
+    friend time_iterator operator+(const difference_type n, time_iterator it) { return it += n; }
+    friend time_iterator operator-(time_iterator it, const difference_type n) { return it -= n; }
+    friend difference_type operator-(const time_iterator &lhs, const time_iterator &rhs)
+    {
+      return lhs.m_index - rhs.m_index;
+    }
+
+    friend bool operator==(const time_iterator &lhs, const time_iterator &rhs) noexcept
+    {
+      return lhs.m_storage == rhs.m_storage && lhs.m_index == rhs.m_index;
+    }
+    friend bool operator!=(const time_iterator &lhs, const time_iterator &rhs) noexcept
+    {
+      return !(lhs == rhs);
+    }
+    friend bool operator<(const time_iterator &lhs, const time_iterator &rhs) noexcept
+    {
+      return lhs.m_index < rhs.m_index;
+    }
+    friend bool operator>(const time_iterator &lhs, const time_iterator &rhs) noexcept
+    {
+      return rhs < lhs;
+    }
+    friend bool operator<=(const time_iterator &lhs, const time_iterator &rhs) noexcept
+    {
+      return !(rhs < lhs);
+    }
+    friend bool operator>=(const time_iterator &lhs, const time_iterator &rhs) noexcept
+    {
+      return !(lhs < rhs);
+    }
+
+  private:
+    friend class TimeIndexedLogStorage;
+    time_iterator(const TimeIndexedLogStorage *storage, const difference_type index)
+        : m_storage{storage}, m_index{index}
+    {
+    }
+
+    const TimeIndexedLogStorage *m_storage{nullptr};
+    difference_type m_index{0};
+  };
+
+  /**
+     insert. This method copies `log` into this object. This function may throw due to
+  allocation failures.
+     \param log: the log to be copied into this object.
+  **/
+  inline void insert(const LogType &log);
+
+  /// Overload of insert for rvalue refs.
+  inline void insert(LogType &&log);
+
+  /**
+     emplace_back. This method builds a log from `args` at the end of this object.
+     \param args: the arguments to be forwarded to the constructor of the log.
+  **/
+  template <typename... Args> inline void emplace_back(Args &&...args);
+
+  /**
+     range. This method returns the logs whose time is in [`first`, `last`), oldest first. Logs
+  with equal times are returned in insertion order. This takes O(log n) time once the side index
+  (if any) is up to date. This function may throw due to allocation failures, as it may update
+  the side index.
+     \param first: the earliest time to be included.
+     \param last: the first time to be excluded.
+     \return a pair of iterators over the logs in the range.
+  **/
+  inline std::pair<time_iterator, time_iterator> range(const time_type &first,
+                                                       const time_type &last) const;
+
+  /**
+     in_order. This method returns true if every log was inserted in time order, in which case no
+  side index is needed. This function does not throw.
+     \return true if the logs are in time order, false otherwise.
+  **/
+  inline bool in_order() const noexcept;
+
+  /**
+     size. This method returns the number of logs in this object.
+     \return the number of logs in this object.
+  **/
+  inline size_type size() const noexcept;
+
+  /**
+     cbegin. This method returns a const iterator to the first log inserted into this object.
+     \return a const iterator to the first log.
+  **/
+  inline const_iterator cbegin() const noexcept;
+
+  /**
+     cend. This method returns a const iterator to one past the last log inserted.
+     \return a const iterator to the end of the logs.
+  **/
+  inline const_iterator cend() const noexcept;
+
+  /// Overloads of cbegin and cend to allow range-based for loops.
+  inline const_iterator begin() const noexcept;
+  inline const_iterator end() const noexcept;
+
+  /**
+     clear. This method removes every log from this object, and drops the side index. Note that
+  the memory is not freed.
+  **/
+  inline void clear() noexcept;
+
+  /**
+      operator<<. Prints a string representation of the object ``st`` to the
+      specified ostream ``os`. This method may throw.
+      \tparam LT: the type stored in st.
+      \param os: the stream to print the storage object to.
+      \param st: the object to be printed.
+      \return the os parameter.
+   **/
+  template <typename LT, typename KT>
+  inline friend std::ostream &operator<<(std::ostream &os, const TimeIndexedLogStorage<LT, KT> &st);
+
+private:
+  /**
+     by_time. This method returns the `index`-th oldest log. The side index must be up to date.
+  **/
+  inline const LogType &by_time(const size_type index) const noexcept;
+
+  /**
+     update_index. This method brings the side index up to date, if there is one.
+  **/
+  inline void update_index() const;
+
+  /**
+     m_logs. This vector holds every log in insertion order.
+  **/
+  std::vector<LogType> m_logs{};
+
+  /**
+     m_in_order. This is true if every log is at least as new as the log before it.
+  **/
+  bool m_in_order{true};
+
+  /**
+     m_index. Once a log arrives out of order, this holds the position of every log that has been
+  indexed, sorted by time.
+  **/
+  mutable std::vector<size_type> m_index{};
+};
+
+/// INLINE FUNCTIONS
+template <typename LogType, typename KeyType>
+inline std::ostream &operator<<(std::ostream &os, const TimeIndexedLogStorage<LogType, KeyType> &st)
+{
+  for (auto &v : st)
+  {
+    os << v;
+  }
+  return os;
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::TimeIndexedLogStorage<LogType, KeyType>::insert(const LogType &log)
+{
+  emplace_back(log);
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::TimeIndexedLogStorage<LogType, KeyType>::insert(LogType &&log)
+{
+  emplace_back(std::move(log));
+}
+
+template <typename LogType, typename KeyType>
+template <typename... Args>
+inline void Feller::TimeIndexedLogStorage<LogType, KeyType>::emplace_back(Args &&...args)
+{
+  m_logs.emplace_back(std::forward<Args>(args)...);
+  const auto size = m_logs.size();
+  if (m_in_order && size > 1 && m_logs[size - 1].time() < m_logs[size - 2].time())
+  {
+    m_in_order = false;
+  }
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::TimeIndexedLogStorage<LogType, KeyType>::update_index() const
+{
+  const auto indexed = m_index.size();
+  if (m_in_order || indexed == m_logs.size())
+  {
+    return;
+  }
+
+  m_index.resize(m_logs.size());
+  std::iota(m_index.begin() + static_cast<std::ptrdiff_t>(indexed), m_index.end(), indexed);
+
+  // The new positions are sorted on their own and then merged in. Both sorts are stable (and the
+  // positions start in insertion order), so logs with equal times stay in insertion order.
+  const auto earlier = [this](const size_type lhs, const size_type rhs) {
+    return m_logs[lhs].time() < m_logs[rhs].time();
+  };
+
+  const auto middle = m_index.begin() + static_cast<std::ptrdiff_t>(indexed);
+  std::stable_sort(middle, m_index.end(), earlier);
+  std::inplace_merge(m_index.begin(), middle, m_index.end(), earlier);
+}
+
+template <typename LogType, typename KeyType>
+inline const LogType &
+Feller::TimeIndexedLogStorage<LogType, KeyType>::by_time(const size_type index) const noexcept
+{
+  return m_in_order ? m_logs[index] : m_logs[m_index[index]];
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::TimeIndexedLogStorage<LogType, KeyType>::range(const time_type &first,
+                                                                   const time_type &last) const
+    -> std::pair<time_iterator, time_iterator>
+{
+  update_index();
+  const time_iterator begin{this, 0};
+  const time_iterator end{this, static_cast<std::ptrdiff_t>(m_logs.size())};
+
+  const auto lower = std::partition_point(
+      begin, end, [&first](const LogType &log) { return log.time() < first; });
+  const auto upper = std::partition_point(
+      lower, end, [&last](const LogType &log) { return log.time() < last; });
+  return {lower, upper};
+}
+
+template <typename LogType, typename KeyType>
+inline bool Feller::TimeIndexedLogStorage<LogType, KeyType>::in_order() const noexcept
+{
+  return m_in_order;
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::TimeIndexedLogStorage<LogType, KeyType>::size() const noexcept -> size_type
+{
+  return m_logs.size();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::TimeIndexedLogStorage<LogType, KeyType>::cbegin() const noexcept
+    -> const_iterator
+{
+  return m_logs.cbegin();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::TimeIndexedLogStorage<LogType, KeyType>::cend() const noexcept
+    -> const_iterator
+{
+  return m_logs.cend();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::TimeIndexedLogStorage<LogType, KeyType>::begin() const noexcept
+    -> const_iterator
+{
+  return cbegin();
+}
+
+template <typename LogType, typename KeyType>
+inline auto Feller::TimeIndexedLogStorage<LogType, KeyType>::end() const noexcept -> const_iterator
+{
+  return cend();
+}
+
+template <typename LogType, typename KeyType>
+inline void Feller::TimeIndexedLogStorage<LogType, KeyType>::clear() noexcept
+{
+  m_logs.clear();
+  m_index.clear();
+  m_in_order = true;
+}
+
+}  // namespace Feller
+
+#endif
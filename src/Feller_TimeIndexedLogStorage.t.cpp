@@ -0,0 +1,137 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+#include "Feller_EventLog.hpp"
+#include "Feller_LogEverything.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_MutexLock.hpp"
+#include "Feller_TestLogs.hpp"
+#include "Feller_TimeIndexedLogStorage.hpp"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using Storage = Feller::TimeIndexedLogStorage<Feller::EventLog>;
+using Time    = std::chrono::time_point<std::chrono::system_clock>;
+
+// This builds a log whose time is `seconds` after the epoch.
+Feller::EventLog at(const int seconds, const char *const name = "")
+{
+  return Feller::EventLog{name, Time{} + std::chrono::seconds(seconds)};
+}
+
+Time seconds(const int s) { return Time{} + std::chrono::seconds(s); }
+
+TEST(TimeIndexedLogStorage, testEmpty)
+{
+  Storage storage;
+  const auto range = storage.range(seconds(0), seconds(10));
+  EXPECT_EQ(range.first, range.second);
+  EXPECT_TRUE(storage.in_order());
+}
+
+TEST(TimeIndexedLogStorage, testInOrder)
+{
+  Storage storage;
+  for (int i = 0; i < 10; i++)
+  {
+    storage.insert(at(i, std::to_string(i).c_str()));
+  }
+
+  EXPECT_TRUE(storage.in_order());
+  EXPECT_EQ(names(storage.range(seconds(3), seconds(6))),
+            (std::vector<std::string>{"3", "4", "5"}));
+  EXPECT_EQ(names(storage.range(seconds(-5), seconds(2))), (std::vector<std::string>{"0", "1"}));
+  EXPECT_EQ(names(storage.range(seconds(9), seconds(100))), std::vector<std::string>{"9"});
+  const auto empty = storage.range(seconds(20), seconds(30));
+  EXPECT_EQ(empty.first, empty.second);
+
+  // The range refers directly to the stored logs.
+  const auto range = storage.range(seconds(0), seconds(1));
+  EXPECT_EQ(&*range.first, &*storage.cbegin());
+}
+
+TEST(TimeIndexedLogStorage, testOutOfOrder)
+{
+  Storage storage;
+  for (const int t : {1, 2, 5, 3, 3, 0, 4})
+  {
+    storage.insert(at(t, std::to_string(t).c_str()));
+  }
+
+  EXPECT_FALSE(storage.in_order());
+  EXPECT_EQ(names(storage.range(seconds(0), seconds(10))),
+            (std::vector<std::string>{"0", "1", "2", "3", "3", "4", "5"}));
+  EXPECT_EQ(names(storage.range(seconds(3), seconds(5))),
+            (std::vector<std::string>{"3", "3", "4"}));
+
+  // Insertion order is untouched.
+  EXPECT_EQ(storage.cbegin()->name(), "1");
+
+  // Logs inserted after a query are merged into the index by the next query.
+  storage.insert(at(2, "late"));
+  storage.insert(at(7, "7"));
+  EXPECT_EQ(names(storage.range(seconds(2), seconds(8))),
+            (std::vector<std::string>{"2", "late", "3", "3", "4", "5", "7"}));
+}
+
+TEST(TimeIndexedLogStorage, testClear)
+{
+  Storage storage;
+  storage.insert(at(2));
+  storage.insert(at(1));
+  EXPECT_FALSE(storage.in_order());
+
+  storage.clear();
+  EXPECT_EQ(storage.size(), 0);
+  EXPECT_TRUE(storage.in_order());
+  storage.insert(at(5, "5"));
+  EXPECT_EQ(names(storage.range(seconds(0), seconds(10))), std::vector<std::string>{"5"});
+}
+
+TEST(TimeIndexedLogStorage, testManyThreads)
+{
+  Feller::Logger<Feller::EventLog, char, Feller::TimeIndexedLogStorage, Feller::MutexLock,
+                 Feller::LogEverything>
+      logger;
+
+  constexpr unsigned nr_threads = 4;
+  constexpr unsigned per_thread = 1000;
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < nr_threads; t++)
+  {
+    threads.emplace_back([&logger]() {
+      for (unsigned i = 0; i < per_thread; i++)
+      {
+        logger.insert(Feller::EventLog{"Event", std::chrono::system_clock::now()});
+      }
+    });
+  }
+
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  const auto range = logger.range(Time::min(), Time::max());
+  ASSERT_EQ(range.second - range.first, nr_threads * per_thread);
+  EXPECT_TRUE(std::is_sorted(range.first, range.second,
+                             [](const Feller::EventLog &lhs, const Feller::EventLog &rhs) {
+                               return lhs.time() < rhs.time();
+                             }));
+}
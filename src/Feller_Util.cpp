@@ -17,15 +17,29 @@
  *
  ****/
 #include "Feller_Util.hpp"
+#include "Feller_TimeFormatter.hpp"
+
+namespace
+{
+/**
+   formatter. This returns the formatter for the calling thread. Each thread has its own, as
+   formatters cache the text of the last second that they formatted.
+**/
+Feller::TimeFormatter &formatter() noexcept
+{
+  thread_local Feller::TimeFormatter formatter;
+  return formatter;
+}
+}  // namespace
 
 auto Feller::Util::time_to_string(const std::chrono::time_point<std::chrono::system_clock> &time)
     -> std::string
 {
-  // This is a remarkably involved process for some reason.
-  // The neatest way I found of doing this was found at:
-  // https://gist.github.com/polaris/adee936198995a6f8c697c419d21f734
-  std::time_t t  = std::chrono::system_clock::to_time_t(time);
-  std::string ts = std::ctime(&t);
-  ts.resize(ts.size() - 1);
-  return ts;
+  return formatter().to_string(time);
+}
+
+void Feller::Util::append_time(std::string &out,
+                               const std::chrono::time_point<std::chrono::system_clock> &time)
+{
+  formatter().append_to(out, time);
 }
@@ -31,13 +31,21 @@ namespace Util
 {
 /**
    time_to_string. Given a time point as input (denoted as `time`), this method
-returns a string representation of the `time` variable. This method differs from
-other approaches in that it does not rely on string streams or similar. This
-method may throw due to allocation failures. Note that this function does not
+returns a string representation of the `time` variable. This is the ISO 8601 form
+of `time` in UTC, with microsecond precision (e.g "2024-01-02T03:04:05.123456Z").
+This method is thread-safe, as each thread formats via its own \ref TimeFormatter.
+This method may throw due to allocation failures. Note that this function does not
 modify the parameter. \param time: the time to be converted to a string. \return
 a string representing the `time` parameter.
 **/
 std::string time_to_string(const std::chrono::time_point<std::chrono::system_clock> &time);
+
+/**
+   append_time. This method appends the same text as `time_to_string` to `out`, without
+building a temporary string. This method may throw due to allocation failures.
+\param out: the string to append to. \param time: the time to be converted.
+**/
+void append_time(std::string &out, const std::chrono::time_point<std::chrono::system_clock> &time);
 }  // namespace Util
 }  // namespace Feller
 #endif
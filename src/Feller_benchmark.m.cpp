@@ -0,0 +1,699 @@
+/***\
+ *
+ *   Copyright (C) Joe Rowell
+ *
+ *   This file is part of Feller. Feller is free software:
+ *   you can redistribute it and/or modify it under the terms of the
+ *   GNU General Public License as published by the Free Software Foundation,
+ *   either version 2 of the License, or (at your option) any later version.
+ *
+ *   Feller is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Feller. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****/
+
+// This file contains some simple benchmarks for the different components in Feller.
+// These are not meant to be rigorous: they simply give a rough idea of the cost of
+// each approach so that regressions are easy to spot. Build in Release mode to run them.
+
+#include "Feller_AsyncLogger.hpp"
+#include "Feller_AtomicConditionalLoggingPolicy.hpp"
+#include "Feller_BinaryFormat.hpp"
+#include "Feller_ChromeTrace.hpp"
+#include "Feller_Clock.hpp"
+#include "Feller_ColumnarLogStorage.hpp"
+#include "Feller_ConditionalLoggingPolicy.hpp"
+#include "Feller_ContiguousLogStorage.hpp"
+#include "Feller_Data.hpp"
+#include "Feller_Decl.hpp"
+#include "Feller_DeferredLog.hpp"
+#include "Feller_EventLog.hpp"
+#include "Feller_LogEverything.hpp"
+#include "Feller_LogNothing.hpp"
+#include "Feller_MetricLog.hpp"
+#include "Feller_MetricLogStorage.hpp"
+#include "Feller_MutexLock.hpp"
+#include "Feller_Logger.hpp"
+#include "Feller_NoLock.hpp"
+#include "Feller_ScopedSpan.hpp"
+#include "Feller_SegmentedLogStorage.hpp"
+#include "Feller_ThreadInfo.hpp"
+#include "Feller_TimeFormatter.hpp"
+#include "Feller_Util.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <ostream>
+#include <memory>
+#include <memory_resource>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+/**
+   Result. This struct holds the mean and worst-case cost of a single operation in nanoseconds.
+**/
+struct Result
+{
+  double mean;
+  double worst;
+};
+
+/**
+   time_each. This function calls `f(i)` for each `i` in [0, n) and times each call.
+   \return the mean and worst-case time per call.
+**/
+template <typename F> Result time_each(const unsigned n, F &&f)
+{
+  double worst     = 0;
+  const auto start = Clock::now();
+  for (unsigned i = 0; i < n; i++)
+  {
+    const auto before = Clock::now();
+    f(i);
+    const auto took = std::chrono::duration<double, std::nano>(Clock::now() - before).count();
+    worst           = std::max(worst, took);
+  }
+  const auto total = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  return Result{total / n, worst};
+}
+
+/**
+   clobber. This function stops the compiler from caching values in registers across calls.
+   Without this, cheap operations (e.g reading a logging mode) can be hoisted out of the loop.
+**/
+inline void clobber() { asm volatile("" : : : "memory"); }
+
+/**
+   NullBuffer. This stream buffer discards everything written to it. This is used to time
+   exporters without the cost of the stream itself.
+**/
+struct NullBuffer : std::streambuf
+{
+  int overflow(const int c) override { return c; }
+  std::streamsize xsputn(const char *, const std::streamsize n) override { return n; }
+};
+
+/**
+   time_total. This function calls `f(i)` for each `i` in [0, n) and times the whole loop.
+   This should be used for operations that are too cheap to time individually.
+   \return the mean time per call. The worst-case time is not measured.
+**/
+template <typename F> Result time_total(const unsigned n, F &&f)
+{
+  const auto start = Clock::now();
+  for (unsigned i = 0; i < n; i++)
+  {
+    f(i);
+  }
+  const auto total = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  return Result{total / n, 0};
+}
+
+/**
+   report. This function prints a single benchmark result.
+**/
+void report(const char *const name, const Result &result)
+{
+  std::cout << name << ": mean " << result.mean << "ns";
+  if (result.worst > 0)
+  {
+    std::cout << ", worst " << result.worst << "ns";
+  }
+  std::cout << std::endl;
+}
+
+/**
+   bench_storage_insert. This function times inserting `n` logs into a Logger that uses the
+   `StoragePolicy` storage.
+**/
+template <template <typename...> class StoragePolicy>
+void bench_storage_insert(const char *const name, const unsigned n)
+{
+  Feller::Logger<Feller::EventLog, char, StoragePolicy, Feller::NoLock, Feller::LogEverything>
+      logger;
+  report(name, time_each(n, [&logger](unsigned) { logger.insert(Feller::EventLog{"Insert"}); }));
+}
+
+/**
+   bench_reject. This function times rejecting `n` logs in a Logger that uses the `LoggingPolicy`
+   logging policy. This is the cost paid by every filtered-out log.
+**/
+template <typename LoggingPolicy> void bench_reject(const char *const name, const unsigned n)
+{
+  Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage, Feller::NoLock,
+                 LoggingPolicy>
+      logger;
+  logger.switchMode(Feller::LoggingMode::IMPORTANT);
+  const Feller::EventLog log{"Rejected"};
+  report(name, time_total(n, [&logger, &log](unsigned) {
+           logger.insert(log, Feller::LoggingMode::EVERYTHING);
+           clobber();
+         }));
+}
+
+/**
+   bench_parameters. This function compares adding an integer and a double parameter to a log as
+   formatted strings and as typed values. The log is reused so that only the parameter is timed.
+**/
+void bench_parameters(const unsigned n)
+{
+  Feller::EventLog log{"Event"};
+  log.reserve(1);
+  const Feller::InternedString key{"index"};
+
+  report("  integer, std::to_string", time_total(n, [&](unsigned i) {
+           log.clear();
+           log.emplace_back(key, std::to_string(i));
+           clobber();
+         }));
+  report("  integer, ParameterValue", time_total(n, [&](unsigned i) {
+           log.clear();
+           log.emplace_back(key, i);
+           clobber();
+         }));
+  report("  double, std::to_string", time_total(n, [&](unsigned i) {
+           log.clear();
+           log.emplace_back(key, std::to_string(i * 0.25));
+           clobber();
+         }));
+  report("  double, ParameterValue", time_total(n, [&](unsigned i) {
+           log.clear();
+           log.emplace_back(key, i * 0.25);
+           clobber();
+         }));
+}
+
+/**
+   bench_deferred. This function compares recording `n` logs with an integer and a double
+   parameter as event logs and as deferred logs. The storage is reserved up front, so that only
+   the cost of building and storing each log is timed.
+**/
+void bench_deferred(const unsigned n)
+{
+  Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage, Feller::NoLock,
+                 Feller::LogEverything>
+      events;
+  events.reserve(n);
+  const Feller::InternedString index{"index"}, ratio{"ratio"};
+  report("  EventLog", time_total(n, [&](unsigned i) {
+           Feller::EventLog log{"Event", std::chrono::system_clock::now()};
+           log.reserve(2);
+           log.emplace_back(index, i);
+           log.emplace_back(ratio, i * 0.25);
+           events.insert(std::move(log));
+         }));
+
+  Feller::Logger<Feller::DeferredLog, char, Feller::ContiguousLogStorage, Feller::NoLock,
+                 Feller::LogEverything>
+      deferred;
+  deferred.reserve(n);
+  report("  DeferredLog", time_total(n, [&](unsigned i) {
+           deferred.insert(
+               Feller::DeferredLog{FELLER_LOG_SITE("Event", "index", "ratio"), i, i * 0.25});
+         }));
+
+  // Both of the above read the clock once per log, so this is a floor for either.
+  report("  system_clock::now", time_total(n, [](unsigned) {
+           const auto now = std::chrono::system_clock::now();
+           asm volatile("" : : "r"(&now) : "memory");
+         }));
+
+  // The formatting is paid when the logs are read instead.
+  std::ostringstream os;
+  Result result = time_total(1, [&](unsigned) { os << deferred; });
+  result.mean /= n;
+  report("  DeferredLog, operator<<", result);
+}
+
+/**
+   bench_serialise. This function compares writing `n` logs in the text, binary and Chrome trace
+   formats, and reading the binary format back. The logs are written to memory to leave out disk
+   costs.
+**/
+void bench_serialise(const unsigned n)
+{
+  Feller::ContiguousLogStorage<Feller::EventLog> storage;
+  for (unsigned i = 0; i < n; i++)
+  {
+    Feller::EventLog log{"Event", std::chrono::system_clock::now()};
+    log.emplace_back("index", std::to_string(i));
+    log.emplace_back("state", "running");
+    storage.insert(std::move(log));
+  }
+
+  // Each of these runs once over every log, so we report the time per log.
+  const auto per_log = [n](Result result) {
+    result.mean /= n;
+    return result;
+  };
+
+  std::ostringstream text;
+  report("  operator<<", per_log(time_total(1, [&](unsigned) { text << storage; })));
+  std::cout << "    " << text.str().size() / n << " bytes per log" << std::endl;
+
+  std::stringstream binary;
+  report("  write_binary",
+         per_log(time_total(1, [&](unsigned) { Feller::write_binary(binary, storage); })));
+  std::cout << "    " << binary.str().size() / n << " bytes per log" << std::endl;
+
+  std::stringstream trace;
+  report("  write_chrome_trace",
+         per_log(time_total(1, [&](unsigned) { Feller::write_chrome_trace(trace, storage); })));
+  std::cout << "    " << trace.str().size() / n << " bytes per log" << std::endl;
+
+  Feller::ContiguousLogStorage<Feller::EventLog> out;
+  out.reserve(n);
+  report("  read_binary",
+         per_log(time_total(1, [&](unsigned) { Feller::read_binary(binary, out); })));
+}
+
+/**
+   bench_scan. This function compares a scan that only reads the time and the name of `n` logs
+   over the contiguous (array-of-structs) and columnar (struct-of-arrays) layouts. Each scan counts
+   the logs with a given name in the second half of the run.
+**/
+void bench_scan(const unsigned n)
+{
+  Feller::ContiguousLogStorage<Feller::EventLog> rows;
+  Feller::ColumnarLogStorage<Feller::EventLog> columns;
+  const auto start = std::chrono::system_clock::now();
+  for (unsigned i = 0; i < n; i++)
+  {
+    Feller::EventLog log{"Event " + std::to_string(i % 16), start + std::chrono::microseconds(i)};
+    log.emplace_back("index", std::to_string(i));
+    log.emplace_back("state", "running");
+    rows.insert(log);
+    columns.insert(std::move(log));
+  }
+
+  const auto middle = start + std::chrono::microseconds(n / 2);
+  const std::string name{"Event 3"};
+  const auto per_log = [n](Result result) {
+    result.mean /= n;
+    return result;
+  };
+
+  // Each scan stores its count here so that it cannot be optimised away.
+  volatile std::size_t sink = 0;
+
+  report("  ContiguousLogStorage", per_log(time_total(1, [&](unsigned) {
+           sink = static_cast<std::size_t>(
+               std::count_if(rows.cbegin(), rows.cend(), [&](const Feller::EventLog &log) {
+                 return log.time() >= middle && log.name() == name;
+               }));
+         })));
+
+  report("  ColumnarLogStorage, views", per_log(time_total(1, [&](unsigned) {
+           std::size_t count = 0;
+           for (const auto log : columns)
+           {
+             count += log.time() >= middle && log.name() == name;
+           }
+           sink = count;
+         })));
+
+  report("  ColumnarLogStorage, columns", per_log(time_total(1, [&](unsigned) {
+           const auto id     = columns.find_name(name);
+           const auto &times = columns.times();
+           const auto &names = columns.name_ids();
+           std::size_t count = 0;
+           for (std::size_t i = 0; i < times.size(); i++)
+           {
+             count += times[i] >= middle && names[i] == id;
+           }
+           sink = count;
+         })));
+}
+
+/**
+   Payload. This is auxiliary data that is too large to be held inline by \ref AuxData.
+**/
+struct Payload : public Feller::Data
+{
+  explicit Payload(const unsigned v) : value{v} {}
+  bool operator==(const Data &) const noexcept override { return false; }
+  std::string to_string() const override { return std::to_string(value); }
+  std::unique_ptr<Data> copy() const override { return std::make_unique<Payload>(*this); }
+
+  unsigned value;
+  char bytes[120]{};
+};
+
+/**
+   bench_aux. This function compares attaching large auxiliary data to `n` logs on the heap and
+   in the arena of the logger, and then clearing the logger. Each logger is filled and cleared
+   once beforehand, so that the steady state (where memory is reused) is timed.
+**/
+void bench_aux(const unsigned n)
+{
+  using LoggerType = Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage,
+                                    Feller::NoLock, Feller::LogEverything>;
+  LoggerType heap, arena;
+  heap.reserve(n);
+  arena.reserve(n);
+
+  const auto on_heap = [&](unsigned i) {
+    Feller::EventLog log{"Event"};
+    log.aux() = std::make_unique<Payload>(i);
+    heap.insert(std::move(log));
+  };
+  const auto in_arena = [&](unsigned i) {
+    Feller::EventLog log{"Event"};
+    log.aux() = arena.make_aux<Payload>(i);
+    arena.insert(std::move(log));
+  };
+
+  time_total(n, on_heap);
+  heap.clear();
+  time_total(n, in_arena);
+  arena.clear();
+
+  report("  Heap", time_total(n, on_heap));
+  report("  Arena", time_total(n, in_arena));
+
+  Result result = time_total(1, [&](unsigned) { heap.clear(); });
+  result.mean /= n;
+  report("  Heap, clear", result);
+  result = time_total(1, [&](unsigned) { arena.clear(); });
+  result.mean /= n;
+  report("  Arena, clear", result);
+}
+
+/**
+   bench_time. This function compares converting `n` times, one microsecond apart, to text via
+   std::ctime (as Util::time_to_string used to), via Util::time_to_string and via appending to a
+   reused string with a TimeFormatter.
+**/
+void bench_time(const unsigned n)
+{
+  const auto start = std::chrono::system_clock::now();
+  const auto time  = [start](unsigned i) { return start + std::chrono::microseconds{i}; };
+
+  report("  std::ctime", time_total(n, [&](unsigned i) {
+           const std::time_t t = std::chrono::system_clock::to_time_t(time(i));
+           std::string ts      = std::ctime(&t);
+           ts.resize(ts.size() - 1);
+           asm volatile("" : : "r"(ts.data()) : "memory");
+         }));
+  report("  Util::time_to_string", time_total(n, [&](unsigned i) {
+           auto ts = Feller::Util::time_to_string(time(i));
+           asm volatile("" : : "r"(ts.data()) : "memory");
+         }));
+
+  Feller::TimeFormatter formatter{Feller::TimeFormatter::Format::ISO8601,
+                                  Feller::TimeFormatter::Precision::NANOSECONDS};
+  std::string out;
+  report("  TimeFormatter::append_to", time_total(n, [&](unsigned i) {
+           out.clear();
+           formatter.append_to(out, time(i));
+           asm volatile("" : : "r"(out.data()) : "memory");
+         }));
+}
+
+/**
+   bench_clock. This function compares the cost of reading each clock policy `n` times, and of
+   building `n` named logs timed by the system clock and by the TSC.
+**/
+void bench_clock(const unsigned n)
+{
+  const auto read = [n](const char *const name, auto now) {
+    report(name, time_total(n, [&](unsigned) {
+             const auto time = now();
+             asm volatile("" : : "r"(time.time_since_epoch().count()) : "memory");
+           }));
+  };
+
+  Feller::TscClock::calibrate();
+  read("  SystemClock::now", Feller::SystemClock::now);
+  read("  SteadyClock::now", Feller::SteadyClock::now);
+  read("  CoarseClock::now", Feller::CoarseClock::now);
+  read("  TscClock::now", Feller::TscClock::now);
+  report("  TscClock::ticks", time_total(n, [&](unsigned) {
+           const auto ticks = Feller::TscClock::ticks();
+           asm volatile("" : : "r"(ticks) : "memory");
+         }));
+
+  const Feller::InternedString name{"Event"};
+  report("  EventLog", time_total(n, [&](unsigned) {
+           const Feller::EventLog log{name};
+           asm volatile("" : : "r"(&log) : "memory");
+         }));
+  report("  ClockedEventLog<TscClock>", time_total(n, [&](unsigned) {
+           const Feller::ClockedEventLog<Feller::TscClock> log{name};
+           asm volatile("" : : "r"(&log) : "memory");
+         }));
+}
+
+/**
+   bench_thread. This function compares finding the calling thread `n` times via \ref
+   Thread::index and by hashing `std::this_thread::get_id`, and the cost of reading the current
+   CPU. It then compares building `n` named logs without the thread and CPU, with them stored as
+   parameters (via \ref Thread::stamp), and with them stored as the fields of a \ref
+   ThreadEventLog.
+**/
+void bench_thread(const unsigned n)
+{
+  report("  Thread::index", time_total(n, [&](unsigned) {
+           const auto index = Feller::Thread::index();
+           asm volatile("" : : "r"(index) : "memory");
+         }));
+  report("  hash(this_thread::get_id)", time_total(n, [&](unsigned) {
+           const auto hash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+           asm volatile("" : : "r"(hash) : "memory");
+         }));
+  report("  Thread::cpu", time_total(n, [&](unsigned) {
+           const auto cpu = Feller::Thread::cpu();
+           asm volatile("" : : "r"(cpu) : "memory");
+         }));
+
+  const Feller::InternedString name{"Event"};
+  report("  EventLog", time_total(n, [&](unsigned) {
+           const Feller::EventLog log{name};
+           asm volatile("" : : "r"(&log) : "memory");
+         }));
+  report("  EventLog + Thread::stamp", time_total(n, [&](unsigned) {
+           Feller::EventLog log{name};
+           Feller::Thread::stamp(log);
+           asm volatile("" : : "r"(&log) : "memory");
+         }));
+  report("  ThreadEventLog", time_total(n, [&](unsigned) {
+           const Feller::ThreadEventLog log{name};
+           asm volatile("" : : "r"(&log) : "memory");
+         }));
+}
+
+/**
+   bench_metrics. This function compares counting `n` requests by inserting an event log per
+   request into a MultiThreadedEventLogger (as one had to before MetricLog), with counting them in
+   a MetricLogger, and then compares setting a gauge `n` times in each.
+**/
+void bench_metrics(const unsigned n)
+{
+  const Feller::InternedString name{"requests"};
+  {
+    Feller::MultiThreadedEventLogger logger;
+    report("  EventLog counter", time_each(n, [&](unsigned) {
+             Feller::EventLog log{name};
+             log.emplace_back(Feller::MetricLog::counter_key(), 1);
+             logger.insert(std::move(log));
+           }));
+  }
+  {
+    Feller::MetricLogger logger;
+    report("  MetricLog counter", time_total(n, [&](unsigned) {
+             logger.insert(Feller::MetricLog::counter(name));
+             clobber();
+           }));
+  }
+
+  const Feller::InternedString load{"load"};
+  {
+    Feller::MultiThreadedEventLogger logger;
+    report("  EventLog gauge", time_each(n, [&](unsigned i) {
+             Feller::EventLog log{load};
+             log.emplace_back(Feller::MetricLog::gauge_key(), static_cast<double>(i));
+             logger.insert(std::move(log));
+           }));
+  }
+  {
+    Feller::MetricLogger logger;
+    report("  MetricLog gauge", time_total(n, [&](unsigned i) {
+             logger.insert(Feller::MetricLog::gauge(load, static_cast<double>(i)));
+             clobber();
+           }));
+  }
+}
+
+/**
+   bench_span. This function compares timing `n` empty scopes by inserting a log at either end
+   (as one had to before ScopedSpan), with a ScopedSpan on the steady clock and on the TSC, and
+   with a ScopedSpan on a logger that logs nothing. The spans are then exported as a Chrome trace
+   to a stream that discards its input.
+**/
+void bench_span(const unsigned n)
+{
+  using LoggerType  = Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage,
+                                    Feller::NoLock, Feller::LogEverything>;
+  using NothingType = Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage,
+                                     Feller::NoLock, Feller::LogNothing>;
+  const Feller::InternedString name{"Span"};
+
+  {
+    LoggerType logger;
+    report("  Two logs", time_total(n, [&](unsigned) {
+             logger.emplace(name);
+             logger.emplace(name);
+           }));
+  }
+  {
+    LoggerType logger;
+    report("  ScopedSpan<SteadyClock>", time_total(n, [&](unsigned) {
+             const Feller::ScopedSpan<LoggerType> span{logger, name};
+           }));
+  }
+  {
+    LoggerType logger;
+    Feller::TscClock::calibrate();
+    report("  ScopedSpan<TscClock>", time_total(n, [&](unsigned) {
+             const Feller::ScopedSpan<LoggerType, Feller::TscClock> span{logger, name};
+           }));
+
+    NullBuffer buffer;
+    std::ostream trace{&buffer};
+    Result result = time_total(1, [&](unsigned) { Feller::write_chrome_trace(trace, logger); });
+    result.mean /= n;
+    report("  write_chrome_trace, per span", result);
+  }
+  {
+    NothingType logger;
+    report("  ScopedSpan, LogNothing", time_total(n, [&](unsigned) {
+             const Feller::ScopedSpan<NothingType> span{logger, name};
+             clobber();
+           }));
+  }
+}
+
+/**
+   bench_async. This function times `n` round trips through an \ref AsyncLogger: each log is
+   inserted and then flushed, so every round trip pays for waking the background thread. A missed
+   wake-up costs a poll interval (1ms). It then times inserting `n` logs through a queue of depth
+   1, where every insertion waits for the previous log to be drained.
+**/
+void bench_async(const unsigned n)
+{
+  using LoggerType = Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage,
+                                    Feller::MutexLock, Feller::LogEverything>;
+  using AsyncType  = Feller::AsyncLogger<LoggerType>;
+  const Feller::InternedString name{"Event"};
+
+  {
+    AsyncType logger;
+    report("  insert and flush", time_each(n, [&](unsigned) {
+             logger.insert(Feller::EventLog{name});
+             logger.flush();
+           }));
+  }
+  {
+    AsyncType logger{1, Feller::Backpressure::BLOCK};
+    report("  insert, depth 1", time_each(n, [&](unsigned) {
+             logger.insert(Feller::EventLog{name});
+           }));
+  }
+}
+
+/**
+   bench_memory_resource. This function compares building and then destroying loggers of
+   `per_request` logs, each with a string parameter that is too long for the small string
+   optimisation, with the default memory resource and with a monotonic buffer resource that is
+   released in one go. This is repeated until `n` logs have been built.
+**/
+void bench_memory_resource(const unsigned n, const unsigned per_request)
+{
+  using LoggerType = Feller::Logger<Feller::EventLog, char, Feller::ContiguousLogStorage,
+                                    Feller::NoLock, Feller::LogEverything>;
+  const std::string value = "a value that is long enough to be allocated";
+
+  report("  Default resource", time_total(n / per_request, [&](unsigned) {
+           LoggerType logger;
+           for (unsigned i = 0; i < per_request; i++)
+           {
+             logger.emplace("Event", value);
+           }
+         }));
+
+  report("  Monotonic buffer", time_total(n / per_request, [&](unsigned) {
+           std::pmr::monotonic_buffer_resource resource;
+           LoggerType logger{&resource};
+           for (unsigned i = 0; i < per_request; i++)
+           {
+             logger.emplace("Event", value);
+           }
+         }));
+}
+}  // namespace
+
+int main()
+{
+  constexpr unsigned nr_logs = 1u << 22;
+
+  std::cout << "Logger::insert (" << nr_logs << " logs)" << std::endl;
+  bench_storage_insert<Feller::ContiguousLogStorage>("  ContiguousLogStorage", nr_logs);
+  bench_storage_insert<Feller::SegmentedLogStorage>("  SegmentedLogStorage", nr_logs);
+
+  std::cout << "Logger::insert, rejected (" << nr_logs << " logs)" << std::endl;
+  bench_reject<Feller::ConditionalLoggingPolicy>("  ConditionalLoggingPolicy", nr_logs);
+  bench_reject<Feller::AtomicConditionalLoggingPolicy>("  AtomicConditionalLoggingPolicy", nr_logs);
+
+  std::cout << "Adding a parameter (" << nr_logs << " logs)" << std::endl;
+  bench_parameters(nr_logs);
+
+  constexpr unsigned nr_serialised = 1u << 20;
+  std::cout << "Serialising (" << nr_serialised << " logs)" << std::endl;
+  bench_serialise(nr_serialised);
+
+  std::cout << "Recording a log with two parameters (" << nr_serialised << " logs)" << std::endl;
+  bench_deferred(nr_serialised);
+
+  std::cout << "Scanning time and name (" << nr_serialised << " logs)" << std::endl;
+  bench_scan(nr_serialised);
+
+  std::cout << "Formatting a time (" << nr_serialised << " logs)" << std::endl;
+  bench_time(nr_serialised);
+
+  std::cout << "Reading the time (" << nr_serialised << " logs)" << std::endl;
+  bench_clock(nr_serialised);
+
+  std::cout << "Finding the thread (" << nr_serialised << " reads)" << std::endl;
+  bench_thread(nr_serialised);
+
+  std::cout << "Counting requests (" << nr_serialised << " updates)" << std::endl;
+  bench_metrics(nr_serialised);
+
+  std::cout << "Timing a scope (" << nr_serialised << " spans)" << std::endl;
+  bench_span(nr_serialised);
+
+  constexpr unsigned per_request = 1024;
+  std::cout << "Per-request loggers (" << nr_serialised << " logs, " << per_request
+            << " per logger)" << std::endl;
+  bench_memory_resource(nr_serialised, per_request);
+
+  std::cout << "Attaching large aux data (" << nr_serialised << " logs)" << std::endl;
+  bench_aux(nr_serialised);
+
+  constexpr unsigned nr_async = 1u << 14;
+  std::cout << "Waking the async logger (" << nr_async << " logs)" << std::endl;
+  bench_async(nr_async);
+}
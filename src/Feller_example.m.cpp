@@ -29,7 +29,7 @@ int main()
 
   for (unsigned i = 0; i < random_size; i++)
   {
-    logger.insert(Log{"Doing something with:", std::to_string(i)});
+    logger.insert(Log{"Doing something with:", i});
   }
   logger.insert(Log{"Leaving"});
 